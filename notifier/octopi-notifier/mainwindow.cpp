@@ -4,6 +4,10 @@
 #include "../../src/package.h"
 #include "../../src/pacmanhelperclient.h"
 #include "../../src/transactiondialog.h"
+#include "../../src/pacmandatabasewatcher.h"
+#include "../../src/settingsmanager.h"
+#include "../../src/packagesnapshot.h"
+#include "../../src/QtSolutions/qtlocalpeer.h"
 
 #include <QTimer>
 #include <QSystemTrayIcon>
@@ -11,6 +15,7 @@
 #include <QMenu>
 #include <QProcess>
 #include <QMessageBox>
+#include <memory>
 
 /*
  * This is Octopi Notifier slim interface code :-)
@@ -22,8 +27,15 @@
 MainWindow::MainWindow(QWidget *parent) :
     QMainWindow(parent)
 {
-  m_pacmanDatabaseSystemWatcher =
-            new QFileSystemWatcher(QStringList() << ctn_PACMAN_DATABASE_DIR, this);
+  m_numberOfOutdatedPackages = 0;
+  m_outdatedYaourtPackageList = 0;
+  m_pacmanDatabaseWatcher = new PacmanDatabaseWatcher(this);
+
+  //Octopi tells us through this peer when it has written a new package snapshot
+  m_localPeer = new QtLocalPeer(this, ctn_NOTIFIER_PEER_ID);
+  m_localPeer->isClient();
+  connect(m_localPeer, SIGNAL(messageReceived(QString)), this, SLOT(localPeerMessageReceived(QString)));
+
   initSystemTrayIcon();
 }
 
@@ -57,10 +69,18 @@ void MainWindow::initSystemTrayIcon()
   m_actionSystemUpgrade->setIcon(IconHelper::getIconSystemUpgrade());
   connect(m_actionSystemUpgrade, SIGNAL(triggered()), this, SLOT(runOctopiSysUpgrade()));
 
+  m_actionKeepOctopiReady = new QAction(this);
+  m_actionKeepOctopiReady->setText(tr("Keep Octopi ready"));
+  m_actionKeepOctopiReady->setCheckable(true);
+  m_actionKeepOctopiReady->setChecked(SettingsManager::getKeepOctopiReady());
+  connect(m_actionKeepOctopiReady, SIGNAL(toggled(bool)), this, SLOT(toggleKeepOctopiReady(bool)));
+
   m_systemTrayIconMenu = new QMenu( this );
   m_systemTrayIconMenu->addAction(m_actionOctopi);
   m_systemTrayIconMenu->addAction(m_actionSystemUpgrade);
   m_systemTrayIconMenu->addSeparator();
+  m_systemTrayIconMenu->addAction(m_actionKeepOctopiReady);
+  m_systemTrayIconMenu->addSeparator();
   m_systemTrayIconMenu->addAction(m_actionAbout);
   m_systemTrayIconMenu->addAction(m_actionExit);
   m_systemTrayIcon->setContextMenu(m_systemTrayIconMenu);
@@ -68,8 +88,13 @@ void MainWindow::initSystemTrayIcon()
   connect ( m_systemTrayIcon , SIGNAL( activated( QSystemTrayIcon::ActivationReason ) ),
             this, SLOT( execSystemTrayActivated ( QSystemTrayIcon::ActivationReason ) ) );
 
+  connect(m_pacmanDatabaseWatcher, SIGNAL(databaseChanged(QStringList,bool)),
+          this, SLOT(pacmanDatabaseChanged(QStringList,bool)));
+
   m_pacmanHelperClient = new PacmanHelperClient("org.octopi.pacmanhelper", "/", QDBusConnection::systemBus(), 0);
   connect(m_pacmanHelperClient, SIGNAL(syncdbcompleted()), this, SLOT(afterPacmanHelperSyncDatabase()));
+  connect(m_pacmanHelperClient, SIGNAL(syncdbprogress(QString,qlonglong,qlonglong)),
+          this, SLOT(pacmanHelperSyncProgress(QString,qlonglong,qlonglong)));
 
   m_pacmanHelperTimer = new QTimer();
   m_pacmanHelperTimer->setInterval(100);
@@ -80,50 +105,90 @@ void MainWindow::initSystemTrayIcon()
 
 /*
  * Execs Octopi
+ *
+ * If Octopi is already running (maybe hidden, see "Keep Octopi ready"), the command goes
+ * through its QtSingleApplication socket instead of starting a new process
  */
 void MainWindow::runOctopi(ExecOpt execOptions)
 {
+  bool octopiRunning = UnixCommand::isAppRunning("octopi", true);
+
   if (execOptions == ectn_SYSUPGRADE_NOCONFIRM_EXEC_OPT)
   {
-    if (!WMHelper::isKDERunning() && (!WMHelper::isRazorQtRunning()))
+    if (!octopiRunning || !_sendToOctopi("SYSUPGRADE_NOCONFIRM"))
     {
-      QProcess::startDetached("octopi -sysupgrade-noconfirm -style gtk");
-    }
-    else
-    {
-      QProcess::startDetached("octopi -sysupgrade-noconfirm");
+      _startOctopi("-sysupgrade-noconfirm");
     }
   }
   else if (execOptions == ectn_SYSUPGRADE_EXEC_OPT &&
-      !UnixCommand::isAppRunning("octopi", true) && m_outdatedPackageList->count() > 0)
+      !octopiRunning && m_outdatedPackageList->count() > 0)
   {
     doSystemUpgrade();
   }
   else if (execOptions == ectn_SYSUPGRADE_EXEC_OPT &&
-      UnixCommand::isAppRunning("octopi", true) && m_outdatedPackageList->count() > 0)
+      octopiRunning && m_outdatedPackageList->count() > 0)
   {
-    if (!WMHelper::isKDERunning() && (!WMHelper::isRazorQtRunning()))
-    {
-      QProcess::startDetached("octopi -sysupgrade -style gtk");
-    }
-    else
+    if (!_sendToOctopi("SYSUPGRADE"))
     {
-      QProcess::startDetached("octopi -sysupgrade");
+      _startOctopi("-sysupgrade");
     }
   }
   else if (execOptions == ectn_NORMAL_EXEC_OPT)
   {
-    if (!WMHelper::isKDERunning() && (!WMHelper::isRazorQtRunning()))
-    {
-      QProcess::startDetached("octopi -style gtk");
-    }
-    else
+    if (!octopiRunning || !_sendToOctopi("RAISE"))
     {
-      QProcess::startDetached("octopi");
+      _startOctopi();
     }
   }
 }
 
+/*
+ * Sends a command ("RAISE", "HIDE", "SYSUPGRADE", "INSTALL:pkg1,pkg2"...) to the running Octopi
+ * Returns false if no instance received it
+ */
+bool MainWindow::_sendToOctopi(const QString &message)
+{
+  QtLocalPeer peer(0, StrConstants::getApplicationName());
+  return peer.sendMessage(message, 2000);
+}
+
+/*
+ * Starts a new Octopi process with the given command line parameters
+ */
+void MainWindow::_startOctopi(const QString &parameters)
+{
+  QString command = "octopi";
+  if (!parameters.isEmpty()) command += " " + parameters;
+
+  if (!WMHelper::isKDERunning() && (!WMHelper::isRazorQtRunning()))
+  {
+    command += " -style gtk";
+  }
+
+  QProcess::startDetached(command);
+}
+
+/*
+ * If the user wants it, keeps a hidden Octopi instance with its package list already built,
+ * so commands from the tray don't pay for Octopi's startup
+ */
+void MainWindow::_keepOctopiReady()
+{
+  if (SettingsManager::getKeepOctopiReady() && !UnixCommand::isAppRunning("octopi", true))
+  {
+    _startOctopi("-hide");
+  }
+}
+
+/*
+ * Saves the "Keep Octopi ready" option and starts the hidden instance right away
+ */
+void MainWindow::toggleKeepOctopiReady(bool checked)
+{
+  SettingsManager::setKeepOctopiReady(checked);
+  _keepOctopiReady();
+}
+
 /*
  * Helper to a runOctopi with a call to SystemUpgrade
  */
@@ -139,7 +204,10 @@ void MainWindow::aboutOctopiNotifier()
 {
   QString aboutText = "<b>Octopi Notifier - " + StrConstants::getApplicationVersion() + "</b><br>";
   aboutText += "<a href=\"http://octopiproject.wordpress.com/\">http://octopiproject.wordpress.com</a><br><br>";
-  aboutText += "&copy; Alexandre Albuquerque Arnt";
+  aboutText += "&copy; Alexandre Albuquerque Arnt<br><br>";
+  aboutText += StrConstants::getNotifierMemoryUsage().arg(
+        QString::number(UpgradeIndex::getResidentSetSize() / (1024.0 * 1024.0), 'f', 1),
+        QString::number(m_upgradeIndex.getMemoryUsage() / 1024.0, 'f', 0));
 
   QMessageBox::about(this, StrConstants::getHelpAbout(), aboutText);
 }
@@ -148,8 +216,11 @@ void MainWindow::aboutOctopiNotifier()
  * Hides Octopi
  */
 void MainWindow::hideOctopi()
-{  
-  QProcess::startDetached("octopi -hide");
+{
+  if (!_sendToOctopi("HIDE"))
+  {
+    QProcess::startDetached("octopi -hide");
+  }
 }
 
 /*
@@ -278,6 +349,8 @@ void MainWindow::doSystemUpgradeFinished(int, QProcess::ExitStatus)
   m_commandExecuting = ectn_NONE;
   m_unixCommand->removeTemporaryActionFile();
   toggleEnableInterface(true);
+  _refreshPackageSnapshot();
+  _keepOctopiReady();
 }
 
 /*
@@ -304,6 +377,15 @@ void MainWindow::pacmanHelperTimerTimeout()
     firstTime=false;
   }
 
+  //If the databases were synced a moment ago (by Octopi or pacman), this sync is needless
+  if (m_lastSync.isValid() &&
+      m_lastSync.secsTo(QDateTime::currentDateTime()) < m_pacmanHelperTimer->interval() / 2000)
+  {
+    refreshAppIcon();
+    _keepOctopiReady();
+    return;
+  }
+
   m_actionOctopi->setEnabled(false);
 
   if (m_outdatedPackageList->count() > 0)
@@ -321,7 +403,52 @@ void MainWindow::pacmanHelperTimerTimeout()
   m_systemTrayIcon->setContextMenu(0);
 
   m_commandExecuting = ectn_SYNC_DATABASE;
-  m_pacmanHelperClient->syncdb();
+  m_syncProgress.clear();
+  m_systemTrayIcon->setToolTip(StrConstants::getSyncDatabases());
+
+  QDBusPendingCallWatcher *watcher =
+      new QDBusPendingCallWatcher(m_pacmanHelperClient->syncdbasync(), this);
+  connect(watcher, SIGNAL(finished(QDBusPendingCallWatcher*)),
+          this, SLOT(pacmanHelperSyncStarted(QDBusPendingCallWatcher*)));
+}
+
+/*
+ * The helper answered syncdbasync(): the sync is running, or it didn't start at all
+ */
+void MainWindow::pacmanHelperSyncStarted(QDBusPendingCallWatcher *watcher)
+{
+  QDBusPendingReply<bool> reply = *watcher;
+  watcher->deleteLater();
+
+  //An older helper only knows the blocking syncdb()
+  if (reply.isError())
+  {
+    m_pacmanHelperClient->syncdb();
+  }
+  //pacman's database is locked (or a sync is already running): there's nothing to wait for
+  else if (!reply.value())
+  {
+    afterPacmanHelperSyncDatabase();
+  }
+}
+
+/*
+ * Shows how much of the repository databases was downloaded so far
+ */
+void MainWindow::pacmanHelperSyncProgress(const QString &repository, qlonglong received, qlonglong)
+{
+  if (m_commandExecuting != ectn_SYNC_DATABASE) return;
+
+  m_syncProgress.insert(repository, received);
+
+  qlonglong total = 0;
+  foreach (qlonglong bytes, m_syncProgress)
+  {
+    total += bytes;
+  }
+
+  m_systemTrayIcon->setToolTip(StrConstants::getSyncDatabases() + " " +
+                               QString::number(total / 1024) + " KiB");
 }
 
 /*
@@ -329,16 +456,19 @@ void MainWindow::pacmanHelperTimerTimeout()
  */
 void MainWindow::afterPacmanHelperSyncDatabase()
 {
+  //Picks the new databases up now instead of after the watcher's settle interval
+  m_pacmanDatabaseWatcher->poll();
+  m_lastSync = QDateTime::currentDateTime();
+
   m_actionOctopi->setEnabled(true);
   m_systemTrayIcon->setContextMenu(m_systemTrayIconMenu);
   m_systemTrayIconMenu->close();
   m_commandExecuting = ectn_NONE;
 
-  disconnect(m_pacmanDatabaseSystemWatcher,
-          SIGNAL(directoryChanged(QString)), this, SLOT(refreshAppIcon()));
-
   int numberOfOutdatedPackages = m_numberOfOutdatedPackages;
   refreshAppIcon();
+  _refreshPackageSnapshot();
+  _keepOctopiReady();
 
   if (numberOfOutdatedPackages != m_numberOfOutdatedPackages)
   {
@@ -377,9 +507,50 @@ void MainWindow::afterPacmanHelperSyncDatabase()
       if (!UnixCommand::isAppRunning("spun", true)) sendNotification(notification);
     }
   }
+}
+
+/*
+ * Whenever pacman has finished changing its databases, drops what was loaded from the changed ones
+ */
+void MainWindow::pacmanDatabaseChanged(const QStringList &repositories, bool local)
+{
+  foreach(QString repository, repositories)
+  {
+    m_upgradeIndex.removeSyncPackages(repository);
+  }
+
+  if (local) m_upgradeIndex.clearInstalledPackages();
+
+  //Someone else synced the databases
+  if (!repositories.isEmpty() && m_commandExecuting != ectn_SYNC_DATABASE)
+    m_lastSync = QDateTime::currentDateTime();
+
+  if (m_commandExecuting == ectn_NONE)
+  {
+    refreshAppIcon();
+    _refreshPackageSnapshot();
+  }
+}
+
+/*
+ * Octopi has written a new package snapshot, so pacman's databases have probably changed
+ */
+void MainWindow::localPeerMessageReceived(const QString &message)
+{
+  if (message == "SNAPSHOT") m_pacmanDatabaseWatcher->poll();
+}
+
+/*
+ * Unless Octopi (or we) already did it for the current databases, writes the package snapshot
+ * so Octopi starts without querying pacman
+ */
+void MainWindow::_refreshPackageSnapshot()
+{
+  if (PackageSnapshot::isFileCurrent()) return;
 
-  connect(m_pacmanDatabaseSystemWatcher,
-          SIGNAL(directoryChanged(QString)), this, SLOT(refreshAppIcon()));
+  const std::auto_ptr<const PackageSnapshot> snapshot(PackageSnapshot::create());
+  if (snapshot.get() != NULL && snapshot->write() && UnixCommand::isAppRunning("octopi", true))
+    PackageSnapshot::notify(StrConstants::getApplicationName());
 }
 
 /*
@@ -396,13 +567,53 @@ void MainWindow::sendNotification(const QString &msg)
   }
 }
 
+/*
+ * Recomputes the outdated package list, querying pacman only for the databases which are not loaded
+ */
+void MainWindow::_refreshOutdatedPackages()
+{
+  //Like pacman, we look at the repositories in pacman.conf order
+  QStringList repositories = UnixCommand::getRepositoryList();
+
+  if (repositories.isEmpty())
+  {
+    const std::auto_ptr<const OutdatedPackages> outdatedPackages(Package::getOutdatedPackages());
+    delete m_outdatedPackageList;
+    m_outdatedPackageList = new QStringList(outdatedPackages->outdated);
+    return;
+  }
+
+  if (!m_upgradeIndex.hasInstalledPackages())
+    m_upgradeIndex.setInstalledPackages(UnixCommand::getInstalledPackageVersionList());
+
+  foreach(QString repository, repositories)
+  {
+    if (!m_upgradeIndex.hasSyncPackages(repository))
+      m_upgradeIndex.setSyncPackages(repository, UnixCommand::getSyncPackageVersionList(repository));
+  }
+
+  foreach(QString repository, m_upgradeIndex.getRepositories())
+  {
+    if (!repositories.contains(repository)) m_upgradeIndex.removeSyncPackages(repository);
+  }
+
+  QStringList ignorePkgList = UnixCommand::getIgnorePkg() + SettingsManager::getFrozenPkgList();
+  delete m_outdatedPackageList;
+  m_outdatedPackageList = new QStringList(m_upgradeIndex.getOutdatedPackages(repositories, ignorePkgList));
+
+  //Over budget, the repositories are read again on every refresh instead of being kept around
+  if (m_upgradeIndex.getMemoryUsage() > UpgradeIndex::ctn_MEMORY_BUDGET)
+    m_upgradeIndex.clearSyncPackages();
+}
+
 /*
  * If we have some outdated packages, let's put an angry red face icon in this app!
  */
 void MainWindow::refreshAppIcon()
 {
-  m_outdatedPackageList = Package::getOutdatedPackageList();
+  _refreshOutdatedPackages();
 
+  delete m_outdatedYaourtPackageList;
   bool hasYaourt = UnixCommand::hasTheExecutable(StrConstants::getForeignRepositoryToolName());
   if (hasYaourt)
   {
@@ -508,6 +719,11 @@ void MainWindow::execSystemTrayActivated(QSystemTrayIcon::ActivationReason ar)
  */
 void MainWindow::exitNotifier()
 {
+  if (m_commandExecuting == ectn_SYNC_DATABASE)
+  {
+    m_pacmanHelperClient->cancelsyncdb().waitForFinished();
+  }
+
   if (UnixCommand::isAppRunning("octopi", true))
   {    
     QProcess::startDetached("octopi -close");
@@ -2,7 +2,10 @@
 #define MAINWINDOW_H
 
 #include "../../src/unixcommand.h"
+#include "../../src/upgradeindex.h"
 
+#include <QDateTime>
+#include <QMap>
 #include <QProcess>
 #include <QString>
 #include <QMainWindow>
@@ -11,8 +14,10 @@
 class QIcon;
 class QMenu;
 class QAction;
-class QFileSystemWatcher;
+class PacmanDatabaseWatcher;
 class PacmanHelperClient;
+class QtLocalPeer;
+class QDBusPendingCallWatcher;
 
 enum ExecOpt { ectn_NORMAL_EXEC_OPT, ectn_SYSUPGRADE_EXEC_OPT, ectn_SYSUPGRADE_NOCONFIRM_EXEC_OPT };
 
@@ -28,10 +33,15 @@ private slots:
 
   void pacmanHelperTimerTimeout();
   void afterPacmanHelperSyncDatabase();
+  void pacmanHelperSyncStarted(QDBusPendingCallWatcher *watcher);
+  void pacmanHelperSyncProgress(const QString &repository, qlonglong received, qlonglong total);
+  void pacmanDatabaseChanged(const QStringList &repositories, bool local);
+  void localPeerMessageReceived(const QString &message);
   void execSystemTrayActivated(QSystemTrayIcon::ActivationReason);
   void refreshAppIcon();
   void runOctopi(ExecOpt execOptions = ectn_SYSUPGRADE_EXEC_OPT);
   void runOctopiSysUpgrade();
+  void toggleKeepOctopiReady(bool checked);
 
   inline void startOctopi() { runOctopi(ectn_NORMAL_EXEC_OPT); }
 
@@ -52,6 +62,7 @@ private:
 
   QAction *m_actionOctopi;
   QAction *m_actionSystemUpgrade;
+  QAction *m_actionKeepOctopiReady;
   QAction *m_actionAbout;
   QAction *m_actionExit;
   QIcon m_icon;
@@ -60,10 +71,23 @@ private:
   QTimer *m_pacmanHelperTimer;
   QSystemTrayIcon *m_systemTrayIcon;
   QMenu *m_systemTrayIconMenu;
-  QFileSystemWatcher *m_pacmanDatabaseSystemWatcher;
+  PacmanDatabaseWatcher *m_pacmanDatabaseWatcher;
   PacmanHelperClient *m_pacmanHelperClient;
+  QtLocalPeer *m_localPeer;
+
+  //Package versions of every repository, reloaded only for repositories whose database changed
+  UpgradeIndex m_upgradeIndex;
+  QDateTime m_lastSync;
+
+  //Bytes received so far of every repository database being synced
+  QMap<QString, qlonglong> m_syncProgress;
 
   bool _isSUAvailable();
+  void _refreshOutdatedPackages();
+  void _refreshPackageSnapshot();
+  bool _sendToOctopi(const QString &message);
+  void _startOctopi(const QString &parameters = QString());
+  void _keepOctopiReady();
   void initSystemTrayIcon();
   void sendNotification(const QString &msg);
 };
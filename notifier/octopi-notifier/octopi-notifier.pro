@@ -22,9 +22,14 @@ SOURCES += main.cpp \
     mainwindow.cpp \
     ../../src/unixcommand.cpp \
     ../../src/package.cpp \
+    ../../src/versionkey.cpp \
     ../../src/wmhelper.cpp \
     ../../src/settingsmanager.cpp \
     ../../src/pacmanhelperclient.cpp \
+    ../../src/pacmandatabasewatcher.cpp \
+    ../../src/upgradeindex.cpp \
+    ../../src/packagesnapshot.cpp \
+    ../../src/QtSolutions/qtlocalpeer.cpp \
     ../../src/utils/processwrapper.cpp \
     ../../src/transactiondialog.cpp
 
@@ -35,7 +40,12 @@ HEADERS  += \
     ../../src/wmhelper.h \
     ../../src/strconstants.h \
     ../../src/package.h \
+    ../../src/versionkey.h \
     ../../src/pacmanhelperclient.h \
+    ../../src/pacmandatabasewatcher.h \
+    ../../src/upgradeindex.h \
+    ../../src/packagesnapshot.h \
+    ../../src/QtSolutions/qtlocalpeer.h \
     ../../src/utils/processwrapper.h \
     ../../src/transactiondialog.h
 
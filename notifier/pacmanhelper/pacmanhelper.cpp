@@ -1,5 +1,6 @@
 #include "pacmanhelper.h"
 #include "pacmanhelperadaptor.h"
+#include "repositorysync.h"
 #include <QCoreApplication>
 #include <QDBusConnection>
 #include <QProcess>
@@ -10,6 +11,13 @@ PacmanHelper::PacmanHelper(QObject *parent) :
 {
   (void) new PacmanHelperAdaptor(this);
 
+  m_repositorySync = new RepositorySync(this);
+  connect(m_repositorySync, SIGNAL(progress(QString,qlonglong,qlonglong)),
+          this, SIGNAL(syncdbprogress(QString,qlonglong,qlonglong)));
+  connect(m_repositorySync, SIGNAL(repositoryFinished(QString,int)),
+          this, SIGNAL(syncdbrepositorycompleted(QString,int)));
+  connect(m_repositorySync, SIGNAL(finished()), this, SIGNAL(syncdbcompleted()));
+
   if (!QDBusConnection::systemBus().registerService("org.octopi.pacmanhelper")) {
       qDebug() << "Another helper is already running!";
       QCoreApplication::instance()->quit();
@@ -33,3 +41,21 @@ void PacmanHelper::syncdb()
 
   emit syncdbcompleted();
 }
+
+/*
+ * Downloads the databases of all repositories at once, skipping the ones not changed on the server.
+ * Returns right away: syncdbprogress and syncdbrepositorycompleted tell how it goes, syncdbcompleted
+ * comes at the end. Returns false (and no signal comes) if a sync is running or pacman's database is locked
+ */
+bool PacmanHelper::syncdbasync()
+{
+  return m_repositorySync->start();
+}
+
+/*
+ * Stops the syncdbasync downloads: the repositories not done yet end as cancelled
+ */
+void PacmanHelper::cancelsyncdb()
+{
+  m_repositorySync->cancel();
+}
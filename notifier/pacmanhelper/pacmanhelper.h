@@ -4,6 +4,8 @@
 #include <QObject>
 #include <QtDBus/QDBusContext>
 
+class RepositorySync;
+
 class PacmanHelper : public QObject, protected QDBusContext
 {
   Q_OBJECT
@@ -13,9 +15,16 @@ public:
   
 public slots:
   void syncdb();
+  bool syncdbasync();
+  void cancelsyncdb();
 
 signals:
   void syncdbcompleted();
+  void syncdbprogress(const QString &repository, qlonglong received, qlonglong total);
+  void syncdbrepositorycompleted(const QString &repository, int result);
+
+private:
+  RepositorySync *m_repositorySync;
 };
 
 #endif // PACMANHELPER_H
@@ -4,7 +4,7 @@
 #
 #-------------------------------------------------
 
-QT += core dbus
+QT += core dbus network
 
 CONFIG += qt console warn_on
 
@@ -16,8 +16,10 @@ MOC_DIR += ../build
 UI_DIR += ../build
 
 HEADERS += pacmanhelper.h \
-    pacmanhelperadaptor.h
+    pacmanhelperadaptor.h \
+    repositorysync.h
 
 SOURCES += main.cpp \
     pacmanhelper.cpp \
-    pacmanhelperadaptor.cpp
+    pacmanhelperadaptor.cpp \
+    repositorysync.cpp
@@ -33,9 +33,23 @@ PacmanHelperAdaptor::~PacmanHelperAdaptor()
     // destructor
 }
 
+void PacmanHelperAdaptor::cancelsyncdb()
+{
+    // handle method call org.octopi.pacmanhelper.cancelsyncdb
+    QMetaObject::invokeMethod(parent(), "cancelsyncdb");
+}
+
 void PacmanHelperAdaptor::syncdb()
 {
     // handle method call org.octopi.pacmanhelper.syncdb
     QMetaObject::invokeMethod(parent(), "syncdb");
 }
 
+bool PacmanHelperAdaptor::syncdbasync()
+{
+    // handle method call org.octopi.pacmanhelper.syncdbasync
+    bool out0;
+    QMetaObject::invokeMethod(parent(), "syncdbasync", Q_RETURN_ARG(bool, out0));
+    return out0;
+}
+
@@ -31,7 +31,20 @@ class PacmanHelperAdaptor: public QDBusAbstractAdaptor
     Q_CLASSINFO("D-Bus Introspection", ""
 "  <interface name=\"org.octopi.pacmanhelper\">\n"
 "    <method name=\"syncdb\"/>\n"
+"    <method name=\"syncdbasync\">\n"
+"      <arg direction=\"out\" type=\"b\"/>\n"
+"    </method>\n"
+"    <method name=\"cancelsyncdb\"/>\n"
 "    <signal name=\"syncdbcompleted\"/>\n"
+"    <signal name=\"syncdbprogress\">\n"
+"      <arg direction=\"out\" type=\"s\" name=\"repository\"/>\n"
+"      <arg direction=\"out\" type=\"x\" name=\"received\"/>\n"
+"      <arg direction=\"out\" type=\"x\" name=\"total\"/>\n"
+"    </signal>\n"
+"    <signal name=\"syncdbrepositorycompleted\">\n"
+"      <arg direction=\"out\" type=\"s\" name=\"repository\"/>\n"
+"      <arg direction=\"out\" type=\"i\" name=\"result\"/>\n"
+"    </signal>\n"
 "  </interface>\n"
         "")
 public:
@@ -40,9 +53,13 @@ public:
 
 public: // PROPERTIES
 public Q_SLOTS: // METHODS
+    void cancelsyncdb();
     void syncdb();
+    bool syncdbasync();
 Q_SIGNALS: // SIGNALS
     void syncdbcompleted();
+    void syncdbprogress(const QString &repository, qlonglong received, qlonglong total);
+    void syncdbrepositorycompleted(const QString &repository, int result);
 };
 
 #endif
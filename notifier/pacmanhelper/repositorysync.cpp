@@ -0,0 +1,353 @@
+/*
+* This file is part of Octopi, an open-source GUI for pacman.
+* Copyright (C) 2014 Thomas Binkau
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*
+*/
+
+#include "repositorysync.h"
+
+#include <fcntl.h>
+#include <sys/utsname.h>
+#include <unistd.h>
+#include <utime.h>
+#include <cstdio>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QLocale>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <QTextStream>
+#include <QTimer>
+
+
+namespace {
+
+const int ctn_MAX_REDIRECTS = 5;
+
+/**
+ * @brief "Architecture" of pacman.conf, "auto" (or nothing) being the machine's one
+ */
+QString getArchitecture(const QString& confValue)
+{
+  const QString arch = confValue.section(' ', 0, 0, QString::SectionSkipEmpty);
+  if (!arch.isEmpty() && arch != "auto") return arch;
+
+  struct utsname name;
+  if (uname(&name) != 0) return QString();
+  return QString::fromLatin1(name.machine);
+}
+
+/**
+ * @brief splits a pacman.conf line into key and value, false for comments, blank lines and sections
+ */
+bool parseLine(QString line, QString& key, QString& value)
+{
+  const int comment = line.indexOf('#');
+  if (comment != -1) line.truncate(comment);
+  line = line.trimmed();
+  if (line.isEmpty() || line.startsWith('[')) return false;
+
+  key   = line.section('=', 0, 0).trimmed();
+  value = line.section('=', 1).trimmed();
+  return true;
+}
+
+/**
+ * @brief the "Server" lines of a mirrorlist
+ */
+QStringList readServers(const QString& fileName)
+{
+  QStringList result;
+  QFile file(fileName);
+  if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) return result;
+
+  QTextStream in(&file);
+  QString key, value;
+  while (!in.atEnd()) {
+    if (parseLine(in.readLine(), key, value) && key == "Server") result.append(value);
+  }
+  return result;
+}
+
+/**
+ * @brief RFC 1123 date, as HTTP wants it
+ */
+QByteArray toHttpDate(const QDateTime& time)
+{
+  return QLocale::c().toString(time.toUTC(), "ddd, dd MMM yyyy hh:mm:ss").toLatin1() + " GMT";
+}
+
+} // namespace
+
+
+RepositorySync::RepositorySync(QObject* parent, const QString& pacmanConf, const QString& dbPath)
+  : QObject(parent), m_pacmanConf(pacmanConf), m_lockFile(dbPath + "/db.lck"), m_syncDir(dbPath + "/sync"),
+    m_manager(new QNetworkAccessManager(this)), m_timeout(new QTimer(this)), m_pending(0), m_cancelled(false)
+{
+  m_timeout->setSingleShot(true);
+  m_timeout->setInterval(ctn_SYNC_TIMEOUT);
+  connect(m_timeout, SIGNAL(timeout()), this, SLOT(onTimeout()));
+}
+
+RepositorySync::~RepositorySync()
+{
+  if (isRunning()) QFile::remove(m_lockFile);
+}
+
+bool RepositorySync::start()
+{
+  if (isRunning()) return false;
+
+  readPacmanConf();
+  if (m_repositories.isEmpty()) return false;
+
+  // the same lock pacman takes, so neither runs while the other writes the databases
+  const int lock = ::open(QFile::encodeName(m_lockFile).constData(), O_WRONLY | O_CREAT | O_EXCL, 0000);
+  if (lock == -1) return false;
+  ::close(lock);
+
+  QDir().mkpath(m_syncDir);
+  m_cancelled = false;
+  m_pending   = m_repositories.size();
+  m_timeout->start();
+
+  for (int repository = 0; repository < m_repositories.size(); ++repository) {
+    m_repositories[repository].server = -1;
+    requestNextServer(repository);
+  }
+  return true;
+}
+
+void RepositorySync::cancel()
+{
+  if (!isRunning()) return;
+
+  m_cancelled = true;
+  // aborting emits finished(), which takes the reply out of m_replies
+  const QList<QNetworkReply*> replies = m_replies.keys();
+  for (QList<QNetworkReply*>::const_iterator it = replies.begin(); it != replies.end(); ++it) (*it)->abort();
+}
+
+void RepositorySync::onDownloadProgress(qint64 received, qint64 total)
+{
+  QNetworkReply*const reply = qobject_cast<QNetworkReply*>(sender());
+  if (reply == NULL || !m_replies.contains(reply)) return;
+
+  const TRepository& repository = m_repositories[m_replies.value(reply)];
+  if (!repository.signature) emit progress(repository.name, received, total);
+}
+
+void RepositorySync::onReplyFinished()
+{
+  QNetworkReply*const reply = qobject_cast<QNetworkReply*>(sender());
+  if (reply == NULL || !m_replies.contains(reply)) return;
+
+  const int index = m_replies.take(reply);
+  reply->deleteLater();
+  TRepository& repository = m_repositories[index];
+
+  if (m_cancelled) {
+    discardParts(repository.name);
+    finish(index, ectn_REPOSITORY_CANCELLED);
+    return;
+  }
+
+  const QUrl redirect = reply->attribute(QNetworkRequest::RedirectionTargetAttribute).toUrl();
+  if (reply->error() == QNetworkReply::NoError && redirect.isValid() && repository.redirects < ctn_MAX_REDIRECTS) {
+    ++repository.redirects;
+    request(index, reply->url().resolved(redirect));
+    return;
+  }
+
+  const int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+  const bool received = reply->error() == QNetworkReply::NoError && (status == 0 || status == 200);
+  const QString fileName = m_syncDir + "/" + repository.name + (repository.signature ? ".db.sig" : ".db");
+
+  if (repository.signature) {
+    // the mirror has no signature for the new database, an old one would not match it
+    if (status == 404 && commit(repository.name, false)) {
+      finish(index, ectn_REPOSITORY_UPDATED);
+    }
+    else if (received && savePart(reply, fileName) && commit(repository.name, true)) {
+      finish(index, ectn_REPOSITORY_UPDATED);
+    }
+    else {
+      discardParts(repository.name);
+      requestNextServer(index);
+    }
+    return;
+  }
+
+  if (status == 304) {
+    finish(index, ectn_REPOSITORY_UNCHANGED);
+    return;
+  }
+  if (!received || !savePart(reply, fileName)) {
+    discardParts(repository.name);
+    requestNextServer(index);
+    return;
+  }
+
+  repository.signature = true;
+  repository.redirects = 0;
+  request(index, QUrl(repository.servers.at(repository.server) + "/" + repository.name + ".db.sig"));
+}
+
+void RepositorySync::onTimeout()
+{
+  cancel();
+}
+
+/**
+ * @brief reads the repositories and their servers (direct or from Include files) out of pacman.conf
+ */
+void RepositorySync::readPacmanConf()
+{
+  m_repositories.clear();
+
+  QFile file(m_pacmanConf);
+  if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) return;
+
+  QString arch;
+  QString section;
+  QTextStream in(&file);
+  while (!in.atEnd()) {
+    const QString line = in.readLine().trimmed();
+    if (line.startsWith('[')) {
+      section = line.mid(1, line.indexOf(']') - 1).trimmed();
+      if (section != "options") {
+        TRepository repository;
+        repository.name      = section;
+        repository.server    = -1;
+        repository.redirects = 0;
+        repository.signature = false;
+        m_repositories.append(repository);
+      }
+      continue;
+    }
+
+    QString key, value;
+    if (!parseLine(line, key, value)) continue;
+
+    if (section == "options") {
+      if (key == "Architecture") arch = value;
+    }
+    else if (!m_repositories.isEmpty()) {
+      if (key == "Server") m_repositories.last().servers.append(value);
+      else if (key == "Include") m_repositories.last().servers += readServers(value);
+    }
+  }
+
+  arch = getArchitecture(arch);
+  for (QList<TRepository>::iterator it = m_repositories.begin(); it != m_repositories.end(); ++it) {
+    for (QStringList::iterator itServer = it->servers.begin(); itServer != it->servers.end(); ++itServer) {
+      itServer->replace("$repo", it->name).replace("$arch", arch);
+    }
+  }
+}
+
+void RepositorySync::request(int repository, const QUrl& url)
+{
+  QNetworkRequest request(url);
+
+  const TRepository& repo = m_repositories.at(repository);
+  const QFileInfo local(m_syncDir + "/" + repo.name + ".db");
+  if (!repo.signature && local.exists()) request.setRawHeader("If-Modified-Since", toHttpDate(local.lastModified()));
+
+  QNetworkReply*const reply = m_manager->get(request);
+  m_replies.insert(reply, repository);
+  connect(reply, SIGNAL(downloadProgress(qint64,qint64)), this, SLOT(onDownloadProgress(qint64,qint64)));
+  connect(reply, SIGNAL(finished()), this, SLOT(onReplyFinished()));
+}
+
+void RepositorySync::requestNextServer(int repository)
+{
+  TRepository& repo = m_repositories[repository];
+  ++repo.server;
+  repo.redirects = 0;
+  repo.signature = false;
+
+  if (repo.server >= repo.servers.size()) {
+    finish(repository, ectn_REPOSITORY_FAILED);
+    return;
+  }
+  request(repository, QUrl(repo.servers.at(repo.server) + "/" + repo.name + ".db"));
+}
+
+void RepositorySync::finish(int repository, int result)
+{
+  emit repositoryFinished(m_repositories.at(repository).name, result);
+
+  if (--m_pending > 0) return;
+  m_timeout->stop();
+  QFile::remove(m_lockFile);
+  emit finished();
+}
+
+/**
+ * @brief writes the downloaded data to "%fileName.part", mtime set to the server's Last-Modified
+ */
+bool RepositorySync::savePart(QNetworkReply* reply, const QString& fileName)
+{
+  const QString partName = fileName + ".part";
+  QFile part(partName);
+  if (!part.open(QIODevice::WriteOnly | QIODevice::Truncate)) return false;
+
+  const QByteArray data = reply->readAll();
+  const bool written = part.write(data) == data.size();
+  part.close();
+  if (!written) return false;
+
+  // rename keeps the mtime, so the database gets it when it is committed
+  const QDateTime lastModified = reply->header(QNetworkRequest::LastModifiedHeader).toDateTime();
+  if (lastModified.isValid()) {
+    struct utimbuf times;
+    times.actime  = lastModified.toTime_t();
+    times.modtime = lastModified.toTime_t();
+    utime(QFile::encodeName(partName).constData(), &times);
+  }
+  return true;
+}
+
+/**
+ * @brief moves the downloaded database (and its signature) of %repository in place, one rename each
+ *
+ * Without %withSignature an old signature is removed, as it belongs to the old database.
+ */
+bool RepositorySync::commit(const QString& repository, bool withSignature)
+{
+  const QString dbName  = m_syncDir + "/" + repository + ".db";
+  const QString sigName = dbName + ".sig";
+
+  if (std::rename(QFile::encodeName(dbName + ".part").constData(), QFile::encodeName(dbName).constData()) != 0) {
+    return false;
+  }
+  if (!withSignature ||
+      std::rename(QFile::encodeName(sigName + ".part").constData(), QFile::encodeName(sigName).constData()) != 0) {
+    QFile::remove(sigName);
+  }
+  return true;
+}
+
+void RepositorySync::discardParts(const QString& repository)
+{
+  QFile::remove(m_syncDir + "/" + repository + ".db.part");
+  QFile::remove(m_syncDir + "/" + repository + ".db.sig.part");
+}
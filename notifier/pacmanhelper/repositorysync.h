@@ -0,0 +1,122 @@
+/*
+* This file is part of Octopi, an open-source GUI for pacman.
+* Copyright (C) 2014 Thomas Binkau
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*
+*/
+
+#ifndef OCTOPI_REPOSITORYSYNC_H
+#define OCTOPI_REPOSITORYSYNC_H
+
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QUrl>
+
+class QNetworkAccessManager;
+class QNetworkReply;
+class QTimer;
+
+const QString ctn_PACMAN_CONF = "/etc/pacman.conf";
+const QString ctn_PACMAN_DB_PATH = "/var/lib/pacman"; // holds db.lck and the sync directory
+const int ctn_SYNC_TIMEOUT = 5 * 60 * 1000; // a hanging mirror must not keep the lock forever
+
+
+/**
+ * @brief Downloads the sync databases of every repository in pacman.conf at the same time
+ *
+ * Works like "pacman -Sy": every database is requested with If-Modified-Since set to the
+ * mtime of the local copy, so unchanged repositories cost one 304 response. New databases
+ * get the server's Last-Modified as mtime, as pacman does. Failed downloads move on to the
+ * next Server of the repository. pacman's lock file is held while the sync runs.
+ *
+ * A new database and its signature are downloaded to ".part" files from the same server, and
+ * both replace the old files only after both arrived. That way pacman never sees a database
+ * with the signature of another one. A mirror without a signature (404) removes the old one.
+ */
+class RepositorySync : public QObject
+{
+  Q_OBJECT
+
+public:
+  enum ERepositoryResult {
+    ectn_REPOSITORY_UPDATED = 0,
+    ectn_REPOSITORY_UNCHANGED = 1,
+    ectn_REPOSITORY_FAILED = 2,
+    ectn_REPOSITORY_CANCELLED = 3
+  };
+
+public:
+  /**
+   * @param pacmanConf = pacman.conf to read the repositories from
+   * @param dbPath = pacman's DBPath, the databases go to its "sync" directory
+   */
+  explicit RepositorySync(QObject* parent = 0, const QString& pacmanConf = ctn_PACMAN_CONF,
+                          const QString& dbPath = ctn_PACMAN_DB_PATH);
+  ~RepositorySync();
+
+  inline bool isRunning() const {
+    return m_pending > 0;
+  }
+
+  /**
+   * @brief starts the downloads, false if a sync is running or pacman's database is locked
+   */
+  bool start();
+  void cancel();
+
+signals:
+  void progress(const QString& repository, qlonglong received, qlonglong total);
+  void repositoryFinished(const QString& repository, int result);
+  void finished();
+
+private slots:
+  void onDownloadProgress(qint64 received, qint64 total);
+  void onReplyFinished();
+  void onTimeout();
+
+private:
+  struct TRepository {
+    QString     name;
+    QStringList servers;     // with $repo and $arch already replaced
+    int         server;      // the one being tried
+    int         redirects;
+    bool        signature;   // downloading "<repo>.db.sig" after "<repo>.db.part" arrived
+  };
+
+  void readPacmanConf();
+  void request(int repository, const QUrl& url);
+  void requestNextServer(int repository);
+  void finish(int repository, int result);
+  bool savePart(QNetworkReply* reply, const QString& fileName);
+  bool commit(const QString& repository, bool withSignature);
+  void discardParts(const QString& repository);
+
+private:
+  const QString                 m_pacmanConf;
+  const QString                 m_lockFile;
+  const QString                 m_syncDir;
+  QNetworkAccessManager*        m_manager;
+  QTimer*                       m_timeout;
+  QList<TRepository>            m_repositories;
+  QHash<QNetworkReply*, int>    m_replies; // reply -> index in m_repositories
+  int                           m_pending;
+  bool                          m_cancelled;
+};
+
+#endif // OCTOPI_REPOSITORYSYNC_H
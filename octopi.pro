@@ -43,8 +43,22 @@ HEADERS  += src/QtSolutions/qtsingleapplication.h \
         src/multiselectiondialog.h \
         src/utils/processwrapper.h \
         src/packagerepository.h \
+        src/versionkey.h \
+        src/dependencygraph.h \
+        src/removalimpact.h \
+        src/transactionresolver.h \
+        src/transactionestimator.h \
+        src/transactionqueue.h \
+        src/transactionchecker.h \
+        src/outputparser.h \
+        src/outputsink.h \
+        src/transactionprogress.h \
+        src/textsearchindex.h \
+        src/pacmandatabasewatcher.h \
+        src/packagesnapshot.h \
+        src/newsfeed.h \
         src/model/packagemodel.h \
-        src/model/packageitem.h \
+        src/model/packagetree.h \
         src/ui/octopitabinfo.h
 
 SOURCES += src/QtSolutions/qtsingleapplication.cpp \
@@ -77,8 +91,22 @@ SOURCES += src/QtSolutions/qtsingleapplication.cpp \
         src/multiselectiondialog.cpp \
         src/utils/processwrapper.cpp \
         src/packagerepository.cpp \
+        src/versionkey.cpp \
+        src/dependencygraph.cpp \
+        src/removalimpact.cpp \
+        src/transactionresolver.cpp \
+        src/transactionestimator.cpp \
+        src/transactionqueue.cpp \
+        src/transactionchecker.cpp \
+        src/outputparser.cpp \
+        src/outputsink.cpp \
+        src/transactionprogress.cpp \
+        src/textsearchindex.cpp \
+        src/pacmandatabasewatcher.cpp \
+        src/packagesnapshot.cpp \
+        src/newsfeed.cpp \
         src/model/packagemodel.cpp \
-        src/model/packageitem.cpp \
+        src/model/packagetree.cpp \
         src/ui/octopitabinfo.cpp
 
 FORMS   += ui/mainwindow.ui \
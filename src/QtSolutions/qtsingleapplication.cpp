@@ -353,7 +353,15 @@ void QtSingleApplication::activateWindow(const QString &message)
 
     if (mw)
     {
-      if (!mw->isExecutingCommand())
+      //A hidden instance may still be building its package list: upgrade as soon as it's done
+      if (!mw->isInitializationCompleted())
+      {
+        if (message == "SYSUPGRADE")
+          mw->setCallSystemUpgrade();
+        else
+          mw->setCallSystemUpgradeNoConfirm();
+      }
+      else if (!mw->isExecutingCommand())
       {
         if (message == "SYSUPGRADE")
         {
@@ -378,6 +386,33 @@ void QtSingleApplication::activateWindow(const QString &message)
       }
     }
   }
+  else if (actWin && message == "SNAPSHOT") {
+    MainWindow *mw = qobject_cast<MainWindow *>(actWin);
+    if (mw) mw->reloadPackageSnapshot();
+  }
+  else if (actWin && message.startsWith("INSTALL:")) {
+    actWin->setWindowState(actWin->windowState() & ~Qt::WindowMinimized);
+    actWin->raise();
+    if (actWin->isHidden())
+      actWin->show();
+    else
+      actWin->activateWindow();
+
+    QStringList packagesToInstallList =
+        message.mid(QString("INSTALL:").length()).split(",", QString::SkipEmptyParts);
+
+    MainWindow *mw = qobject_cast<MainWindow *>(actWin);
+
+    if (mw)
+    {
+      mw->setRepositoryPackagesToInstallList(packagesToInstallList);
+
+      if (mw->isInitializationCompleted() && !mw->isExecutingCommand())
+      {
+        mw->doInstallRepositoryPackages();
+      }
+    }
+  }
   else if (actWin && message.contains("pkg.tar.xz")) {
     actWin->setWindowState(actWin->windowState() & ~Qt::WindowMinimized);
     actWin->raise();
@@ -0,0 +1,606 @@
+/*
+* This file is part of Octopi, an open-source GUI for pacman.
+* Copyright (C) 2014 Thomas Binkau
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*
+*/
+
+#include "dependencygraph.h"
+
+#include <algorithm>
+#include <QSet>
+
+#include "package.h"
+#include "unixcommand.h"
+
+
+namespace {
+
+/**
+ * @brief The fields of one "pacman -Qi" / "pacman -Si" record we are interested in
+ */
+struct TInfoRecord {
+  TInfoRecord() : installedSize(0), downloadSize(0), explicitlyInstalled(false) {}
+
+  QString     name;
+  QString     version;
+  QString     repository;
+  QStringList depends;
+  QStringList optDepends;
+  QStringList provides;
+  QStringList conflicts;
+  QStringList replaces;
+  QStringList groups;
+  double      installedSize; // KiB
+  double      downloadSize;  // KiB
+  bool        explicitlyInstalled;
+};
+
+enum EInfoField {
+  ectn_FIELD_OTHER,
+  ectn_FIELD_NAME,
+  ectn_FIELD_VERSION,
+  ectn_FIELD_REPOSITORY,
+  ectn_FIELD_DEPENDS,
+  ectn_FIELD_OPTDEPENDS,
+  ectn_FIELD_PROVIDES,
+  ectn_FIELD_CONFLICTS,
+  ectn_FIELD_REPLACES,
+  ectn_FIELD_GROUPS,
+  ectn_FIELD_INSTALLED_SIZE,
+  ectn_FIELD_DOWNLOAD_SIZE,
+  ectn_FIELD_INSTALL_REASON
+};
+
+EInfoField fieldFromKey(const QString& key)
+{
+  if (key == "Name")            return ectn_FIELD_NAME;
+  if (key == "Version")         return ectn_FIELD_VERSION;
+  if (key == "Repository")      return ectn_FIELD_REPOSITORY;
+  if (key == "Depends On")      return ectn_FIELD_DEPENDS;
+  if (key == "Optional Deps")   return ectn_FIELD_OPTDEPENDS;
+  if (key == "Provides")        return ectn_FIELD_PROVIDES;
+  if (key == "Conflicts With")  return ectn_FIELD_CONFLICTS;
+  if (key == "Replaces")        return ectn_FIELD_REPLACES;
+  if (key == "Groups")          return ectn_FIELD_GROUPS;
+  if (key == "Installed Size")  return ectn_FIELD_INSTALLED_SIZE;
+  if (key == "Download Size")   return ectn_FIELD_DOWNLOAD_SIZE;
+  if (key == "Install Reason")  return ectn_FIELD_INSTALL_REASON;
+  return ectn_FIELD_OTHER;
+}
+
+/**
+ * @brief "1.50 MiB" -> 1536.0
+ */
+double sizeInKiB(const QString& value)
+{
+  const QStringList parts = value.split(' ', QString::SkipEmptyParts);
+  if (parts.isEmpty()) return 0;
+
+  double size = parts.at(0).toDouble();
+  const QString unit = parts.size() > 1 ? parts.at(1) : QString("KiB");
+  if (unit == "B")        size /= 1024.0;
+  else if (unit == "MiB") size *= 1024.0;
+  else if (unit == "GiB") size *= 1024.0 * 1024.0;
+  return size;
+}
+
+/**
+ * @brief "python2: for the scripts [installed]" -> "python2"
+ */
+QString optionalDependencyName(const QString& line)
+{
+  QString result = line;
+  const int colon = result.indexOf(": ");
+  if (colon != -1) result.truncate(colon);
+  const int bracket = result.indexOf(" [");
+  if (bracket != -1) result.truncate(bracket);
+  return result.trimmed();
+}
+
+void applyField(TInfoRecord& record, EInfoField field, const QString& value, bool continuation)
+{
+  if (value == "None") return;
+
+  switch (field) {
+  case ectn_FIELD_NAME:
+    record.name = value;
+    break;
+  case ectn_FIELD_VERSION:
+    record.version = value;
+    break;
+  case ectn_FIELD_REPOSITORY:
+    record.repository = value;
+    break;
+  case ectn_FIELD_DEPENDS:
+    record.depends += value.split(' ', QString::SkipEmptyParts);
+    break;
+  case ectn_FIELD_OPTDEPENDS:
+    record.optDepends.append(optionalDependencyName(value));
+    break;
+  case ectn_FIELD_PROVIDES:
+    record.provides += value.split(' ', QString::SkipEmptyParts);
+    break;
+  case ectn_FIELD_CONFLICTS:
+    record.conflicts += value.split(' ', QString::SkipEmptyParts);
+    break;
+  case ectn_FIELD_REPLACES:
+    record.replaces += value.split(' ', QString::SkipEmptyParts);
+    break;
+  case ectn_FIELD_GROUPS:
+    record.groups += value.split(' ', QString::SkipEmptyParts);
+    break;
+  case ectn_FIELD_INSTALLED_SIZE:
+    if (!continuation) record.installedSize = sizeInKiB(value);
+    break;
+  case ectn_FIELD_DOWNLOAD_SIZE:
+    if (!continuation) record.downloadSize = sizeInKiB(value);
+    break;
+  case ectn_FIELD_INSTALL_REASON:
+    if (!continuation) record.explicitlyInstalled = value.startsWith("Explicitly");
+    break;
+  default:
+    break;
+  }
+}
+
+/**
+ * @brief splits the output of "pacman -Qi" or "pacman -Si" (LANG=C) into records
+ *
+ * Lines look like "Key             : value"; lines starting with blanks continue the previous
+ * field (used by "Optional Deps", one dependency per line) and empty lines end a record.
+ */
+QList<TInfoRecord> parseInfo(const QByteArray& info)
+{
+  QList<TInfoRecord> records;
+  TInfoRecord record;
+  EInfoField  field = ectn_FIELD_OTHER;
+
+  int pos = 0;
+  while (pos < info.size()) {
+    int end = info.indexOf('\n', pos);
+    if (end == -1) end = info.size();
+    const QString line = QString::fromUtf8(info.constData() + pos, end - pos);
+    pos = end + 1;
+
+    if (line.trimmed().isEmpty()) {
+      if (!record.name.isEmpty()) records.append(record);
+      record = TInfoRecord();
+      field  = ectn_FIELD_OTHER;
+    }
+    else if (line.at(0).isSpace()) {
+      applyField(record, field, line.trimmed(), true);
+    }
+    else {
+      const int colon = line.indexOf(':');
+      if (colon == -1) continue;
+      field = fieldFromKey(line.left(colon).trimmed());
+      applyField(record, field, line.mid(colon + 1).trimmed(), false);
+    }
+  }
+  if (!record.name.isEmpty()) records.append(record);
+
+  return records;
+}
+
+} // namespace
+
+
+/**
+ * @brief compares %version against the constraint the way pacman does (see Package::vercmp)
+ */
+bool DependencyGraph::Constraint::isSatisfiedBy(const QString& otherVersion) const
+{
+  if (op == ectn_ANY) return true;
+
+  const int cmp = Package::vercmp(otherVersion, version);
+  switch (op) {
+  case ectn_EQUAL:         return cmp == 0;
+  case ectn_GREATER_EQUAL: return cmp >= 0;
+  case ectn_LESS_EQUAL:    return cmp <= 0;
+  case ectn_GREATER:       return cmp > 0;
+  case ectn_LESS:          return cmp < 0;
+  default:                 return true;
+  }
+}
+
+/**
+ * @brief parses "name", "name=1.0", "name>=1.0-2", ... (optional dependency descriptions are cut off)
+ */
+DependencyGraph::Constraint DependencyGraph::parseConstraint(const QString& spec)
+{
+  Constraint result;
+  result.op = ectn_ANY;
+
+  QString str = spec;
+  const int colon = str.indexOf(": ");
+  if (colon != -1) str.truncate(colon);
+  str = str.trimmed();
+
+  int opPos = -1;
+  for (int i = 0; i < str.size(); ++i) {
+    const QChar c = str.at(i);
+    if (c == '<' || c == '>' || c == '=') {
+      opPos = i;
+      break;
+    }
+  }
+  if (opPos == -1) {
+    result.name = str;
+    return result;
+  }
+
+  result.name = str.left(opPos);
+  const QChar first  = str.at(opPos);
+  const bool  twoChars = opPos + 1 < str.size() && str.at(opPos + 1) == '=';
+  if (first == '=')      result.op = ectn_EQUAL;
+  else if (first == '>') result.op = twoChars ? ectn_GREATER_EQUAL : ectn_GREATER;
+  else                   result.op = twoChars ? ectn_LESS_EQUAL : ectn_LESS;
+
+  result.version = str.mid(opPos + (first != '=' && twoChars ? 2 : 1));
+  return result;
+}
+
+DependencyGraph* DependencyGraph::build()
+{
+  bool localOk, syncOk;
+  const QByteArray localInfo = UnixCommand::getAllPackageInformation(true, &localOk);
+  const QByteArray syncInfo  = UnixCommand::getAllPackageInformation(false, &syncOk);
+  // a truncated output would drop packages and dependencies without notice
+  if (!localOk || !syncOk) return NULL;
+  return build(localInfo, syncInfo);
+}
+
+/**
+ * @brief builds the graph from the outputs of "pacman -Qi" (%localInfo) and "pacman -Si" (%syncInfo)
+ */
+DependencyGraph* DependencyGraph::build(const QByteArray& localInfo, const QByteArray& syncInfo)
+{
+  const QList<TInfoRecord> localRecords = parseInfo(localInfo);
+  const QList<TInfoRecord> syncRecords  = parseInfo(syncInfo);
+
+  // the first sync db containing a package wins, just like pacman resolves it
+  QHash<QString, int> syncIndex;
+  syncIndex.reserve(syncRecords.size());
+  for (int i = 0; i < syncRecords.size(); ++i) {
+    if (!syncIndex.contains(syncRecords.at(i).name)) syncIndex.insert(syncRecords.at(i).name, i);
+  }
+
+  DependencyGraph* graph = new DependencyGraph();
+  const int estimatedNodes = syncIndex.size() + localRecords.size();
+  graph->m_nameIndex.reserve(estimatedNodes);
+
+  // installed packages come from the local db, since that is what is actually on the system
+  for (QList<TInfoRecord>::const_iterator it = localRecords.begin(); it != localRecords.end(); ++it) {
+    if (graph->m_nameIndex.contains(it->name)) continue;
+    const QHash<QString, int>::const_iterator syncIt = syncIndex.constFind(it->name);
+    const TInfoRecord sync = syncIt != syncIndex.constEnd() ? syncRecords.at(syncIt.value()) : TInfoRecord();
+    graph->addNode(it->name, it->version, sync.repository, true, it->explicitlyInstalled, it->installedSize,
+                   it->depends, it->optDepends, it->provides, it->conflicts);
+    // what an upgrade would bring in
+    graph->addSyncData(sync.version, sync.downloadSize, sync.installedSize,
+                       sync.depends, sync.provides, sync.conflicts, sync.replaces);
+    graph->addGroups(it->groups, sync.groups);
+  }
+
+  for (QList<TInfoRecord>::const_iterator it = syncRecords.begin(); it != syncRecords.end(); ++it) {
+    if (graph->m_nameIndex.contains(it->name)) continue;
+    graph->addNode(it->name, it->version, it->repository, false, false, 0,
+                   it->depends, it->optDepends, it->provides, it->conflicts);
+    // depends, provides and conflicts are the very same as above, so they aren't stored twice
+    graph->addSyncData(it->version, it->downloadSize, it->installedSize,
+                       QStringList(), QStringList(), QStringList(), it->replaces);
+    graph->addGroups(QStringList(), it->groups);
+  }
+
+  graph->buildEdges();
+  return graph;
+}
+
+int DependencyGraph::findNode(const QString& name) const
+{
+  return m_nameIndex.value(name, -1);
+}
+
+/**
+ * @brief returns all nodes which provide %name (the node called %name itself is not included)
+ */
+QList<int> DependencyGraph::findProviders(const QString& name) const
+{
+  QList<int> result;
+  const QHash<QString, QVector<TProvision> >::const_iterator it = m_providerIndex.constFind(name);
+  if (it == m_providerIndex.constEnd()) return result;
+
+  for (QVector<TProvision>::const_iterator itProv = it->begin(); itProv != it->end(); ++itProv) {
+    result.append(itProv->node);
+  }
+  return result;
+}
+
+/**
+ * @brief returns the node satisfying %constraint or -1
+ *
+ * An installed package is preferred over the others, followed by the package with the exact name.
+ * Versioned dependencies can only be satisfied by versioned provides.
+ */
+int DependencyGraph::resolve(const Constraint& constraint) const
+{
+  int candidate = -1;
+
+  const int byName = findNode(constraint.name);
+  if (byName != -1 && constraint.isSatisfiedBy(m_versions.at(byName))) {
+    if (m_installed.at(byName)) return byName;
+    candidate = byName;
+  }
+
+  const QHash<QString, QVector<TProvision> >::const_iterator it = m_providerIndex.constFind(constraint.name);
+  if (it == m_providerIndex.constEnd()) return candidate;
+
+  for (QVector<TProvision>::const_iterator itProv = it->begin(); itProv != it->end(); ++itProv) {
+    if (constraint.op != ectn_ANY && (itProv->version.isEmpty() || !constraint.isSatisfiedBy(itProv->version))) {
+      continue;
+    }
+    if (m_installed.at(itProv->node)) return itProv->node;
+    if (candidate == -1) candidate = itProv->node;
+  }
+  return candidate;
+}
+
+DependencyGraph::TNodeRange DependencyGraph::dependsOn(int node) const
+{
+  return TNodeRange(m_depTargets.begin() + m_depOffsets.at(node), m_depTargets.begin() + m_depOffsets.at(node + 1));
+}
+
+DependencyGraph::TNodeRange DependencyGraph::requiredBy(int node) const
+{
+  return TNodeRange(m_revTargets.begin() + m_revOffsets.at(node), m_revTargets.begin() + m_revOffsets.at(node + 1));
+}
+
+/**
+ * @brief returns all installed packages which are not reachable from an explicitly installed one
+ *
+ * Mark phase: depth first search from every explicitly installed package along the dependency edges
+ * (and along the optional dependencies if %keepOptionalDependencies is set).
+ * Sweep phase: every installed package left unmarked is an orphan, including the ones which are
+ * only needed by other orphans.
+ */
+QList<int> DependencyGraph::findOrphans(bool keepOptionalDependencies) const
+{
+  const int nodeCount = m_names.size();
+  std::vector<bool> marked(nodeCount, false);
+  std::vector<int>  stack;
+
+  for (int node = 0; node < nodeCount; ++node) {
+    if (m_installed.at(node) && m_explicit.at(node)) {
+      marked[node] = true;
+      stack.push_back(node);
+    }
+  }
+
+  while (!stack.empty()) {
+    const int node = stack.back();
+    stack.pop_back();
+
+    for (int x = m_depOffsets[node]; x < m_depOffsets[node + 1]; ++x) {
+      const int target = m_depTargets[x];
+      if (!marked[target] && m_installed.at(target)) {
+        marked[target] = true;
+        stack.push_back(target);
+      }
+    }
+
+    if (keepOptionalDependencies) {
+      for (int x = m_optDepends.offsets[node]; x < m_optDepends.offsets[node + 1]; ++x) {
+        const int target = resolve(parseConstraint(m_optDepends.values.at(x)));
+        if (target != -1 && !marked[target] && m_installed.at(target)) {
+          marked[target] = true;
+          stack.push_back(target);
+        }
+      }
+    }
+  }
+
+  QList<int> orphans;
+  for (int node = 0; node < nodeCount; ++node) {
+    if (m_installed.at(node) && !marked[node]) orphans.append(node);
+  }
+  return orphans;
+}
+
+/**
+ * @brief the packages "pacman -S %group" installs, i.e. the members of %group in the sync dbs
+ */
+QList<int> DependencyGraph::findGroupMembers(const QString& group) const
+{
+  return m_groupIndex.value(group).toList();
+}
+
+/**
+ * @brief the packages "pacman -R %group" removes, i.e. the installed members of %group
+ */
+QList<int> DependencyGraph::findInstalledGroupMembers(const QString& group) const
+{
+  return m_installedGroupIndex.value(group).toList();
+}
+
+QStringList DependencyGraph::getProvides(int node) const
+{
+  return m_provides.at(node);
+}
+
+QStringList DependencyGraph::getConflicts(int node) const
+{
+  return m_conflicts.at(node);
+}
+
+QStringList DependencyGraph::getOptionalDepends(int node) const
+{
+  return m_optDepends.at(node);
+}
+
+/**
+ * @brief dependencies of the sync package, i.e. of the version an install or upgrade would bring in
+ */
+QStringList DependencyGraph::getSyncDepends(int node) const
+{
+  return m_installed.at(node) ? m_syncDepends.at(node) : m_depends.at(node);
+}
+
+/**
+ * @brief conflicts of the sync package, i.e. of the version an install or upgrade would bring in
+ */
+QStringList DependencyGraph::getSyncConflicts(int node) const
+{
+  return m_installed.at(node) ? m_syncConflicts.at(node) : m_conflicts.at(node);
+}
+
+/**
+ * @brief provides of the sync package; an upgrade may add or drop provisions
+ */
+QStringList DependencyGraph::getSyncProvides(int node) const
+{
+  return m_installed.at(node) ? m_syncProvides.at(node) : m_provides.at(node);
+}
+
+QStringList DependencyGraph::getReplaces(int node) const
+{
+  return m_replaces.at(node);
+}
+
+DependencyGraph::DependencyGraph()
+{
+  m_depends.offsets.push_back(0);
+  m_optDepends.offsets.push_back(0);
+  m_provides.offsets.push_back(0);
+  m_conflicts.offsets.push_back(0);
+  m_syncDepends.offsets.push_back(0);
+  m_syncProvides.offsets.push_back(0);
+  m_syncConflicts.offsets.push_back(0);
+  m_replaces.offsets.push_back(0);
+}
+
+void DependencyGraph::addNode(const QString& name, const QString& version, const QString& repository,
+                              bool installed, bool isExplicit, double installedSize,
+                              const QStringList& depends, const QStringList& optDepends,
+                              const QStringList& provides, const QStringList& conflicts)
+{
+  const int node = m_names.size();
+
+  m_names.append(name);
+  m_versions.append(version);
+  m_repositories.append(repository);
+  m_installed.append(installed);
+  m_explicit.append(isExplicit);
+  m_installedSizes.append(installedSize);
+
+  m_depends.append(depends);
+  m_optDepends.append(optDepends);
+  m_provides.append(provides);
+  m_conflicts.append(conflicts);
+
+  m_nameIndex.insert(name, node);
+  for (QStringList::const_iterator it = provides.begin(); it != provides.end(); ++it) {
+    const Constraint provision = parseConstraint(*it);
+    TProvision entry;
+    entry.node    = node;
+    entry.version = provision.op == ectn_EQUAL ? provision.version : QString();
+    m_providerIndex[provision.name].append(entry);
+  }
+}
+
+/**
+ * @brief stores the sync side of the node added last (an empty %version for foreign packages)
+ */
+void DependencyGraph::addSyncData(const QString& version, double downloadSize, double installedSize,
+                                  const QStringList& depends, const QStringList& provides,
+                                  const QStringList& conflicts, const QStringList& replaces)
+{
+  m_syncVersions.append(version);
+  m_downloadSizes.append(downloadSize);
+  m_syncInstalledSizes.append(installedSize);
+
+  m_syncDepends.append(depends);
+  m_syncProvides.append(provides);
+  m_syncConflicts.append(conflicts);
+  m_replaces.append(replaces);
+}
+
+/**
+ * @brief registers the node added last as member of %installedGroups (local db) and %syncGroups
+ */
+void DependencyGraph::addGroups(const QStringList& installedGroups, const QStringList& syncGroups)
+{
+  const int node = m_names.size() - 1;
+  for (QStringList::const_iterator it = installedGroups.begin(); it != installedGroups.end(); ++it) {
+    m_installedGroupIndex[*it].append(node);
+  }
+  for (QStringList::const_iterator it = syncGroups.begin(); it != syncGroups.end(); ++it) {
+    m_groupIndex[*it].append(node);
+  }
+}
+
+/**
+ * @brief resolves all dependencies and fills both CSR edge arrays
+ *
+ * Self dependencies and duplicates (e.g. two dependencies satisfied by the same provider) are dropped.
+ */
+void DependencyGraph::buildEdges()
+{
+  const int nodeCount = m_names.size();
+
+  m_depOffsets.assign(1, 0);
+  m_depOffsets.reserve(nodeCount + 1);
+  m_depTargets.clear();
+  m_depTargets.reserve(m_depends.values.size());
+
+  std::vector<int> inDegree(nodeCount, 0);
+
+  for (int node = 0; node < nodeCount; ++node) {
+    const std::size_t first = m_depTargets.size();
+    for (int x = m_depends.offsets[node]; x < m_depends.offsets[node + 1]; ++x) {
+      const int target = resolve(parseConstraint(m_depends.values.at(x)));
+      if (target != -1 && target != node) m_depTargets.push_back(target);
+    }
+    std::sort(m_depTargets.begin() + first, m_depTargets.end());
+    m_depTargets.erase(std::unique(m_depTargets.begin() + first, m_depTargets.end()), m_depTargets.end());
+
+    for (std::size_t x = first; x < m_depTargets.size(); ++x) ++inDegree[m_depTargets[x]];
+    m_depOffsets.push_back(static_cast<int>(m_depTargets.size()));
+  }
+
+  // reverse edges: prefix sums of the in-degrees, then scatter (sources stay sorted per target)
+  m_revOffsets.assign(nodeCount + 1, 0);
+  for (int node = 0; node < nodeCount; ++node) m_revOffsets[node + 1] = m_revOffsets[node] + inDegree[node];
+
+  m_revTargets.assign(m_depTargets.size(), 0);
+  std::vector<int> fill(m_revOffsets.begin(), m_revOffsets.end() - 1);
+  for (int node = 0; node < nodeCount; ++node) {
+    for (int x = m_depOffsets[node]; x < m_depOffsets[node + 1]; ++x) {
+      m_revTargets[fill[m_depTargets[x]]++] = node;
+    }
+  }
+}
+
+void DependencyGraph::TStringTable::append(const QStringList& list)
+{
+  values += list;
+  offsets.push_back(values.size());
+}
+
+QStringList DependencyGraph::TStringTable::at(int node) const
+{
+  return values.mid(offsets.at(node), offsets.at(node + 1) - offsets.at(node));
+}
@@ -0,0 +1,199 @@
+/*
+* This file is part of Octopi, an open-source GUI for pacman.
+* Copyright (C) 2014 Thomas Binkau
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*
+*/
+
+#ifndef OCTOPI_DEPENDENCYGRAPH_H
+#define OCTOPI_DEPENDENCYGRAPH_H
+
+#include <vector>
+#include <QByteArray>
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+
+/**
+ * @brief Dependency graph of all packages known to pacman (local db + sync dbs)
+ *
+ * Every package name is one node: installed packages are taken from the local db, all other
+ * packages from the first sync db which contains them. Dependencies are resolved against
+ * package names and virtual provides (honoring version constraints) and the resulting edges
+ * are kept in compressed sparse row arrays, once for "depends on" and once for "required by".
+ * The graph is immutable after build() and can therefore be built in a worker thread.
+ */
+class DependencyGraph
+{
+public:
+  enum EConstraintOperator {
+    ectn_ANY,
+    ectn_EQUAL,
+    ectn_GREATER_EQUAL,
+    ectn_LESS_EQUAL,
+    ectn_GREATER,
+    ectn_LESS
+  };
+
+  /**
+   * @brief A parsed dependency string like "glibc>=2.19" or "sh"
+   */
+  struct Constraint {
+    QString             name;
+    EConstraintOperator op;
+    QString             version;
+
+    bool isSatisfiedBy(const QString& version) const;
+  };
+
+  typedef std::vector<int>::const_iterator TNodeIterator;
+  typedef std::pair<TNodeIterator, TNodeIterator> TNodeRange;
+
+public:
+  static Constraint parseConstraint(const QString& spec);
+
+  /**
+   * @brief fetches "pacman -Qi" and "pacman -Si" and builds the graph from both
+   *
+   * Returns NULL if pacman didn't finish successfully, as the graph would miss packages then.
+   */
+  static DependencyGraph* build();
+  static DependencyGraph* build(const QByteArray& localInfo, const QByteArray& syncInfo);
+
+  inline int getNodeCount() const {
+    return m_names.size();
+  }
+
+  int        findNode(const QString& name) const; // -1 if unknown
+  QList<int> findProviders(const QString& name) const;
+  int        resolve(const Constraint& constraint) const;
+  QList<int> findGroupMembers(const QString& group) const;
+  QList<int> findInstalledGroupMembers(const QString& group) const;
+
+  inline const QString& getName(int node) const {
+    return m_names.at(node);
+  }
+  inline const QString& getVersion(int node) const {
+    return m_versions.at(node);
+  }
+  // empty for installed packages which are not in any sync db (foreign)
+  inline const QString& getRepository(int node) const {
+    return m_repositories.at(node);
+  }
+  inline bool isInstalled(int node) const {
+    return m_installed.at(node);
+  }
+  inline bool isExplicitlyInstalled(int node) const {
+    return m_explicit.at(node);
+  }
+  // in KiB, 0 for packages which are not installed
+  inline double getInstalledSize(int node) const {
+    return m_installedSizes.at(node);
+  }
+
+  // version in the first sync db containing the package, empty for foreign packages
+  inline const QString& getSyncVersion(int node) const {
+    return m_syncVersions.at(node);
+  }
+  // in KiB, size of the sync package file
+  inline double getDownloadSize(int node) const {
+    return m_downloadSizes.at(node);
+  }
+  // in KiB, installed size of the sync package
+  inline double getSyncInstalledSize(int node) const {
+    return m_syncInstalledSizes.at(node);
+  }
+
+  TNodeRange dependsOn(int node) const;
+  TNodeRange requiredBy(int node) const;
+
+  QList<int> findOrphans(bool keepOptionalDependencies) const;
+
+  QStringList getProvides(int node) const;
+  QStringList getConflicts(int node) const;
+  QStringList getOptionalDepends(int node) const;
+
+  QStringList getSyncDepends(int node) const;
+  QStringList getSyncConflicts(int node) const;
+  QStringList getSyncProvides(int node) const;
+  QStringList getReplaces(int node) const;
+
+private:
+  /**
+   * @brief Per node lists of strings, stored back to back
+   */
+  struct TStringTable {
+    std::vector<int> offsets; // node x owns values[offsets[x]] .. values[offsets[x+1]-1]
+    QStringList      values;
+
+    void append(const QStringList& list);
+    QStringList at(int node) const;
+  };
+
+  struct TProvision {
+    int     node;
+    QString version; // empty for unversioned provides
+  };
+
+  DependencyGraph();
+
+  void addNode(const QString& name, const QString& version, const QString& repository,
+               bool installed, bool isExplicit, double installedSize,
+               const QStringList& depends, const QStringList& optDepends,
+               const QStringList& provides, const QStringList& conflicts);
+  void addSyncData(const QString& version, double downloadSize, double installedSize,
+                   const QStringList& depends, const QStringList& provides, const QStringList& conflicts,
+                   const QStringList& replaces);
+  void addGroups(const QStringList& installedGroups, const QStringList& syncGroups);
+  void buildEdges();
+
+private:
+  QStringList     m_names;
+  QStringList     m_versions;
+  QStringList     m_repositories;
+  QVector<bool>   m_installed;
+  QVector<bool>   m_explicit;
+  QVector<double> m_installedSizes;
+
+  TStringTable    m_depends;
+  TStringTable    m_optDepends;
+  TStringTable    m_provides;
+  TStringTable    m_conflicts;
+
+  // sync side of every node; depends, provides and conflicts only for installed ones (see getSyncDepends)
+  QStringList     m_syncVersions;
+  QVector<double> m_downloadSizes;
+  QVector<double> m_syncInstalledSizes;
+  TStringTable    m_syncDepends;
+  TStringTable    m_syncProvides;
+  TStringTable    m_syncConflicts;
+  TStringTable    m_replaces;
+
+  QHash<QString, int>                   m_nameIndex;
+  QHash<QString, QVector<TProvision> >  m_providerIndex;
+  QHash<QString, QVector<int> >         m_groupIndex;          // group -> members in the sync dbs
+  QHash<QString, QVector<int> >         m_installedGroupIndex; // group -> installed members
+
+  // CSR: targets of node x are m_depTargets[m_depOffsets[x]] .. m_depTargets[m_depOffsets[x+1]-1]
+  std::vector<int> m_depOffsets;
+  std::vector<int> m_depTargets;
+  std::vector<int> m_revOffsets;
+  std::vector<int> m_revTargets;
+};
+
+#endif // OCTOPI_DEPENDENCYGRAPH_H
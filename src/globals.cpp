@@ -21,6 +21,8 @@
 #include "globals.h"
 #include "mainwindow.h"
 #include "packagecontroller.h"
+#include "dependencygraph.h"
+#include "transactionchecker.h"
 
 #include <QStandardItem>
 #include <QFutureWatcher>
@@ -40,8 +42,10 @@ QFutureWatcher<QList<PackageListData> *> g_fwPacman;
 QFutureWatcher<GroupMemberPair>          g_fwPacmanGroup;
 QFutureWatcher<QList<PackageListData> *> g_fwYaourt;
 QFutureWatcher<QList<PackageListData> *> g_fwYaourtMeta;
+QFutureWatcher<QList<PackageListData> *> g_fwYaourtRanked;
 QFutureWatcher<YaourtOutdatedPackages *> g_fwOutdatedYaourtPackages;
 QFutureWatcher<QString> g_fwDistroNews;
+QFutureWatcher<DependencyGraph *> g_fwDependencyGraph;
 
 /*
  * Given a packageName, returns its description
@@ -55,7 +59,7 @@ QString showPackageInfo(QString pkgName)
     return "";
   }
 
-  QString description = package->description;
+  QString description = package->getDescription();
 
   if (description.trimmed().isEmpty()) return "";
 
@@ -115,3 +119,19 @@ QString getLatestDistroNews()
 {
   return PackageController::retrieveDistroNews(true);
 }
+
+/*
+ * Builds the dependency graph of all local and sync packages (non blocking)
+ */
+DependencyGraph * buildDependencyGraph()
+{
+  return DependencyGraph::build();
+}
+
+/*
+ * Runs the pre-flight checks of a resolved transaction (non blocking)
+ */
+TransactionChecker * checkTransaction(const TransactionResolver *resolution)
+{
+  return new TransactionChecker(*resolution);
+}
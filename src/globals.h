@@ -33,14 +33,20 @@ struct YaourtOutdatedPackages
 
 typedef std::pair<QString, QStringList*> GroupMemberPair;
 
+class DependencyGraph;
+class TransactionChecker;
+class TransactionResolver;
+
 
 extern QFutureWatcher<QString> g_fwToolTip;
 extern QFutureWatcher<QList<PackageListData> *> g_fwPacman;
 extern QFutureWatcher<GroupMemberPair>          g_fwPacmanGroup;
 extern QFutureWatcher<QList<PackageListData> *> g_fwYaourt;
 extern QFutureWatcher<QList<PackageListData> *> g_fwYaourtMeta;
+extern QFutureWatcher<QList<PackageListData> *> g_fwYaourtRanked;
 extern QFutureWatcher<YaourtOutdatedPackages *> g_fwOutdatedYaourtPackages;
 extern QFutureWatcher<QString> g_fwDistroNews;
+extern QFutureWatcher<DependencyGraph *> g_fwDependencyGraph;
 
 QString showPackageInfo(QString pkgName);
 QList<PackageListData> * searchPacmanPackages();
@@ -48,5 +54,7 @@ GroupMemberPair          searchPacmanPackagesFromGroup(QString groupName);
 QList<PackageListData> * searchYaourtPackages(QString searchString);
 YaourtOutdatedPackages * getOutdatedYaourtPackages();
 QString getLatestDistroNews();
+DependencyGraph * buildDependencyGraph();
+TransactionChecker * checkTransaction(const TransactionResolver *resolution);
 
 #endif // MAINWINDOW_GLOBALS_H
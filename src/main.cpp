@@ -28,6 +28,7 @@
 #include "QtSolutions/qtsingleapplication.h"
 #include <QtGui>
 #include <QMessageBox>
+#include <QNetworkProxyFactory>
 
 //#define NO_GTK_STYLE
 
@@ -51,6 +52,9 @@ int main(int argc, char *argv[])
     }
   }
 
+  //Repository packages to install, as in "-install pkg1,pkg2"
+  QString repositoryPackagesToInstall = argList->getSwitchArg("-install");
+
   QtSingleApplication app( StrConstants::getApplicationName(), argc, argv );
 
   if (app.isRunning())
@@ -71,6 +75,10 @@ int main(int argc, char *argv[])
     {
       app.sendMessage("HIDE");
     }
+    else if (!repositoryPackagesToInstall.isEmpty())
+    {
+      app.sendMessage("INSTALL:" + repositoryPackagesToInstall);
+    }
     else if (!packagesToInstall.isEmpty())
     {
       app.sendMessage(packagesToInstall);
@@ -106,6 +114,9 @@ int main(int argc, char *argv[])
     return ( -2 );
   }
 
+  //The news feed is fetched through the proxy the desktop is configured with
+  QNetworkProxyFactory::setUseSystemConfiguration(true);
+
   MainWindow w;
   app.setActivationWindow(&w);
   app.setQuitOnLastWindowClosed(false);
@@ -144,8 +155,19 @@ int main(int argc, char *argv[])
     w.setPackagesToInstallList(packagesToInstallList);
   }
 
+  if (!repositoryPackagesToInstall.isEmpty())
+  {
+    w.setRepositoryPackagesToInstallList(
+          repositoryPackagesToInstall.split(",", QString::SkipEmptyParts));
+  }
+
   w.setRemoveCommand("Rcs"); //argList->getSwitchArg("-removecmd", "Rcs"));
-  w.show();
+
+  //"-hide" starts an instance which stays hidden until it's needed (octopi-notifier keeps one ready)
+  if (argList->getSwitch("-hide"))
+    w.showHidden();
+  else
+    w.show();
 
   QResource::registerResource("./resources.qrc");
 
@@ -29,6 +29,9 @@
 #include "searchbar.h"
 #include "packagecontroller.h"
 #include "globals.h"
+#include "outputsink.h"
+#include "pacmandatabasewatcher.h"
+#include "transactionresolver.h" // for m_transactionResolution's destructor
 #include <iostream>
 
 #include <QStandardItemModel>
@@ -57,8 +60,11 @@ MainWindow::MainWindow(QWidget *parent) :
   m_callSystemUpgrade = false;
   m_callSystemUpgradeNoConfirm = false;
   m_initializationCompleted=false;
+  m_widgetsInitialized=false;
   m_systemUpgradeDialog = false;
   m_cic = NULL;
+  m_dependencyGraphGeneration = 0;
+  m_dependencyGraphHandedOver = 0;
   m_outdatedPackageList = new QStringList();
   m_outdatedYaourtPackageList = new QStringList();
   m_outdatedYaourtPackagesNameVersion = new QHash<QString, QString>();
@@ -72,6 +78,12 @@ MainWindow::~MainWindow()
 {
   //Let's garbage collect transaction files...
   m_unixCommand->removeTemporaryFiles();
+
+  //A graph still being built was never handed over, so it is ours to delete
+  if (m_dependencyGraphHandedOver != m_dependencyGraphGeneration)
+    m_staleDependencyGraphs.append(g_fwDependencyGraph.future());
+  _deleteStaleDependencyGraphs(true);
+
   delete ui;
 }
 
@@ -81,38 +93,9 @@ MainWindow::~MainWindow()
  */
 void MainWindow::show()
 {
-  if(m_initializationCompleted == false)
+  if(m_widgetsInitialized == false)
   {
-    UnixCommand::getIgnorePkg();
-    restoreGeometry(SettingsManager::getWindowSize());
-    m_commandExecuting=ectn_NONE;
-    m_commandQueued=ectn_NONE;
-    m_leFilterPackage = new SearchLineEdit(this);
-
-    setWindowTitle(StrConstants::getApplicationName());
-    setMinimumSize(QSize(820, 520));
-
-    initTabOutput();
-    initTabInfo();
-    initTabFiles();
-    initTabTransaction();
-    initTabHelpUsage();
-    initTabNews();
-    initLineEditFilterPackages();
-    initPackageTreeView();
-    loadSettings();
-
-    loadPanelSettings();
-    initActions();
-    initStatusBar();
-    initToolButtonPacman();
-    initToolButtonYaourt();
-    initAppIcon();
-    initToolBar();
-    initTabWidgetPropertiesIndex();
-    refreshDistroNews(false);
-    refreshGroupsWidget();
-
+    _initWidgets();
     QMainWindow::show();
 
     metaBuildPackageList();
@@ -121,6 +104,60 @@ void MainWindow::show()
     QMainWindow::show();
 }
 
+/*
+ * Does everything show() does the first time, but keeps the window hidden.
+ * A later show() (ex: a "RAISE" or "SYSUPGRADE" message) finds the package list already built
+ */
+void MainWindow::showHidden()
+{
+  if(m_widgetsInitialized) return;
+
+  _initWidgets();
+  metaBuildPackageList();
+}
+
+/*
+ * Init member variables and all UI widgets
+ */
+void MainWindow::_initWidgets()
+{
+  m_widgetsInitialized = true;
+
+  UnixCommand::getIgnorePkg();
+  restoreGeometry(SettingsManager::getWindowSize());
+  m_commandExecuting=ectn_NONE;
+  m_commandQueued=ectn_NONE;
+  m_leFilterPackage = new SearchLineEdit(this);
+
+  setWindowTitle(StrConstants::getApplicationName());
+  setMinimumSize(QSize(820, 520));
+
+  m_pacmanDatabaseWatcher = new PacmanDatabaseWatcher(this);
+  connect(m_pacmanDatabaseWatcher, SIGNAL(databaseChanged(QStringList,bool)),
+          this, SLOT(pacmanDatabaseChanged(QStringList,bool)));
+
+  initTabOutput();
+  initTabInfo();
+  initTabFiles();
+  initTabTransaction();
+  initTabHelpUsage();
+  initTabNews();
+  initLineEditFilterPackages();
+  initPackageTreeView();
+  loadSettings();
+
+  loadPanelSettings();
+  initActions();
+  initStatusBar();
+  initToolButtonPacman();
+  initToolButtonYaourt();
+  initAppIcon();
+  initToolBar();
+  initTabWidgetPropertiesIndex();
+  refreshDistroNews(false);
+  refreshGroupsWidget();
+}
+
 /*
  * Retrieves a pointer to Output's QTextBrowser object
  */
@@ -219,9 +256,9 @@ void MainWindow::outputOutdatedPackageList()
       if (package != NULL) {
         html += "<tr><td><a href=\"goto:" + pkg + "\">" + pkg +
             "</td><td align=\"right\"><b><font color=\"#E55451\">" +
-            package->outdatedVersion +
+            package->getOutdatedVersion() +
             "</b></font></td><td align=\"right\">" +
-            package->version + "</td></tr>";
+            package->getVersion() + "</td></tr>";
       }
     }
 
@@ -232,6 +269,8 @@ void MainWindow::outputOutdatedPackageList()
 
     if (text)
     {
+      //The anchor must be in the document before scrolling to it
+      m_outputSink->flush();
       text->scrollToAnchor(anchorBegin);
     }
 
@@ -278,7 +317,7 @@ void MainWindow::outputOutdatedYaourtPackageList()
   
       html += "<tr><td><a href=\"goto:" + pkg + "\">" + pkg +
           "</td><td align=\"right\"><b><font color=\"#E55451\">" +
-          package->version +
+          package->getVersion() +
           "</b></font></td><td align=\"right\">" +
           availableVersion + "</td></tr>";
     }
@@ -291,6 +330,8 @@ void MainWindow::outputOutdatedYaourtPackageList()
 
   if (text)
   {
+    //The anchor must be in the document before scrolling to it
+    m_outputSink->flush();
     text->scrollToAnchor(anchorBegin);
   }
 
@@ -302,11 +343,7 @@ void MainWindow::outputOutdatedYaourtPackageList()
  */
 void MainWindow::clearTabOutput()
 {
-  QTextBrowser *text = ui->twProperties->widget(ctn_TABINDEX_OUTPUT)->findChild<QTextBrowser*>("textOutputEdit");
-  if (text)
-  {
-    text->clear();
-  }
+  m_outputSink->clear();
 }
 
 /*
@@ -333,6 +370,17 @@ bool MainWindow::isAllGroups(const QString& group)
   return (group == "<" + StrConstants::getDisplayAllGroups() + ">");
 }
 
+/*
+ * Helper to analyse if one of the orphan groups (computed by Octopi) is selected
+ */
+bool MainWindow::isOrphansGroupSelected()
+{
+  QModelIndex index = ui->twGroups->currentIndex();
+  QString group = ui->twGroups->model()->data(index).toString();
+
+  return (group == StrConstants::getOrphansGroup() || group == StrConstants::getUnusedOrphansGroup());
+}
+
 /*
  * Helper to analyse if < Yaourt > is selected
  */
@@ -384,6 +432,20 @@ bool MainWindow::isPackageInstalled(const QString &pkgName)
   return (package != NULL && package->installed());
 }
 
+/*
+ * Returns the filter expression for the text typed in the package filter:
+ * a regular expression for name/description searches or the plain words for ranked search
+ */
+QString MainWindow::_getPackageFilterExpression()
+{
+  if (m_leFilterPackage->text().isEmpty()) return "";
+
+  if (ui->actionSearchByRelevance->isChecked())
+    return m_leFilterPackage->text().simplified();
+  else
+    return Package::parseSearchString(m_leFilterPackage->text());
+}
+
 /*
  * User changed the search column used by the SortFilterProxyModel in tvPackages
  */
@@ -392,12 +454,17 @@ void MainWindow::tvPackagesSearchColumnChanged(QAction *actionSelected)
   //We are in the realm of tradictional NAME search
   if (actionSelected->objectName() == ui->actionSearchByName->objectName())
   {
-    m_packageModel->applyFilter(PackageModel::ctn_PACKAGE_NAME_COLUMN);
+    m_packageModel->applyFilter(PackageModel::ctn_PACKAGE_NAME_COLUMN, _getPackageFilterExpression());
+  }
+  //Ranked search works on the plain words typed, looking at both name and description
+  else if (actionSelected->objectName() == ui->actionSearchByRelevance->objectName())
+  {
+    m_packageModel->applyFilter(PackageModel::ctn_PACKAGE_RELEVANCE_FILTER_NO_COLUMN, _getPackageFilterExpression());
   }
   //We are talking about slower 'search by description'...
   else
   {
-    m_packageModel->applyFilter(PackageModel::ctn_PACKAGE_DESCRIPTION_FILTER_NO_COLUMN);
+    m_packageModel->applyFilter(PackageModel::ctn_PACKAGE_DESCRIPTION_FILTER_NO_COLUMN, _getPackageFilterExpression());
   }
 
   QModelIndex mi = m_packageModel->index(0, PackageModel::ctn_PACKAGE_NAME_COLUMN, QModelIndex());
@@ -464,7 +531,7 @@ void MainWindow::execContextMenuPackages(QPoint point)
     {
       const PackageRepository::PackageData*const package = m_packageModel->getData(item);
 
-      if (package->repository == StrConstants::getForeignRepositoryName())
+      if (package->getRepository() == StrConstants::getForeignRepositoryName())
       {
         allInstallable = false;
         numberOfAUR++;
@@ -479,7 +546,7 @@ void MainWindow::execContextMenuPackages(QPoint point)
     {
       menu->addAction(ui->actionInstall);
 
-      if (!isAllGroupsSelected() && !isYaourtGroupSelected() && numberOfSelPkgs > 1)
+      if (!isAllGroupsSelected() && !isYaourtGroupSelected() && !isOrphansGroupSelected() && numberOfSelPkgs > 1)
       {
         menu->addAction(ui->actionInstallGroup);
       }
@@ -493,7 +560,7 @@ void MainWindow::execContextMenuPackages(QPoint point)
     {
       menu->addAction(ui->actionRemove);
 
-      if (!isAllGroupsSelected() && !isYaourtGroupSelected())
+      if (!isAllGroupsSelected() && !isYaourtGroupSelected() && !isOrphansGroupSelected())
       {
         //Is this group already installed?
         const QList<PackageRepository::PackageData*> packageList = m_packageRepo.getPackageList(getSelectedGroup());
@@ -974,11 +1041,12 @@ void MainWindow::_ensureTabVisible(const int index)
  */
 bool MainWindow::_textInTabOutput(const QString& findText)
 {
-  bool res;
+  bool res = false;
   QTextBrowser *text =
       ui->twProperties->widget(ctn_TABINDEX_OUTPUT)->findChild<QTextBrowser*>("textOutputEdit");
   if (text)
   {
+    m_outputSink->flush();
     _positionTextEditCursorAtEnd();
     res = text->find(findText, QTextDocument::FindBackward | QTextDocument::FindWholeWords);
     _positionTextEditCursorAtEnd();
@@ -992,11 +1060,12 @@ bool MainWindow::_textInTabOutput(const QString& findText)
  */
 bool MainWindow::_IsSyncingRepoInTabOutput()
 {
-  bool res;
+  bool res = false;
   QTextBrowser *text =
       ui->twProperties->widget(ctn_TABINDEX_OUTPUT)->findChild<QTextBrowser*>("textOutputEdit");
   if (text)
   {
+    m_outputSink->flush();
     _positionTextEditCursorAtEnd();
     //We have to find at least two times, as "Synching" string will always be the first text in output
     res = text->find(StrConstants::getSyncing(), QTextDocument::FindBackward | QTextDocument::FindWholeWords);
@@ -1169,22 +1238,8 @@ void MainWindow::launchRepoEditor()
 
 void MainWindow::on_actionShow_Dependencies_triggered()
 {
-//FIXME: prototype
+  _waitForDependencyGraph();
   m_packageModel->switchDisplayMode(PackageModel::DEPENDS_ON);
-  QList<std::pair<PackageRepository::PackageData*, QStringList> > dependencies;
-
-  QString pkgInfoAll   = UnixCommand::getPackageInformation("", false);
-  QStringList pkgInfos = pkgInfoAll.split("\n\n", QString::SkipEmptyParts);
-  std::cout << "fetched info for " << pkgInfos.size() << " packages, " << pkgInfoAll.length() << "bytes" << std::endl;
-
-  for (int x = 0; x < pkgInfos.size(); ++x) {
-    QString aux = Package::getDependsOn(pkgInfos.at(x));
-    QStringList result = aux.split(" ", QString::SkipEmptyParts);
-    result.removeAll("None");
-
-    dependencies.push_back(std::make_pair(m_packageRepo.getFirstPackageByName(Package::getName(pkgInfos.at(x))), result));
-  }
-  m_packageRepo.setPackageDependencies(dependencies);
 
   ui->tvPackages->setIndentation(20);
   ui->tvPackages->setColumnWidth(PackageModel::ctn_PACKAGE_ICON_COLUMN, 400);
@@ -1195,7 +1250,6 @@ void MainWindow::on_actionShow_Dependencies_triggered()
 
 void MainWindow::on_actionShow_Package_list_triggered()
 {
-//FIXME: prototype
   m_packageModel->switchDisplayMode(PackageModel::FLAT);
   ui->tvPackages->setIndentation(0);
   resizePackageView();
@@ -1203,16 +1257,8 @@ void MainWindow::on_actionShow_Package_list_triggered()
 
 void MainWindow::on_actionShow_Required_by_triggered()
 {
-//FIXME: prototype
-  if (m_packageRepo.setPackageRequirements(false)) {
-    m_packageModel->switchDisplayMode(PackageModel::REQUIRED_BY);
-  }
-  else {
-    on_actionShow_Dependencies_triggered();
-    if (m_packageRepo.setPackageRequirements(true)) {
-      m_packageModel->switchDisplayMode(PackageModel::REQUIRED_BY);
-    }
-  }
+  _waitForDependencyGraph();
+  m_packageModel->switchDisplayMode(PackageModel::REQUIRED_BY);
 
   ui->tvPackages->setIndentation(20);
   ui->tvPackages->setColumnWidth(PackageModel::ctn_PACKAGE_ICON_COLUMN, 400);
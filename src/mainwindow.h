@@ -32,6 +32,7 @@
 #include <QMainWindow>
 #include <QToolButton>
 #include <QList>
+#include <QFuture>
 #include <QUrl>
 
 class QTreeView;
@@ -48,10 +49,19 @@ class QMenu;
 class SearchLineEdit;
 class QAction;
 class QTreeWidgetItem;
+class TransactionResolver;
+class TransactionDialog;
+class TransactionQueue;
+class OutputSink;
+class PacmanDatabaseWatcher;
 
 
 #include "src/model/packagemodel.h"
 #include "src/packagerepository.h"
+#include "src/transactionestimator.h"
+#include "src/outputparser.h"
+#include "src/transactionprogress.h"
+#include "src/packagesnapshot.h"
 
 
 //Tab indices for Properties' tabview
@@ -89,6 +99,9 @@ private:
   UnixCommand *m_unixCommand;
   bool m_initializationCompleted;
 
+  //Controls if the widgets were already set up by show() or showHidden()
+  bool m_widgetsInitialized;
+
   SearchLineEdit *m_leFilterPackage;
   QList<QModelIndex> *m_foundFilesInPkgFileList;
   int m_indFoundFilesInPkgFileList;
@@ -99,12 +112,16 @@ private:
   PackageRepository           m_packageRepo;
   std::auto_ptr<PackageModel> m_packageModel;
 
+  //Generation of the dependency graph build in g_fwDependencyGraph and the last one handed over to m_packageRepo
+  int m_dependencyGraphGeneration;
+  int m_dependencyGraphHandedOver;
+
+  //Builds for outdated package lists, their graphs are deleted as soon as they finish
+  QList<QFuture<DependencyGraph *> > m_staleDependencyGraphs;
+
   //Controls if the dialog showing the packages to be upgraded is opened
   bool m_systemUpgradeDialog;
 
-  //Searches /etc/pacman.conf to see if ILoveCandy is there
-  bool m_iLoveCandy;
-
   //Controls the calling of System Upgrade action
   bool m_callSystemUpgrade;
 
@@ -122,6 +139,20 @@ private:
 
   //This model provides the list of pending actions of a transaction
   QStandardItemModel *m_modelTransaction;
+  TransactionQueue *m_transactionQueue;
+
+  //Everything written to the Output tab goes through it
+  OutputSink *m_outputSink;
+
+  //Tells when pacman changed its databases, whoever ran it
+  PacmanDatabaseWatcher *m_pacmanDatabaseWatcher;
+
+  //Steps and timings of the running (or last) pacman transaction
+  TransactionProgress m_transactionProgress;
+
+  //Split pacman's stdout and stderr into events, holding back lines which aren't complete yet
+  OutputParser m_outputParser;
+  OutputParser m_errorParser;
 
   //This member holds the result list of Yaourt packages searched by the user
   QList<PackageListData> *m_listOfYaourtPackages;
@@ -129,15 +160,31 @@ private:
   //This member holds the list of Pacman packages available
   std::auto_ptr<QList<PackageListData> > m_listOfPackages;
 
+  //A current package snapshot (written by octopi-notifier or an earlier run), used by the next package list build
+  std::auto_ptr<PackageSnapshot> m_packageSnapshot;
+
+  //Database stamp of pacman when the shown package list was queried
+  QByteArray m_packageListStamp;
+
   //This member holds the list of Pacman packages from the selected group
   std::auto_ptr<QList<QString> > m_listOfPackagesFromGroup;
 
   //This member holds the target list retrieved by the pacman command which will be executed
   QStringList *m_targets;
 
+  //This member holds the last dry run of the install queue (or of a system upgrade) and the queue it was made for
+  std::auto_ptr<const TransactionResolver> m_transactionResolution;
+  QString m_transactionResolutionKey;
+
+  //This member holds the running download/installed size totals of tvTransaction's queues
+  TransactionEstimator m_transactionEstimator;
+
   //This member holds the list of packages to install with "pacman -U" command
   QStringList m_packagesToInstallList;
 
+  //This member holds the list of repository packages to install with "pacman -S" command
+  QStringList m_repositoryPackagesToInstallList;
+
   //This member holds the current command type being executed by Octopi
   CommandExecuting m_commandExecuting;
   CommandExecuting m_commandQueued;
@@ -188,9 +235,11 @@ private:
   bool isAllGroupsSelected();
   bool isAllGroups(const QString& group);
   bool isYaourtGroupSelected();
+  bool isOrphansGroupSelected();
 
   bool isPackageInstalled(const QString &pkgName);
   bool _isPackageTreeViewVisible();
+  QString _getPackageFilterExpression();
   void initPackageTreeView();
   void resizePackageView();
 
@@ -222,8 +271,8 @@ private:
   bool isPackageInInstallTransaction(const QString &pkgName);
   bool isPackageInRemoveTransaction(const QString &pkgName);
 
-  void insertRemovePackageIntoTransaction(const QString &pkgName);
-  void insertInstallPackageIntoTransaction(const QString &pkgName);
+  void insertRemovePackageIntoTransaction(const QStringList &pkgNames);
+  void insertInstallPackageIntoTransaction(const QStringList &pkgNames);
   void removePackagesFromRemoveTransaction();
   void removePackagesFromInstallTransaction();
   int getNumberOfTobeRemovedPackages();
@@ -239,14 +288,18 @@ private:
   bool _textInTabOutput(const QString& findText);
   bool _IsSyncingRepoInTabOutput();
 
-  bool _searchForKeyVerbs(const QString& msg);
-  bool _splitOutputStrings(const QString &output);
-  void _treatProcessOutput(const QString &pMsg);
+  void _treatProcessOutput(OutputParser &parser, const QString &output);
+  void _treatOutputEvent(const OutputParser::Event &event);
+  void _updateTransactionProgressView();
+  void _saveTransactionProgress();
   void _ensureTabVisible(const int index);
+  void _initWidgets();
   bool _isPropertiesTabWidgetVisible();
   bool _isSUAvailable();
   void writeToTabOutput(const QString &msg, TreatURLLinks treatURLLinks = ectn_TREAT_URL_LINK);
   void writeToTabOutputExt(const QString &msg);
+  void _writeOutputLine(const QString &line, const QString &color = QString());
+  static QString _getVerbColor(const QString &verb);
   void initTabOutput();
   void clearTabOutput();
 
@@ -279,13 +332,22 @@ private slots:
   void tvPackagesSearchColumnChanged(QAction*);
   void tvPackagesSelectionChanged(const QItemSelection&, const QItemSelection&);
   void tvTransactionSelectionChanged (const QItemSelection&, const QItemSelection&);
-  void tvTransactionRowsInserted(const QModelIndex& parent, int, int);
+  void tvTransactionRowsInserted(const QModelIndex& parent, int first, int last);
+  void tvTransactionRowsAboutToBeRemoved(const QModelIndex& parent, int first, int last);
   void tvTransactionRowsRemoved(const QModelIndex& parent, int, int);
 
   void _deleteStandardItemModel(QStandardItemModel * sim);
 
   void buildPackagesFromGroupList(const QString group);
   void buildPackageList(bool nonBlocking=true);
+  void _startDependencyGraphBuild();
+  void _deleteStaleDependencyGraphs(bool wait);
+  QString _getRemovalImpactText(QStandardItem *itemRemove);
+  QString _getTransactionEstimateText(QStandardItem *itemInstall);
+  const TransactionResolver& _resolveTransaction(const QString &listOfTargets, const QString &listOfRemoveTargets = "");
+  QString _getTransactionTargetList(const TransactionResolver &resolution, const QString &prefix);
+  void _checkTransaction(TransactionDialog &question, const TransactionResolver &resolution, const QString &list);
+  void _waitForDependencyGraph();
   void metaBuildPackageList();
   void onPackageGroupChanged();
 
@@ -294,6 +356,8 @@ private slots:
   void preBuildYaourtPackageList();
   void preBuildYaourtPackageListMeta();
   void buildYaourtPackageList();
+  void mergeYaourtSearchResults();
+  void postBuildDependencyGraph();
 
   void headerViewPackageListSortIndicatorClicked(int col, Qt::SortOrder order);
   void changePackageListModel();
@@ -344,7 +408,7 @@ private slots:
   void insertIntoRemovePackage();
   void insertIntoInstallPackage();
 
-  void insertIntoInstallPackageOptDeps(const QString &packageName);
+  void insertIntoInstallPackageOptDeps(const QStringList &packageNames);
   bool insertIntoRemovePackageDeps(const QStringList &dependencies);
 
   void insertGroupIntoRemovePackage();
@@ -367,6 +431,7 @@ private slots:
   void changeTransactionActionsState();
   void clearTransactionTreeView();
 
+  QTextBrowser *_getSearchTextBrowser();
   void _positionInFirstMatch();
   void searchBarTextChanged(const QString textToSearch);
   void searchBarFindNext();
@@ -382,6 +447,8 @@ private slots:
   void launchPLV();
   void launchRepoEditor();
 
+  void pacmanDatabaseChanged(const QStringList &repositories, bool local);
+
 // prototyping dependency view
   void on_actionShow_Dependencies_triggered();
   void on_actionShow_Package_list_triggered();
@@ -413,8 +480,13 @@ public:
   void setRemoveCommand(const QString &removeCommand);
   void setPackagesToInstallList(QStringList pkgList){ m_packagesToInstallList = pkgList; }
   void doInstallLocalPackages();
+  void setRepositoryPackagesToInstallList(QStringList pkgList){ m_repositoryPackagesToInstallList = pkgList; }
+  void doInstallRepositoryPackages();
+  void showHidden();
 
   bool isExecutingCommand(){ return m_commandExecuting != ectn_NONE; }
+  bool isInitializationCompleted(){ return m_initializationCompleted; }
+  void reloadPackageSnapshot();
 };
 
 #endif // MAINWINDOW_H
@@ -106,6 +106,17 @@ void MainWindow::keyPressEvent(QKeyEvent* ke)
       g_fwYaourt.setFuture(f);
       connect(&g_fwYaourt, SIGNAL(finished()), this, SLOT(preBuildYaourtPackageList()));
     }
+    //Ranked search also asks Yaourt, so official and AUR hits end up in the same list
+    else if (isAllGroupsSelected() && ui->actionSearchByRelevance->isChecked() && m_hasYaourt &&
+             m_leFilterPackage->hasFocus() && !m_leFilterPackage->text().isEmpty() && m_cic == NULL)
+    {
+      QFuture<QList<PackageListData> *> f;
+      disconnect(&g_fwYaourtRanked, SIGNAL(finished()), this, SLOT(mergeYaourtSearchResults()));
+      m_cic = new CPUIntensiveComputing();
+      f = QtConcurrent::run(searchYaourtPackages, m_leFilterPackage->text());
+      g_fwYaourtRanked.setFuture(f);
+      connect(&g_fwYaourtRanked, SIGNAL(finished()), this, SLOT(mergeYaourtSearchResults()));
+    }
     else
     {
       QTreeView *tvPkgFileList =
@@ -186,9 +197,10 @@ void MainWindow::keyPressEvent(QKeyEvent* ke)
   {
     if (_isPropertiesTabWidgetVisible() &&
         (ui->twProperties->currentIndex() == ctn_TABINDEX_NEWS ||
-         ui->twProperties->currentIndex() == ctn_TABINDEX_HELPUSAGE))
+         ui->twProperties->currentIndex() == ctn_TABINDEX_HELPUSAGE ||
+         ui->twProperties->currentIndex() == ctn_TABINDEX_OUTPUT))
     {
-      QTextBrowser *tb = ui->twProperties->currentWidget()->findChild<QTextBrowser*>("textBrowser");
+      QTextBrowser *tb = _getSearchTextBrowser();
       SearchBar *searchBar = ui->twProperties->currentWidget()->findChild<SearchBar*>("searchbar");
 
       if (tb && tb->toPlainText().size() > 0 && searchBar)
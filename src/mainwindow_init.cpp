@@ -31,6 +31,8 @@
 #include "treeviewpackagesitemdelegate.h"
 #include "searchbar.h"
 #include "packagecontroller.h"
+#include "transactionqueue.h"
+#include "outputsink.h"
 
 #include <QLabel>
 #include <QStandardItemModel>
@@ -114,7 +116,15 @@ void MainWindow::saveSettings(int saveSettingsReason){
  */
 void MainWindow::initAppIcon()
 {
-  m_outdatedPackageList = Package::getOutdatedPackageList();
+  //With a current snapshot, pacman needs no query at all until something changes
+  m_packageSnapshot.reset(new PackageSnapshot());
+  if (!m_packageSnapshot->read()) m_packageSnapshot.reset();
+
+  const std::auto_ptr<const OutdatedPackages> outdatedPackages(m_packageSnapshot.get() != NULL ?
+        Package::getOutdatedPackages(m_packageSnapshot->getPackages(), Package::getIgnoredPackageList()) :
+        Package::getOutdatedPackages());
+  delete m_outdatedPackageList;
+  m_outdatedPackageList = new QStringList(outdatedPackages->outdated);
 
   if (UnixCommand::hasTheExecutable(StrConstants::getForeignRepositoryToolName()))
   {
@@ -182,7 +192,7 @@ void MainWindow::initPackageGroups()
  */
 void MainWindow::onPackageGroupChanged()
 {
-  if (isAllGroupsSelected())
+  if (isAllGroupsSelected() && !ui->actionSearchByRelevance->isChecked())
   {
     ui->actionSearchByName->setChecked(true);
     tvPackagesSearchColumnChanged(ui->actionSearchByName);
@@ -242,6 +252,7 @@ void MainWindow::initStatusBar()
   ui->statusBar->addPermanentWidget(m_progressWidget);
 
   connect(m_lblTotalCounters, SIGNAL(linkActivated(QString)), this, SLOT(outputOutdatedPackageList()));
+  connect(m_outputSink, SIGNAL(progressChanged(int)), m_progressWidget, SLOT(setValue(int)));
 }
 
 /*
@@ -368,6 +379,7 @@ void MainWindow::initTabTransaction()
 
   m_modelTransaction->appendRow(siToBeRemoved);
   m_modelTransaction->appendRow(siToBeInstalled);
+  m_transactionQueue = new TransactionQueue(m_modelTransaction);
 
   gridLayoutX->addWidget(tvTransaction, 0, 0, 1, 1);
 
@@ -390,6 +402,8 @@ void MainWindow::initTabTransaction()
 
   connect(tvTransaction->model(), SIGNAL(rowsInserted ( const QModelIndex , int, int )),
           this, SLOT(tvTransactionRowsInserted(QModelIndex,int,int)));
+  connect(tvTransaction->model(), SIGNAL(rowsAboutToBeRemoved ( const QModelIndex , int, int )),
+          this, SLOT(tvTransactionRowsAboutToBeRemoved(QModelIndex,int,int)));
   connect(tvTransaction->model(), SIGNAL(rowsRemoved ( const QModelIndex , int, int )),
           this, SLOT(tvTransactionRowsRemoved(QModelIndex,int,int)));
 }
@@ -565,11 +579,19 @@ void MainWindow::initTabOutput()
   text->setOpenLinks(false);
   text->setFrameShape(QFrame::NoFrame);
   text->setFrameShadow(QFrame::Plain);
+  m_outputSink = new OutputSink(text);
 
   connect(text, SIGNAL(anchorClicked(QUrl)), this, SLOT(outputTextBrowserAnchorClicked(QUrl)));
 
   gridLayoutX->addWidget (text, 0, 0, 1, 1);  
 
+  SearchBar *searchBar = new SearchBar(this);
+  connect(searchBar, SIGNAL(textChanged(QString)), this, SLOT(searchBarTextChanged(QString)));
+  connect(searchBar, SIGNAL(closed()), this, SLOT(searchBarClosed()));
+  connect(searchBar, SIGNAL(findNext()), this, SLOT(searchBarFindNext()));
+  connect(searchBar, SIGNAL(findPrevious()), this, SLOT(searchBarFindPrevious()));
+  gridLayoutX->addWidget(searchBar, 1, 0, 1, 1);
+
   QString aux(StrConstants::getTabOutputName());
   ui->twProperties->removeTab(ctn_TABINDEX_OUTPUT);
 
@@ -625,6 +647,7 @@ void MainWindow::initActions()
   QActionGroup *actionGroup = new QActionGroup(this);
   actionGroup->addAction(ui->actionSearchByDescription);
   actionGroup->addAction(ui->actionSearchByName);
+  actionGroup->addAction(ui->actionSearchByRelevance);
   ui->actionSearchByName->setChecked(true);
   actionGroup->setExclusive(true);
 
@@ -29,6 +29,9 @@
 #include "uihelper.h"
 #include "globals.h"
 #include "packagecontroller.h"
+#include "transactionresolver.h"
+#include "dependencygraph.h"
+#include "pacmandatabasewatcher.h"
 #include <iostream>
 #include <cassert>
 
@@ -39,6 +42,7 @@
 #include <QTextBrowser>
 #include <QStandardItem>
 #include <QFutureWatcher>
+#include <QEventLoop>
 
 #if QT_VERSION > 0x050000
   #include <QtConcurrent/QtConcurrentRun>
@@ -99,6 +103,10 @@ void MainWindow::refreshGroupsWidget()
     m_YaourtItem = items.at(1);
   }
 
+  QTreeWidgetItem*const orphans = new QTreeWidgetItem((QTreeWidget*)0, QStringList(StrConstants::getOrphansGroup()));
+  orphans->addChild(new QTreeWidgetItem((QTreeWidget*)0, QStringList(StrConstants::getUnusedOrphansGroup())));
+  items.append(orphans);
+
   QTreeWidgetItem* lastGroupItem = NULL;
   const QStringList*const packageGroups = Package::getPackageGroups();
   foreach(QString group, *packageGroups)
@@ -274,7 +282,11 @@ void MainWindow::preBuildPackageList()
   static bool secondTime=false;
   bool hasToCallSysUpgrade = (m_callSystemUpgrade || m_callSystemUpgradeNoConfirm);
 
-  m_listOfPackages.reset(g_fwPacman.result());
+  if (m_packageSnapshot.get() != NULL)
+    m_listOfPackages.reset(new QList<PackageListData>(m_packageSnapshot->getPackages()));
+  else
+    m_listOfPackages.reset(g_fwPacman.result());
+
   buildPackageList();
 
   if(!hasToCallSysUpgrade && !secondTime && UnixCommand::hasTheExecutable(ctn_MIRROR_CHECK_APP))
@@ -308,10 +320,20 @@ void MainWindow::metaBuildPackageList()
     connect(m_leFilterPackage, SIGNAL(textChanged(QString)), this, SLOT(reapplyPackageFilter()));
     reapplyPackageFilter();
     disconnect(&g_fwPacman, SIGNAL(finished()), this, SLOT(preBuildPackageList()));
-    QFuture<QList<PackageListData> *> f;
-    f = QtConcurrent::run(searchPacmanPackages);
-    g_fwPacman.setFuture(f);
-    connect(&g_fwPacman, SIGNAL(finished()), this, SLOT(preBuildPackageList()));
+
+    if (m_packageSnapshot.get() != NULL && !m_packageSnapshot->isCurrent()) m_packageSnapshot.reset();
+    if (m_packageSnapshot.get() != NULL)
+    {
+      preBuildPackageList();
+    }
+    else
+    {
+      m_packageListStamp = PacmanDatabaseWatcher::getDatabaseStamp();
+      QFuture<QList<PackageListData> *> f;
+      f = QtConcurrent::run(searchPacmanPackages);
+      g_fwPacman.setFuture(f);
+      connect(&g_fwPacman, SIGNAL(finished()), this, SLOT(preBuildPackageList()));
+    }
   }
   else if (isYaourtGroupSelected())
   {
@@ -326,6 +348,18 @@ void MainWindow::metaBuildPackageList()
     g_fwYaourtMeta.setFuture(f);
     connect(&g_fwYaourtMeta, SIGNAL(finished()), this, SLOT(preBuildYaourtPackageListMeta()));
   }
+  else if (isOrphansGroupSelected())
+  {
+    //Orphans are computed from the dependency graph, pacman knows no such group
+    toggleSystemActions(true);
+    connect(m_leFilterPackage, SIGNAL(textChanged(QString)), this, SLOT(reapplyPackageFilter()));
+    _waitForDependencyGraph();
+    m_packageModel->applyFilter(!ui->actionNonInstalledPackages->isChecked(), getSelectedGroup());
+    reapplyPackageFilter();
+    m_numberOfInstalledPackages = m_packageRepo.getPackageList(getSelectedGroup()).size();
+    refreshStatusBar();
+    ui->twGroups->setEnabled(true);
+  }
   else
   {
     toggleSystemActions(true);
@@ -339,6 +373,120 @@ void MainWindow::metaBuildPackageList()
   }
 }
 
+/*
+ * Called when octopi-notifier has written a new package snapshot: if pacman's databases changed
+ * since our package list was queried, the list is rebuilt from that snapshot
+ */
+void MainWindow::reloadPackageSnapshot()
+{
+  if (!m_initializationCompleted || isExecutingCommand() || !isAllGroupsSelected()) return;
+
+  std::auto_ptr<PackageSnapshot> snapshot(new PackageSnapshot());
+  if (!snapshot->read() || snapshot->getDatabaseStamp() == m_packageListStamp) return;
+
+  m_packageSnapshot = snapshot;
+  metaBuildPackageList();
+}
+
+/*
+ * Starts building the dependency graph of the current package list in a worker thread
+ */
+void MainWindow::_startDependencyGraphBuild()
+{
+  m_transactionResolution.reset();
+  m_transactionEstimator.setDependencyGraph(NULL);
+  disconnect(&g_fwDependencyGraph, SIGNAL(finished()), this, SLOT(postBuildDependencyGraph()));
+
+  //The previous build belongs to an outdated package list. setFuture() drops its pending finished()
+  //signal, so it is not waited for but deleted by _deleteStaleDependencyGraphs() once it is done
+  if (m_dependencyGraphHandedOver != m_dependencyGraphGeneration)
+    m_staleDependencyGraphs.append(g_fwDependencyGraph.future());
+  _deleteStaleDependencyGraphs(false);
+
+  ++m_dependencyGraphGeneration;
+  QFuture<DependencyGraph *> f;
+  f = QtConcurrent::run(buildDependencyGraph);
+  g_fwDependencyGraph.setFuture(f);
+  connect(&g_fwDependencyGraph, SIGNAL(finished()), this, SLOT(postBuildDependencyGraph()));
+}
+
+/*
+ * Deletes the graphs of outdated builds which have finished (with wait, all of them)
+ */
+void MainWindow::_deleteStaleDependencyGraphs(bool wait)
+{
+  QList<QFuture<DependencyGraph *> >::iterator it = m_staleDependencyGraphs.begin();
+  while (it != m_staleDependencyGraphs.end())
+  {
+    if (wait) it->waitForFinished();
+    if (!it->isFinished())
+    {
+      ++it;
+      continue;
+    }
+
+    if (it->resultCount() > 0) delete it->result();
+    it = m_staleDependencyGraphs.erase(it);
+  }
+}
+
+/*
+ * Hands the freshly built dependency graph over to the package repository
+ */
+void MainWindow::postBuildDependencyGraph()
+{
+  //Once per build: _waitForDependencyGraph() may have been quicker than the finished() signal
+  if (m_dependencyGraphHandedOver == m_dependencyGraphGeneration || !g_fwDependencyGraph.isFinished()) return;
+  m_dependencyGraphHandedOver = m_dependencyGraphGeneration;
+  _deleteStaleDependencyGraphs(false);
+
+  //NULL if pacman failed, _waitForDependencyGraph() tries again when the graph is needed
+  DependencyGraph *graph = g_fwDependencyGraph.result();
+  if (graph == NULL) return;
+
+  m_transactionResolution.reset();
+  m_packageRepo.setDependencyGraph(graph);
+  m_transactionEstimator.setDependencyGraph(m_packageRepo.getDependencyGraph());
+
+  // the removal impact and the size estimate of already queued packages can be computed now
+  QStandardItem *siRemoveParent = getRemoveTransactionParentItem();
+  QStandardItem *siInstallParent = getInstallTransactionParentItem();
+  if (siRemoveParent->hasChildren()) _tvTransactionRowsChanged(siRemoveParent->index());
+  else if (siInstallParent->hasChildren()) _tvTransactionRowsChanged(siInstallParent->index());
+
+  // resolve the pending system upgrade now, so its dialog pops up right away
+  if (m_numberOfOutdatedPackages > 0) _resolveTransaction("");
+}
+
+/*
+ * Makes sure the package repository has its dependency graph, waiting for the worker thread if needed
+ */
+void MainWindow::_waitForDependencyGraph()
+{
+  if (m_packageRepo.hasDependencyGraph()) return;
+
+  CPUIntensiveComputing cic;
+  if (g_fwDependencyGraph.isRunning())
+  {
+    //Keeps the window painted, postBuildDependencyGraph() runs before the loop quits
+    QEventLoop loop;
+    connect(&g_fwDependencyGraph, SIGNAL(finished()), &loop, SLOT(quit()));
+    loop.exec(QEventLoop::ExcludeUserInputEvents);
+  }
+
+  //The build may have finished without its finished() signal being delivered yet
+  postBuildDependencyGraph();
+
+  if (!m_packageRepo.hasDependencyGraph())
+  {
+    //No build was started or pacman failed. The callers need a graph, even an empty one
+    DependencyGraph *graph = buildDependencyGraph();
+    if (graph == NULL) graph = DependencyGraph::build(QByteArray(), QByteArray());
+    m_packageRepo.setDependencyGraph(graph);
+    m_transactionEstimator.setDependencyGraph(m_packageRepo.getDependencyGraph());
+  }
+}
+
 /*
  * Outputs a list of packages that don't have a description
  */
@@ -379,21 +527,22 @@ void MainWindow::buildPackageList(bool nonBlocking)
 
   static bool firstTime = true;
 
-  if(!firstTime) //If it's not the starting of the app...
+  if(!firstTime && hasYaourt) //If it's not the starting of the app...
   {
-    //Let's get outdatedPackages list again!
-    m_outdatedPackageList = Package::getOutdatedPackageList();
-    m_numberOfOutdatedPackages = m_outdatedPackageList->count();
-
-    if (hasYaourt)
-    {
-      m_outdatedYaourtPackageList = Package::getOutdatedYaourtPackageList();
-    }
+    m_outdatedYaourtPackageList = Package::getOutdatedYaourtPackageList();
   }
 
+  //The snapshot is good for one build only
+  const std::auto_ptr<const PackageSnapshot> snapshot(nonBlocking ? m_packageSnapshot.release() : NULL);
+  m_packageSnapshot.reset();
+  if (snapshot.get() != NULL) m_packageListStamp = snapshot->getDatabaseStamp();
+  else if (!nonBlocking) m_packageListStamp = PacmanDatabaseWatcher::getDatabaseStamp();
+
   qApp->processEvents();
-  const std::auto_ptr<const QSet<QString> > unrequiredPackageList(Package::getUnrequiredPackageList());
-  const std::auto_ptr<const QSet<QString> > explicitlyInstalledPackageList(Package::getExplicitPackageList());
+  const std::auto_ptr<const QSet<QString> > unrequiredPackageList(snapshot.get() != NULL ?
+        new QSet<QString>(snapshot->getUnrequiredPackages()) : Package::getUnrequiredPackageList());
+  const std::auto_ptr<const QSet<QString> > explicitlyInstalledPackageList(snapshot.get() != NULL ?
+        new QSet<QString>(snapshot->getExplicitPackages()) : Package::getExplicitPackageList());
 
   // fetch package list
   QList<PackageListData> *list;
@@ -402,10 +551,30 @@ void MainWindow::buildPackageList(bool nonBlocking)
   else
     list = Package::getPackageList();
 
+  if(!firstTime)
+  {
+    //Let's get outdatedPackages list again, straight from the versions we've just fetched
+    const std::auto_ptr<const OutdatedPackages> outdatedPackages(
+          Package::getOutdatedPackages(*list, Package::getIgnoredPackageList()));
+    delete m_outdatedPackageList;
+    m_outdatedPackageList = new QStringList(outdatedPackages->outdated);
+    m_numberOfOutdatedPackages = m_outdatedPackageList->count();
+  }
+
   // fetch foreign package list
-  std::auto_ptr<QList<PackageListData> > listForeign(Package::getForeignPackageList());
+  std::auto_ptr<QList<PackageListData> > listForeign(snapshot.get() != NULL ?
+        new QList<PackageListData>(snapshot->getForeignPackages()) : Package::getForeignPackageList());
   qApp->processEvents();
 
+  //What we've just queried spares octopi-notifier (and our next start) the same queries
+  if (snapshot.get() == NULL)
+  {
+    PackageSnapshot fresh;
+    fresh.setData(m_packageListStamp, *list, *listForeign, *unrequiredPackageList, *explicitlyInstalledPackageList);
+    if (fresh.write() && UnixCommand::isAppRunning("octopi-notifier", true))
+      PackageSnapshot::notify(ctn_NOTIFIER_PEER_ID);
+  }
+
   m_progressWidget->setRange(0, list->count());
   m_progressWidget->setValue(0);
 
@@ -417,15 +586,13 @@ void MainWindow::buildPackageList(bool nonBlocking)
     {
       pld = PackageListData(
             itForeign->name, itForeign->repository, itForeign->version,
-            itForeign->name + " " + Package::getInformationDescription(itForeign->name, true),
-            ectn_FOREIGN);
+            "", ectn_FOREIGN); // description is loaded lazily by the repository
     }
     else
     {
       pld = PackageListData(
             itForeign->name, itForeign->repository, itForeign->version,
-            itForeign->name + " " + Package::getInformationDescription(itForeign->name, true),
-            ectn_FOREIGN_OUTDATED);
+            "", ectn_FOREIGN_OUTDATED);
     }
     list->append(pld);
 
@@ -433,6 +600,7 @@ void MainWindow::buildPackageList(bool nonBlocking)
   }
 
   m_packageRepo.setData(list, *unrequiredPackageList, *explicitlyInstalledPackageList);
+  _startDependencyGraphBuild();
   if (isAllGroupsSelected()) m_packageModel->applyFilter(!ui->actionNonInstalledPackages->isChecked(), "");
   m_progressWidget->show();
   QList<PackageListData>::const_iterator it = list->begin();
@@ -516,6 +684,12 @@ void MainWindow::buildPackageList(bool nonBlocking)
       QApplication::restoreOverrideCursor();
       doInstallLocalPackages();
     }
+    else if (m_repositoryPackagesToInstallList.count() > 0)
+    {
+      //First, let us throw away that 'wainting cursor'...
+      QApplication::restoreOverrideCursor();
+      doInstallRepositoryPackages();
+    }
   }
 
   refreshStatusBarToolButtons();
@@ -705,7 +879,7 @@ void MainWindow::refreshTabInfo(QString pkgName)
   if (text)
   {
     text->clear();
-    text->setHtml(OctopiTabInfo::formatTabInfo(*package, *m_outdatedYaourtPackagesNameVersion));
+    text->setHtml(OctopiTabInfo::formatTabInfo(*package, *m_outdatedYaourtPackagesNameVersion, m_packageRepo));
     text->scrollToAnchor(OctopiTabInfo::anchorBegin);
   }
 }
@@ -744,7 +918,7 @@ void MainWindow::refreshTabInfo(bool clearContents, bool neverQuit)
   }
 
   //If we are trying to refresh an already displayed package...
-  if (strSelectedPackage == package->repository+"#"+package->name+"#"+package->version)
+  if (strSelectedPackage == package->getRepository()+"#"+package->getName()+"#"+package->getVersion())
   {
     if (neverQuit)
     {
@@ -757,11 +931,11 @@ void MainWindow::refreshTabInfo(bool clearContents, bool neverQuit)
   CPUIntensiveComputing cic;
 
   /* Appends all info from the selected package! */
-  QString pkgName=package->name;
+  QString pkgName=package->getName();
 
   if (isYaourtGroupSelected() && package->installed() == false)
   {
-    QString aux_desc = package->description;
+    QString aux_desc = package->getDescription();
     int space = aux_desc.indexOf(' ');
     QString pkgDescription = aux_desc.mid(space+1);
     QString version = StrConstants::getVersion();
@@ -784,7 +958,7 @@ void MainWindow::refreshTabInfo(bool clearContents, bool neverQuit)
       html += "<table border=\"0\">";
       html += "<tr><th width=\"20%\"></th><th width=\"80%\"></th></tr>";
 
-      html += "<tr><td>" + version + "</td><td>" + package->version + "</td></tr>";
+      html += "<tr><td>" + version + "</td><td>" + package->getVersion() + "</td></tr>";
 
       html += "</table>";
       text->setHtml(html);
@@ -799,12 +973,12 @@ void MainWindow::refreshTabInfo(bool clearContents, bool neverQuit)
     if (text)
     {
       text->clear();
-      text->setHtml(OctopiTabInfo::formatTabInfo(*package, *m_outdatedYaourtPackagesNameVersion));
+      text->setHtml(OctopiTabInfo::formatTabInfo(*package, *m_outdatedYaourtPackagesNameVersion, m_packageRepo));
       text->scrollToAnchor(OctopiTabInfo::anchorBegin);
     }
   }
 
-  strSelectedPackage = package->repository+"#"+package->name+"#"+package->version;
+  strSelectedPackage = package->getRepository()+"#"+package->getName()+"#"+package->getVersion();
 
   if (neverQuit)
   {
@@ -856,7 +1030,7 @@ void MainWindow::refreshTabFiles(bool clearContents, bool neverQuit)
   }
 
   //If we are trying to refresh an already displayed package...
-  if (strSelectedPackage == package->repository+"#"+package->name+"#"+package->version)
+  if (strSelectedPackage == package->getRepository()+"#"+package->getName()+"#"+package->getVersion())
   {
     if (neverQuit)
     {
@@ -881,7 +1055,7 @@ void MainWindow::refreshTabFiles(bool clearContents, bool neverQuit)
 
   if (tvPkgFileList)
   {
-    QString pkgName = package->name;
+    QString pkgName = package->getName();
     QStringList fileList;
     QStandardItemModel *fakeModelPkgFileList = new QStandardItemModel(this);
     QStandardItemModel *modelPkgFileList = qobject_cast<QStandardItemModel*>(tvPkgFileList->model());
@@ -1015,7 +1189,7 @@ void MainWindow::refreshTabFiles(bool clearContents, bool neverQuit)
                                                  StrConstants::getContentsOf().arg(pkgName));   
   }
 
-  strSelectedPackage = package->repository+"#"+package->name+"#"+package->version;
+  strSelectedPackage = package->getRepository()+"#"+package->getName()+"#"+package->getVersion();
 
   if (neverQuit)
   {
@@ -1026,6 +1200,32 @@ void MainWindow::refreshTabFiles(bool clearContents, bool neverQuit)
   _closeTabFilesSearchBar();
 }
 
+/*
+ * Merges the Yaourt packages found by a ranked search into the package list of all groups,
+ * so they get ranked together with the official ones
+ */
+void MainWindow::mergeYaourtSearchResults()
+{
+  QList<PackageListData> *list = g_fwYaourtRanked.result();
+  const QSet<QString>*const unrequiredPackageList = Package::getUnrequiredPackageList();
+
+  if (isAllGroupsSelected())
+  {
+    m_packageRepo.setAURData(list, *unrequiredPackageList);
+    reapplyPackageFilter();
+  }
+
+  delete unrequiredPackageList;
+  delete list;
+
+  if (m_cic) {
+    delete m_cic;
+    m_cic = NULL;
+  }
+
+  refreshStatusBarToolButtons();
+}
+
 /*
  * This SLOT is called every time we press a key at FilterLineEdit
  */
@@ -1034,7 +1234,7 @@ void MainWindow::reapplyPackageFilter()
   CPUIntensiveComputing cic;
 
   bool isFilterPackageSelected = m_leFilterPackage->hasFocus();
-  QString search = Package::parseSearchString(m_leFilterPackage->text());
+  QString search = _getPackageFilterExpression();
 
   m_packageModel->applyFilter(search);
   int numPkgs = m_packageModel->getPackageCount();
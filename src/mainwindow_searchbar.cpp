@@ -26,26 +26,37 @@
 #include "mainwindow.h"
 #include "searchbar.h"
 #include "packagecontroller.h"
+#include "textsearchindex.h"
 
 #include <QTextBrowser>
 
+/*
+ * Returns the textBrowser of the current tab which has a searchBar, or NULL
+ */
+QTextBrowser *MainWindow::_getSearchTextBrowser()
+{
+  QTextBrowser *tb = ui->twProperties->currentWidget()->findChild<QTextBrowser*>("textBrowser");
+  if (!tb) tb = ui->twProperties->currentWidget()->findChild<QTextBrowser*>("updaterOutput");
+  if (!tb) tb = ui->twProperties->currentWidget()->findChild<QTextBrowser*>("textOutputEdit");
+  return tb;
+}
+
 /*
  * Every time the user changes the text to search inside a textBrowser...
  */
 void MainWindow::searchBarTextChanged(const QString textToSearch)
 {
   qApp->processEvents();
-  QTextBrowser *tb = ui->twProperties->currentWidget()->findChild<QTextBrowser*>("textBrowser");
-  if (!tb) tb = ui->twProperties->currentWidget()->findChild<QTextBrowser*>("updaterOutput");
-  QList<QTextEdit::ExtraSelection> extraSelections;
+  QTextBrowser *tb = _getSearchTextBrowser();
 
   if (tb){
     static int limit = SettingsManager::getHighlightedSearchItems();
 
+    TextSearchIndex *index = TextSearchIndex::forBrowser(tb);
     SearchBar *sb = ui->twProperties->currentWidget()->findChild<SearchBar*>("searchbar");
     if (textToSearch.isEmpty() || textToSearch.length() < 2){
       sb->getSearchLineEdit()->initStyleSheet();
-      tb->setExtraSelections(extraSelections);
+      index->setPattern("");
       QTextCursor tc = tb->textCursor();
       tc.clearSelection();
       tb->setTextCursor(tc);
@@ -54,28 +65,10 @@ void MainWindow::searchBarTextChanged(const QString textToSearch)
       return;
     }
 
-    if (textToSearch.length() < 2) return;
-
-    tb->setExtraSelections(extraSelections);
-    tb->moveCursor(QTextCursor::Start);
-    QColor color = QColor(Qt::yellow).lighter(130);
-
-    while(tb->find(textToSearch)){
-      QTextEdit::ExtraSelection extra;
-      extra.format.setBackground(color);
-      extra.cursor = tb->textCursor();
-      extraSelections.append(extra);
+    index->setHighlightLimit(limit);
+    index->setPattern(textToSearch);
 
-      if (limit > 0 && extraSelections.count() == limit)
-        break;
-    }
-
-    if (extraSelections.count()>0){
-      tb->setExtraSelections(extraSelections);
-      tb->setTextCursor(extraSelections.at(0).cursor);
-      QTextCursor tc = tb->textCursor();
-      tc.clearSelection();
-      tb->setTextCursor(tc);
+    if (index->getMatchCount()>0){
       _positionInFirstMatch();
     }
     else sb->getSearchLineEdit()->setNotFoundStyle();
@@ -118,15 +111,12 @@ void MainWindow::searchBarTextChangedEx(const QString textToSearch)
  */
 void MainWindow::searchBarFindNext()
 {
-  QTextBrowser *tb = ui->twProperties->currentWidget()->findChild<QTextBrowser*>("textBrowser");
-  if (!tb) tb = ui->twProperties->currentWidget()->findChild<QTextBrowser*>("updaterOutput");
+  QTextBrowser *tb = _getSearchTextBrowser();
   SearchBar *sb = ui->twProperties->currentWidget()->findChild<SearchBar*>("searchbar");
 
   if (tb && sb && !sb->getTextToSearch().isEmpty()){
-    if (!tb->find(sb->getTextToSearch())){
-      tb->moveCursor(QTextCursor::Start);
-      tb->find(sb->getTextToSearch());
-    }
+    TextSearchIndex *index = TextSearchIndex::forBrowser(tb);
+    index->select(index->findNext(tb->textCursor().selectionEnd()));
   }
 }
 
@@ -135,15 +125,12 @@ void MainWindow::searchBarFindNext()
  */
 void MainWindow::searchBarFindPrevious()
 {
-  QTextBrowser *tb = ui->twProperties->currentWidget()->findChild<QTextBrowser*>("textBrowser");
-  if (!tb) tb = ui->twProperties->currentWidget()->findChild<QTextBrowser*>("updaterOutput");
+  QTextBrowser *tb = _getSearchTextBrowser();
   SearchBar *sb = ui->twProperties->currentWidget()->findChild<SearchBar*>("searchbar");
 
   if (tb && sb && !sb->getTextToSearch().isEmpty()){
-    if (!tb->find(sb->getTextToSearch(), QTextDocument::FindBackward)){
-      tb->moveCursor(QTextCursor::End);
-      tb->find(sb->getTextToSearch(), QTextDocument::FindBackward);
-    }
+    TextSearchIndex *index = TextSearchIndex::forBrowser(tb);
+    index->select(index->findPrevious(tb->textCursor().selectionStart()));
   }
 }
 
@@ -203,9 +190,8 @@ void MainWindow::searchBarFindPreviousEx()
 void MainWindow::searchBarClosed()
 {
   searchBarTextChanged("");
-  QTextBrowser *tb = ui->twProperties->currentWidget()->findChild<QTextBrowser*>("textBrowser");
-  //if (!tb) tb = ui->twProperties->currentWidget()->findChild<QTextBrowser*>("updaterOutput");
-  tb->setFocus();
+  QTextBrowser *tb = _getSearchTextBrowser();
+  if (tb) tb->setFocus();
 }
 
 /*
@@ -223,14 +209,15 @@ void MainWindow::searchBarClosedEx()
  */
 void MainWindow::_positionInFirstMatch()
 {
-  QTextBrowser *tb = ui->twProperties->currentWidget()->findChild<QTextBrowser*>("textBrowser");
-  //if (!tb) tb = ui->twProperties->currentWidget()->findChild<QTextBrowser*>("updaterOutput");
+  QTextBrowser *tb = _getSearchTextBrowser();
   SearchBar *sb = ui->twProperties->currentWidget()->findChild<SearchBar*>("searchbar");
 
   if (tb && sb && sb->isVisible() && !sb->getTextToSearch().isEmpty()){
-    tb->moveCursor(QTextCursor::Start);
-    if (tb->find(sb->getTextToSearch()))
+    TextSearchIndex *index = TextSearchIndex::forBrowser(tb);
+    if (index->getMatchCount() > 0){
+      index->select(index->findNext(0));
       sb->getSearchLineEdit()->setFoundStyle();
+    }
     else
       sb->getSearchLineEdit()->setNotFoundStyle();
   }
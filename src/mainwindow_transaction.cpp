@@ -29,14 +29,33 @@
 #include "strconstants.h"
 #include "transactiondialog.h"
 #include "multiselectiondialog.h"
+#include "dependencygraph.h"
+#include "removalimpact.h"
+#include "transactionresolver.h"
+#include "transactionchecker.h"
+#include "outputsink.h"
+#include "transactionqueue.h"
+#include "globals.h"
 #include <iostream>
 #include <cassert>
+#include <memory>
 
 #include <QComboBox>
 #include <QProgressBar>
 #include <QMessageBox>
 #include <QStandardItem>
 #include <QTextBrowser>
+#include <QDir>
+#include <QFile>
+#include <QTime>
+#include <QEventLoop>
+#include <QFutureWatcher>
+
+#if QT_VERSION > 0x050000
+  #include <QtConcurrent/QtConcurrentRun>
+#else
+  #include <QtConcurrentRun>
+#endif
 
 /*
  * Watches the state of tvTransaction treeview to see if Commit/Rollback actions must be activated/deactivated
@@ -71,17 +90,7 @@ bool MainWindow::_isThereAPendingTransaction()
  */
 QStandardItem * MainWindow::getRemoveTransactionParentItem()
 {
-  QTreeView *tvTransaction =
-      ui->twProperties->widget(ctn_TABINDEX_TRANSACTION)->findChild<QTreeView*>("tvTransaction");
-  QStandardItemModel *sim = qobject_cast<QStandardItemModel *>(tvTransaction->model());
-  QStandardItem *si;
-
-  if(sim)
-  {
-    si = sim->item(0, 0);
-  }
-
-  return si;
+  return m_transactionQueue->getParentItem(TransactionQueue::ectn_REMOVE_QUEUE);
 }
 
 /*
@@ -89,50 +98,19 @@ QStandardItem * MainWindow::getRemoveTransactionParentItem()
  */
 QStandardItem * MainWindow::getInstallTransactionParentItem()
 {
-  QTreeView *tvTransaction =
-      ui->twProperties->widget(ctn_TABINDEX_TRANSACTION)->findChild<QTreeView*>("tvTransaction");
-  QStandardItemModel *sim = qobject_cast<QStandardItemModel *>(tvTransaction->model());
-  QStandardItem *si;
-
-  if(sim)
-  {
-    si = sim->item(1, 0);
-  }
-
-  return si;
+  return m_transactionQueue->getParentItem(TransactionQueue::ectn_INSTALL_QUEUE);
 }
 
 /*
- * Inserts the given package into the Remove parent item of the Transaction treeview
+ * Inserts the given packages into the Remove parent item of the Transaction treeview
+ * (those queued for installation are moved over)
  */
-void MainWindow::insertRemovePackageIntoTransaction(const QString &pkgName)
+void MainWindow::insertRemovePackageIntoTransaction(const QStringList &pkgNames)
 {
   QTreeView *tvTransaction =
       ui->twProperties->widget(ctn_TABINDEX_TRANSACTION)->findChild<QTreeView*>("tvTransaction");
 
-  QStandardItem * siRemoveParent = getRemoveTransactionParentItem();
-  QStandardItem * siInstallParent = getInstallTransactionParentItem();
-  QStandardItem * siPackageToRemove = new QStandardItem(IconHelper::getIconRemoveItem(), pkgName);
-  QStandardItemModel *sim = qobject_cast<QStandardItemModel *>(siRemoveParent->model());
-  QList<QStandardItem *> foundItems = sim->findItems(pkgName, Qt::MatchRecursive | Qt::MatchExactly);
-
-  int slash = pkgName.indexOf("/");
-  QString pkg = pkgName.mid(slash+1);
-  siPackageToRemove->setText(pkg);
-
-  if (foundItems.size() == 0)
-  {
-    int slash = pkgName.indexOf("/");
-    QString pkg = pkgName.mid(slash+1);
-    QList<QStandardItem *> aux = sim->findItems(pkg, Qt::MatchRecursive | Qt::MatchExactly);
-
-    if (aux.count() == 0) siRemoveParent->appendRow(siPackageToRemove);
-  }
-  else if (foundItems.size() == 1 && foundItems.at(0)->parent() == siInstallParent)
-  {
-    siInstallParent->removeRow(foundItems.at(0)->row());
-    siRemoveParent->appendRow(siPackageToRemove);
-  }
+  m_transactionQueue->insert(TransactionQueue::ectn_REMOVE_QUEUE, pkgNames);
 
   ui->twProperties->setCurrentIndex(ctn_TABINDEX_TRANSACTION);
   tvTransaction->expandAll();
@@ -140,33 +118,15 @@ void MainWindow::insertRemovePackageIntoTransaction(const QString &pkgName)
 }
 
 /*
- * Inserts the given package into the Install parent item of the Transaction treeview
+ * Inserts the given packages into the Install parent item of the Transaction treeview
+ * (those queued for removal are moved over)
  */
-void MainWindow::insertInstallPackageIntoTransaction(const QString &pkgName)
+void MainWindow::insertInstallPackageIntoTransaction(const QStringList &pkgNames)
 {
   QTreeView *tvTransaction =
       ui->twProperties->widget(ctn_TABINDEX_TRANSACTION)->findChild<QTreeView*>("tvTransaction");
-  QStandardItem * siInstallParent = getInstallTransactionParentItem();
-  QStandardItem * siPackageToInstall = new QStandardItem(IconHelper::getIconInstallItem(), pkgName);
-  QStandardItem * siRemoveParent = getRemoveTransactionParentItem();
-  QStandardItemModel *sim = qobject_cast<QStandardItemModel *>(siInstallParent->model());
-
-  QList<QStandardItem *> foundItems = sim->findItems(pkgName, Qt::MatchRecursive | Qt::MatchExactly);
-
-  if (foundItems.size() == 0)
-  {
-    int slash = pkgName.indexOf("/");
-    QString pkg = pkgName.mid(slash+1);
-    QList<QStandardItem *> aux = sim->findItems(pkg, Qt::MatchRecursive | Qt::MatchExactly);
 
-    if (aux.count() > 0) siRemoveParent->removeRow(aux.at(0)->row());
-    siInstallParent->appendRow(siPackageToInstall);
-  }
-  else if (foundItems.size() == 1 && foundItems.at(0)->parent() == siRemoveParent)
-  {
-    siRemoveParent->removeRow(foundItems.at(0)->row());
-    siInstallParent->appendRow(siPackageToInstall);
-  }
+  m_transactionQueue->insert(TransactionQueue::ectn_INSTALL_QUEUE, pkgNames);
 
   ui->twProperties->setCurrentIndex(ctn_TABINDEX_TRANSACTION);
   tvTransaction->expandAll();
@@ -178,8 +138,7 @@ void MainWindow::insertInstallPackageIntoTransaction(const QString &pkgName)
  */
 void MainWindow::removePackagesFromRemoveTransaction()
 {
-  QStandardItem * siRemove = getRemoveTransactionParentItem();
-  siRemove->removeRows(0, siRemove->rowCount());
+  m_transactionQueue->clear(TransactionQueue::ectn_REMOVE_QUEUE);
   changeTransactionActionsState();
 }
 
@@ -188,8 +147,7 @@ void MainWindow::removePackagesFromRemoveTransaction()
  */
 void MainWindow::removePackagesFromInstallTransaction()
 {
-  QStandardItem * siInstall = getInstallTransactionParentItem();
-  siInstall->removeRows(0, siInstall->rowCount());
+  m_transactionQueue->clear(TransactionQueue::ectn_INSTALL_QUEUE);
   changeTransactionActionsState();
 }
 
@@ -198,8 +156,7 @@ void MainWindow::removePackagesFromInstallTransaction()
  */
 int MainWindow::getNumberOfTobeRemovedPackages()
 {
-  QStandardItem * siRemoval = getRemoveTransactionParentItem();
-  return siRemoval->rowCount();
+  return m_transactionQueue->count(TransactionQueue::ectn_REMOVE_QUEUE);
 }
 
 /*
@@ -207,16 +164,7 @@ int MainWindow::getNumberOfTobeRemovedPackages()
  */
 QString MainWindow::getTobeRemovedPackages()
 {
-  QStandardItem * siRemoval = getRemoveTransactionParentItem();
-  QString res;
-
-  for(int c=0; c < siRemoval->rowCount(); c++)
-  {
-    res += siRemoval->child(c)->text() + " ";
-  }
-
-  res = res.trimmed();
-  return res;
+  return m_transactionQueue->getPackages(TransactionQueue::ectn_REMOVE_QUEUE).join(" ");
 }
 
 /*
@@ -224,21 +172,12 @@ QString MainWindow::getTobeRemovedPackages()
  */
 QString MainWindow::getTobeInstalledPackages()
 {
-  QStandardItem * siInstall = getInstallTransactionParentItem();
-  QString res;
-
-  for(int c=0; c < siInstall->rowCount(); c++)
-  {
-    res += siInstall->child(c)->text() + " ";
-  }
-
-  res = res.trimmed();
-  return res;
+  return m_transactionQueue->getPackages(TransactionQueue::ectn_INSTALL_QUEUE).join(" ");
 }
 
 /*
  * Inserts the current selected packages for removal into the Transaction Treeview
- * This is the SLOT, it needs to call insertRemovePackageIntoTransaction(PackageName) to work!
+ * This is the SLOT, it needs to call insertRemovePackageIntoTransaction(PackageNames) to work!
  */
 void MainWindow::insertIntoRemovePackage()
 {
@@ -253,12 +192,12 @@ void MainWindow::insertIntoRemovePackage()
     QModelIndexList selectedRows = ui->tvPackages->selectionModel()->selectedRows();
 
     //First, let's see if we are dealing with a package group
-    if(!isAllGroupsSelected())
+    if(!isAllGroupsSelected() && !isOrphansGroupSelected())
     {
       //If we are trying to remove all the group's packages, why not remove the entire group?
       if(selectedRows.count() == m_packageModel->getPackageCount())
       {
-        insertRemovePackageIntoTransaction(getSelectedGroup());
+        insertRemovePackageIntoTransaction(QStringList(getSelectedGroup()));
         return;
       }
     }
@@ -269,6 +208,8 @@ void MainWindow::insertIntoRemovePackage()
       checkDependencies = true;
     }
 
+    QStringList names;
+    QStringList targets;
     foreach(QModelIndex item, selectedRows)
     {
       const PackageRepository::PackageData*const package = m_packageModel->getData(item);
@@ -277,35 +218,25 @@ void MainWindow::insertIntoRemovePackage()
         continue;
       }
 
-      if(checkDependencies)
-      {
-        QStringList *targets = Package::getTargetRemovalList(package->name, removeCmd);
-
-        foreach(QString target, *targets)
-        {
-          int separator = target.lastIndexOf("-");
-          QString candidate = target.left(separator);
-          separator = candidate.lastIndexOf("-");
-          candidate = candidate.left(separator);
+      names.append(package->getName());
+      targets.append(package->getRepository() + "/" + package->getName());
+    }
 
-          if (candidate != package->name)
-          {
-            dependencies.append(candidate);
-          }
-        }
+    //One dependency check and one dialog for the whole selection
+    if(checkDependencies)
+    {
+      _waitForDependencyGraph();
+      const RemovalImpact impact(*m_packageRepo.getDependencyGraph(), names, removeCmd);
+      dependencies = impact.getAdditionalPackageNames();
 
-        if (dependencies.count() > 0)
-        {
-          if (!dependencies.at(0).contains("HoldPkg was found in"))
-          {
-            if (!insertIntoRemovePackageDeps(dependencies))
-              return;
-          }
-        }
+      if (dependencies.count() > 0)
+      {
+        if (!insertIntoRemovePackageDeps(dependencies))
+          return;
       }
-
-      insertRemovePackageIntoTransaction(package->repository + "/" + package->name);
     }
+
+    insertRemovePackageIntoTransaction(targets);
   }
   else
   {
@@ -319,12 +250,12 @@ void MainWindow::insertIntoRemovePackage()
 void MainWindow::insertGroupIntoRemovePackage()
 {
   _ensureTabVisible(ctn_TABINDEX_TRANSACTION);
-  insertRemovePackageIntoTransaction(getSelectedGroup());
+  insertRemovePackageIntoTransaction(QStringList(getSelectedGroup()));
 }
 
 /*
  * Inserts the current selected packages for installation into the Transaction Treeview
- * This is the SLOT, it needs to call insertInstallPackageIntoTransaction(PackageName) to work!
+ * This is the SLOT, it needs to call insertInstallPackageIntoTransaction(PackageNames) to work!
  */
 void MainWindow::insertIntoInstallPackage()
 {
@@ -336,16 +267,18 @@ void MainWindow::insertIntoInstallPackage()
 
     QModelIndexList selectedRows = ui->tvPackages->selectionModel()->selectedRows();
     //First, let's see if we are dealing with a package group
-    if(!isAllGroupsSelected())
+    if(!isAllGroupsSelected() && !isOrphansGroupSelected())
     {
       //If we are trying to insert all the group's packages, why not insert the entire group?
       if(selectedRows.count() == m_packageModel->getPackageCount())
       {
-        insertInstallPackageIntoTransaction(getSelectedGroup());
+        insertInstallPackageIntoTransaction(QStringList(getSelectedGroup()));
         return;
       }
     }
 
+    QStringList names;
+    QStringList targets;
     foreach(QModelIndex item, selectedRows)
     {
       const PackageRepository::PackageData*const package = m_packageModel->getData(item);
@@ -354,10 +287,12 @@ void MainWindow::insertIntoInstallPackage()
         continue;
       }
 
-      insertIntoInstallPackageOptDeps(package->name); //Do we have any deps???
-
-      insertInstallPackageIntoTransaction(package->repository + "/" + package->name);
+      names.append(package->getName());
+      targets.append(package->getRepository() + "/" + package->getName());
     }
+
+    insertIntoInstallPackageOptDeps(names); //Do we have any deps???
+    insertInstallPackageIntoTransaction(targets);
   }
   else
   {
@@ -370,15 +305,7 @@ void MainWindow::insertIntoInstallPackage()
  */
 bool MainWindow::isPackageInInstallTransaction(const QString &pkgName)
 {
-  QStandardItem * siInstallParent = getInstallTransactionParentItem();
-  QStandardItemModel *sim = qobject_cast<QStandardItemModel *>(siInstallParent->model());
-  const PackageRepository::PackageData*const package = m_packageRepo.getFirstPackageByName(pkgName);
-  QString repo;
-  if (package != NULL) repo = package->repository;
-
-  QList<QStandardItem *> foundItems = sim->findItems(repo + "/" + pkgName, Qt::MatchRecursive | Qt::MatchExactly);
-
-  return (foundItems.size() > 0);
+  return m_transactionQueue->contains(TransactionQueue::ectn_INSTALL_QUEUE, pkgName);
 }
 
 /*
@@ -386,63 +313,77 @@ bool MainWindow::isPackageInInstallTransaction(const QString &pkgName)
  */
 bool MainWindow::isPackageInRemoveTransaction(const QString &pkgName)
 {
-  QStandardItem * siRemoveParent = getRemoveTransactionParentItem();
-  QStandardItemModel *sim = qobject_cast<QStandardItemModel *>(siRemoveParent->model());
-
-  QList<QStandardItem *> foundItems = sim->findItems(pkgName, Qt::MatchRecursive | Qt::MatchExactly);
-
-  return (foundItems.size() > 0);
+  return m_transactionQueue->contains(TransactionQueue::ectn_REMOVE_QUEUE, pkgName);
 }
 
 /*
- * Inserts all optional deps of the current select package into the Transaction Treeview
+ * Inserts all optional deps of the given packages into the Transaction Treeview
+ * (they are looked up in the dependency graph and offered in a single dialog)
  */
-void MainWindow::insertIntoInstallPackageOptDeps(const QString &packageName)
+void MainWindow::insertIntoInstallPackageOptDeps(const QStringList &packageNames)
 {
   CPUIntensiveComputing *cic = new CPUIntensiveComputing;
+  _waitForDependencyGraph();
+  const DependencyGraph *graph = m_packageRepo.getDependencyGraph();
 
-  //Does this package have non installed optional dependencies?
-  QStringList optDeps = Package::getOptionalDeps(packageName); //si->text());
+  //Do these packages have optional dependencies no installed package satisfies?
   QList<const PackageRepository::PackageData*> optionalPackages;
+  QSet<QString> visited = QSet<QString>::fromList(packageNames);
+  QSet<QString> offered;
 
-  foreach(QString optDep, optDeps)
+  foreach(QString packageName, packageNames)
   {
-    QString candidate = optDep;
-    int points = candidate.indexOf(":");
-    candidate = candidate.mid(0, points).trimmed();
+    const int node = graph->findNode(packageName);
+    if (node == -1) continue;
 
-    const PackageRepository::PackageData*const package = m_packageRepo.getFirstPackageByName(candidate);
-    if(!isPackageInInstallTransaction(candidate) &&
-       !isPackageInstalled(candidate) && package != 0)
+    foreach(QString optDep, graph->getOptionalDepends(node))
     {
-      optionalPackages.append(package);
+      if (visited.contains(optDep)) continue;
+      visited.insert(optDep);
+      if (m_packageRepo.isSatisfiedByInstalled(optDep)) continue;
+
+      /* Virtual names like "java-runtime" are offered through the package providing them */
+      const DependencyGraph::Constraint constraint = DependencyGraph::parseConstraint(optDep);
+      const PackageRepository::PackageData* package = m_packageRepo.getFirstPackageByName(constraint.name);
+      if (package == 0)
+      {
+        const int provider = graph->resolve(constraint);
+        if (provider != -1) package = m_packageRepo.getFirstPackageByName(graph->getName(provider));
+      }
+
+      if(package != 0 && !offered.contains(package->getName()) &&
+         !isPackageInInstallTransaction(package->getName()))
+      {
+        offered.insert(package->getName());
+        optionalPackages.append(package);
+      }
     }
   }
 
   if(optionalPackages.count() > 0)
   {
     MultiSelectionDialog *msd = new MultiSelectionDialog(this);
-    msd->setWindowTitle(packageName + ": " + StrConstants::getOptionalDeps());
+    if (packageNames.count() == 1)
+      msd->setWindowTitle(packageNames.first() + ": " + StrConstants::getOptionalDeps());
+    else
+      msd->setWindowTitle(StrConstants::getOptionalDeps());
     msd->setWindowIcon(windowIcon());
     QStringList selectedPackages;
 
     foreach(const PackageRepository::PackageData* candidate, optionalPackages)
     {
-      QString desc = candidate->description;
+      QString desc = candidate->getDescription();
       int space = desc.indexOf(" ");
       desc = desc.mid(space+1);
 
-      msd->addPackageItem(candidate->name, candidate->description, candidate->repository);
+      msd->addPackageItem(candidate->getName(), candidate->getDescription(), candidate->getRepository());
     }
 
     delete cic;
     if (msd->exec() == QMessageBox::Ok)
     {
       selectedPackages = msd->getSelectedPackages();
-      foreach(QString pkg, selectedPackages)
-      {
-        insertInstallPackageIntoTransaction(pkg);
-      }
+      insertInstallPackageIntoTransaction(selectedPackages);
     }
 
     delete msd;
@@ -481,11 +422,11 @@ bool MainWindow::insertIntoRemovePackageDeps(const QStringList &dependencies)
 
     foreach(const PackageRepository::PackageData* dep, newDeps)
     {
-      QString desc = dep->description;
+      QString desc = dep->getDescription();
       int space = desc.indexOf(" ");
       desc = desc.mid(space+1);
 
-      msd->addPackageItem(dep->name, desc, dep->repository);
+      msd->addPackageItem(dep->getName(), desc, dep->getRepository());
     }
 
     msd->setAllSelected();
@@ -495,10 +436,7 @@ bool MainWindow::insertIntoRemovePackageDeps(const QStringList &dependencies)
     if (res == QMessageBox::Ok)
     {
       selectedPackages = msd->getSelectedPackages();
-      foreach(QString pkg, selectedPackages)
-      {
-        insertRemovePackageIntoTransaction(pkg);
-      }
+      insertRemovePackageIntoTransaction(selectedPackages);
     }
 
     delete msd;
@@ -514,7 +452,7 @@ bool MainWindow::insertIntoRemovePackageDeps(const QStringList &dependencies)
 void MainWindow::insertGroupIntoInstallPackage()
 {
   _ensureTabVisible(ctn_TABINDEX_TRANSACTION);
-  insertInstallPackageIntoTransaction(getSelectedGroup());
+  insertInstallPackageIntoTransaction(QStringList(getSelectedGroup()));
 }
 
 /*
@@ -573,30 +511,246 @@ void MainWindow::_tvTransactionRowsChanged(const QModelIndex& parent)
   {
     if (item->rowCount() > 0)
     {
-      itemRemove->setText(StrConstants::getTransactionRemoveText() + " (" + count + ")");
+      itemRemove->setText(StrConstants::getTransactionRemoveText() + " (" + count + ")" +
+                          _getRemovalImpactText(itemRemove));
       _tvTransactionAdjustItemText(itemRemove);
     }
-    else itemRemove->setText(StrConstants::getTransactionRemoveText());
+    else
+    {
+      itemRemove->setText(StrConstants::getTransactionRemoveText());
+      itemRemove->setToolTip("");
+    }
+  }
+
+  //The net installed size change depends on both queues
+  if ((item == itemInstall || item == itemRemove) && itemInstall->rowCount() > 0)
+  {
+    itemInstall->setText(StrConstants::getTransactionInstallText() +
+                         " (" + QString::number(itemInstall->rowCount()) + ")" +
+                         _getTransactionEstimateText(itemInstall));
+    _tvTransactionAdjustItemText(itemInstall);
   }
   else if (item == itemInstall)
   {
-    if (item->rowCount() > 0)
+    itemInstall->setText(StrConstants::getTransactionInstallText());
+    itemInstall->setToolTip("");
+  }
+}
+
+/*
+ * Computes what the queued removals will take along (using the dependency graph) and
+ * returns a short summary to be appended to the Remove parent item text.
+ * The affected packages are put in the item's tooltip.
+ */
+QString MainWindow::_getRemovalImpactText(QStandardItem *itemRemove)
+{
+  const DependencyGraph *graph = m_packageRepo.getDependencyGraph();
+  if (graph == NULL) return "";
+
+  QStringList targets;
+  for(int c=0; c < itemRemove->rowCount(); c++)
+  {
+    targets.append(itemRemove->child(c)->text());
+  }
+
+  const RemovalImpact impact(*graph, targets, m_removeCommand);
+
+  const char *label;
+  double size = Package::humanizeSize(static_cast<off_t>(impact.getFreedSize() * 1024), '\0', 2, &label);
+  QString freed = QString::number(size, 'f', 2) + " " + QString(label);
+
+  QStringList toolTip;
+  QStringList additional = impact.getAdditionalPackageNames();
+  if (additional.count() > 0)
+    toolTip.append(StrConstants::getRemovalImpactAlsoRemoves().arg(additional.join(" ")));
+  QStringList blockers = impact.getBlockingPackageNames();
+  if (blockers.count() > 0)
+    toolTip.append(StrConstants::getRemovalImpactBreaks().arg(blockers.join(" ")));
+  itemRemove->setToolTip(toolTip.join("\n"));
+
+  return " - " + StrConstants::getRemovalImpact().arg(impact.getPackageCount()).arg(freed);
+}
+
+/*
+ * Returns the running download size and net installed size change of the queued packages
+ * to be appended to the Install parent item text. Packages found in the package cache are put
+ * in the item's tooltip.
+ */
+QString MainWindow::_getTransactionEstimateText(QStandardItem *itemInstall)
+{
+  if (m_packageRepo.getDependencyGraph() == NULL) return "";
+
+  const char *label;
+  double size = Package::humanizeSize(static_cast<off_t>(m_transactionEstimator.getDownloadSize() * 1024), '\0', 2, &label);
+  QString download = QString::number(size, 'f', 2) + " " + QString(label);
+  size = Package::humanizeSize(static_cast<off_t>(m_transactionEstimator.getInstalledSizeDelta() * 1024), '\0', 2, &label);
+  QString net = (size > 0 ? "+" : "") + QString::number(size, 'f', 2) + " " + QString(label);
+
+  QStringList cached = m_transactionEstimator.getCachedPackages();
+  if (cached.count() > 0)
+    itemInstall->setToolTip(StrConstants::getTransactionEstimateCached().arg(cached.join(" ")));
+  else
+    itemInstall->setToolTip("");
+
+  return " - " + StrConstants::getTransactionEstimate().arg(download).arg(net);
+}
+
+/*
+ * Dry runs the install of the given targets (or a system upgrade, if listOfTargets is empty)
+ * on the dependency graph, after the removal of listOfRemoveTargets. The result is kept until
+ * the queues or the graph change, so preparing the same confirmation dialog again costs nothing.
+ */
+const TransactionResolver& MainWindow::_resolveTransaction(const QString &listOfTargets,
+                                                           const QString &listOfRemoveTargets)
+{
+  _waitForDependencyGraph();
+
+  const QString key = listOfTargets + "\n" + listOfRemoveTargets;
+  if (m_transactionResolution.get() == NULL || m_transactionResolutionKey != key)
+  {
+    CPUIntensiveComputing cic;
+    m_transactionResolution.reset(
+          new TransactionResolver(*m_packageRepo.getDependencyGraph(),
+                                  listOfTargets.split(" ", QString::SkipEmptyParts),
+                                  UnixCommand::getIgnorePkg(),
+                                  listOfRemoveTargets.split(" ", QString::SkipEmptyParts)));
+    m_transactionResolutionKey = key;
+  }
+
+  return *m_transactionResolution;
+}
+
+/*
+ * Builds the detailed text of a transaction dialog: problems first, then replacements and targets
+ */
+QString MainWindow::_getTransactionTargetList(const TransactionResolver &resolution, const QString &prefix)
+{
+  QString list;
+
+  foreach(const TransactionResolver::Unresolved &unresolved, resolution.getUnresolved())
+  {
+    if (unresolved.requiredBy.isEmpty())
+      list.append(StrConstants::getTransactionTargetNotFound().arg(unresolved.dependency) + "\n");
+    else
+      list.append(StrConstants::getTransactionUnresolvedDependency().arg(unresolved.dependency)
+                  .arg(unresolved.requiredBy) + "\n");
+  }
+
+  foreach(const TransactionResolver::Conflict &conflict, resolution.getConflicts())
+  {
+    list.append(StrConstants::getTransactionConflict().arg(conflict.package).arg(conflict.conflictsWith) + "\n");
+  }
+
+  foreach(const TransactionResolver::Replacement &replacement, resolution.getReplacements())
+  {
+    list.append(StrConstants::getTransactionReplacement().arg(replacement.replacedBy).arg(replacement.replaced) + "\n");
+  }
+
+  foreach(const TransactionResolver::Target &target, resolution.getTargets())
+  {
+    list.append(prefix + target.name + "-" + target.version + "\n");
+  }
+
+  list.remove(list.size()-1, 1);
+  return list;
+}
+
+/*
+ * This SLOT is called whenever pacman changed its databases, from Octopi or anywhere else
+ */
+void MainWindow::pacmanDatabaseChanged(const QStringList &repositories, bool local)
+{
+  Q_UNUSED(repositories);
+
+  if (local) TransactionChecker::invalidateInstalledFiles();
+}
+
+/*
+ * Runs the pre-flight checks of a transaction before its dialog is shown: the file collisions
+ * go on top of the detailed text and any problem is pointed out above the question
+ *
+ * The check itself runs in a worker thread. Meanwhile the window keeps being painted, but
+ * user input is held back, as the dialog can't be shown before the result is there.
+ */
+void MainWindow::_checkTransaction(TransactionDialog &question, const TransactionResolver &resolution,
+                                   const QString &list)
+{
+  CPUIntensiveComputing *cic = new CPUIntensiveComputing;
+  QEventLoop loop;
+  QFutureWatcher<TransactionChecker *> watcher;
+  connect(&watcher, SIGNAL(finished()), &loop, SLOT(quit()));
+  watcher.setFuture(QtConcurrent::run(checkTransaction, &resolution));
+  loop.exec(QEventLoop::ExcludeUserInputEvents);
+  delete cic;
+
+  const std::auto_ptr<TransactionChecker> result(watcher.result());
+  const TransactionChecker &checker = *result;
+
+  QString report;
+  if (!checker.getFileCollisions().isEmpty())
+  {
+    report.append(StrConstants::getTransactionFileCollisions() + "\n");
+    foreach(const TransactionChecker::FileCollision &collision, checker.getFileCollisions())
     {
-      itemInstall->setText(StrConstants::getTransactionInstallText() + " (" + count + ")");
-      _tvTransactionAdjustItemText(itemInstall);
+      if (collision.owner.isEmpty())
+        report.append(StrConstants::getTransactionFileExists().arg(collision.package).arg(collision.file) + "\n");
+      else
+        report.append(StrConstants::getTransactionFileOwned().arg(collision.package).arg(collision.file)
+                      .arg(collision.owner) + "\n");
     }
-    else itemInstall->setText(StrConstants::getTransactionInstallText());
+    report.append("\n");
+  }
+  else if (!checker.hasFileLists() && !resolution.getTargets().isEmpty())
+  {
+    report.append(StrConstants::getTransactionFileListsUnavailable() + "\n\n");
+  }
+
+  question.setDetailedText(report + list);
+  if (!resolution.getUnresolved().isEmpty())
+  {
+    /* pacman refuses transactions with missing targets or dependencies, so there's nothing to confirm */
+    question.removeYesButton();
+    question.setInformativeText(StrConstants::getTransactionUnresolved());
+  }
+  else if (checker.hasProblems())
+  {
+    question.setInformativeText(StrConstants::getTransactionCheckFailed() + "\n" +
+                                StrConstants::getConfirmationQuestion());
   }
 }
 
 /*
  * SLOT called each time some item is inserted into tvTransaction
  */
-void MainWindow::tvTransactionRowsInserted(const QModelIndex& parent, int, int)
+void MainWindow::tvTransactionRowsInserted(const QModelIndex& parent, int first, int last)
 {
+  QStandardItem *item = m_modelTransaction->itemFromIndex(parent);
+  if (item == getInstallTransactionParentItem() || item == getRemoveTransactionParentItem())
+  {
+    TransactionEstimator::EQueue queue = (item == getInstallTransactionParentItem() ?
+                                            TransactionEstimator::ectn_INSTALL_QUEUE :
+                                            TransactionEstimator::ectn_REMOVE_QUEUE);
+    for (int r=first; r <= last; r++) m_transactionEstimator.add(queue, item->child(r)->text());
+  }
+
   _tvTransactionRowsChanged(parent);
 }
 
+/*
+ * SLOT called right before items are removed from tvTransaction (their names are still there)
+ */
+void MainWindow::tvTransactionRowsAboutToBeRemoved(const QModelIndex& parent, int first, int last)
+{
+  QStandardItem *item = m_modelTransaction->itemFromIndex(parent);
+  if (item == getInstallTransactionParentItem() || item == getRemoveTransactionParentItem())
+  {
+    TransactionEstimator::EQueue queue = (item == getInstallTransactionParentItem() ?
+                                            TransactionEstimator::ectn_INSTALL_QUEUE :
+                                            TransactionEstimator::ectn_REMOVE_QUEUE);
+    for (int r=first; r <= last; r++) m_transactionEstimator.remove(queue, item->child(r)->text());
+  }
+}
+
 /*
  * SLOT called each time some item is removed from tvTransaction
  */
@@ -797,16 +951,17 @@ void MainWindow::doSystemUpgrade(SystemUpgradeOptions systemUpgradeOptions)
   else
   {
     //Shows a dialog indicating the targets needed to be retrieved and asks for the user's permission.
-    QList<PackageListData> * targets = Package::getTargetUpgradeList();
+    const TransactionResolver &resolution = _resolveTransaction("");
+    const int targetCount = resolution.getTargets().count();
 
     //There are no new updates to install!
-    if (targets->count() == 0 && m_outdatedPackageList->count() == 0)
+    if (targetCount == 0 && m_outdatedPackageList->count() == 0)
     {
       clearTabOutput();
       writeToTabOutputExt("<b>" + StrConstants::getNoNewUpdatesAvailable() + "</b>");
       return;
     }
-    else if (targets->count() == 0 && m_outdatedPackageList->count() > 0)
+    else if (targetCount == 0 && m_outdatedPackageList->count() > 0)
     {
       //This is a bug and should be shown to the user!
       clearTabOutput();
@@ -814,15 +969,7 @@ void MainWindow::doSystemUpgrade(SystemUpgradeOptions systemUpgradeOptions)
       return;
     }
 
-    QString list;
-    double totalDownloadSize = 0;
-
-    foreach(PackageListData target, *targets)
-    {
-      totalDownloadSize += target.downloadSize;
-      list = list + target.name + "-" + target.version + "\n";
-    }
-    list.remove(list.size()-1, 1);
+    QString list = _getTransactionTargetList(resolution, "");
 
     //User already confirmed all updates in the notifier window!
     if (systemUpgradeOptions == ectn_NOCONFIRM_OPT)
@@ -840,21 +987,21 @@ void MainWindow::doSystemUpgrade(SystemUpgradeOptions systemUpgradeOptions)
     else
     {
       //Let's build the system upgrade transaction dialog...
-      totalDownloadSize = totalDownloadSize / 1024;
-      QString ds = QString::number(totalDownloadSize, 'f', 2);
+      QString ds = QString::number(resolution.getDownloadSize(), 'f', 2);
 
       TransactionDialog question(this);
 
-      if(targets->count()==1)
+      if(targetCount==1)
         question.setText(StrConstants::getRetrieveTarget() +
                          "\n\n" + StrConstants::getTotalDownloadSize().arg(ds));
       else
-        question.setText(StrConstants::getRetrieveTargets().arg(targets->count()) +
+        question.setText(StrConstants::getRetrieveTargets().arg(targetCount) +
                          "\n\n" + StrConstants::getTotalDownloadSize().arg(ds));
 
       question.setWindowTitle(StrConstants::getConfirmation());
       question.setInformativeText(StrConstants::getConfirmationQuestion());
       question.setDetailedText(list);
+      _checkTransaction(question, resolution, list);
 
       m_systemUpgradeDialog = true;
       int result = question.exec();
@@ -909,26 +1056,10 @@ void MainWindow::doRemoveAndInstall()
   }
 
   QString listOfInstallTargets = getTobeInstalledPackages();
-  QList<PackageListData> *installTargets = Package::getTargetUpgradeList(listOfInstallTargets);
-  QString installList;
-
-  double totalDownloadSize = 0;
-  foreach(PackageListData installTarget, *installTargets)
-  {
-    totalDownloadSize += installTarget.downloadSize;
-    installList.append(StrConstants::getInstall() + " " +
-                       installTarget.name + "-" + installTarget.version + "\n");
-  }
-  installList.remove(installList.size()-1, 1);
-
-  totalDownloadSize = totalDownloadSize / 1024;
-  QString ds = QString::number(totalDownloadSize, 'f', 2);
-
-  if (installList.count() == 0)
-  {
-    installTargets->append(PackageListData(listOfInstallTargets, "", 0));
-    installList.append(StrConstants::getInstall() + " " + listOfInstallTargets);
-  }
+  const TransactionResolver &installResolution = _resolveTransaction(listOfInstallTargets, listOfRemoveTargets);
+  const int installTargetCount = installResolution.getTargets().count();
+  QString installList = _getTransactionTargetList(installResolution, StrConstants::getInstall() + " ");
+  QString ds = QString::number(installResolution.getDownloadSize(), 'f', 2);
 
   allLists.append(removeList);
   allLists.append(installList);
@@ -942,15 +1073,6 @@ void MainWindow::doRemoveAndInstall()
       return;
     }
   }
-  else if(installTargets->count()==1)
-  {
-    if (installTargets->at(0).name.indexOf("HoldPkg was found in") != -1)
-    {
-      QMessageBox::warning(
-            this, StrConstants::getAttention(), StrConstants::getWarnHoldPkgFound(), QMessageBox::Ok);
-      return;
-    }
-  }
 
   if (removeTargets.count() == 1)
   {
@@ -960,14 +1082,14 @@ void MainWindow::doRemoveAndInstall()
   {
     dialogText = StrConstants::getRemoveTargets().arg(removeTargets.count()) + "\n";
   }
-  if (installTargets->count() == 1)
+  if (installTargetCount == 1)
   {
     dialogText += StrConstants::getRetrieveTarget() +
       "\n\n" + StrConstants::getTotalDownloadSize().arg(ds);
   }
-  else if (installTargets->count() > 1)
+  else if (installTargetCount > 1)
   {
-    dialogText += StrConstants::getRetrieveTargets().arg(installTargets->count()) +
+    dialogText += StrConstants::getRetrieveTargets().arg(installTargetCount) +
       "\n\n" + StrConstants::getTotalDownloadSize().arg(ds);
   }
 
@@ -975,6 +1097,7 @@ void MainWindow::doRemoveAndInstall()
   question.setWindowTitle(StrConstants::getConfirmation());
   question.setInformativeText(StrConstants::getConfirmationQuestion());
   question.setDetailedText(allLists);
+  _checkTransaction(question, installResolution, allLists);
   int result = question.exec();
 
   if(result == QDialogButtonBox::Yes || result == QDialogButtonBox::AcceptRole)
@@ -1142,13 +1265,13 @@ void MainWindow::doInstallYaourtPackage()
       assert(false);
       continue;
     }
-    if (package->repository != StrConstants::getForeignRepositoryName()) {
+    if (package->getRepository() != StrConstants::getForeignRepositoryName()) {
       std::cerr << "Octopi could not install selection using yaourt" << std::endl;
       return;
     }
 
     listOfTargets += StrConstants::getForeignRepositoryTargetPrefix() +
-        package->name + " ";
+        package->getName() + " ";
   }
 
   if (listOfTargets.isEmpty()) {
@@ -1191,7 +1314,7 @@ void MainWindow::doRemoveYaourtPackage()
       continue;
     }
 
-    listOfTargets += package->name + " ";
+    listOfTargets += package->getName() + " ";
   }
 
   m_lastCommandList.clear();
@@ -1229,46 +1352,24 @@ void MainWindow::doRemoveYaourtPackage()
 void MainWindow::doInstall()
 {
   QString listOfTargets = getTobeInstalledPackages();
-  QList<PackageListData> *targets = Package::getTargetUpgradeList(listOfTargets);
-  QString list;
-
-  double totalDownloadSize = 0;
-  foreach(PackageListData target, *targets)
-  {
-    totalDownloadSize += target.downloadSize;
-    list = list + target.name + "-" + target.version + "\n";
-  }
-  list.remove(list.size()-1, 1);
-
-  totalDownloadSize = totalDownloadSize / 1024;
-  QString ds = QString::number(totalDownloadSize, 'f', 2);
-
-  if (list.count() == 0)
-  {
-    targets->append(PackageListData(listOfTargets, "", 0));
-    list.append(listOfTargets);
-  }
+  const TransactionResolver &resolution = _resolveTransaction(listOfTargets);
+  const int targetCount = resolution.getTargets().count();
+  QString list = _getTransactionTargetList(resolution, "");
+  QString ds = QString::number(resolution.getDownloadSize(), 'f', 2);
 
   TransactionDialog question(this);
 
-  if(targets->count()==1)
-  {
-    if (targets->at(0).name.indexOf("HoldPkg was found in") != -1)
-    {
-      QMessageBox::warning(
-            this, StrConstants::getAttention(), StrConstants::getWarnHoldPkgFound(), QMessageBox::Ok);
-      return;
-    }
-    else question.setText(StrConstants::getRetrieveTarget() +
-                          "\n\n" + StrConstants::getTotalDownloadSize().arg(ds));
-  }
+  if(targetCount==1)
+    question.setText(StrConstants::getRetrieveTarget() +
+                     "\n\n" + StrConstants::getTotalDownloadSize().arg(ds));
   else
-    question.setText(StrConstants::getRetrieveTargets().arg(targets->count()) +
+    question.setText(StrConstants::getRetrieveTargets().arg(targetCount) +
                      "\n\n" + StrConstants::getTotalDownloadSize().arg(ds));
 
   question.setWindowTitle(StrConstants::getConfirmation());
   question.setInformativeText(StrConstants::getConfirmationQuestion());
   question.setDetailedText(list);
+  _checkTransaction(question, resolution, list);
   int result = question.exec();
 
   if(result == QDialogButtonBox::Yes || result == QDialogButtonBox::AcceptRole)
@@ -1384,6 +1485,20 @@ void MainWindow::doInstallLocalPackages()
   }
 }
 
+/*
+ * Queues the repository packages given with "-install" (or by the notifier) and installs them with "pacman -S"
+ */
+void MainWindow::doInstallRepositoryPackages()
+{
+  if (m_repositoryPackagesToInstallList.isEmpty()) return;
+
+  _ensureTabVisible(ctn_TABINDEX_TRANSACTION);
+  insertInstallPackageIntoTransaction(m_repositoryPackagesToInstallList);
+  m_repositoryPackagesToInstallList.clear();
+
+  doInstall();
+}
+
 /*
  * Clears the local package cache using "pacman -Sc"
  */
@@ -1536,7 +1651,23 @@ void MainWindow::actionsProcessStarted()
 {
   m_progressWidget->setValue(0);
   m_progressWidget->setMaximum(100);
-  m_iLoveCandy = UnixCommand::isILoveCandyEnabled();
+  m_progressWidget->setFormat("%p%");
+  m_progressWidget->setToolTip("");
+
+  //The resolver already knows how much is coming, which helps the first time estimates
+  if ((m_commandExecuting == ectn_INSTALL ||
+       m_commandExecuting == ectn_SYSTEM_UPGRADE ||
+       m_commandExecuting == ectn_REMOVE_INSTALL) && m_transactionResolution.get() != NULL)
+  {
+    m_transactionProgress.start(m_transactionResolution->getTargets().count(),
+                                m_transactionResolution->getDownloadSize());
+  }
+  else
+  {
+    m_transactionProgress.start(0, 0);
+  }
+  m_outputParser.reset();
+  m_errorParser.reset();
 
   clearTabOutput();
 
@@ -1589,6 +1720,16 @@ void MainWindow::actionsProcessFinished(int exitCode, QProcess::ExitStatus exitS
 {
   bool bRefreshGroups = true;
 
+  //The watcher only reports once pacman's changes have settled, but the next dialog may come sooner
+  TransactionChecker::invalidateInstalledFiles();
+
+  //Whatever pacman wrote last without a line break is still held back by the parsers
+  foreach(const OutputParser::Event &event, m_outputParser.flush() + m_errorParser.flush())
+  {
+    _treatOutputEvent(event);
+  }
+
+  m_outputSink->flush();
   m_progressWidget->close();
 
   ui->twProperties->setTabText(ctn_TABINDEX_OUTPUT, StrConstants::getTabOutputName());
@@ -1603,6 +1744,9 @@ void MainWindow::actionsProcessFinished(int exitCode, QProcess::ExitStatus exitS
                      StrConstants::getCommandFinishedWithErrors() + "</b><br>");
   }
 
+  m_transactionProgress.finish(exitCode == 0 && exitStatus == QProcess::NormalExit);
+  _saveTransactionProgress();
+
   if(m_commandQueued == ectn_SYSTEM_UPGRADE)
   {
     //Did it synchronize any repo? If so, let's refresh some things...
@@ -1744,7 +1888,7 @@ void MainWindow::actionsProcessReadOutput()
   if (WMHelper::getSUCommand().contains("kdesu"))
   {
     QString msg = m_unixCommand->readAllStandardOutput();
-    _splitOutputStrings(msg);
+    _treatProcessOutput(m_outputParser, msg);
   }
   else if (WMHelper::getSUCommand().contains("gksu"))
   {
@@ -1760,315 +1904,165 @@ void MainWindow::actionsProcessReadOutput()
   }
 }
 
-/*
- * Searches the given msg for a series of verbs that a Pacman transaction may produce
- */
-bool MainWindow::_searchForKeyVerbs(const QString &msg)
-{
-  return (msg.contains(QRegExp("checking ")) ||
-          msg.contains(QRegExp("loading ")) ||
-          msg.contains(QRegExp("installing ")) ||
-          msg.contains(QRegExp("upgrading ")) ||
-          msg.contains(QRegExp("resolving ")) ||
-          msg.contains(QRegExp("looking ")) ||
-          msg.contains(QRegExp("removing ")));
-}
-
 /*
  * Processes the output of the 'pacman process' so we can update percentages and messages at real time
  */
-void MainWindow::_treatProcessOutput(const QString &pMsg)
-{  
+void MainWindow::_treatProcessOutput(OutputParser &parser, const QString &output)
+{
   if (m_commandExecuting == ectn_RUN_IN_TERMINAL ||
       m_commandExecuting == ectn_RUN_SYSTEM_UPGRADE_IN_TERMINAL) return;
 
-  bool continueTesting = false;
-  QString perc;
-  QString msg = pMsg;
-
-  QString progressRun;
-  QString progressEnd;
-  msg.remove(QRegExp(".+\\[Y/n\\].+"));
-  //msg.remove(QRegExp("warning:\\S{0}"));
-
-  msg.remove("\033[0;1m");
-  msg.remove("\033[0m");
-  msg.remove("[1;33m");
-  msg.remove("\033[1;34m"); //strings starting with ::
-  msg.remove("\033[0;1m");
+  foreach(const OutputParser::Event &event, parser.parse(output))
+  {
+    _treatOutputEvent(event);
+  }
 
-  if (msg.contains("exists in filesystem")) return;
+  if(m_commandExecuting == ectn_NONE)
+    ui->twProperties->setTabText(ctn_TABINDEX_OUTPUT, StrConstants::getTabOutputName());
+}
 
-  //std::cout << "_treat: " << msg.toAscii().data() << std::endl;
+/*
+ * Shows one line of the pacman output in the Output tab and moves the progress bar
+ */
+void MainWindow::_treatOutputEvent(const OutputParser::Event &event)
+{
+  const bool isTransaction = (m_commandExecuting == ectn_INSTALL ||
+                              m_commandExecuting == ectn_SYSTEM_UPGRADE ||
+                              m_commandExecuting == ectn_SYNC_DATABASE ||
+                              m_commandExecuting == ectn_REMOVE ||
+                              m_commandExecuting == ectn_REMOVE_INSTALL);
 
-  if (m_iLoveCandy)
-  {
-    progressRun = "m]";
-    progressEnd = "100%";
-  }
-  else
+  if (isTransaction)
   {
-    progressRun = "-]";
-    progressEnd = "#]";
+    /* The view follows new steps and the progress of the running one, so the time left keeps moving */
+    const QList<TransactionProgress::Step> &steps = m_transactionProgress.getSteps();
+    const int stepCount = steps.count();
+    const int percent = steps.isEmpty() ? -1 : steps.last().percent;
+    m_transactionProgress.addEvent(event);
+    if (steps.count() != stepCount || (!steps.isEmpty() && steps.last().percent != percent))
+      _updateTransactionProgressView();
   }
 
-  //If it is a percentage, we are talking about curl output...
-  if(msg.indexOf(progressEnd) != -1)
+  switch (event.type)
   {
-    perc = "100%";
-    if (!m_progressWidget->isVisible()) m_progressWidget->show();
-    m_progressWidget->setValue(100);
-    continueTesting = true;
-  }
+  case OutputParser::ectn_PROGRESS:
+    if (isTransaction) _writeOutputLine(event.text, _getVerbColor(event.verb));
+    break;
 
-  if (msg.indexOf(progressRun) != -1 || continueTesting)
-  {
-    if (!continueTesting){
-      perc = msg.right(4).trimmed();
+  case OutputParser::ectn_DOWNLOAD:
+    if (!isTransaction) break;
+    if (m_commandExecuting != ectn_SYNC_DATABASE)
+    {
+      _writeOutputLine(event.target, "#b4ab58"); //#C9BE62
     }
-
-    continueTesting = false;
-
-    int aux = msg.indexOf("[");
-    if (aux > 0 && !msg.at(aux-1).isSpace()) return;
-
-    QString target;
-    if (m_commandExecuting == ectn_INSTALL ||
-        m_commandExecuting == ectn_SYSTEM_UPGRADE ||
-        m_commandExecuting == ectn_SYNC_DATABASE ||
-        m_commandExecuting == ectn_REMOVE ||
-        m_commandExecuting == ectn_REMOVE_INSTALL)
+    else if (!event.target.contains("/"))
     {
-      int ini = msg.indexOf(QRegExp("\\(\\s{0,3}[0-9]{1,4}/[0-9]{1,4}\\) "));
-      if (ini == 0)
-      {
-        int rp = msg.indexOf(")");
-        msg = msg.remove(0, rp+2);
+      _writeOutputLine(StrConstants::getSyncing() + " " + event.target, "#FF8040"); //ORANGE
+    }
+    break;
 
-        if (_searchForKeyVerbs(msg))
-        {
-          int end = msg.indexOf("[");
-          msg = msg.remove(end, msg.size()-end).trimmed() + " ";
-          writeToTabOutputExt(msg);
-        }
-        else
-        {
-          //std::cout << "test1: " << target.toAscii().data() << std::endl;
-          int pos = msg.indexOf(" ");
-          if (pos >=0)
-          {
-            target = msg.left(pos);
-            target = target.trimmed() + " ";
-            //std::cout << "target: " << target.toAscii().data() << std::endl;
-
-            if(!target.isEmpty())
-            {
-              writeToTabOutputExt("<b><font color=\"#b4ab58\">" + target + "</font></b>"); //#C9BE62
-            }
-          }
-          else
-          {
-            writeToTabOutputExt("<b><font color=\"#b4ab58\">" + msg + "</font></b>"); //#C9BE62
-          }
-        }
-      }
-      else if (ini == -1)
+  case OutputParser::ectn_STAGE:
+    if (event.verb == "removing")
+    {
+      if (!m_outputSink->contains(event.text))
       {
-        if (_searchForKeyVerbs(msg))
-        {
-          //std::cout << "test2: " << msg.toAscii().data() << std::endl;
-
-          int end = msg.indexOf("[");
-          msg = msg.remove(end, msg.size()-end);
-          msg = msg.trimmed() + " ";
-
-          writeToTabOutputExt(msg);
-        }
-        else
+        //Does this package exist or is it a proccessOutput buggy string???
+        const PackageRepository::PackageData*const package = m_packageRepo.getFirstPackageByName(event.target);
+        if (event.target.contains("...") || (package != NULL && package->installed()))
         {
-          int pos = msg.indexOf(" ");
-          if (pos >=0)
-          {
-            target = msg.left(pos);
-            target = target.trimmed() + " ";
-            //std::cout << "target: " << target.toAscii().data() << std::endl;
-
-            if(!target.isEmpty() && !_textInTabOutput(target))
-            {
-              if (target.indexOf(QRegExp("[a-z]+")) != -1)
-              {
-                if(m_commandExecuting == ectn_SYNC_DATABASE && !target.contains("/"))
-                {
-                  writeToTabOutputExt("<b><font color=\"#FF8040\">" +
-                                      StrConstants::getSyncing() + " " + target + "</font></b>");
-                }
-                else if (m_commandExecuting != ectn_SYNC_DATABASE)
-                {
-                  writeToTabOutputExt("<b><font color=\"#b4ab58\">" +
-                                      target + "</font></b>"); //#C9BE62
-                }
-              }
-            }
-          }
-          else
-          {
-            writeToTabOutputExt("<b><font color=\"blue\">" + msg + "</font></b>");
-          }
+          _writeOutputLine(event.text, _getVerbColor(event.verb));
         }
       }
     }
-
-    //Here we print the transaction percentage updating
-    if(!perc.isEmpty() && perc.indexOf("%") > 0)
+    else if (!event.text.startsWith(":: Synchronizing package databases...") &&
+             !event.text.startsWith(":: Starting full system upgrade..."))
     {
-      int percentage = perc.left(perc.size()-1).toInt();
-      if (!m_progressWidget->isVisible()) m_progressWidget->show();
-      m_progressWidget->setValue(percentage);
+      _writeOutputLine(event.text, _getVerbColor(event.verb));
     }
-  }
-  //It's another error, so we have to output it
-  else
-  {      
-    //Let's supress some annoying string bugs...
-    msg.remove(QRegExp("\\(process.+"));
-    msg.remove(QRegExp("Using the fallback.+"));
-    msg.remove(QRegExp("Gkr-Message:.+"));
-    msg.remove(QRegExp("kdesu.+"));
-    msg.remove(QRegExp("kbuildsycoca.+"));
-    msg.remove(QRegExp("Connecting to deprecated signal.+"));
-    msg.remove(QRegExp("QVariant.+"));
-    msg.remove(QRegExp("gksu-run.+"));
-    msg.remove(QRegExp(":: Do you want.+"));
-    msg = msg.trimmed();
+    break;
 
-    //std::cout << "debug: " << msg.toAscii().data() << std::endl;
+  case OutputParser::ectn_ERROR:
+    _writeOutputLine(event.text, "#E55451"); //RED
+    break;
 
-    QString order;
-    int ini = msg.indexOf(QRegExp("\\(\\s{0,3}[0-9]{1,4}/[0-9]{1,4}\\) "));
-    if (ini == 0)
+  case OutputParser::ectn_WARNING:
+    _writeOutputLine(event.text, "#FF8040"); //ORANGE
+    break;
+
+  case OutputParser::ectn_TEXT:
+    if (m_commandExecuting == ectn_SYNC_DATABASE && event.text.endsWith("is up to date"))
     {
-      int rp = msg.indexOf(")");
-      order = msg.left(rp+2);
-      msg = msg.remove(0, rp+2);
+      if (!m_progressWidget->isVisible()) m_progressWidget->show();
+      m_outputSink->setProgress(100);
+      _writeOutputLine(event.text.section(' ', 0, 0) + " " + StrConstants::getIsUpToDate());
     }
-
-    if (!msg.isEmpty())
+    else
     {
-      if (msg.contains(QRegExp("removing ")) && !_textInTabOutput(msg + " "))
-      {
-        //Does this package exist or is it a proccessOutput buggy string???
-        QString pkgName = msg.mid(9).trimmed();
-
-        const PackageRepository::PackageData*const package = m_packageRepo.getFirstPackageByName(pkgName);
-        if (pkgName.indexOf("...") != -1 || //TODO: maybe && was meant ?, what does pacman actually do here ?
-            (package != NULL && package->installed()))
-        {
-          writeToTabOutputExt("<b><font color=\"#E55451\">" + msg + "</font></b>"); //RED
-        }
-      }
-      else
-      {
-        QString altMsg = msg;
-
-        if (msg.indexOf(":: Synchronizing package databases...") == -1 &&
-            msg.indexOf(":: Starting full system upgrade...") == -1)
-        {
-          //std::cout << "Entered here: " << msg.toAscii().data() << std::endl;
-
-          if (m_commandExecuting == ectn_SYNC_DATABASE &&
-              msg.indexOf("is up to date"))
-          {
-            if (!m_progressWidget->isVisible()) m_progressWidget->show();
-            m_progressWidget->setValue(100);
-
-            int blank = msg.indexOf(" ");
-            QString repo = msg.left(blank);
-
-            if (repo.contains("error")) return;
+      _writeOutputLine(event.text); //BLACK
+    }
+    break;
 
-            altMsg = repo + " " + StrConstants::getIsUpToDate();
-          }
+  case OutputParser::ectn_NOISE:
+    break;
+  }
 
-          writeToTabOutputExt(altMsg); //BLACK
-        }
-      }
-    }
+  //Here we print the transaction percentage updating
+  if (event.percent != -1)
+  {
+    if (!m_progressWidget->isVisible()) m_progressWidget->show();
+    m_outputSink->setProgress(event.percent);
   }
+}
 
-  if(m_commandExecuting == ectn_NONE)
-    ui->twProperties->setTabText(ctn_TABINDEX_OUTPUT, StrConstants::getTabOutputName());
+/*
+ * This SLOT is called whenever Pacman's process has something to output to Standard error
+ */
+void MainWindow::actionsProcessRaisedError()
+{
+  QString msg = m_unixCommand->readAllStandardError();
+  _treatProcessOutput(m_errorParser, msg);
 }
 
 /*
- * Breaks the output generated by QProcess so we can parse the strings
- * and give a better feedback to our users (including showing percentages)
- *
- * Returns true if the given output was split
+ * Shows the running step of the transaction and the time left in the progress bar,
+ * the time spent in each phase goes to its tooltip
  */
-bool MainWindow::_splitOutputStrings(const QString &output)
+void MainWindow::_updateTransactionProgressView()
 {
-  bool res = true;
-  QString msg = output.trimmed();
-  QStringList msgs = msg.split(QRegExp("\\n"), QString::SkipEmptyParts);
+  QString format = "%p%";
+  const QString step = m_transactionProgress.getCurrentStepText();
+  if (!step.isEmpty()) format += " " + step;
 
-  foreach (QString m, msgs)
+  const int secondsLeft = m_transactionProgress.getEstimatedSecondsLeft();
+  if (secondsLeft >= 0)
   {
-    QStringList m2 = m.split(QRegExp("\\(\\s{0,3}[0-9]{1,4}/[0-9]{1,4}\\) "), QString::SkipEmptyParts);
-
-    if (m2.count() == 1)
-    {
-      //Let's try another test... if it doesn't work, we give up.
-      QStringList maux = m.split(QRegExp("%"), QString::SkipEmptyParts);
-      if (maux.count() > 1)
-      {
-        foreach (QString aux, maux)
-        {
-          aux = aux.trimmed();
-          if (!aux.isEmpty())
-          {
-            if (aux.at(aux.count()-1).isDigit())
-            {
-              aux += "%";
-            }
-
-            //std::cout << "Error1: " << aux.toAscii().data() << std::endl;
-            _treatProcessOutput(aux);
-          }
-        }
-      }
-      else if (maux.count() == 1)
-      {
-        if (!m.isEmpty())
-        {
-          //std::cout << "Error2: " << m.toAscii().data() << std::endl;
-          _treatProcessOutput(m);
-        }
-      }
-    }
-    else if (m2.count() > 1)
-    {
-      foreach (QString m3, m2)
-      {
-        if (!m3.isEmpty())
-        {
-          //std::cout << "Error3: " << m3.toAscii().data() << std::endl;
-          _treatProcessOutput(m3);
-        }
-      }
-    }
-    else res = false;
+    const QTime timeLeft = QTime(0, 0).addSecs(secondsLeft);
+    format += " - " + StrConstants::getTimeLeft().arg(timeLeft.toString(secondsLeft >= 3600 ? "h:mm:ss" : "mm:ss"));
   }
+  m_progressWidget->setFormat(format);
 
-  return res;
+  m_progressWidget->setToolTip(StrConstants::getTransactionPhaseTimes()
+      .arg(m_transactionProgress.getPhaseDuration(TransactionProgress::ectn_DOWNLOAD) / 1000.0, 0, 'f', 1)
+      .arg(m_transactionProgress.getPhaseDuration(TransactionProgress::ectn_CHECK) / 1000.0, 0, 'f', 1)
+      .arg(m_transactionProgress.getPhaseDuration(TransactionProgress::ectn_INSTALL) / 1000.0, 0, 'f', 1)
+      .arg(m_transactionProgress.getPhaseDuration(TransactionProgress::ectn_HOOK) / 1000.0, 0, 'f', 1));
 }
 
 /*
- * This SLOT is called whenever Pacman's process has something to output to Standard error
+ * Saves the timeline of the finished transaction as JSON to "~/.config/octopi/last_transaction.json"
  */
-void MainWindow::actionsProcessRaisedError()
+void MainWindow::_saveTransactionProgress()
 {
-  QString msg = m_unixCommand->readAllStandardError();
-  _splitOutputStrings(msg);
+  if (m_transactionProgress.getSteps().isEmpty()) return;
+
+  QString path = QDir::homePath() + QDir::separator() + ".config/octopi/last_transaction.json";
+  QFile file(path);
+  if (file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text))
+  {
+    file.write(m_transactionProgress.toJson().toUtf8());
+    file.close();
+    writeToTabOutput(StrConstants::getTransactionTimelineSaved().arg(path) + "<br>", ectn_DONT_TREAT_URL_LINK);
+  }
 }
 
 /*
@@ -2076,108 +2070,126 @@ void MainWindow::actionsProcessRaisedError()
  */
 void MainWindow::writeToTabOutput(const QString &msg, TreatURLLinks treatURLLinks)
 {
-  QTextBrowser *text = ui->twProperties->widget(ctn_TABINDEX_OUTPUT)->findChild<QTextBrowser*>("textOutputEdit");
-  if (text)
+  _ensureTabVisible(ctn_TABINDEX_OUTPUT);
+
+  if(treatURLLinks == ectn_TREAT_URL_LINK)
   {
-    _ensureTabVisible(ctn_TABINDEX_OUTPUT);
-    _positionTextEditCursorAtEnd();
+    m_outputSink->append(Package::makeURLClickable(msg));
+  }
+  else
+  {
+    m_outputSink->append(msg);
+  }
+}
 
-    if(treatURLLinks == ectn_TREAT_URL_LINK)
-    {
-      text->insertHtml(Package::makeURLClickable(msg));
-    }
-    else
-    {
-      text->insertHtml(msg);
-    }
+/*
+ * Writes one line of pacman's output, as classified by OutputParser, to OutputTab's textbrowser
+ * The caller already knows what the line is, so it is neither filtered nor colored by its text here
+ */
+void MainWindow::_writeOutputLine(const QString &line, const QString &color)
+{
+  if (m_outputSink->contains(line)) return;
+  _ensureTabVisible(ctn_TABINDEX_OUTPUT);
+
+  QString html;
+  if (line.startsWith("::"))
+    html = "<br><B>" + line + "</B><br><br>";
+  else if (!color.isEmpty())
+    html = "<b><font color=\"" + color + "\">" + line + "</font></b><br>";
+  else
+    html = line + "<br>";
 
-    text->ensureCursorVisible();
-  }
+  m_outputSink->append(Package::makeURLClickable(html), line);
+}
+
+/*
+ * The color of a progress or stage line starting with the given verb of pacman (empty for none)
+ */
+QString MainWindow::_getVerbColor(const QString &verb)
+{
+  if (verb == "removing") return "#E55451"; //RED
+  if (verb.isEmpty()) return QString();
+  return "#4BC413"; //GREEN
 }
 
 /*
  * A helper method which writes the given string to OutputTab's textbrowser
  * This is the EXTENDED version, it checks lots of things before writing msg
+ * (for free-form messages, pacman's output goes through _writeOutputLine)
  */
 void MainWindow::writeToTabOutputExt(const QString &msg)
 {
   //std::cout << "To print: " << msg.toAscii().data() << std::endl;
 
-  QTextBrowser *text = ui->twProperties->widget(ctn_TABINDEX_OUTPUT)->findChild<QTextBrowser*>("textOutputEdit");
-  if (text)
-  {    
-    //If the msg waiting to being print is from curl status OR any other unwanted string...
-    if ((msg.contains(QRegExp("\\(\\d")) &&
-         (!msg.contains("target", Qt::CaseInsensitive)) &&
-         (!msg.contains("package", Qt::CaseInsensitive))) ||
-       (msg.contains(QRegExp("\\d\\)")) &&
-        (!msg.contains("target", Qt::CaseInsensitive)) &&
-        (!msg.contains("package", Qt::CaseInsensitive))) ||
-
-        msg.indexOf("Enter a selection", Qt::CaseInsensitive) == 0 ||
-        msg.indexOf("Proceed with", Qt::CaseInsensitive) == 0 ||
-        msg.indexOf("%") != -1 ||
-        msg.indexOf("[") != -1 ||
-        msg.indexOf("]") != -1 ||
-        msg.indexOf("---") != -1)
-    {
-      return;
-    }
+  //If the msg waiting to being print is from curl status OR any other unwanted string...
+  if ((msg.contains(QRegExp("\\(\\d")) &&
+       (!msg.contains("target", Qt::CaseInsensitive)) &&
+       (!msg.contains("package", Qt::CaseInsensitive))) ||
+     (msg.contains(QRegExp("\\d\\)")) &&
+      (!msg.contains("target", Qt::CaseInsensitive)) &&
+      (!msg.contains("package", Qt::CaseInsensitive))) ||
+
+      msg.indexOf("Enter a selection", Qt::CaseInsensitive) == 0 ||
+      msg.indexOf("Proceed with", Qt::CaseInsensitive) == 0 ||
+      msg.indexOf("%") != -1 ||
+      msg.indexOf("[") != -1 ||
+      msg.indexOf("]") != -1 ||
+      msg.indexOf("---") != -1)
+  {
+    return;
+  }
 
-    //If the msg waiting to being print has not yet been printed...
-    if(_textInTabOutput(msg))
-    {
-      return;
-    }
+  //If the msg waiting to being print has not yet been printed...
+  if(m_outputSink->contains(msg))
+  {
+    return;
+  }
 
-    QString newMsg = msg;
-    _ensureTabVisible(ctn_TABINDEX_OUTPUT);
-    _positionTextEditCursorAtEnd();
+  QString newMsg = msg;
+  _ensureTabVisible(ctn_TABINDEX_OUTPUT);
 
-    if(newMsg.contains(QRegExp("<font color")))
+  if(newMsg.contains("<font color"))
+  {
+    newMsg += "<br>";
+  }
+  else
+  {
+    if(newMsg.contains("removing ") ||
+       newMsg.contains("could not ") ||
+       newMsg.contains("error") ||
+       newMsg.contains("failed"))
     {
-      newMsg += "<br>";
+      newMsg = "<b><font color=\"#E55451\">" + newMsg + "&nbsp;</font></b>"; //RED
     }
-    else
+    else if(newMsg.contains("checking ") ||
+            newMsg.contains("-- reinstalling") ||
+            newMsg.contains("installing ") ||
+            newMsg.contains("upgrading ") ||
+            newMsg.contains("loading ") ||
+            newMsg.contains("resolving ") ||
+            newMsg.contains("looking "))
     {
-      if(newMsg.contains("removing ") ||
-         newMsg.contains("could not ") ||
-         newMsg.contains("error") ||
-         newMsg.contains("failed"))
-      {
-        newMsg = "<b><font color=\"#E55451\">" + newMsg + "&nbsp;</font></b>"; //RED
-      }
-      else if(newMsg.contains("checking ") ||
-              newMsg.contains("-- reinstalling") ||
-              newMsg.contains("installing ") ||
-              newMsg.contains("upgrading ") ||
-              newMsg.contains("loading ") ||
-              newMsg.contains("resolving ") ||
-              newMsg.contains("looking "))
-      {
-         newMsg = "<b><font color=\"#4BC413\">" + newMsg + "</font></b>"; //GREEN
-      }
-      else if (newMsg.contains("warning"))
-      {
-        newMsg = "<b><font color=\"#FF8040\">" + newMsg + "</font></b>"; //ORANGE
-      }
-      else if (!newMsg.contains("::"))
-      {
-        newMsg += "<br>";
-      }
+       newMsg = "<b><font color=\"#4BC413\">" + newMsg + "</font></b>"; //GREEN
     }
-
-    if (newMsg.contains("::"))
+    else if (newMsg.contains("warning"))
     {
-      newMsg = "<br><B>" + newMsg + "</B><br><br>";
+      newMsg = "<b><font color=\"#FF8040\">" + newMsg + "</font></b>"; //ORANGE
     }
-
-    if (!newMsg.contains(QRegExp("<br"))) //It was an else!
+    else if (!newMsg.contains("::"))
     {
       newMsg += "<br>";
     }
+  }
+
+  if (newMsg.contains("::"))
+  {
+    newMsg = "<br><B>" + newMsg + "</B><br><br>";
+  }
 
-    text->insertHtml(Package::makeURLClickable(newMsg));
-    text->ensureCursorVisible();
+  if (!newMsg.contains("<br")) //It was an else!
+  {
+    newMsg += "<br>";
   }
+
+  m_outputSink->append(Package::makeURLClickable(newMsg), msg);
 }
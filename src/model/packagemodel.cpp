@@ -22,6 +22,14 @@
 
 #include <iostream>
 #include <cassert>
+#include <algorithm>
+#include <vector>
+
+#if QT_VERSION > 0x050000
+  #include <QtConcurrent/QtConcurrentRun>
+#else
+  #include <QtConcurrentRun>
+#endif
 
 #include "src/uihelper.h"
 #include "src/strconstants.h"
@@ -29,8 +37,8 @@
 
 PackageModel::PackageModel(const PackageRepository& repo, QObject *parent)
 : QAbstractItemModel(parent), m_packageRepo(repo), m_displayMode(FLAT),
-  m_rootItem(createDummyRoot()),
-  m_sortOrder(Qt::AscendingOrder), m_sortColumn(1),
+  m_tree(NULL),
+  m_sortOrder(Qt::AscendingOrder), m_sortColumn(1), m_sortSource(NULL),
   m_filterPackagesNotInstalled(false), m_filterPackagesNotInThisGroup(""),
   m_filterColumn(-1), m_filterRegExp("", Qt::CaseInsensitive, QRegExp::RegExp),
   m_iconNotInstalled(IconHelper::getIconNonInstalled()), m_iconInstalled(IconHelper::getIconInstalled()),
@@ -52,7 +60,8 @@ QModelIndex PackageModel::index(int row, int column, const QModelIndex &parent)
       return QModelIndex();
 
     if (!parent.isValid()) {
-      const int adaptedRow = transformRowIndex(row, m_columnSortedlistOfPackages.size());
+      // ranked hits are already ordered by sortRanked(), the best ones stay on top in both orders
+      const int adaptedRow = m_rankKeys.empty() ? transformRowIndex(row, m_columnSortedlistOfPackages.size()) : row;
       if (adaptedRow >= 0 && adaptedRow < m_columnSortedlistOfPackages.size()) {
         return createIndex(row, column, (void*)m_columnSortedlistOfPackages.at(adaptedRow));
       }
@@ -61,13 +70,11 @@ QModelIndex PackageModel::index(int row, int column, const QModelIndex &parent)
   }
   case DEPENDS_ON:
   case REQUIRED_BY: {
-    const PackageItem& pkgItem = getPackageItem(parent);
-    const std::size_t adaptedRow = transformRowIndex(row, pkgItem.getChildCount());
-    if (adaptedRow < static_cast<std::size_t>(pkgItem.getChildCount())) {
-      const PackageItem*const child = pkgItem.getChildAt(adaptedRow);
-      if (child != NULL) {
-        return createIndex(row, column, (void*)child);
-      }
+    const int parentNode = getTreeNode(parent);
+    const int childCount = m_tree->getChildCount(parentNode);
+    const int adaptedRow = transformRowIndex(row, childCount);
+    if (column >= 0 && column < columnCount(parent) && adaptedRow >= 0 && adaptedRow < childCount) {
+      return createIndex(row, column, static_cast<quint32>(m_tree->getChildAt(parentNode, adaptedRow) + 1));
     }
     return QModelIndex();
   }
@@ -88,19 +95,11 @@ QModelIndex PackageModel::parent(const QModelIndex& child) const
     if (child.isValid() == false)
       return QModelIndex();
 
-    const PackageItem*const data = static_cast<const PackageItem*const>(child.internalPointer());
-    if (data == NULL || &data->getParent() == m_rootItem.get()) {
+    const int parentNode = m_tree->getParent(getTreeNode(child));
+    if (parentNode == PackageTree::ctn_ROOT_NODE) {
       return QModelIndex();
     }
-    else {
-      const PackageItem& parent = data->getParent();
-      int row = 0; //FIXME: search necessary ?
-      for (; row < parent.getChildCount(); ++row) {
-        if (parent.getChildAt(row) == data)
-          break;
-      }
-      return createIndex(row, 0, (void*)&parent);
-    }
+    return createTreeIndex(parentNode, 0);
   }
   default:
     assert(false);
@@ -118,14 +117,25 @@ int PackageModel::rowCount(const QModelIndex& parent) const
   }
   else if (m_displayMode == DEPENDS_ON || m_displayMode == REQUIRED_BY)
   {
-    const PackageItem& branch = getPackageItem(parent);
-    return branch.getChildCount();
+    if (parent.isValid() && parent.column() != 0) return 0;
+    return m_tree->getChildCount(getTreeNode(parent));
   } else {
     assert(false);
     return 0;
   }
 }
 
+/**
+ * @brief tree nodes which are not fetched yet still need their expand indicator
+ */
+bool PackageModel::hasChildren(const QModelIndex& parent) const
+{
+  if (m_displayMode == FLAT) return parent.isValid() == false && m_columnSortedlistOfPackages.isEmpty() == false;
+
+  if (parent.isValid() && parent.column() != 0) return false;
+  return m_tree->hasChildren(getTreeNode(parent));
+}
+
 int PackageModel::columnCount(const QModelIndex&) const
 {
   switch (m_displayMode) {
@@ -150,18 +160,22 @@ QVariant PackageModel::data(const QModelIndex &index, int role) const
 
         switch (index.column()) {
           case ctn_PACKAGE_ICON_COLUMN:
-            if (m_displayMode != FLAT) return QVariant(package->name);
+            if (m_displayMode != FLAT) {
+              if (m_tree->isBackReference(getTreeNode(index)))
+                return QVariant(package->getName() + " " + StrConstants::getDependencyCycle());
+              return QVariant(package->getName());
+            }
             break;
           case ctn_PACKAGE_NAME_COLUMN:
-            if (m_displayMode == FLAT) return QVariant(package->name);
+            if (m_displayMode == FLAT) return QVariant(package->getName());
             break;
           case ctn_PACKAGE_VERSION_COLUMN:
-            return QVariant(package->version);
+            return QVariant(package->getVersion());
           case ctn_PACKAGE_REPOSITORY_COLUMN:
-            return QVariant(package->repository);
+            return QVariant(package->getRepository());
           case ctn_PACKAGE_POPULARITY_COLUMN:
-            if (package->popularity >= 0)
-              return QVariant(package->popularityString);
+            if (package->getPopularity() >= 0)
+              return QVariant(package->getPopularityString());
             break;
           default:
             assert(false);
@@ -227,9 +241,8 @@ bool PackageModel::canFetchMore(const QModelIndex& parent) const
   default:
     return false;
   case DEPENDS_ON:
-    return getPackageItem(parent).canFetchChildren(PackageItem::DEPENDS_ON);
   case REQUIRED_BY:
-    return getPackageItem(parent).canFetchChildren(PackageItem::REQUIRED_BY);
+    return m_tree->canFetchChildren(getTreeNode(parent));
   }
 }
 
@@ -240,12 +253,18 @@ void PackageModel::fetchMore(const QModelIndex& parent)
   default:
     return;
   case DEPENDS_ON:
-    getPackageItem(parent).fetchDepencies(PackageItem::DEPENDS_ON);
-    return;
-  case REQUIRED_BY:
-    getPackageItem(parent).fetchDepencies(PackageItem::REQUIRED_BY);
+  case REQUIRED_BY: {
+    const int node = getTreeNode(parent);
+    const int count = m_tree->getDependencyCount(node);
+    if (m_tree->canFetchChildren(node) == false || count == 0) return;
+
+    beginInsertRows(parent, 0, count - 1);
+    m_tree->fetchChildren(node);
+    sortTree(node);
+    endInsertRows();
     return;
   }
+  }
 }
 
 void PackageModel::sort(int column, Qt::SortOrder order)
@@ -253,62 +272,35 @@ void PackageModel::sort(int column, Qt::SortOrder order)
 //  std::cout << "sort column " << column << " in order " << order << std::endl;
 
   if (column != m_sortColumn || order != m_sortOrder) {
-    if (m_displayMode == FLAT)
-      emit layoutAboutToBeChanged();
-    else beginResetModel();
+    emit layoutAboutToBeChanged();
+    const bool columnChanged = column != m_sortColumn;
     m_sortColumn = column;
     m_sortOrder  = order;
-    sort();
-    if (m_displayMode == FLAT)
-      emit layoutChanged();
-    else {
-      //TODO: reset here requires reset model -> maybe sort child-list instead
-      m_rootItem.reset(new PackageItem(m_columnSortedlistOfPackages,
-                                       m_displayMode == DEPENDS_ON ? PackageItem::DEPENDS_ON : PackageItem::REQUIRED_BY));
-      endResetModel();
+    if (columnChanged || m_rankKeys.empty() == false) sort(); // otherwise the order is applied by transformRowIndex
+    if (m_displayMode != FLAT) {
+      // the tree keeps its nodes, only the child arrays get reordered
+      if (columnChanged) sortTree(PackageTree::ctn_ALL_NODES);
+
+      const QModelIndexList oldIndexes = persistentIndexList();
+      QModelIndexList newIndexes;
+      for (QModelIndexList::const_iterator it = oldIndexes.begin(); it != oldIndexes.end(); ++it) {
+        newIndexes.append(it->isValid() ? createTreeIndex(getTreeNode(*it), it->column()) : QModelIndex());
+      }
+      changePersistentIndexList(oldIndexes, newIndexes);
     }
+    emit layoutChanged();
   }
 }
 
 void PackageModel::beginResetRepository()
 {
-  beginResetModel();
-  m_listOfPackages.clear();
-  m_columnSortedlistOfPackages.clear();
+  clearSortCache(); // the cached permutations point into the old package list
+  beginResetPackageList();
 }
 
 void PackageModel::endResetRepository()
 {
-  const PackageRepository::TListOfPackages& data = m_packageRepo.getPackageList(m_filterPackagesNotInThisGroup);
-  m_listOfPackages.reserve(data.size());
-  for (PackageRepository::TListOfPackages::const_iterator it = data.begin(); it != data.end(); ++it) {
-      if (m_filterPackagesNotInstalled == false || (*it)->installed()) {
-        if (m_filterRegExp.isEmpty()) {
-          m_listOfPackages.push_back(*it);
-        }
-        else {
-          switch (m_filterColumn) {
-            case ctn_PACKAGE_NAME_COLUMN:
-              if (m_filterRegExp.indexIn((*it)->name) != -1) m_listOfPackages.push_back(*it);
-              break;
-            case ctn_PACKAGE_DESCRIPTION_FILTER_NO_COLUMN:
-              if (m_filterRegExp.indexIn((*it)->description) != -1) m_listOfPackages.push_back(*it);
-              break;
-            default:
-              m_listOfPackages.push_back(*it);
-          }
-        }
-      }
-  }
-  m_columnSortedlistOfPackages.reserve(data.size());
-  m_columnSortedlistOfPackages = m_listOfPackages;
-  sort();
-  if (m_displayMode == FLAT)
-    m_rootItem.reset(createDummyRoot());
-  else
-    m_rootItem.reset(new PackageItem(m_columnSortedlistOfPackages,
-                                     m_displayMode == DEPENDS_ON ? PackageItem::DEPENDS_ON : PackageItem::REQUIRED_BY));
-  endResetModel();
+  endResetPackageList();
 }
 
 int PackageModel::getPackageCount() const
@@ -318,7 +310,7 @@ int PackageModel::getPackageCount() const
 
 const PackageRepository::PackageData* PackageModel::getData(const QModelIndex& index) const
 {
-  if (index.isValid() == false || index.internalPointer() == NULL)
+  if (index.isValid() == false || index.internalId() == 0)
     return NULL;
 
   switch (m_displayMode) {
@@ -327,8 +319,7 @@ const PackageRepository::PackageData* PackageModel::getData(const QModelIndex& i
   }
   case DEPENDS_ON:
   case REQUIRED_BY: {
-    const PackageItem*const data = static_cast<const PackageItem*const>(index.internalPointer());
-    return &data->getPackage();
+    return &m_tree->getPackage(getTreeNode(index));
   }
   default:
     assert(false);
@@ -338,19 +329,19 @@ const PackageRepository::PackageData* PackageModel::getData(const QModelIndex& i
 
 void PackageModel::switchDisplayMode(PackageModel::EDisplayMode newMode)
 {
-  beginResetRepository();
+  beginResetPackageList();
   m_displayMode = newMode;
-  endResetRepository();
+  endResetPackageList();
 }
 
 void PackageModel::applyFilter(bool packagesNotInstalled, const QString& group)
 {
 //  std::cout << "apply new group filter " << (packagesNotInstalled ? "true" : "false") << ", " << group.toStdString() << std::endl;
 
-  beginResetRepository();
+  beginResetPackageList();
   m_filterPackagesNotInstalled   = packagesNotInstalled;
   m_filterPackagesNotInThisGroup = group;
-  endResetRepository();
+  endResetPackageList();
 }
 
 void PackageModel::applyFilter(const int filterColumn)
@@ -368,45 +359,114 @@ void PackageModel::applyFilter(const int filterColumn, const QString& filterExp)
   assert(filterExp.isNull() == false);
 //  std::cout << "apply new column filter " << filterColumn << ", " << filterExp.toStdString() << std::endl;
 
-  beginResetRepository();
+  beginResetPackageList();
   m_filterColumn = filterColumn;
   m_filterRegExp.setPattern(filterExp);
-  endResetRepository();
+  endResetPackageList();
 }
 
-PackageItem& PackageModel::getPackageItem(const QModelIndex& index) const
+void PackageModel::beginResetPackageList()
 {
-  if (index.isValid()) {
-    PackageItem*const branch = static_cast<PackageItem*const>(index.internalPointer());
-    if (branch) return *branch;
+  beginResetModel();
+  m_listOfPackages.clear();
+  m_columnSortedlistOfPackages.clear();
+  m_rankKeys.clear();
+}
+
+/**
+ * @brief filters the package list of the current group into m_listOfPackages (name order)
+ *
+ * m_filterMembership marks which packages of the group list passed the filter,
+ * so the column sorted list can be taken from the cached sort permutations.
+ */
+void PackageModel::endResetPackageList()
+{
+  const PackageRepository::TListOfPackages& data = m_packageRepo.getPackageList(m_filterPackagesNotInThisGroup);
+  if (&data != m_sortSource) {
+    clearSortCache();
+    m_sortSource = &data;
   }
-  return *m_rootItem;
+
+  m_filterMembership.assign(data.size(), false);
+  std::vector<int> rankCandidates;
+  m_listOfPackages.reserve(data.size());
+  for (int i = 0; i < data.size(); ++i) {
+      PackageRepository::PackageData*const pkg = data.at(i);
+      if (m_filterPackagesNotInstalled == false || pkg->installed()) {
+        bool accepted = false;
+        if (m_filterRegExp.isEmpty()) {
+          accepted = true;
+        }
+        else {
+          switch (m_filterColumn) {
+            case ctn_PACKAGE_NAME_COLUMN:
+              accepted = m_filterRegExp.indexIn(pkg->getName()) != -1;
+              break;
+            case ctn_PACKAGE_DESCRIPTION_FILTER_NO_COLUMN:
+              accepted = m_filterRegExp.indexIn(pkg->getDescription()) != -1;
+              break;
+            case ctn_PACKAGE_RELEVANCE_FILTER_NO_COLUMN:
+              rankCandidates.push_back(i);
+              break;
+            default:
+              accepted = true;
+          }
+        }
+        if (accepted) {
+          m_listOfPackages.push_back(pkg);
+          m_filterMembership[i] = true;
+        }
+      }
+  }
+  if (rankCandidates.empty() == false) rankPackages(data, rankCandidates);
+  sort();
+  if (m_displayMode == FLAT)
+    m_tree.reset();
+  else
+    m_tree.reset(new PackageTree(m_columnSortedlistOfPackages,
+                                 m_displayMode == DEPENDS_ON ? PackageTree::DEPENDS_ON : PackageTree::REQUIRED_BY));
+  endResetModel();
+}
+
+/**
+ * @brief tree indices carry node id + 1 as internal id, so the invisible root maps to an invalid index
+ */
+int PackageModel::getTreeNode(const QModelIndex& index) const
+{
+  if (index.isValid() == false || index.internalId() == 0) return PackageTree::ctn_ROOT_NODE;
+  return static_cast<int>(index.internalId()) - 1;
+}
+
+QModelIndex PackageModel::createTreeIndex(int node, int column) const
+{
+  const int row = transformRowIndex(m_tree->getRow(node), m_tree->getChildCount(m_tree->getParent(node)));
+  return createIndex(row, column, static_cast<quint32>(node + 1));
 }
 
 const QIcon& PackageModel::getIconFor(const PackageRepository::PackageData& package) const
 {
-  switch (package.status)
+  switch (package.getStatus())
   {
     case ectn_FOREIGN:
       return m_iconForeign;
     case ectn_FOREIGN_OUTDATED:
       return m_iconForeignOutdated;
     case ectn_OUTDATED:
-      if (package.explicitlyInstalled) return m_iconOutdatedByUser;
+      if (package.isExplicitlyInstalled()) return m_iconOutdatedByUser;
       return m_iconOutdated;
     case ectn_NEWER:
-      if (package.explicitlyInstalled) return m_iconNewerByUser;
+      if (package.isExplicitlyInstalled()) return m_iconNewerByUser;
       return m_iconNewer;
     case ectn_INSTALLED:
       // Does no other package depend on this package ? (unrequired package list)
-      if (package.required)
+      if (package.isRequired())
       {
-        if (package.explicitlyInstalled) return m_iconInstalledByUser;
+        if (package.isExplicitlyInstalled()) return m_iconInstalledByUser;
         return m_iconInstalled;
       }
       else
       {
-        if (package.explicitlyInstalled) return m_iconInstalledUnrequiredByUser;
+        if (package.isExplicitlyInstalled()) return m_iconInstalledUnrequiredByUser;
         return m_iconInstalledUnrequired;
       }
       break;
@@ -421,13 +481,13 @@ const QIcon& PackageModel::getIconFor(const PackageRepository::PackageData& pack
 
 struct TSort0 {
   bool operator()(const PackageRepository::PackageData* a, const PackageRepository::PackageData* b) const {
-  if (a->status < b->status) return true;
-  if (a->status == b->status) {
-    if (a->explicitlyInstalled > b->explicitlyInstalled) return true;
-    if (a->explicitlyInstalled == b->explicitlyInstalled) {
-        if (a->required < b->required) return true;
-        if (a->required == b->required) {
-          return a->name < b->name;
+  if (a->getStatus() < b->getStatus()) return true;
+  if (a->getStatus() == b->getStatus()) {
+    if (a->isExplicitlyInstalled() > b->isExplicitlyInstalled()) return true;
+    if (a->isExplicitlyInstalled() == b->isExplicitlyInstalled()) {
+        if (a->isRequired() < b->isRequired()) return true;
+        if (a->isRequired() == b->isRequired()) {
+          return a->compareName(*b) < 0;
         }
       }
     }
@@ -435,12 +495,23 @@ struct TSort0 {
   }
 };
 
+struct TSort1 {
+  bool operator()(const PackageRepository::PackageData* a, const PackageRepository::PackageData* b) const {
+    const int cmp = a->compareName(*b);
+    if (cmp < 0) return true;
+    if (cmp == 0) {
+      return a->getRepository() < b->getRepository();
+    }
+    return false;
+  }
+};
+
 struct TSort2 {
   bool operator()(const PackageRepository::PackageData* a, const PackageRepository::PackageData* b) const {
-    const int cmp = Package::rpmvercmp(a->version.toLatin1().data(), b->version.toLatin1().data());
+    const int cmp = a->compareVersion(*b);
     if (cmp < 0) return true;
     if (cmp == 0) {
-      return a->name < b->name;
+      return a->compareName(*b) < 0;
     }
     return false;
   }
@@ -448,9 +519,9 @@ struct TSort2 {
 
 struct TSort3 {
   bool operator()(const PackageRepository::PackageData* a, const PackageRepository::PackageData* b) const {
-    if (a->repository < b->repository) return true;
-    if (a->repository == b->repository) {
-      return a->name < b->name;
+    if (a->getRepository() < b->getRepository()) return true;
+    if (a->getRepository() == b->getRepository()) {
+      return a->compareName(*b) < 0;
     }
     return false;
   }
@@ -458,37 +529,321 @@ struct TSort3 {
 
 struct TSort4 {
   bool operator()(const PackageRepository::PackageData* a, const PackageRepository::PackageData* b) const {
-    if (a->popularity > b->popularity) return true;
-    if (a->popularity == b->popularity) {
-      return a->name < b->name;
+    if (a->getPopularity() > b->getPopularity()) return true;
+    if (a->getPopularity() == b->getPopularity()) {
+      return a->compareName(*b) < 0;
     }
     return false;
   }
 };
 
-void PackageModel::sort()
+template <typename TComp>
+static void sortRange(std::vector<int>::iterator first, std::vector<int>::iterator last, TComp comp)
 {
-  switch (m_sortColumn) {
-  case ctn_PACKAGE_NAME_COLUMN:
-    m_columnSortedlistOfPackages = m_listOfPackages;
+  std::sort(first, last, comp);
+}
+
+/**
+ * @brief sorts %permutation with %comp, splitting bigger lists into two halves sorted in parallel
+ */
+template <typename TComp>
+static void sortPermutation(std::vector<int>& permutation, const TComp comp)
+{
+  if (permutation.size() < 4096) {
+    std::sort(permutation.begin(), permutation.end(), comp);
     return;
+  }
+
+  const std::vector<int>::iterator middle = permutation.begin() + permutation.size() / 2;
+  QFuture<void> lowerHalf = QtConcurrent::run(sortRange<TComp>, permutation.begin(), middle, comp);
+  std::sort(middle, permutation.end(), comp);
+  lowerHalf.waitForFinished();
+  std::inplace_merge(permutation.begin(), middle, permutation.end(), comp);
+}
+
+/**
+ * @brief adapts the package comparators (TSort0, ...) to indices into a package list
+ */
+template <typename TSort>
+struct TIndexSort {
+  TIndexSort(const PackageRepository::TListOfPackages& packages) : m_packages(&packages) {}
+
+  bool operator()(const int a, const int b) const {
+    return TSort()(m_packages->at(a), m_packages->at(b));
+  }
+
+  const PackageRepository::TListOfPackages* m_packages;
+};
+
+/**
+ * @brief returns the sort permutation of m_sortSource for %column, computing it on first use
+ *
+ * The permutations stay valid until the repository or the package group changes.
+ */
+const std::vector<int>& PackageModel::getSortPermutation(const int column)
+{
+  assert(column >= 0 && column < ctn_SORTABLE_COLUMNS);
+  std::vector<int>& permutation = m_sortPermutations[column];
+  if (permutation.empty() && m_sortSource != NULL && m_sortSource->isEmpty() == false) {
+    permutation.resize(m_sortSource->size());
+    for (std::size_t i = 0; i < permutation.size(); ++i) permutation[i] = static_cast<int>(i);
+
+    switch (column) {
+    case ctn_PACKAGE_ICON_COLUMN:
+      sortPermutation(permutation, TIndexSort<TSort0>(*m_sortSource));
+      break;
+    case ctn_PACKAGE_VERSION_COLUMN:
+      sortPermutation(permutation, TIndexSort<TSort2>(*m_sortSource));
+      break;
+    case ctn_PACKAGE_REPOSITORY_COLUMN:
+      sortPermutation(permutation, TIndexSort<TSort3>(*m_sortSource));
+      break;
+    case ctn_PACKAGE_POPULARITY_COLUMN:
+      sortPermutation(permutation, TIndexSort<TSort4>(*m_sortSource));
+      break;
+    case ctn_PACKAGE_NAME_COLUMN:
+    default:
+      break; // m_sortSource already is sorted by name
+    }
+  }
+  return permutation;
+}
+
+/**
+ * @brief sorts the children of tree %node by the sort column (every fetched node for ctn_ALL_NODES)
+ */
+void PackageModel::sortTree(int node)
+{
+  switch (m_sortColumn) {
   case ctn_PACKAGE_ICON_COLUMN:
-    qSort(m_columnSortedlistOfPackages.begin(), m_columnSortedlistOfPackages.end(), TSort0());
-    return;
+    m_tree->sortChildren(node, TSort0());
+    break;
   case ctn_PACKAGE_VERSION_COLUMN:
-    qSort(m_columnSortedlistOfPackages.begin(), m_columnSortedlistOfPackages.end(), TSort2());
-    return;
+    m_tree->sortChildren(node, TSort2());
+    break;
   case ctn_PACKAGE_REPOSITORY_COLUMN:
-    qSort(m_columnSortedlistOfPackages.begin(), m_columnSortedlistOfPackages.end(), TSort3());
-    return;
+    m_tree->sortChildren(node, TSort3());
+    break;
   case ctn_PACKAGE_POPULARITY_COLUMN:
-    qSort(m_columnSortedlistOfPackages.begin(), m_columnSortedlistOfPackages.end(), TSort4());
-    return;
+    m_tree->sortChildren(node, TSort4());
+    break;
+  case ctn_PACKAGE_NAME_COLUMN:
   default:
+    m_tree->sortChildren(node, TSort1());
+    break;
+  }
+}
+
+void PackageModel::clearSortCache()
+{
+  m_sortSource = NULL;
+  for (int i = 0; i < ctn_SORTABLE_COLUMNS; ++i) {
+    std::vector<int>().swap(m_sortPermutations[i]);
+  }
+}
+
+/**
+ * @brief fills m_columnSortedlistOfPackages by walking the cached permutation of the sort column
+ *        and picking the packages which passed the filter
+ */
+void PackageModel::sort()
+{
+  if (m_rankKeys.empty() == false) {
+    sortRanked();
+    return;
+  }
+  if (m_sortColumn == ctn_PACKAGE_NAME_COLUMN) {
+    m_columnSortedlistOfPackages = m_listOfPackages;
+    return;
+  }
+  if (m_sortColumn < 0 || m_sortColumn >= ctn_SORTABLE_COLUMNS || m_sortSource == NULL)
     return;
+
+  const std::vector<int>& permutation = getSortPermutation(m_sortColumn);
+  m_columnSortedlistOfPackages.clear();
+  m_columnSortedlistOfPackages.reserve(m_listOfPackages.size());
+  for (std::vector<int>::const_iterator it = permutation.begin(); it != permutation.end(); ++it) {
+    if (m_filterMembership[*it]) m_columnSortedlistOfPackages.push_back(m_sortSource->at(*it));
   }
 }
 
+/**
+ * @brief relevance first, then the position in the sort column (%positions, the m_sortSource index if empty)
+ */
+struct TRankedOrder {
+  TRankedOrder(const std::vector<std::pair<int, int> >& keys, const std::vector<int>& positions, const bool descending)
+    : m_keys(keys), m_positions(positions), m_descending(descending) {}
+
+  bool operator()(const std::size_t a, const std::size_t b) const {
+    if (m_keys[a].first != m_keys[b].first) return m_keys[a].first > m_keys[b].first;
+    const int positionA = m_positions.empty() ? m_keys[a].second : m_positions[m_keys[a].second];
+    const int positionB = m_positions.empty() ? m_keys[b].second : m_positions[m_keys[b].second];
+    return m_descending ? positionA > positionB : positionA < positionB;
+  }
+
+  const std::vector<std::pair<int, int> >& m_keys;
+  const std::vector<int>&                  m_positions;
+  const bool                               m_descending;
+};
+
+/**
+ * @brief fills m_columnSortedlistOfPackages with the ranked hits
+ *
+ * The relevance is the primary key, whatever the sort order of the header is: the sort column
+ * (in the sort order) only decides between hits of the same score and among the hits beyond the top k.
+ */
+void PackageModel::sortRanked()
+{
+  std::vector<int> positions; // m_sortSource index -> position in the sort column, the name column needs none
+  if (m_sortColumn != ctn_PACKAGE_NAME_COLUMN && m_sortColumn >= 0 && m_sortColumn < ctn_SORTABLE_COLUMNS &&
+      m_sortSource != NULL) {
+    const std::vector<int>& permutation = getSortPermutation(m_sortColumn);
+    positions.resize(permutation.size());
+    for (std::size_t i = 0; i < permutation.size(); ++i) positions[permutation[i]] = static_cast<int>(i);
+  }
+
+  std::vector<std::size_t> order(m_rankKeys.size());
+  for (std::size_t i = 0; i < order.size(); ++i) order[i] = i;
+  std::stable_sort(order.begin(), order.end(),
+                   TRankedOrder(m_rankKeys, positions, m_sortOrder == Qt::DescendingOrder));
+
+  m_columnSortedlistOfPackages.clear();
+  m_columnSortedlistOfPackages.reserve(m_listOfPackages.size());
+  for (std::vector<std::size_t>::const_iterator it = order.begin(); it != order.end(); ++it) {
+    m_columnSortedlistOfPackages.push_back(m_listOfPackages.at(*it));
+  }
+}
+
+typedef std::pair<int, int> TRankedHit; // score, index into the package list
+
+struct TBetterHit {
+  TBetterHit(const std::vector<TRankedHit>& hits, const PackageRepository::TListOfPackages& packages)
+    : m_hits(hits), m_packages(packages) {}
+
+  bool operator()(const std::size_t a, const std::size_t b) const {
+    if (m_hits[a].first > m_hits[b].first) return true;
+    if (m_hits[a].first == m_hits[b].first) {
+      return m_packages.at(m_hits[a].second)->compareName(*m_packages.at(m_hits[b].second)) < 0;
+    }
+    return false;
+  }
+
+  const std::vector<TRankedHit>&           m_hits;
+  const PackageRepository::TListOfPackages& m_packages;
+};
+
+/**
+ * @brief true if %packages holds a non yaourt package with the same name as the one at %index
+ *
+ * %packages is sorted by name, so twins are always neighbours.
+ */
+static bool hasNativeTwin(const PackageRepository::TListOfPackages& packages, const int index)
+{
+  const PackageRepository::PackageData& package = *packages.at(index);
+  for (int i = index - 1; i >= 0 && packages.at(i)->compareName(package) == 0; --i) {
+    if (packages.at(i)->isManagedByYaourt() == false) return true;
+  }
+  for (int i = index + 1; i < packages.size() && packages.at(i)->compareName(package) == 0; ++i) {
+    if (packages.at(i)->isManagedByYaourt() == false) return true;
+  }
+  return false;
+}
+
+/**
+ * @brief fills m_listOfPackages with all candidates matching the search words, best hits first
+ * @param packages (sorted by name, official and yaourt packages mixed)
+ * @param candidates (indices into %packages which passed the other filters)
+ *
+ * Only the best ctn_RANKED_SEARCH_TOP_K hits are ordered by relevance using a bounded heap,
+ * the remaining hits follow in name order.
+ */
+void PackageModel::rankPackages(const PackageRepository::TListOfPackages& packages, const std::vector<int>& candidates)
+{
+  const QStringList terms = m_filterRegExp.pattern().split(QRegExp("\\s+"), QString::SkipEmptyParts);
+
+  std::vector<TRankedHit> hits;
+  hits.reserve(candidates.size());
+  for (std::vector<int>::const_iterator it = candidates.begin(); it != candidates.end(); ++it) {
+    const PackageRepository::PackageData*const pkg = packages.at(*it);
+    if (pkg->isManagedByYaourt() && hasNativeTwin(packages, *it)) continue;
+
+    const int score = computeRelevance(*pkg, terms);
+    if (score > 0) {
+      hits.push_back(TRankedHit(score, *it));
+      m_filterMembership[*it] = true;
+    }
+  }
+
+  // the heap front always is the weakest of the best hits found so far
+  const std::size_t topK = ctn_RANKED_SEARCH_TOP_K;
+  const TBetterHit better(hits, packages);
+  std::vector<std::size_t> heap;
+  heap.reserve(std::min(hits.size(), topK));
+  for (std::size_t i = 0; i < hits.size(); ++i) {
+    if (heap.size() < topK) {
+      heap.push_back(i);
+      std::push_heap(heap.begin(), heap.end(), better);
+    }
+    else if (better(i, heap.front())) {
+      std::pop_heap(heap.begin(), heap.end(), better);
+      heap.back() = i;
+      std::push_heap(heap.begin(), heap.end(), better);
+    }
+  }
+  std::sort_heap(heap.begin(), heap.end(), better);
+
+  std::vector<bool> ranked(hits.size(), false);
+  m_listOfPackages.reserve(hits.size());
+  m_rankKeys.reserve(hits.size());
+  for (std::vector<std::size_t>::const_iterator it = heap.begin(); it != heap.end(); ++it) {
+    m_listOfPackages.push_back(packages.at(hits[*it].second));
+    m_rankKeys.push_back(hits[*it]);
+    ranked[*it] = true;
+  }
+  for (std::size_t i = 0; i < hits.size(); ++i) {
+    if (ranked[i] == false) {
+      m_listOfPackages.push_back(packages.at(hits[i].second));
+      m_rankKeys.push_back(TRankedHit(-1, hits[i].second));
+    }
+  }
+}
+
+/**
+ * @brief scores how well %package matches all search %terms
+ * @return 0 if any term doesn't match, a positive relevance otherwise
+ *
+ * A name hit always outweighs a description hit. Exact names beat prefixes, prefixes beat substrings
+ * and earlier positions beat later ones. Installed packages get a small boost.
+ */
+int PackageModel::computeRelevance(const PackageRepository::PackageData& package, const QStringList& terms)
+{
+  const QString name = package.getName();
+  int score = 0;
+  for (QStringList::const_iterator it = terms.begin(); it != terms.end(); ++it) {
+    int termScore = 0;
+    if (name.compare(*it, Qt::CaseInsensitive) == 0) {
+      termScore = 1000;
+    }
+    else if (name.startsWith(*it, Qt::CaseInsensitive)) {
+      termScore = 700 - qMin(name.size() - it->size(), 100);
+    }
+    else {
+      const int namePos = name.indexOf(*it, 0, Qt::CaseInsensitive);
+      if (namePos != -1) {
+        termScore = 500 - qMin(namePos, 100);
+      }
+      else {
+        const int descPos = package.getDescription().indexOf(*it, 0, Qt::CaseInsensitive);
+        if (descPos != -1) termScore = 300 - qMin(descPos, 200);
+      }
+    }
+    if (termScore == 0) return 0;
+    score += termScore;
+  }
+  if (package.installed()) score += 50;
+  return score;
+}
+
 int PackageModel::transformRowIndex(int row, int rowCount) const
 {
   switch (m_sortOrder) {
@@ -499,8 +854,3 @@ int PackageModel::transformRowIndex(int row, int rowCount) const
   }
   return -1;
 }
-
-PackageItem*PackageModel::createDummyRoot()
-{
-  return new PackageItem(PackageItem::TPkgVec(), PackageItem::DEPENDS_ON);
-}
@@ -26,7 +26,7 @@
 
 #include "src/package.h"
 #include "src/packagerepository.h"
-#include "packageitem.h"
+#include "packagetree.h"
 
 
 class PackageModel : public QAbstractItemModel, public PackageRepository::IDependency
@@ -42,6 +42,9 @@ public:
   static const int ctn_PACKAGE_POPULARITY_COLUMN  = 4;
   // Pseudo Column indices for additional filter criterias
   static const int ctn_PACKAGE_DESCRIPTION_FILTER_NO_COLUMN = 5;
+  static const int ctn_PACKAGE_RELEVANCE_FILTER_NO_COLUMN   = 6; // plain search words, ranked by name/description hits
+  // Number of relevance search hits which get fully ordered by their score
+  static const std::size_t ctn_RANKED_SEARCH_TOP_K = 200;
 
   enum EDisplayMode {
     FLAT,
@@ -62,6 +65,7 @@ public:
   virtual QModelIndex index(int row, int column, const QModelIndex& parent) const /*override*/;
   virtual QModelIndex parent(const QModelIndex& child) const /*override*/;
   virtual int rowCount(const QModelIndex& parent) const /*override*/;
+  virtual bool hasChildren(const QModelIndex& parent) const /*override*/;
   virtual int columnCount(const QModelIndex& parent) const /*override*/;
   virtual QVariant data(const QModelIndex& index, int role) const /*override*/;
   virtual QVariant headerData(int section, Qt::Orientation orientation, int role) const /*override*/;
@@ -88,25 +92,39 @@ public:
   void applyFilter(const int filterColumn, const QString& filterExp);
 
 private:
-  PackageItem& getPackageItem(const QModelIndex& index) const; // for use in tree models only (e.g. depends)
+  int  getTreeNode(const QModelIndex& index) const; // for use in tree models only (e.g. depends)
+  QModelIndex createTreeIndex(int node, int column) const;
+  void sortTree(int node);
   const QIcon& getIconFor(const PackageRepository::PackageData& package) const;
+  void beginResetPackageList();
+  void endResetPackageList();
   void sort();
+  void sortRanked();
+  const std::vector<int>& getSortPermutation(const int column);
+  void clearSortCache();
+  void rankPackages(const PackageRepository::TListOfPackages& packages, const std::vector<int>& candidates);
+  static int computeRelevance(const PackageRepository::PackageData& package, const QStringList& terms);
 private:
   int transformRowIndex(int row, int rowCount) const;
-  static PackageItem* createDummyRoot();
 
 
 private:
   const PackageRepository&                m_packageRepo;
-  QList<PackageRepository::PackageData*>  m_listOfPackages;             // should be provided sorted by name (by repo)
+  QList<PackageRepository::PackageData*>  m_listOfPackages;             // sorted by name (by repo) or by relevance when ranking
   QList<PackageRepository::PackageData*>  m_columnSortedlistOfPackages; // sorted by column
 
   EDisplayMode                m_displayMode;
-  std::auto_ptr<PackageItem>  m_rootItem; // dummy for FLAT mode
+  std::auto_ptr<PackageTree>  m_tree; // NULL in FLAT mode
 
   // Filter / Sort attributes
   Qt::SortOrder m_sortOrder;
   int           m_sortColumn;
+  static const int ctn_SORTABLE_COLUMNS = 5;
+  const PackageRepository::TListOfPackages* m_sortSource;                         // package list of the current group
+  std::vector<int>                          m_sortPermutations[ctn_SORTABLE_COLUMNS]; // per column, empty until needed
+  std::vector<bool>                         m_filterMembership;                   // m_sortSource index passed the filter
+  std::vector<std::pair<int, int> >         m_rankKeys; // score (-1 beyond the top k hits) and m_sortSource index
+                                                        // per m_listOfPackages entry, empty unless ranking
   bool    m_filterPackagesNotInstalled;
   QString m_filterPackagesNotInThisGroup;
   int     m_filterColumn;
@@ -0,0 +1,127 @@
+/*
+* This file is part of Octopi, an open-source GUI for pacman.
+* Copyright (C) 2014 Thomas Binkau
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*
+*/
+
+#include "packagetree.h"
+
+#include <cassert>
+
+
+PackageTree::PackageTree(const PackageRepository::TListOfPackages& packages, EDirection mode)
+  : m_mode(mode)
+{
+  m_nodes.reserve(packages.size());
+  m_childArrays.push_back(std::vector<int>());
+  m_childArrays[0].reserve(packages.size());
+
+  for (int x = 0; x < packages.size(); ++x) {
+    TNode node;
+    node.package       = packages.at(x);
+    node.parent        = ctn_ROOT_NODE;
+    node.row           = x;
+    node.children      = ctn_NOT_FETCHED;
+    node.backReference = false;
+    m_childArrays[0].push_back(static_cast<int>(m_nodes.size()));
+    m_nodes.push_back(node);
+  }
+}
+
+int PackageTree::getChildCount(int node) const
+{
+  const std::vector<int>*const children = getChildArray(node);
+  return children != NULL ? static_cast<int>(children->size()) : 0;
+}
+
+int PackageTree::getChildAt(int node, int row) const
+{
+  const std::vector<int>*const children = getChildArray(node);
+  assert(children != NULL && row >= 0 && row < static_cast<int>(children->size()));
+  return (*children)[row];
+}
+
+bool PackageTree::hasChildren(int node) const
+{
+  if (node == ctn_ROOT_NODE || m_nodes[node].children != ctn_NOT_FETCHED) return getChildCount(node) > 0;
+  return getDependencyCount(node) > 0;
+}
+
+bool PackageTree::canFetchChildren(int node) const
+{
+  if (node == ctn_ROOT_NODE || m_nodes[node].children != ctn_NOT_FETCHED) return false;
+  return getDependencyCount(node) > 0;
+}
+
+int PackageTree::getDependencyCount(int node) const
+{
+  if (node == ctn_ROOT_NODE || m_nodes[node].backReference) return 0;
+  const PackageRepository::PackageData::TDependencyVec*const deps = getDependencies(node);
+  return deps != NULL ? deps->size() : 0;
+}
+
+/**
+ * @brief creates a node for every dependency (or requirement) of %node's package
+ *
+ * Packages which are ancestors of %node already become back references which can't be expanded.
+ */
+void PackageTree::fetchChildren(int node)
+{
+  if (canFetchChildren(node) == false) return;
+
+  const PackageRepository::PackageData::TDependencyVec& deps = *getDependencies(node);
+  const int arrayIndex = static_cast<int>(m_childArrays.size());
+  m_childArrays.push_back(std::vector<int>());
+  m_nodes[node].children = arrayIndex;
+
+  std::vector<int>& children = m_childArrays.back();
+  children.reserve(deps.size());
+  for (int x = 0; x < deps.size(); ++x) {
+    TNode child;
+    child.package       = deps.at(x);
+    child.parent        = node;
+    child.row           = x;
+    child.children      = ctn_NOT_FETCHED;
+    child.backReference = isAncestor(node, child.package);
+    children.push_back(static_cast<int>(m_nodes.size()));
+    m_nodes.push_back(child);
+  }
+}
+
+const PackageRepository::PackageData::TDependencyVec* PackageTree::getDependencies(int node) const
+{
+  const PackageRepository::PackageData& package = *m_nodes[node].package;
+  return m_mode == DEPENDS_ON ? package.getDependsOn() : package.getRequiredBy();
+}
+
+/**
+ * @brief true if %package is the package of %node or of one of its ancestors
+ */
+bool PackageTree::isAncestor(int node, const PackageRepository::PackageData* package) const
+{
+  for (; node != ctn_ROOT_NODE; node = m_nodes[node].parent) {
+    if (m_nodes[node].package == package) return true;
+  }
+  return false;
+}
+
+const std::vector<int>* PackageTree::getChildArray(int node) const
+{
+  if (node == ctn_ROOT_NODE) return &m_childArrays[0];
+  if (m_nodes[node].children == ctn_NOT_FETCHED) return NULL;
+  return &m_childArrays[m_nodes[node].children];
+}
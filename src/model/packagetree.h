@@ -0,0 +1,148 @@
+/*
+* This file is part of Octopi, an open-source GUI for pacman.
+* Copyright (C) 2014 Thomas Binkau
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*
+*/
+
+#ifndef OCTOPI_PACKAGETREE_H
+#define OCTOPI_PACKAGETREE_H
+
+#include <algorithm>
+#include <vector>
+
+#include "src/packagerepository.h"
+
+/**
+ * @brief Holds package navigation information for a dependency treeview
+ *
+ * All nodes live in one flat pool and are addressed by their index (node id). A node is
+ * little more than (package, parent node id): the package data itself is shared with the
+ * repository. Children are only created when a node gets expanded (fetchChildren).
+ * A package which already shows up among the ancestors of a node is added as a leaf
+ * back reference, so cyclic dependencies never expand forever.
+ */
+class PackageTree
+{
+public:
+  /**
+   * @brief Parent item %EDirection% child items (e.g parent DEPENDS_ON child)
+   */
+  enum EDirection {
+    REQUIRED_BY,
+    DEPENDS_ON
+  };
+
+  static const int ctn_ROOT_NODE = -1; // invisible parent of the top level nodes
+  static const int ctn_ALL_NODES = -2; // see sortChildren
+
+public:
+  /**
+   * @brief creates one top level node per package in %packages (in that order)
+   */
+  PackageTree(const PackageRepository::TListOfPackages& packages, EDirection mode);
+
+  int  getChildCount(int node) const; // 0 until fetched
+  int  getChildAt(int node, int row) const;
+  bool hasChildren(int node) const;   // true if there are or would be children after fetching
+  bool canFetchChildren(int node) const;
+  int  getDependencyCount(int node) const; // number of children fetchChildren would create
+
+  /**
+   * @brief creates the child nodes of %node (in repository order)
+   */
+  void fetchChildren(int node);
+
+  inline int getParent(int node) const {
+    return m_nodes[node].parent;
+  }
+  // position within the child array of the parent
+  inline int getRow(int node) const {
+    return m_nodes[node].row;
+  }
+  inline const PackageRepository::PackageData& getPackage(int node) const {
+    return *m_nodes[node].package;
+  }
+  // true if the package is one of the node's ancestors already (cycle)
+  inline bool isBackReference(int node) const {
+    return m_nodes[node].backReference;
+  }
+
+  /**
+   * @brief sorts the children of %node in place (every fetched child array for ctn_ALL_NODES)
+   * @param comp compares two PackageData pointers
+   */
+  template <typename TComp>
+  void sortChildren(int node, TComp comp);
+
+private:
+  struct TNode {
+    const PackageRepository::PackageData* package;
+    int  parent;
+    int  row;
+    int  children; // index into m_childArrays, ctn_NOT_FETCHED until fetched
+    bool backReference;
+  };
+
+  static const int ctn_NOT_FETCHED = -1;
+
+  template <typename TComp>
+  struct TNodeSort {
+    TNodeSort(const std::vector<TNode>& nodes, TComp comp) : m_nodes(nodes), m_comp(comp) {}
+
+    bool operator()(const int a, const int b) const {
+      return m_comp(m_nodes[a].package, m_nodes[b].package);
+    }
+
+    const std::vector<TNode>& m_nodes;
+    TComp                     m_comp;
+  };
+
+  const PackageRepository::PackageData::TDependencyVec* getDependencies(int node) const;
+  bool isAncestor(int node, const PackageRepository::PackageData* package) const;
+  const std::vector<int>* getChildArray(int node) const;
+  template <typename TComp>
+  void sortChildArray(std::vector<int>& children, TComp comp);
+
+private:
+  const EDirection               m_mode;
+  std::vector<TNode>             m_nodes;
+  std::vector<std::vector<int> > m_childArrays; // m_childArrays[0] holds the top level nodes
+};
+
+
+template <typename TComp>
+void PackageTree::sortChildren(int node, TComp comp)
+{
+  if (node == ctn_ALL_NODES) {
+    for (std::size_t x = 0; x < m_childArrays.size(); ++x) sortChildArray(m_childArrays[x], comp);
+  }
+  else if (node == ctn_ROOT_NODE) {
+    sortChildArray(m_childArrays[0], comp);
+  }
+  else if (m_nodes[node].children != ctn_NOT_FETCHED) {
+    sortChildArray(m_childArrays[m_nodes[node].children], comp);
+  }
+}
+
+template <typename TComp>
+void PackageTree::sortChildArray(std::vector<int>& children, TComp comp)
+{
+  std::stable_sort(children.begin(), children.end(), TNodeSort<TComp>(m_nodes, comp));
+  for (std::size_t x = 0; x < children.size(); ++x) m_nodes[children[x]].row = static_cast<int>(x);
+}
+
+#endif // OCTOPI_PACKAGETREE_H
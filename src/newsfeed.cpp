@@ -0,0 +1,244 @@
+/*
+* This file is part of Octopi, an open-source GUI for pacman.
+* Copyright (C) 2014 Thomas Binkau
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*
+*/
+
+#include "newsfeed.h"
+
+#include <cstdio>
+#include <QDir>
+#include <QEventLoop>
+#include <QFile>
+#include <QFileInfo>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <QRegExp>
+#include <QTextStream>
+#include <QTimer>
+#include <QXmlStreamReader>
+
+#include "package.h"
+#include "unixcommand.h"
+
+
+namespace {
+
+const int ctn_MAX_REDIRECTS = 5;
+
+/**
+ * @brief the HTML of one news item, the way the News tab has always shown it
+ */
+QString renderItem(QXmlStreamReader& reader)
+{
+  QString itemTitle;
+  QString itemLink;
+  QString itemDescription;
+  QString itemPubDate;
+
+  while (reader.readNextStartElement()) {
+    if (reader.qualifiedName() == "title") {
+      itemTitle = "<h3>" + reader.readElementText(QXmlStreamReader::IncludeChildElements) + "</h3>";
+    }
+    else if (reader.qualifiedName() == "link") {
+      itemLink = Package::makeURLClickable(reader.readElementText(QXmlStreamReader::IncludeChildElements));
+      if (UnixCommand::getLinuxDistro() == ectn_MANJAROLINUX) itemLink += "<br>";
+    }
+    else if (reader.qualifiedName() == "description") {
+      itemDescription = reader.readElementText(QXmlStreamReader::IncludeChildElements) + "<br>";
+    }
+    else if (reader.qualifiedName() == "pubDate") {
+      itemPubDate = reader.readElementText(QXmlStreamReader::IncludeChildElements).remove(QRegExp("\\n"));
+      const int pos = itemPubDate.indexOf("+");
+      if (pos > -1) itemPubDate = itemPubDate.mid(0, pos-1).trimmed() + "<br>";
+    }
+    else {
+      reader.skipCurrentElement();
+    }
+  }
+
+  return "<li><p>" + itemTitle + " " + itemPubDate + "<br>" + itemLink + itemDescription + "</p></li>";
+}
+
+/**
+ * @brief writes %data to %fileName through a temporary file, so readers never see half of it
+ */
+bool writeFile(const QString& fileName, const QByteArray& data)
+{
+  const QString tmpName = fileName + ".tmp";
+  QFile file(tmpName);
+  if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) return false;
+
+  const bool written = file.write(data) == data.size();
+  file.close();
+  if (!written || std::rename(QFile::encodeName(tmpName).constData(), QFile::encodeName(fileName).constData()) != 0) {
+    QFile::remove(tmpName);
+    return false;
+  }
+  return true;
+}
+
+} // namespace
+
+
+NewsFeed::NewsFeed(const QString& fileName, const QUrl& url)
+  : m_fileName(fileName), m_url(url)
+{
+}
+
+NewsFeed::EFetchResult NewsFeed::fetch()
+{
+  QNetworkAccessManager manager;
+  QNetworkRequest request(m_url);
+
+  QFile file(m_fileName);
+  if (file.exists()) {
+    const QStringList validators = readValidators();
+    if (!validators.at(0).isEmpty()) request.setRawHeader("If-None-Match", validators.at(0).toLatin1());
+    if (!validators.at(1).isEmpty()) request.setRawHeader("If-Modified-Since", validators.at(1).toLatin1());
+  }
+
+  QNetworkReply* reply = NULL;
+  for (int redirects = 0; ; ++redirects) {
+    reply = manager.get(request);
+
+    QEventLoop loop;
+    QTimer timer;
+    timer.setSingleShot(true);
+    QObject::connect(reply, SIGNAL(finished()), &loop, SLOT(quit()));
+    QObject::connect(&timer, SIGNAL(timeout()), &loop, SLOT(quit()));
+    timer.start(ctn_FETCH_TIMEOUT);
+    loop.exec();
+
+    if (!reply->isFinished()) {
+      reply->abort();
+      return ectn_FEED_FAILED;
+    }
+
+    const QUrl redirect = reply->attribute(QNetworkRequest::RedirectionTargetAttribute).toUrl();
+    if (reply->error() != QNetworkReply::NoError || !redirect.isValid() || redirects == ctn_MAX_REDIRECTS) break;
+    request.setUrl(reply->url().resolved(redirect));
+  }
+
+  const int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+  if (status == 304) return ectn_FEED_UNCHANGED;
+  if (reply->error() != QNetworkReply::NoError || (status != 0 && status != 200)) return ectn_FEED_FAILED;
+
+  const QByteArray data = reply->readAll();
+  QDir().mkpath(QFileInfo(m_fileName).absolutePath());
+
+  // servers without validators send the whole feed every time
+  bool unchanged = false;
+  if (file.open(QIODevice::ReadOnly)) {
+    unchanged = file.readAll() == data;
+    file.close();
+  }
+  if (!unchanged && !writeFile(m_fileName, data)) return ectn_FEED_FAILED;
+
+  // only now the validators describe the local copy; written before it, a failed save would leave
+  // them pointing at a feed that isn't there, and the next fetch would get a 304 for it
+  writeValidators(reply->rawHeader("ETag"), reply->rawHeader("Last-Modified"));
+  return unchanged ? ectn_FEED_UNCHANGED : ectn_FEED_UPDATED;
+}
+
+QString NewsFeed::readFeed() const
+{
+  QFile file(m_fileName);
+  if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) return QString();
+
+  QTextStream in(&file);
+  return in.readAll();
+}
+
+QString NewsFeed::getHtml(const QString& header) const
+{
+  QFile file(m_fileName);
+  if (!file.open(QIODevice::ReadOnly)) return "";
+
+  QString key;
+  QString html = header;
+  int itemCounter = 0;
+
+  QXmlStreamReader reader(&file);
+  if (!reader.readNextStartElement()) return ""; // rss
+  if (!reader.readNextStartElement()) return ""; // channel
+
+  while (itemCounter < ctn_NEWS_ITEMS && reader.readNextStartElement()) {
+    if (reader.qualifiedName() == "lastBuildDate") {
+      key = reader.readElementText(QXmlStreamReader::IncludeChildElements).trimmed() + "\n" + header;
+
+      const QString cachedHtml = readCachedHtml(key);
+      if (!cachedHtml.isEmpty()) return cachedHtml;
+    }
+    else if (reader.qualifiedName() == "item") {
+      html += renderItem(reader);
+      itemCounter++;
+    }
+    else {
+      reader.skipCurrentElement();
+    }
+  }
+
+  // the feed is only read up to the last item shown, so errors after it don't matter
+  if (reader.hasError() && itemCounter < ctn_NEWS_ITEMS) return "";
+
+  html += "</ul>";
+  if (!key.isEmpty()) writeCachedHtml(key, html);
+  return html;
+}
+
+/**
+ * @brief ETag and Last-Modified of the local copy, empty strings if unknown
+ */
+QStringList NewsFeed::readValidators() const
+{
+  QStringList result;
+  QFile file(m_fileName + ".validators");
+  if (file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+    QTextStream in(&file);
+    result << in.readLine() << in.readLine();
+  }
+
+  while (result.count() < 2) result.append(QString());
+  return result;
+}
+
+void NewsFeed::writeValidators(const QByteArray& eTag, const QByteArray& lastModified) const
+{
+  writeFile(m_fileName + ".validators", eTag + "\n" + lastModified + "\n");
+}
+
+/**
+ * @brief the rendered HTML if it was made from the same lastBuildDate and header, otherwise empty
+ *
+ * The cache file starts with the key's two lines, the HTML follows.
+ */
+QString NewsFeed::readCachedHtml(const QString& key) const
+{
+  QFile file(m_fileName + ".html");
+  if (!file.open(QIODevice::ReadOnly)) return QString();
+
+  const QString contents = QString::fromUtf8(file.readAll());
+  if (!contents.startsWith(key + "\n")) return QString();
+  return contents.mid(key.length() + 1);
+}
+
+void NewsFeed::writeCachedHtml(const QString& key, const QString& html) const
+{
+  writeFile(m_fileName + ".html", (key + "\n" + html).toUtf8());
+}
@@ -0,0 +1,78 @@
+/*
+* This file is part of Octopi, an open-source GUI for pacman.
+* Copyright (C) 2014 Thomas Binkau
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*
+*/
+
+#ifndef OCTOPI_NEWSFEED_H
+#define OCTOPI_NEWSFEED_H
+
+#include <QString>
+#include <QStringList>
+#include <QUrl>
+
+
+/**
+ * @brief The distro's RSS news feed, kept in a local file
+ *
+ * fetch() is a conditional GET: the ETag and Last-Modified of the last download are sent back,
+ * so an unchanged feed costs one 304 response. getHtml() reads the local copy with
+ * QXmlStreamReader, stops after the ctn_NEWS_ITEMS items it shows and keeps the result next to
+ * the feed, keyed by the feed's lastBuildDate; as long as that doesn't change, the HTML is
+ * only read back.
+ *
+ * Besides the feed file, "<fileName>.validators" and "<fileName>.html" are written.
+ */
+class NewsFeed
+{
+public:
+  enum EFetchResult {
+    ectn_FEED_UPDATED,
+    ectn_FEED_UNCHANGED,
+    ectn_FEED_FAILED
+  };
+
+  static const int ctn_NEWS_ITEMS = 10;
+  static const int ctn_FETCH_TIMEOUT = 30 * 1000;
+
+public:
+  explicit NewsFeed(const QString& fileName, const QUrl& url = QUrl());
+
+  /**
+   * @brief downloads the feed if it changed since the last time; blocks, so it belongs in a worker thread
+   */
+  EFetchResult fetch();
+
+  QString readFeed() const;
+
+  /**
+   * @brief the latest news as a HTML list, below %header
+   */
+  QString getHtml(const QString& header) const;
+
+private:
+  QStringList readValidators() const;
+  void writeValidators(const QByteArray& eTag, const QByteArray& lastModified) const;
+  QString readCachedHtml(const QString& key) const;
+  void writeCachedHtml(const QString& key, const QString& html) const;
+
+private:
+  QString m_fileName;
+  QUrl    m_url;
+};
+
+#endif // OCTOPI_NEWSFEED_H
@@ -0,0 +1,285 @@
+/*
+* This file is part of Octopi, an open-source GUI for pacman.
+* Copyright (C) 2014 Thomas Binkau
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*
+*/
+
+#include "outputparser.h"
+
+#include <cstddef>
+
+
+namespace {
+
+// verbs pacman starts its progress and stage lines with
+const char* const ctn_KEY_VERBS[] = {
+  "checking", "loading", "installing", "reinstalling", "upgrading", "downgrading",
+  "removing", "resolving", "looking"
+};
+
+// line parts written by the su frontends and the desktop, everything from them on is dropped
+const char* const ctn_NOISE_MARKERS[] = {
+  "(process", "Using the fallback", "Gkr-Message:", "kdesu", "kbuildsycoca",
+  "Connecting to deprecated signal", "QVariant", "gksu-run", ":: Do you want"
+};
+
+QString keyVerbOf(const QString& text)
+{
+  const int space = text.indexOf(' ');
+  const QString word = (space == -1 ? text : text.left(space));
+  for (std::size_t x = 0; x < sizeof(ctn_KEY_VERBS) / sizeof(ctn_KEY_VERBS[0]); ++x) {
+    if (word == QLatin1String(ctn_KEY_VERBS[x])) return word;
+  }
+  return QString();
+}
+
+inline bool isDigit(const QString& text, int pos)
+{
+  return pos >= 0 && pos < text.size() && text.at(pos).isDigit();
+}
+
+} // namespace
+
+
+/**
+ * @brief returns the events of all lines %output completes, the unterminated tail is kept for the next call
+ */
+QList<OutputParser::Event> OutputParser::parse(const QString& output)
+{
+  QString raw = m_pendingEscape + output;
+  m_pendingEscape.clear();
+  const int escape = unfinishedEscapeAt(raw);
+  if (escape != -1) {
+    m_pendingEscape = raw.mid(escape);
+    raw.truncate(escape);
+  }
+
+  QList<Event> events;
+  const QString text = m_pending + stripEscapeSequences(raw);
+  m_pending.clear();
+
+  int lineStart = 0;
+  for (int x = 0; x < text.size(); ++x) {
+    int lineEnd = -1;
+    int next    = x;
+    if (text.at(x) == '\n' || text.at(x) == '\r') {
+      lineEnd = x;
+      next    = x + 1;
+    }
+    else if (x > lineStart && text.at(x) == '(' && isCounterAt(text, x)) {
+      lineEnd = x;
+    }
+    else if (text.at(x) == '%' && isBarEndAt(text, x)) {
+      lineEnd = x + 1;
+      next    = x + 1;
+    }
+    if (lineEnd == -1) continue;
+
+    Event event;
+    if (parseLine(text.mid(lineStart, lineEnd - lineStart), event)) events.append(event);
+    lineStart = next;
+    x         = next - 1;
+  }
+
+  m_pending = text.mid(lineStart);
+  return events;
+}
+
+/**
+ * @brief returns the event of the tail held back so far (if any), called when the process has finished
+ */
+QList<OutputParser::Event> OutputParser::flush()
+{
+  QList<Event> events;
+  Event event;
+  if (parseLine(m_pending, event)) events.append(event);
+  reset();
+  return events;
+}
+
+void OutputParser::reset()
+{
+  m_pending.clear();
+  m_pendingEscape.clear();
+}
+
+/**
+ * @brief returns the position of an escape sequence %output ends in the middle of, or -1
+ */
+int OutputParser::unfinishedEscapeAt(const QString& output)
+{
+  const int escape = output.lastIndexOf(QChar(0x1b));
+  if (escape == -1) return -1;
+
+  int x = escape + 1;
+  if (x < output.size() && output.at(x) == '[') ++x;
+  while (x < output.size() && (output.at(x).isDigit() || output.at(x) == ';')) ++x;
+  return x == output.size() ? escape : -1;
+}
+
+/**
+ * @brief removes "ESC[...<letter>" sequences, and the "[1;33m" leftovers whose ESC got lost on the way
+ */
+QString OutputParser::stripEscapeSequences(const QString& output)
+{
+  QString result;
+  result.reserve(output.size());
+
+  for (int x = 0; x < output.size(); ++x) {
+    const QChar c = output.at(x);
+    const bool escaped = c == QChar(0x1b);
+    if (!escaped && c != '[') {
+      result.append(c);
+      continue;
+    }
+
+    int y = escaped ? x + 1 : x;
+    if (y >= output.size() || output.at(y) != '[') {
+      if (!escaped) result.append(c);
+      continue;
+    }
+
+    ++y;
+    while (y < output.size() && (output.at(y).isDigit() || output.at(y) == ';')) ++y;
+    if (y < output.size() && (escaped ? output.at(y).isLetter() : (output.at(y) == 'm' && y > x + 1))) {
+      x = y;
+    }
+    else if (escaped) {
+      x = y - 1;
+    }
+    else {
+      result.append(c);
+    }
+  }
+
+  return result;
+}
+
+/**
+ * @brief true if "(x/y) " starts at %pos (up to 3 blanks after the parenthesis, up to 4 digits each)
+ */
+bool OutputParser::isCounterAt(const QString& text, int pos, int* current, int* total, int* length)
+{
+  if (pos >= text.size() || text.at(pos) != '(') return false;
+
+  int x = pos + 1;
+  for (int blanks = 0; blanks < 3 && x < text.size() && text.at(x) == ' '; ++blanks) ++x;
+
+  const int currentStart = x;
+  while (isDigit(text, x) && x - currentStart < 4) ++x;
+  if (x == currentStart || x >= text.size() || text.at(x) != '/') return false;
+  const int currentEnd = x++;
+
+  const int totalStart = x;
+  while (isDigit(text, x) && x - totalStart < 4) ++x;
+  if (x == totalStart || x + 1 >= text.size() || text.at(x) != ')' || text.at(x + 1) != ' ') return false;
+
+  if (current != 0) *current = text.mid(currentStart, currentEnd - currentStart).toInt();
+  if (total != 0)   *total   = text.mid(totalStart, x - totalStart).toInt();
+  if (length != 0)  *length  = x + 2 - pos;
+  return true;
+}
+
+/**
+ * @brief true if the '%' at %pos ends a progress bar: "] 50%"
+ */
+bool OutputParser::isBarEndAt(const QString& text, int pos)
+{
+  int x = pos - 1;
+  while (isDigit(text, x)) --x;
+  if (x == pos - 1 || pos - 1 - x > 3) return false;
+  while (x >= 0 && text.at(x) == ' ') --x;
+  return x >= 0 && text.at(x) == ']';
+}
+
+/**
+ * @brief classifies one line, returns false for blank lines
+ */
+bool OutputParser::parseLine(const QString& line, Event& event)
+{
+  event.type    = ectn_TEXT;
+  event.percent = -1;
+  event.current = 0;
+  event.total   = 0;
+
+  QString text = line;
+  bool hadNoise = false;
+  for (std::size_t x = 0; x < sizeof(ctn_NOISE_MARKERS) / sizeof(ctn_NOISE_MARKERS[0]); ++x) {
+    const int marker = text.indexOf(QLatin1String(ctn_NOISE_MARKERS[x]));
+    if (marker != -1) {
+      text.truncate(marker);
+      hadNoise = true;
+    }
+  }
+  text = text.trimmed();
+
+  if (text.isEmpty()) {
+    if (!hadNoise) return false;
+    event.type = ectn_NOISE;
+    event.text = line.trimmed();
+    return true;
+  }
+  if (text.contains("[Y/n]") || text.startsWith("Enter a selection")) {
+    event.type = ectn_NOISE;
+    event.text = text;
+    return true;
+  }
+
+  int counterLength = 0;
+  if (isCounterAt(text, 0, &event.current, &event.total, &counterLength)) {
+    text = text.mid(counterLength).trimmed();
+  }
+
+  // progress bar: "<label> [<bar>] <percent>%"
+  if (text.endsWith('%') && isBarEndAt(text, text.size() - 1)) {
+    const int barEnd   = text.lastIndexOf(']');
+    const int barStart = text.lastIndexOf('[', barEnd);
+    if (barStart <= 0 || !text.at(barStart - 1).isSpace()) {
+      // the tail of a redraw which got split somewhere else
+      event.type = ectn_NOISE;
+      event.text = text;
+      return true;
+    }
+
+    event.percent = text.mid(barEnd + 1, text.size() - barEnd - 2).trimmed().toInt();
+    event.text    = text.left(barStart).trimmed();
+    event.verb    = keyVerbOf(event.text);
+    if (!event.verb.isEmpty()) {
+      event.type   = ectn_PROGRESS;
+      event.target = event.text.mid(event.verb.size()).trimmed();
+    }
+    else {
+      event.type   = ectn_DOWNLOAD;
+      event.target = event.text.section(' ', 0, 0);
+    }
+    return true;
+  }
+
+  event.text = text;
+  if (text.startsWith("error:") || text.contains("exists in filesystem")) {
+    event.type = ectn_ERROR;
+  }
+  else if (text.startsWith("warning:")) {
+    event.type = ectn_WARNING;
+  }
+  else {
+    event.verb = keyVerbOf(text);
+    if (!event.verb.isEmpty()) event.target = text.mid(event.verb.size()).trimmed();
+    if (!event.verb.isEmpty() || text.startsWith("::") || event.total > 0) event.type = ectn_STAGE;
+  }
+  return true;
+}
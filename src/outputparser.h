@@ -0,0 +1,77 @@
+/*
+* This file is part of Octopi, an open-source GUI for pacman.
+* Copyright (C) 2014 Thomas Binkau
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*
+*/
+
+#ifndef OCTOPI_OUTPUTPARSER_H
+#define OCTOPI_OUTPUTPARSER_H
+
+#include <QList>
+#include <QString>
+
+
+/**
+ * @brief Splits the output of a running pacman transaction into typed events
+ *
+ * Every chunk read from the process is scanned once: escape sequences are dropped, lines are
+ * broken at '\n' and '\r', and also where pacman redraws a progress bar without a line break
+ * (a new "(x/y) " counter or the end of a "[####] 50%" bar). Each line then becomes one event.
+ * As the process output arrives in arbitrary chunks, an unterminated tail is held back until the
+ * next chunk completes it or flush() is called, so one parser is used per output stream.
+ */
+class OutputParser
+{
+public:
+  enum EEventType {
+    ectn_PROGRESS, // "(1/3) installing foo   [####] 50%", "checking keys in keyring   [####] 100%"
+    ectn_DOWNLOAD, // "foo-1.0-1-x86_64   1024.0 KiB  512K/s 00:02 [####] 50%", "core   [####] 100%"
+    ectn_STAGE,    // ":: Retrieving packages ...", "resolving dependencies...", "(2/3) removing foo..."
+    ectn_WARNING,  // "warning: ..."
+    ectn_ERROR,    // "error: ...", "foo: /usr/bin/foo exists in filesystem"
+    ectn_NOISE,    // messages of kdesu, gksu and friends, confirmation prompts, garbled redraws
+    ectn_TEXT      // anything else
+  };
+
+  struct Event {
+    EEventType type;
+    QString    text;    // the line without counter and progress bar, trimmed
+    QString    verb;    // "installing", "checking"... for progress and stage lines starting with one
+    QString    target;  // what follows the verb, or the file/db name of a download
+    int        percent; // -1 without a progress bar
+    int        current; // "(current/total)", both 0 without a counter
+    int        total;
+  };
+
+public:
+  QList<Event> parse(const QString& output);
+  QList<Event> flush();
+  void         reset();
+
+private:
+  static QString stripEscapeSequences(const QString& output);
+  static bool    isCounterAt(const QString& text, int pos, int* current = 0, int* total = 0, int* length = 0);
+  static bool    isBarEndAt(const QString& text, int pos);
+  static bool    parseLine(const QString& line, Event& event);
+  static int     unfinishedEscapeAt(const QString& output);
+
+private:
+  QString m_pending;       // the text after the last line break, without escape sequences
+  QString m_pendingEscape; // an escape sequence cut off at the end of the last chunk
+};
+
+#endif // OCTOPI_OUTPUTPARSER_H
@@ -0,0 +1,127 @@
+/*
+* This file is part of Octopi, an open-source GUI for pacman.
+* Copyright (C) 2014 Thomas Binkau
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*
+*/
+
+#include "outputsink.h"
+
+#include <QTextBrowser>
+#include <QTextCursor>
+#include <QTextDocument>
+
+
+OutputSink::OutputSink(QTextBrowser* browser)
+  : QObject(browser), m_browser(browser), m_pendingProgress(-1), m_length(0)
+{
+  m_timer.setSingleShot(true);
+  m_timer.setInterval(ctn_FLUSH_INTERVAL);
+  connect(&m_timer, SIGNAL(timeout()), this, SLOT(flush()));
+}
+
+void OutputSink::append(const QString& html, const QString& line)
+{
+  if (!line.isEmpty()) {
+    m_printed.insert(line.trimmed());
+    m_pendingLines.append(line.trimmed());
+  }
+  m_pending.append(html);
+  if (!m_timer.isActive()) m_timer.start();
+}
+
+bool OutputSink::contains(const QString& line) const
+{
+  return m_printed.contains(line.trimmed());
+}
+
+void OutputSink::setProgress(int percent)
+{
+  m_pendingProgress = percent;
+  if (!m_timer.isActive()) m_timer.start();
+}
+
+void OutputSink::clear()
+{
+  m_timer.stop();
+  m_pending.clear();
+  m_pendingLines.clear();
+  m_pendingProgress = -1;
+  m_printed.clear();
+  m_flushLengths.clear();
+  m_flushLines.clear();
+  m_length = 0;
+  m_browser->clear();
+}
+
+/**
+ * @brief writes everything queued, also called directly by whoever needs the document up to date
+ */
+void OutputSink::flush()
+{
+  m_timer.stop();
+
+  if (!m_pending.isEmpty()) {
+    QTextDocument*const document = m_browser->document();
+    const int before = document->characterCount();
+
+    QTextCursor cursor = m_browser->textCursor();
+    cursor.clearSelection();
+    cursor.movePosition(QTextCursor::End);
+    m_browser->setTextCursor(cursor);
+    m_browser->insertHtml(m_pending.join(""));
+    m_browser->ensureCursorVisible();
+    m_pending.clear();
+
+    const int added = document->characterCount() - before;
+    m_flushLengths.enqueue(added);
+    m_flushLines.enqueue(m_pendingLines);
+    m_pendingLines.clear();
+    m_length += added;
+    if (m_length > ctn_MAX_CHARACTERS) trim();
+  }
+
+  if (m_pendingProgress != -1) {
+    emit progressChanged(m_pendingProgress);
+    m_pendingProgress = -1;
+  }
+}
+
+/**
+ * @brief drops the oldest flushes until a quarter of the cap is free again
+ *
+ * Their lines aren't in the document anymore, so they may be printed again.
+ */
+void OutputSink::trim()
+{
+  int remove = 0;
+  while (m_flushLengths.size() > 1 && m_length - remove > ctn_MAX_CHARACTERS / 4 * 3) {
+    remove += m_flushLengths.dequeue();
+    const QStringList lines = m_flushLines.dequeue();
+    for (QStringList::const_iterator it = lines.begin(); it != lines.end(); ++it) m_printed.remove(*it);
+  }
+  if (remove == 0) return;
+
+  QTextCursor cursor(m_browser->document());
+  cursor.movePosition(QTextCursor::Start);
+  cursor.movePosition(QTextCursor::NextCharacter, QTextCursor::KeepAnchor, remove);
+  cursor.removeSelectedText();
+  m_length -= remove;
+
+  cursor = m_browser->textCursor();
+  cursor.movePosition(QTextCursor::End);
+  m_browser->setTextCursor(cursor);
+}
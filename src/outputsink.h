@@ -0,0 +1,83 @@
+/*
+* This file is part of Octopi, an open-source GUI for pacman.
+* Copyright (C) 2014 Thomas Binkau
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*
+*/
+
+#ifndef OCTOPI_OUTPUTSINK_H
+#define OCTOPI_OUTPUTSINK_H
+
+#include <QObject>
+#include <QQueue>
+#include <QSet>
+#include <QStringList>
+#include <QTimer>
+
+class QTextBrowser;
+
+
+/**
+ * @brief Batches what is written to the Output tab
+ *
+ * Messages are collected and inserted with one insertHtml call per frame at most, progress
+ * values in between overwrite each other and only the last one is reported. The printed lines
+ * are kept in a hash, so deduplication doesn't search the document. The document is capped:
+ * when it grows beyond ctn_MAX_CHARACTERS the oldest flushes are dropped, and their lines
+ * are forgotten with them.
+ */
+class OutputSink : public QObject
+{
+  Q_OBJECT
+
+public:
+  static const int ctn_FLUSH_INTERVAL = 16;      // ms, about one frame
+  static const int ctn_MAX_CHARACTERS = 500000;
+
+public:
+  explicit OutputSink(QTextBrowser* browser);
+
+  /**
+   * @brief queues %html, %line (if not empty) is remembered as printed
+   */
+  void append(const QString& html, const QString& line = QString());
+  bool contains(const QString& line) const;
+
+  void setProgress(int percent);
+  void clear();
+
+signals:
+  void progressChanged(int percent);
+
+public slots:
+  void flush();
+
+private:
+  void trim();
+
+private:
+  QTextBrowser* m_browser;
+  QTimer        m_timer;
+  QStringList   m_pending;
+  QStringList   m_pendingLines;    // the lines of m_pending
+  int           m_pendingProgress; // -1 if none
+  QSet<QString> m_printed;
+  QQueue<int>   m_flushLengths;    // characters each flush added, oldest first
+  QQueue<QStringList> m_flushLines; // lines each flush added, oldest first
+  int           m_length;
+};
+
+#endif // OCTOPI_OUTPUTSINK_H
@@ -26,6 +26,7 @@
 
 #include <QTextStream>
 #include <QList>
+#include <QFile>
 
 /*
  * This class abstracts all the relevant package information and services
@@ -217,31 +218,100 @@ QSet<QString>*Package::getExplicitPackageList()
 }
 
 /*
- * Retrieves the list of outdated packages (those which have newer versions available to download)
+ * Retrieves the outdated and newer packages, comparing local and sync versions as given by "pacman -Sl"
  */
-QStringList *Package::getOutdatedPackageList()
+OutdatedPackages *Package::getOutdatedPackages()
 {
-  QString outPkgList = UnixCommand::getOutdatedPackageList();
-  QStringList packageTuples = outPkgList.split(QRegExp("\\n"), QString::SkipEmptyParts);
-  QStringList * res = new QStringList();
-  QStringList ignorePkgList = UnixCommand::getIgnorePkg();
+  //core acl 2.2.52-2 [installed: 2.2.51-1]
+  QString syncList = UnixCommand::getSyncPackageVersionList();
+  QStringList packageTuples = syncList.split(QRegExp("\\n"), QString::SkipEmptyParts);
+  QList<PackageListData> syncPackages;
 
   foreach(QString packageTuple, packageTuples)
   {
-    QStringList parts = packageTuple.split(' ');
+    QStringList parts = packageTuple.split(' ', QString::SkipEmptyParts);
+    if (parts.count() < 3) continue;
+
+    if (packageTuple.indexOf("[installed:") != -1)
     {
-      QString pkgName;
-      pkgName = parts[0];
+      int i = packageTuple.indexOf("[installed:");
+      QString localVersion = packageTuple.mid(i+11);
+      localVersion.remove(']');
+      syncPackages.append(PackageListData(parts[1], parts[0], parts[2], ectn_OUTDATED, localVersion));
+    }
+    else if (packageTuple.indexOf("[installed]") != -1)
+    {
+      syncPackages.append(PackageListData(parts[1], parts[0], parts[2], ectn_INSTALLED));
+    }
+    else
+    {
+      syncPackages.append(PackageListData(parts[1], parts[0], parts[2], ectn_NON_INSTALLED));
+    }
+  }
 
-      //Let's ignore the "IgnorePkg" list of packages...
-      if (!ignorePkgList.contains(pkgName))
-      {
-        res->append(pkgName); //We only need the package name!
-      }
+  return getOutdatedPackages(syncPackages, getIgnoredPackageList());
+}
+
+/*
+ * Matches the package name against pacman.conf's IgnorePkg (which may hold glob patterns)
+ */
+bool Package::isIgnoredPackage(const QString &pkgName, const QStringList &ignorePkgList)
+{
+  foreach(QString ignorePkg, ignorePkgList)
+  {
+    if (ignorePkg == pkgName) return true;
+    if (ignorePkg.contains('*') || ignorePkg.contains('?') || ignorePkg.contains('['))
+    {
+      QRegExp pattern(ignorePkg, Qt::CaseSensitive, QRegExp::Wildcard);
+      if (pattern.exactMatch(pkgName)) return true;
     }
   }
+  return false;
+}
 
-  res->sort();
+/*
+ * Returns the packages which must not be upgraded: pacman.conf's IgnorePkg and Octopi's frozen list
+ */
+QStringList Package::getIgnoredPackageList()
+{
+  return UnixCommand::getIgnorePkg() + SettingsManager::getFrozenPkgList();
+}
+
+/*
+ * Computes the outdated and newer packages in one pass over the given sync package list
+ * (local version in "outatedVersion", as produced by "pacman -Ss" or "pacman -Sl").
+ * Like pacman, only the first repository holding a package counts. Versions are compared
+ * with vercmp (epoch, version and release apart, as "pacman -Qu" does), the same ordering
+ * PackageRepository uses for the OUTDATED/NEWER status.
+ * Packages in ignorePkgList (IgnorePkg and Octopi's frozen list) are not reported as outdated.
+ */
+OutdatedPackages *Package::getOutdatedPackages(const QList<PackageListData> &syncPackages,
+                                               const QStringList &ignorePkgList)
+{
+  OutdatedPackages * res = new OutdatedPackages();
+  QSet<QString> seen;
+  seen.reserve(syncPackages.count());
+
+  foreach(const PackageListData &pld, syncPackages)
+  {
+    if (seen.contains(pld.name)) continue;
+    seen.insert(pld.name);
+
+    if (pld.status != ectn_OUTDATED || pld.outatedVersion.isEmpty()) continue;
+
+    const int cmp = vercmp(pld.outatedVersion, pld.version);
+    if (cmp < 0)
+    {
+      if (!isIgnoredPackage(pld.name, ignorePkgList)) res->outdated.append(pld.name);
+    }
+    else if (cmp > 0)
+    {
+      res->newer.append(pld.name);
+    }
+  }
+
+  res->outdated.sort();
+  res->newer.sort();
   return res;
 }
 
@@ -406,7 +476,8 @@ QList<PackageListData> * Package::getPackageList()
 
   QString pkgName, pkgRepository, pkgVersion, pkgDescription, pkgOutVersion;
   PackageStatus pkgStatus;
-  QString pkgList = UnixCommand::getPackageList();
+  // descriptions may contain any UTF-8 text
+  QString pkgList = QString::fromUtf8(UnixCommand::getPackageList());
   QStringList packageTuples = pkgList.split(QRegExp("\\n"), QString::SkipEmptyParts);
   QList<PackageListData> * res = new QList<PackageListData>();
 
@@ -495,7 +566,7 @@ QList<PackageListData> * Package::getYaourtPackageList(const QString& searchStri
   if (searchString.isEmpty())
     return res;
 
-  QString pkgList = UnixCommand::getYaourtPackageList(searchString);
+  QString pkgList = QString::fromUtf8(UnixCommand::getYaourtPackageList(searchString));
   QStringList packageTuples = pkgList.split(QRegExp("\\n"), QString::SkipEmptyParts);
 
   pkgDescription = "";
@@ -937,6 +1008,66 @@ cleanup:
   return ret;
 }
 
+/*
+ * Splits a full version string into epoch, version and release (like pacman's parseEVR)
+ */
+static void parseEVR(const QString &evr, QString &epoch, QString &version, QString &release)
+{
+  int s = 0;
+  while (s < evr.size() && evr.at(s).isDigit()) s++;
+
+  int versionStart = 0;
+  if (s < evr.size() && evr.at(s) == ':')
+  {
+    epoch = (s == 0 ? QString("0") : evr.left(s));
+    versionStart = s+1;
+  }
+  else
+  {
+    epoch = "0";
+  }
+
+  int se = evr.lastIndexOf('-');
+  if (se >= versionStart)
+  {
+    version = evr.mid(versionStart, se - versionStart);
+    release = evr.mid(se+1);
+  }
+  else
+  {
+    version = evr.mid(versionStart);
+    release = QString();
+  }
+}
+
+/**
+ * Compares two full package versions (epoch:version-release) the way pacman's alpm_pkg_vercmp does.
+ * The release is only compared if both versions have one.
+ * return 1: a is newer than b
+ *        0: a and b are the same version
+ *       -1: b is newer than a
+ */
+int Package::vercmp(const QString &a, const QString &b)
+{
+  if (a == b) return 0;
+
+  QString epoch1, version1, release1;
+  QString epoch2, version2, release2;
+  parseEVR(a, epoch1, version1, release1);
+  parseEVR(b, epoch2, version2, release2);
+
+  int ret = rpmvercmp(epoch1.toLatin1().constData(), epoch2.toLatin1().constData());
+  if (ret == 0)
+  {
+    ret = rpmvercmp(version1.toLatin1().constData(), version2.toLatin1().constData());
+    if (ret == 0 && !release1.isNull() && !release2.isNull())
+    {
+      ret = rpmvercmp(release1.toLatin1().constData(), release2.toLatin1().constData());
+    }
+  }
+  return ret;
+}
+
 /*
  * Retrieves "Description" field of the given package information string represented by pkgInfo
  */
@@ -993,6 +1124,40 @@ QString Package::getInformationDescription(const QString &pkgName, bool foreignP
   return getDescription(pkgInfo);
 }
 
+/*
+ * Retrieves the description of an installed package straight from pacman's local database,
+ * which is much cheaper than a "pacman -Qi" call. Falls back to the latter if the entry can't be read.
+ */
+QString Package::getLocalDescription(const QString &pkgName, const QString &pkgVersion)
+{
+  QFile descFile(ctn_PACMAN_DATABASE_DIR + "/local/" + pkgName + "-" + pkgVersion + "/desc");
+
+  if (descFile.open(QIODevice::ReadOnly) && descFile.size() > 0)
+  {
+    uchar *data = descFile.map(0, descFile.size());
+    if (data != NULL)
+    {
+      const QByteArray content = QByteArray::fromRawData(reinterpret_cast<const char*>(data), descFile.size());
+      const int field = content.indexOf("%DESC%\n");
+      QString res;
+
+      if (field != -1)
+      {
+        const int begin = field + 7;
+        int end = content.indexOf('\n', begin);
+        if (end == -1) end = content.size();
+        // pacman writes its databases in UTF-8, whatever the locale's codec is
+        res = QString::fromUtf8(content.constData() + begin, end - begin);
+      }
+
+      descFile.unmap(data);
+      if (field != -1) return res;
+    }
+  }
+
+  return getInformationDescription(pkgName, true);
+}
+
 /*
  * Helper to get only the Version field of Yaourt package information
  */
@@ -1071,19 +1236,6 @@ QStringList Package::getContents(const QString& pkgName, bool isInstalled)
   return slResult;
 }
 
-/*
- * Retrieves the list of optional dependencies of the given package
- */
-QStringList Package::getOptionalDeps(const QString &pkgName)
-{
-  QString pkgInfo = UnixCommand::getPackageInformation(pkgName, false);
-  QString aux = Package::getOptDepends(pkgInfo);
-  QStringList result = aux.split("<br>", QString::SkipEmptyParts);
-  result.removeAll("None");
-
-  return result;
-}
-
 /*
  * Returns a modified RegExp-based string given the string entered by the user
  */
@@ -42,6 +42,7 @@ const QString ctn_DATE_RELEASE      = "^[0-9]{8}$";
 const QString ctn_NO_MATCH      	  = "not found!";
 
 const QString ctn_PACMAN_DATABASE_DIR = "/var/lib/pacman";
+const QString ctn_PACMAN_CACHE_DIR = "/var/cache/pacman/pkg";
 
 const int ctn_KNOWN_ARCHS_LEN = 8;
 const int ctn_KNOWN_NAMES_LEN = 3;
@@ -90,6 +91,11 @@ struct PackageListData{
   }
 };
 
+struct OutdatedPackages{
+  QStringList outdated; // installed version is older than the sync one (IgnorePkg and frozen ones excluded)
+  QStringList newer;    // installed version is newer than the sync one
+};
+
 struct PackageInfoData{
   QString name;
   QString repository;
@@ -124,9 +130,14 @@ class Package{
 
 	public:
     static int rpmvercmp(const char *a, const char *b);
+    static int vercmp(const QString &a, const QString &b);
     static QSet<QString>* getUnrequiredPackageList();
     static QSet<QString>* getExplicitPackageList(); // pacman explicitly installed
-    static QStringList * getOutdatedPackageList();
+    static bool isIgnoredPackage(const QString &pkgName, const QStringList &ignorePkgList);
+    static QStringList getIgnoredPackageList();
+    static OutdatedPackages * getOutdatedPackages();
+    static OutdatedPackages * getOutdatedPackages(const QList<PackageListData> &syncPackages,
+                                                  const QStringList &ignorePkgList);
     static QStringList * getOutdatedYaourtPackageList();
     static QStringList * getPackageGroups();
     static QStringList * getPackagesOfGroup(const QString &groupName);
@@ -142,10 +153,10 @@ class Package{
     static PackageInfoData getInformation(const QString &pkgName, bool foreignPackage = false);
     static double getDownloadSizeDescription(const QString &pkgName);
     static QString getInformationDescription(const QString &pkgName, bool foreignPackage = false);
+    static QString getLocalDescription(const QString &pkgName, const QString &pkgVersion);
     static QHash<QString, QString> getYaourtOutdatedPackagesNameVersion();
     static QStringList getContents(const QString &pkgName, bool isInstalled);
 
-    static QStringList getOptionalDeps(const QString &pkgName);
 
     static QString getName(const QString &pkgInfo);
     static QString getVersion(const QString &pkgInfo);
@@ -23,14 +23,13 @@
 #include "package.h"
 #include "unixcommand.h"
 #include "strconstants.h"
+#include "newsfeed.h"
 
 #include <QDirIterator>
 #include <QStandardItemModel>
 #include <QStandardItem>
 #include <QCoreApplication>
 #include <QTextStream>
-#include <QCryptographicHash>
-#include <QDomDocument>
 
 /*
  * This is a controller class that provides search services, using Package methods.
@@ -109,84 +108,39 @@ QString PackageController::retrieveDistroNews(bool searchForLatestNews)
 
   LinuxDistro distro = UnixCommand::getLinuxDistro();
   QString res;
-  QString tmpRssPath = QDir::homePath() + QDir::separator() + ".config/octopi/.tmp_distro_rss.xml";
   QString rssPath = QDir::homePath() + QDir::separator() + ".config/octopi/distro_rss.xml";
-  QString contentsRss;
+  QString rssUrl;
 
-  QFile fileRss(rssPath);
-  if (fileRss.exists())
+  if (distro == ectn_ARCHLINUX || distro == ectn_ARCHBANGLINUX)
+  {
+    rssUrl = ctn_ARCH_LINUX_RSS;
+  }
+  else if (distro == ectn_CHAKRA)
   {
-    if (!fileRss.open(QIODevice::ReadOnly | QIODevice::Text)) res = "";
-    QTextStream in2(&fileRss);
-    contentsRss = in2.readAll();
-    fileRss.close();
+    rssUrl = ctn_CHAKRA_RSS;
   }
+  else if (distro == ectn_KAOS)
+  {
+    rssUrl = ctn_KAOS_RSS;
+  }
+  else if (distro == ectn_MANJAROLINUX)
+  {
+    rssUrl = ctn_MANJARO_LINUX_RSS;
+  }
+
+  NewsFeed feed(rssPath, QUrl(rssUrl));
 
   if(searchForLatestNews && UnixCommand::hasInternetConnection() && distro != ectn_UNKNOWN)
   {
-    QString curlCommand = "curl %1 -o %2";
+    bool hadRss = QFile::exists(rssPath);
 
-    if (distro == ectn_ARCHLINUX || distro == ectn_ARCHBANGLINUX)
-    {
-      curlCommand = curlCommand.arg(ctn_ARCH_LINUX_RSS).arg(tmpRssPath);
-    }
-    else if (distro == ectn_CHAKRA)
-    {
-      curlCommand = curlCommand.arg(ctn_CHAKRA_RSS).arg(tmpRssPath);
-    }
-    else if (distro == ectn_KAOS)
-    {
-      curlCommand = curlCommand.arg(ctn_KAOS_RSS).arg(tmpRssPath);
-    }
-    else if (distro == ectn_MANJAROLINUX)
-    {
-      curlCommand = curlCommand.arg(ctn_MANJARO_LINUX_RSS).arg(tmpRssPath);
-    }
+    //Only downloads the feed if it changed since the last time
+    NewsFeed::EFetchResult result = feed.fetch();
+    res = feed.readFeed();
 
-    if (UnixCommand::runCurlCommand(curlCommand).isEmpty())
+    if (result == NewsFeed::ectn_FEED_UPDATED && hadRss)
     {
-      QFile fileTmpRss(tmpRssPath);
-      QFile fileRss(rssPath);
-
-      if (!fileRss.exists())
-      {
-        fileTmpRss.rename(tmpRssPath, rssPath);
-
-        if (!fileRss.open(QIODevice::ReadOnly | QIODevice::Text)) res = "";
-        QTextStream in2(&fileRss);
-        contentsRss = in2.readAll();
-        fileRss.close();
-
-        res = contentsRss;
-      }
-      else
-      {
-        //A rss file already exists. We have to make a SHA1 hash to compare the contents
-        QString tmpRssSHA1;
-        QString rssSHA1;
-        QString contentsTmpRss;
-
-        QFile fileTmpRss(tmpRssPath);
-        if (!fileTmpRss.open(QIODevice::ReadOnly | QIODevice::Text)) res = "";
-        QTextStream in(&fileTmpRss);
-        contentsTmpRss = in.readAll();
-        fileTmpRss.close();
-
-        tmpRssSHA1 = QCryptographicHash::hash(contentsTmpRss.toLatin1(), QCryptographicHash::Sha1);
-        rssSHA1 = QCryptographicHash::hash(contentsRss.toLatin1(), QCryptographicHash::Sha1);
-
-        if (tmpRssSHA1 != rssSHA1){
-          fileRss.remove();
-          fileTmpRss.rename(tmpRssPath, rssPath);
-
-          res = "*" + contentsTmpRss; //The asterisk indicates there is a MORE updated rss!
-        }
-        else
-        {
-          fileTmpRss.remove();
-          res = contentsRss;
-        }
-      }
+      res = "*" + res; //The asterisk indicates there is a MORE updated rss!
     }
   }
 
@@ -198,7 +152,7 @@ QString PackageController::retrieveDistroNews(bool searchForLatestNews)
     //Maybe we have a file in "./.config/octopi/distro_rss.xml"
     if (fileRss.exists())
     {
-      res = contentsRss;
+      res = feed.readFeed();
     }
     else if (searchForLatestNews)
     {
@@ -220,6 +174,7 @@ QString PackageController::retrieveDistroNews(bool searchForLatestNews)
 /*
  * Parses the raw XML contents from the Distro RSS news feed
  * Creates and returns a string containing a HTML code with latest 10 news
+ * (read back from the cache while the feed's lastBuildDate doesn't change)
  */
 QString PackageController::parseDistroNews()
 {
@@ -243,89 +198,6 @@ QString PackageController::parseDistroNews()
     html = "<p align=\"center\"><h2>" + StrConstants::getManjaroLinuxNews() + "</h2></p><ul>";
   }
 
-  QString lastBuildDate;
   QString rssPath = QDir::homePath() + QDir::separator() + ".config/octopi/distro_rss.xml";
-  QDomDocument doc("rss");
-  int itemCounter=0;
-
-  QFile file(rssPath);
-  if (!file.open(QIODevice::ReadOnly)) return "";
-  if (!doc.setContent(&file)) {
-      file.close();
-      return "";
-  }
-  file.close();
-
-  QDomElement docElem = doc.documentElement(); //This is rss
-  QDomNode n = docElem.firstChild(); //This is channel
-  n = n.firstChild();
-
-  while(!n.isNull()) {
-    QDomElement e = n.toElement();
-
-    if(!e.isNull())
-    {
-      if (e.tagName() == "lastBuildDate")
-      {
-        lastBuildDate = e.text();
-      }
-      else if(e.tagName() == "item")
-      {
-        //Let's iterate over the 10 lastest "item" news
-        if (itemCounter == 10) break;
-
-        QDomNode text = e.firstChild();
-
-        QString itemTitle;
-        QString itemLink;
-        QString itemDescription;
-        QString itemPubDate;
-
-        while(!text.isNull())
-        {
-          QDomElement eText = text.toElement();
-
-          if(!eText.isNull())
-          {
-            if (eText.tagName() == "title")
-            {
-              itemTitle = "<h3>" + eText.text() + "</h3>";
-            }
-            else if (eText.tagName() == "link")
-            {
-              itemLink = Package::makeURLClickable(eText.text());
-              if (UnixCommand::getLinuxDistro() == ectn_MANJAROLINUX) itemLink += "<br>";
-            }
-            else if (eText.tagName() == "description")
-            {
-              itemDescription = eText.text();
-              //itemDescription = itemDescription.remove(QRegExp("\\n"));
-              itemDescription += "<br>";
-            }
-            else if (eText.tagName() == "pubDate")
-            {
-              itemPubDate = eText.text();
-              itemPubDate = itemPubDate.remove(QRegExp("\\n"));
-              int pos = itemPubDate.indexOf("+");
-
-              if (pos > -1)
-              {
-                itemPubDate = itemPubDate.mid(0, pos-1).trimmed() + "<br>";
-              }
-            }
-          }
-
-          text = text.nextSibling();
-        }
-
-        html += "<li><p>" + itemTitle + " " + itemPubDate + "<br>" + itemLink + itemDescription + "</p></li>";
-        itemCounter++;
-      }
-    }
-
-    n = n.nextSibling();
-  }
-
-  html += "</ul>";
-  return html;
+  return NewsFeed(rssPath).getHtml(html);
 }
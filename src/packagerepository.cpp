@@ -22,17 +22,27 @@
 
 #include <cassert>
 #include <iostream>
+#include <new>
 
 #include <QSet>
+#include <QMutex>
+#include <QMutexLocker>
 
 #include "strconstants.h"
 #include "package.h"
+#include "dependencygraph.h"
+#include "versionkey.h"
 
 
 PackageRepository::PackageRepository()
 {
 }
 
+// defined here, where DependencyGraph is a complete type
+PackageRepository::~PackageRepository()
+{
+}
+
 void PackageRepository::registerDependency(PackageRepository::IDependency &depends)
 {
   m_dependingModels.push_back(&depends);
@@ -47,7 +57,7 @@ struct BeginResetModel {
 
 struct TSort {
   bool operator()(const PackageRepository::PackageData* a, const PackageRepository::PackageData* b) const {
-    return a->name < b->name;
+    return a->compareName(*b) < 0;
   }
 };
 
@@ -69,17 +79,17 @@ void PackageRepository::setData(const QList<PackageListData>*const listOfPackage
   for (QList<Group*>::const_iterator it = m_listOfGroups.begin(); it != m_listOfGroups.end(); ++it) {
     if (*it != NULL) (*it)->invalidateList();
   }
-  // delete items in list
-  for (TListOfPackages::const_iterator it = m_listOfPackages.begin(); it != m_listOfPackages.end(); ++it) {
-    if (*it != NULL) delete *it;
-  }
-  m_listOfYaourtPackages.clear();
-  m_listOfPackages.clear();
+  m_dependencyGraph.reset(); // describes the old package list
+  m_installedProvisions.clear();
+  deletePackages();
 
+  m_pacmanPackages.reset(listOfPackages->size());
+  m_listOfPackages.reserve(listOfPackages->size());
   for (QList<PackageListData>::const_iterator it = listOfPackages->begin(); it != listOfPackages->end(); ++it) {
-    m_listOfPackages.push_back(new PackageData(*it, unrequiredPackages.contains(it->name) == false, false,
-                                               explicitlyInstalledPackages.contains(it->name) == true));
+    m_listOfPackages.push_back(m_pacmanPackages.append(*it, unrequiredPackages.contains(it->name) == false, false,
+                                                       explicitlyInstalledPackages.contains(it->name) == true));
   }
+  m_pacmanPackages.squeeze();
 
   qSort(m_listOfPackages.begin(), m_listOfPackages.end(), TSort());
   std::for_each(m_dependingModels.begin(), m_dependingModels.end(), EndResetModel());
@@ -93,101 +103,138 @@ void PackageRepository::setAURData(const QList<PackageListData>*const listOfFore
     std::for_each(m_dependingModels.begin(), m_dependingModels.end(), BeginResetModel());
 
     // delete yaourt items in list
-    for (TListOfPackages::iterator it = m_listOfPackages.begin(); it != m_listOfPackages.end(); ++it) {
-      if (*it != NULL && (*it)->managedByYaourt) {
-        delete *it;
-        it = m_listOfPackages.erase(it);
-      }
+    for (TListOfPackages::iterator it = m_listOfPackages.begin(); it != m_listOfPackages.end();) {
+      if (*it != NULL && (*it)->isManagedByYaourt()) it = m_listOfPackages.erase(it);
+      else ++it;
     }
     m_listOfYaourtPackages.clear();
+    m_yaourtPackages.reset(listOfForeignPackages->size());
 
     for (QList<PackageListData>::const_iterator it = listOfForeignPackages->begin();
          it != listOfForeignPackages->end(); ++it)
     {
       //TODO: check if explicitly installed really is always true for yaourt
-      PackageData*const pkg = new PackageData(*it, unrequiredPackages.contains(it->name) == false, true, true);
+      PackageData*const pkg = m_yaourtPackages.append(*it, unrequiredPackages.contains(it->name) == false, true, true);
       m_listOfPackages.push_back(pkg);
       m_listOfYaourtPackages.push_back(pkg);
     }
+    m_yaourtPackages.squeeze();
 
     qSort(m_listOfPackages.begin(), m_listOfPackages.end(), TSort());
     qSort(m_listOfYaourtPackages.begin(), m_listOfYaourtPackages.end(), TSort());
     std::for_each(m_dependingModels.begin(), m_dependingModels.end(), EndResetModel());
 }
 
-void PackageRepository::setPackageDependencies(const QList<std::pair<PackageData*, QStringList> >& dependencies)
+/**
+ * @brief takes ownership of %graph and sets dependsOn/requiredBy of all pacman packages from it
+ *
+ * Graph nodes are matched to packages by name (preferring the package of the node's repository).
+ * Packages which are not part of the graph (yaourt search results) get no dependency lists.
+ */
+void PackageRepository::setDependencyGraph(DependencyGraph* graph)
 {
-//  std::cout << "set package dependencies" << std::endl;
+  if (graph == m_dependencyGraph.get()) return;
 
-  typedef const QList<std::pair<PackageData*, QStringList> > TDepList;
-
-  //TODO: full reset model isnt really necessary here since dependencies never change
   std::for_each(m_dependingModels.begin(), m_dependingModels.end(), BeginResetModel());
+  m_dependencyGraph.reset(graph);
+  m_listOfOrphanPackages.clear();
+  m_listOfUnusedOrphanPackages.clear();
+  m_installedProvisions.clear();
+
+  if (graph != NULL) {
+    setInstalledProvisions(*graph);
+
+    std::vector<PackageData*> nodeToPackage(graph->getNodeCount(), NULL);
+    std::vector<int>          packageToNode(m_listOfPackages.size(), -1);
+    for (int x = 0; x < m_listOfPackages.size(); ++x) {
+      PackageData*const pkg = m_listOfPackages.at(x);
+      if (pkg == NULL || pkg->isManagedByYaourt()) continue;
+
+      const int node = graph->findNode(pkg->getName());
+      if (node == -1) continue;
+      packageToNode[x] = node;
+      if (nodeToPackage[node] == NULL || pkg->getRepository() == graph->getRepository(node)) nodeToPackage[node] = pkg;
+    }
+
+    for (int x = 0; x < m_listOfPackages.size(); ++x) {
+      const int node = packageToNode[x];
+      if (node == -1) continue;
 
-  for (TDepList::const_iterator it = dependencies.begin();
-       it != dependencies.end(); ++it)
-  {
-    PackageData* pkg = const_cast<PackageData*>(it->first);
-    PackageData::TDependencyVec* depVec = new PackageData::TDependencyVec();
-    for (int x = 0; x < it->second.size(); ++x) {
-      PackageData* depPkg = getFirstPackageByName(it->second.at(x));
-      //FIXME: doesnt work sometimes because there are packages with same name in different (official) repos
-      //       also there are dependencies like packageAbc>=5.0.1
-      if (depPkg != NULL) depVec->push_back(depPkg);
+      PackageData::TDependencyVec* depVec = new PackageData::TDependencyVec();
+      const DependencyGraph::TNodeRange deps = graph->dependsOn(node);
+      for (DependencyGraph::TNodeIterator it = deps.first; it != deps.second; ++it) {
+        if (nodeToPackage[*it] != NULL) depVec->push_back(nodeToPackage[*it]);
+      }
+      PackageData::TDependencyVec* reqVec = new PackageData::TDependencyVec();
+      const DependencyGraph::TNodeRange reqs = graph->requiredBy(node);
+      for (DependencyGraph::TNodeIterator it = reqs.first; it != reqs.second; ++it) {
+        if (nodeToPackage[*it] != NULL) reqVec->push_back(nodeToPackage[*it]);
+      }
+
+      PackageData& pkg = *m_listOfPackages.at(x);
+      PackageGuard::setDependencies(pkg, depVec);
+      PackageGuard::setRequirements(pkg, reqVec);
     }
-    PackageGuard::setDependencies(*pkg, depVec);
+
+    setOrphans(m_listOfOrphanPackages, graph->findOrphans(false), nodeToPackage);
+    setOrphans(m_listOfUnusedOrphanPackages, graph->findOrphans(true), nodeToPackage);
   }
 
   std::for_each(m_dependingModels.begin(), m_dependingModels.end(), EndResetModel());
 }
 
 /**
- * @brief calculate and set required packages for all pacman packages (inverse dependencies)
- * @param forceSuccessful is a hack to help prototyping and will be removed later on
- * @return false if not successful
+ * @brief indexes every installed package under its own name and under everything it provides
  *
- * All dependencies must be set before calling this method (setPackageDependencies)
+ * The own names go in first, so a package with the literal name wins over its providers.
  */
-bool PackageRepository::setPackageRequirements(bool forceSuccessful)
+void PackageRepository::setInstalledProvisions(const DependencyGraph& graph)
 {
-//  std::cout << "set package requirements" << std::endl;
+  const int nodeCount = graph.getNodeCount();
+  for (int node = 0; node < nodeCount; ++node) {
+    if (!graph.isInstalled(node)) continue;
+
+    TProvision self;
+    self.provider = graph.getName(node);
+    self.version  = graph.getVersion(node);
+    m_installedProvisions[self.provider].append(self);
+  }
 
-  //TODO: full reset model isnt really necessary here since dependencies will never change
-  std::for_each(m_dependingModels.begin(), m_dependingModels.end(), BeginResetModel());
+  for (int node = 0; node < nodeCount; ++node) {
+    if (!graph.isInstalled(node)) continue;
 
-  // first we check that all pacman packages have dependencies fetched
-  for (TListOfPackages::const_iterator it = m_listOfPackages.begin(); it != m_listOfPackages.end(); ++it) {
-    if (*it != NULL && (*it)->managedByYaourt == false) {
-      if ((*it)->getDependsOn() == NULL) {
-        std::cerr << "Octopi package " << (*it)->name.toStdString() << " is missing dependency information" << std::endl;
-        if (!forceSuccessful) return false;
-        //FIXME: sometimes this might fail because the dependency list wasnt processed correctly
-        //       forceSuccessful should be removed when this is fixed
-      }
+    const QStringList provides = graph.getProvides(node);
+    for (QStringList::const_iterator it = provides.begin(); it != provides.end(); ++it) {
+      const DependencyGraph::Constraint provision = DependencyGraph::parseConstraint(*it);
+      TProvision entry;
+      entry.provider = graph.getName(node);
+      entry.version  = provision.op == DependencyGraph::ectn_EQUAL ? provision.version : QString();
+      m_installedProvisions[provision.name].append(entry);
     }
   }
+}
 
-  // now we reset all requirements lists
-  for (TListOfPackages::iterator it = m_listOfPackages.begin(); it != m_listOfPackages.end(); ++it) {
-    if (*it != NULL && (*it)->managedByYaourt == false) {
-      PackageGuard::resetRequirements(**it);
-    }
+/**
+ * @brief fills %list with the packages of the orphan %nodes, sorted by name
+ */
+void PackageRepository::setOrphans(TListOfPackages& list, const QList<int>& nodes,
+                                   const std::vector<PackageData*>& nodeToPackage)
+{
+  list.reserve(nodes.size());
+  for (QList<int>::const_iterator it = nodes.begin(); it != nodes.end(); ++it) {
+    if (nodeToPackage[*it] != NULL) list.push_back(nodeToPackage[*it]);
   }
+  qSort(list.begin(), list.end(), TSort());
+}
 
-  // now we set all requirements
-  for (TListOfPackages::iterator it = m_listOfPackages.begin(); it != m_listOfPackages.end(); ++it) {
-    if (*it != NULL && (*it)->managedByYaourt == false) {
-      const PackageData::TDependencyVec*const deps = (*it)->getDependsOn();
-      if (forceSuccessful && deps == NULL) continue; //FIXME: also an error in upstream processing
-      for (PackageData::TDependencyVec::const_iterator itDepPkg = deps->begin(); itDepPkg != deps->end(); ++itDepPkg) {
-        // now each package in the dependsOn list obviously requires package (*it)
-        PackageGuard::addRequirement(**itDepPkg, **it);
-      }
-    }
-  }
+bool PackageRepository::hasDependencyGraph() const
+{
+  return m_dependencyGraph.get() != NULL;
+}
 
-  std::for_each(m_dependingModels.begin(), m_dependingModels.end(), EndResetModel());
-  return true;
+const DependencyGraph* PackageRepository::getDependencyGraph() const
+{
+  return m_dependencyGraph.get();
 }
 
 /**
@@ -212,10 +259,10 @@ void PackageRepository::checkAndSetGroups(const QStringList& listOfGroups)
 
 struct TComp {
   bool operator()(const PackageRepository::PackageData* a, const QString& b) const {
-    return a->name < b;
+    return a->compareName(b) < 0;
   }
   bool operator()(const QString& b, const PackageRepository::PackageData* a) const {
-    return b < a->name;
+    return a->compareName(b) > 0;
   }
 };
 
@@ -245,7 +292,7 @@ void PackageRepository::checkAndSetMembersOfGroup(const QString& groupName, cons
         typedef TListOfPackages::const_iterator TIter;
         std::pair<TIter, TIter> packageIt =  std::equal_range(m_listOfPackages.begin(), m_listOfPackages.end(), *it, TComp());
         for (TIter iter = packageIt.first; iter != packageIt.second; ++iter) {
-          if ((*iter)->managedByYaourt == false) {
+          if ((*iter)->isManagedByYaourt() == false) {
             group.addPackage(**iter);
             break;
           }
@@ -286,6 +333,12 @@ const PackageRepository::TListOfPackages& PackageRepository::getPackageList(cons
     // Workaround for Yaourt filter -> pre-built yaourt packageList
     if (group == "<Yaourt>")
       return m_listOfYaourtPackages;
+
+    // virtual groups computed from the dependency graph
+    if (group == StrConstants::getOrphansGroup())
+      return m_listOfOrphanPackages;
+    if (group == StrConstants::getUnusedOrphansGroup())
+      return m_listOfUnusedOrphanPackages;
   }
 
   // if no group found or not loaded yet. default to all packages
@@ -295,12 +348,44 @@ const PackageRepository::TListOfPackages& PackageRepository::getPackageList(cons
 PackageRepository::PackageData* PackageRepository::getFirstPackageByName(const QString name) const
 {
   for (TListOfPackages::const_iterator it = m_listOfPackages.begin(); it != m_listOfPackages.end(); ++it) {
-    if ((*it)->name == name)
+    if ((*it)->compareName(name) == 0)
       return *it;
   }
   return NULL;
 }
 
+QString PackageRepository::getInstalledProvider(const QString& dependency) const
+{
+  const DependencyGraph::Constraint constraint = DependencyGraph::parseConstraint(dependency);
+  if (m_dependencyGraph.get() == NULL) {
+    const PackageData*const package = getFirstPackageByName(constraint.name);
+    return package != NULL && package->installed() ? package->getName() : QString();
+  }
+
+  const QHash<QString, QVector<TProvision> >::const_iterator it = m_installedProvisions.constFind(constraint.name);
+  if (it == m_installedProvisions.constEnd()) return QString();
+
+  for (QVector<TProvision>::const_iterator itProv = it->begin(); itProv != it->end(); ++itProv) {
+    if (constraint.op == DependencyGraph::ectn_ANY) return itProv->provider;
+    if (!itProv->version.isEmpty() && constraint.isSatisfiedBy(itProv->version)) return itProv->provider;
+  }
+  return QString();
+}
+
+/**
+ * @brief drops all packages; the handles live in the package tables, so there is nothing to delete
+ */
+void PackageRepository::deletePackages()
+{
+  m_listOfYaourtPackages.clear();
+  m_listOfOrphanPackages.clear();
+  m_listOfUnusedOrphanPackages.clear();
+  m_listOfPackages.clear();
+
+  m_pacmanPackages.reset(0);
+  m_yaourtPackages.reset(0);
+}
+
 /**
  * @brief checks if the repository groups are up to date
  * @param listOfGroups == group-names
@@ -320,25 +405,185 @@ bool PackageRepository::memberListOfGroupsEquals(const QStringList& listOfGroups
   return true;
 }
 
+//////// PackageRepository::PackageTable //////////////////////////////
+
+PackageRepository::PackageTable::PackageTable()
+  : m_handles(NULL), m_capacity(0)
+{
+  m_textOffsets.push_back(0);
+  m_versionKeyOffsets.push_back(0);
+}
+
+PackageRepository::PackageTable::~PackageTable()
+{
+  reset(0);
+}
+
+void PackageRepository::PackageTable::reset(int capacity)
+{
+  deleteDependencies();
+  for (int id = 0; id < size(); ++id) m_handles[id].~PackageData();
+  ::operator delete(m_handles);
+  m_handles  = NULL;
+  m_capacity = 0;
+
+  m_text.clear();
+  m_textOffsets.assign(1, 0);
+  m_versionKeys.clear();
+  m_versionKeyOffsets.assign(1, 0);
+  m_repositories.clear();
+  m_repositoryNames.clear();
+  m_downloadSizes.clear();
+  m_popularities.clear();
+  m_flags.clear();
+  m_dependsOn.clear();
+  m_requiredBy.clear();
+  m_loadedDescriptions.clear();
+
+  if (capacity == 0) return;
+
+  // every package needs its handle anyway, so they are allocated in one block with the columns
+  m_handles  = static_cast<PackageData*>(::operator new(capacity * sizeof(PackageData)));
+  m_capacity = capacity;
+  m_textOffsets.reserve(capacity * ectn_TEXT_COLUMNS + 1);
+  m_versionKeyOffsets.reserve(capacity + 1);
+  m_repositories.reserve(capacity);
+  m_downloadSizes.reserve(capacity);
+  m_popularities.reserve(capacity);
+  m_flags.reserve(capacity);
+  m_dependsOn.reserve(capacity);
+  m_requiredBy.reserve(capacity);
+}
+
+/**
+ * @brief adds %pkg to all columns and returns its handle
+ */
+PackageRepository::PackageData* PackageRepository::PackageTable::append(const PackageListData& pkg,
+                                                                        const bool isRequired,
+                                                                        const bool isManagedByYaourt,
+                                                                        const bool wasExplicitlyInstalled)
+{
+  assert(size() < m_capacity);
+  const TId id = static_cast<TId>(size());
+
+  // descriptions are already decoded from UTF-8 by Package, so they are stored as they are
+  const QString* texts[ectn_TEXT_COLUMNS] = { &pkg.name, &pkg.version, &pkg.outatedVersion, &pkg.description };
+  for (int column = 0; column < ectn_TEXT_COLUMNS; ++column) {
+    m_text.append(*texts[column]);
+    m_textOffsets.push_back(static_cast<quint32>(m_text.size()));
+  }
+
+  VersionKey::append(m_versionKeys, pkg.version);
+  m_versionKeyOffsets.push_back(static_cast<quint32>(m_versionKeys.size()));
+
+  const PackageStatus status = pkg.status != ectn_OUTDATED ?
+        pkg.status :
+        (Package::vercmp(pkg.outatedVersion, pkg.version) == 1 ? ectn_NEWER : ectn_OUTDATED);
+  quint8 flags = static_cast<quint8>(status);
+  if (isRequired) flags |= ectn_REQUIRED;
+  if (isManagedByYaourt) flags |= ectn_MANAGED_BY_YAOURT;
+  if (wasExplicitlyInstalled) flags |= ectn_EXPLICIT;
+  if (pkg.description.isEmpty() && pkg.status != ectn_NON_INSTALLED && !isManagedByYaourt) {
+    flags |= ectn_LAZY_DESCRIPTION;
+  }
+
+  m_repositories.push_back(internRepositoryName(pkg.repository));
+  m_downloadSizes.push_back(pkg.downloadSize);
+  m_popularities.push_back(isManagedByYaourt ? pkg.popularity : -1);
+  m_flags.push_back(flags);
+  m_dependsOn.push_back(NULL);
+  m_requiredBy.push_back(NULL);
+
+  return new (m_handles + id) PackageData(*this, id);
+}
+
+void PackageRepository::PackageTable::squeeze()
+{
+  m_text.squeeze();
+  m_versionKeys.squeeze();
+}
+
+/**
+ * @brief returns the id of %repository, an empty %repository defaults to the foreign repo name
+ */
+quint16 PackageRepository::PackageTable::internRepositoryName(const QString& repository)
+{
+  const QString& name = repository.isEmpty() ? StrConstants::getForeignRepositoryName() : repository;
+  int id = m_repositoryNames.indexOf(name);
+  if (id == -1) {
+    id = m_repositoryNames.size();
+    m_repositoryNames.append(name);
+  }
+  return static_cast<quint16>(id);
+}
+
+void PackageRepository::PackageTable::deleteDependencies()
+{
+  for (std::size_t id = 0; id < m_dependsOn.size(); ++id) {
+    delete m_dependsOn[id];
+    delete m_requiredBy[id];
+    m_dependsOn[id]  = NULL;
+    m_requiredBy[id] = NULL;
+  }
+}
+
 //////// PackageRepository::PackageData //////////////////////////////
 
+PackageRepository::PackageData::PackageData(PackageTable& table, const PackageTable::TId id)
+  : m_table(&table), m_id(id)
+{
+}
+
+QString PackageRepository::PackageData::getPopularityString() const
+{
+  if (isManagedByYaourt() == false) return QString();
+  return QString::number(getPopularity()) + StrConstants::getVotes();
+}
+
+int PackageRepository::PackageData::compareVersion(const PackageData& other) const
+{
+  const std::vector<quint32>& offsets      = m_table->m_versionKeyOffsets;
+  const std::vector<quint32>& otherOffsets = other.m_table->m_versionKeyOffsets;
+  return VersionKey::compare(m_table->m_versionKeys.constData() + offsets[m_id],
+                             offsets[m_id + 1] - offsets[m_id],
+                             other.m_table->m_versionKeys.constData() + otherOffsets[other.m_id],
+                             otherOffsets[other.m_id + 1] - otherOffsets[other.m_id]);
+}
+
+void PackageRepository::PackageData::setDependsOn(const TDependencyVec* packages)
+{
+  delete m_table->m_dependsOn[m_id];
+  m_table->m_dependsOn[m_id] = packages;
+}
+
+void PackageRepository::PackageData::setRequiredBy(const TDependencyVec* packages)
+{
+  delete m_table->m_requiredBy[m_id];
+  m_table->m_requiredBy[m_id] = packages;
+}
+
+// guards the lazy loading of descriptions, since tooltips are built in a worker thread
+static QMutex g_lazyDescriptionMutex;
+
 /**
- * @brief conversion from pkg will default the repository to the foreign repo name
+ * @brief returns the package description (prefixed with the package name)
+ *
+ * Installed packages which came without a description (e.g. foreign ones) read it
+ * from the local pacman database when it is needed for the first time.
  */
-PackageRepository::PackageData::PackageData(const PackageListData& pkg, const bool isRequired,
-                                            const bool isManagedByYaourt,const bool wasExplicitlyInstalled)
-  : required(isRequired), managedByYaourt(isManagedByYaourt),
-    explicitlyInstalled(wasExplicitlyInstalled), name(pkg.name),
-    repository(pkg.repository.isEmpty() ? StrConstants::getForeignRepositoryName() : pkg.repository),
-    version(pkg.version), description(pkg.description.toLatin1()), // octopi wants it converted to utf8
-    outdatedVersion(pkg.outatedVersion), downloadSize(pkg.downloadSize),
-    status(pkg.status != ectn_OUTDATED ?
-            pkg.status :
-            (Package::rpmvercmp(pkg.outatedVersion.toLatin1().data(), pkg.version.toLatin1().data()) == 1 ?
-              ectn_NEWER : ectn_OUTDATED)),
-    popularity(isManagedByYaourt ? pkg.popularity : -1),
-    popularityString(isManagedByYaourt ? QString::number(pkg.popularity) + StrConstants::getVotes() : QString())
+QString PackageRepository::PackageData::getDescription() const
 {
+  if ((m_table->m_flags[m_id] & PackageTable::ectn_LAZY_DESCRIPTION) == 0) {
+    return m_table->text(m_id, PackageTable::ectn_DESCRIPTION).toString();
+  }
+
+  QMutexLocker locker(&g_lazyDescriptionMutex);
+  QHash<PackageTable::TId, QString>::iterator it = m_table->m_loadedDescriptions.find(m_id);
+  if (it == m_table->m_loadedDescriptions.end()) {
+    const QString loaded = getName() + " " + Package::getLocalDescription(getName(), getVersion());
+    it = m_table->m_loadedDescriptions.insert(m_id, loaded);
+  }
+  return *it;
 }
 
 //////// PackageRepository::Group //////////////////////////////
@@ -360,7 +605,7 @@ bool PackageRepository::Group::memberListEquals(const QStringList& packagelist)
 
   QStringList::const_iterator it2 = packagelist.begin();
   for (TListOfPackages::const_iterator it = m_listOfPackages->begin(); it != m_listOfPackages->end(); ++it, ++it2) {
-    if ((*it)->name != *it2)
+    if ((*it)->compareName(*it2) != 0)
       return false;
   }
 
@@ -24,10 +24,18 @@
 #include <vector>
 #include <memory>
 #include <cassert>
+#include <QByteArray>
+#include <QHash>
 #include <QList>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <QVector>
 
 #include "package.h"
 
+class DependencyGraph;
+
 
 /**
  * @brief Central data storage for package data
@@ -54,7 +62,80 @@ public:
 
   ////////////////////////
   /**
-   * @brief Holds data of one package + a few convenience functions
+   * @brief Column store of one package list: one array per field, indexed by 32 bit package ids
+   *
+   * The texts of all packages (name, version, outdated version, description) lie back to back in
+   * a single UTF-16 pool, the version sort keys (see VersionKey) in a byte pool. Repositories are
+   * 16 bit ids into a list of names, status and flags share one byte per package. PackageData
+   * objects are small handles (table + id) into the table, so the model and the views keep
+   * working with PackageData pointers.
+   */
+  class PackageTable {
+  public:
+    friend class PackageRepository::PackageData;
+    typedef quint32 TId;
+
+  public:
+    PackageTable();
+    ~PackageTable();
+
+    /**
+     * @brief drops all packages and makes room for %capacity packages
+     *
+     * The handles of the new packages are never moved, so no more than %capacity may be appended.
+     */
+    void reset(int capacity);
+    PackageData* append(const PackageListData& package, const bool isRequired,
+                        const bool isManagedByYaourt, const bool wasExplicitlyInstalled);
+    // gives the unused capacity of the pools back, called after the last append
+    void squeeze();
+
+    inline int size() const {
+      return static_cast<int>(m_flags.size());
+    }
+
+  private:
+    enum ETextColumn { ectn_NAME, ectn_VERSION, ectn_OUTDATED_VERSION, ectn_DESCRIPTION, ectn_TEXT_COLUMNS };
+
+    enum EFlags {
+      ectn_STATUS_MASK       = 0x07,
+      ectn_REQUIRED          = 0x08,
+      ectn_MANAGED_BY_YAOURT = 0x10,
+      ectn_EXPLICIT          = 0x20,
+      ectn_LAZY_DESCRIPTION  = 0x40  // loaded from the local pacman db on first access
+    };
+
+    inline QStringRef text(const TId id, const ETextColumn column) const {
+      const std::size_t cell = id * ectn_TEXT_COLUMNS + column;
+      return QStringRef(&m_text, m_textOffsets[cell], m_textOffsets[cell + 1] - m_textOffsets[cell]);
+    }
+    quint16 internRepositoryName(const QString& repository);
+    void deleteDependencies();
+
+    // no copies, the handles point back to their table
+    PackageTable(const PackageTable&);
+    PackageTable& operator=(const PackageTable&);
+
+  private:
+    QString                           m_text;              // text pool
+    std::vector<quint32>              m_textOffsets;       // cell id * ectn_TEXT_COLUMNS + column spans [cell], [cell+1]
+    QByteArray                        m_versionKeys;       // version key pool
+    std::vector<quint32>              m_versionKeyOffsets; // key of id x is [m_versionKeyOffsets[x], m_versionKeyOffsets[x+1])
+    std::vector<quint16>              m_repositories;
+    QStringList                       m_repositoryNames;   // repository id -> name
+    std::vector<double>               m_downloadSizes;
+    std::vector<qint32>               m_popularities;      // -1 for non AUR
+    std::vector<quint8>               m_flags;
+    std::vector<const TListOfPackages*> m_dependsOn;       // set from the dependency graph, NULL until then
+    std::vector<const TListOfPackages*> m_requiredBy;
+    PackageData*                      m_handles;           // one block of %m_capacity handles
+    int                               m_capacity;
+    QHash<TId, QString>               m_loadedDescriptions; // descriptions loaded lazily
+  };
+
+  ////////////////////////
+  /**
+   * @brief Handle of one package in a PackageTable + a few convenience functions
    */
   class PackageData {
   public:
@@ -62,59 +143,77 @@ public:
     typedef TListOfPackages TDependencyVec;
 
   public:
-    /**
-     * @brief PackageData constructor
-     * @param package    = parsed data from pacman (e.g.)
-     * @param isRequired = false if package is not required by other packages installed, or true otherwise
-     */
-    PackageData(const PackageListData& package, const bool isRequired, const bool isManagedByYaourt,
-                const bool wasExplicitlyInstalled);
+    PackageData(PackageTable& table, const PackageTable::TId id);
+
+    inline QString getName() const {
+      return m_table->text(m_id, PackageTable::ectn_NAME).toString();
+    }
+    // shared by all packages of the same repository
+    inline const QString& getRepository() const {
+      return m_table->m_repositoryNames.at(m_table->m_repositories[m_id]);
+    }
+    inline QString getVersion() const {
+      return m_table->text(m_id, PackageTable::ectn_VERSION).toString();
+    }
+    inline QString getOutdatedVersion() const {
+      return m_table->text(m_id, PackageTable::ectn_OUTDATED_VERSION).toString();
+    }
+    QString getPopularityString() const;
+    inline double getDownloadSize() const {
+      return m_table->m_downloadSizes[m_id];
+    }
+    // -1 for non AUR
+    inline int getPopularity() const {
+      return m_table->m_popularities[m_id];
+    }
+    inline PackageStatus getStatus() const {
+      return static_cast<PackageStatus>(m_table->m_flags[m_id] & PackageTable::ectn_STATUS_MASK);
+    }
+    inline bool isRequired() const {
+      return (m_table->m_flags[m_id] & PackageTable::ectn_REQUIRED) != 0;
+    }
+    // yaourt packages must not be in any group
+    inline bool isManagedByYaourt() const {
+      return (m_table->m_flags[m_id] & PackageTable::ectn_MANAGED_BY_YAOURT) != 0;
+    }
+    inline bool isExplicitlyInstalled() const {
+      return (m_table->m_flags[m_id] & PackageTable::ectn_EXPLICIT) != 0;
+    }
 
     inline bool installed() const {
-      return status != ectn_NON_INSTALLED;
+      return getStatus() != ectn_NON_INSTALLED;
     }
     inline bool outdated() const {
-      return status == ectn_OUTDATED || status == ectn_NEWER;
+      return getStatus() == ectn_OUTDATED || getStatus() == ectn_NEWER;
     }
 
-    inline const TDependencyVec* getDependsOn() const {
-      return dependsOn.get();
+    // compare without copying the names out of the pool
+    inline int compareName(const PackageData& other) const {
+      return QStringRef::compare(m_table->text(m_id, PackageTable::ectn_NAME),
+                                 other.m_table->text(other.m_id, PackageTable::ectn_NAME));
     }
-
-    inline const TDependencyVec* getRequiredBy() const {
-      return requiredBy.get();
+    inline int compareName(const QString& name) const {
+      return m_table->text(m_id, PackageTable::ectn_NAME).compare(name);
     }
+    // like Package::rpmvercmp
+    int compareVersion(const PackageData& other) const;
 
-  private:
-    inline void setDependsOn(const TDependencyVec* packages) {
-//      std::cout << "set dependencies for " << name.toStdString() << " to " << dependencies << std::endl;
-      this->dependsOn.reset(packages);
-    }
-    inline void resetRequiredBy() {
-      this->requiredBy.reset(new TDependencyVec());
+    inline const TDependencyVec* getDependsOn() const {
+      return m_table->m_dependsOn[m_id];
     }
-    inline void addRequiredBy(PackageData& pkg) {
-      assert(this->requiredBy.get() != NULL);
-      this->requiredBy->push_back(&pkg);
+    inline const TDependencyVec* getRequiredBy() const {
+      return m_table->m_requiredBy[m_id];
     }
 
-  public:
-    const bool    required;
-    const bool    managedByYaourt; // yaourt packages must not be in any group
-    const bool    explicitlyInstalled;
-    const QString name;
-    const QString repository;
-    const QString version;
-    const QString description;
-    const QString outdatedVersion;
-    const double  downloadSize;
-    const PackageStatus status;
-    const int     popularity; // -1 for non AUR
-    const QString popularityString;
+    QString getDescription() const;
 
   private:
-    std::auto_ptr<const TDependencyVec> dependsOn;
-    std::auto_ptr<TDependencyVec>       requiredBy;
+    void setDependsOn(const TDependencyVec* packages);
+    void setRequiredBy(const TDependencyVec* packages);
+
+  private:
+    PackageTable*           m_table;
+    const PackageTable::TId m_id;
   };
 
   ////////////////////////
@@ -125,8 +224,7 @@ public:
     friend class PackageRepository;
 
     inline static void setDependencies(PackageData& pkg, const PackageData::TDependencyVec*const dependencies);
-    inline static void resetRequirements(PackageData& pkg);
-    inline static void addRequirement(PackageData& pkg, PackageData& dependsOnPkg);
+    inline static void setRequirements(PackageData& pkg, const PackageData::TDependencyVec*const requirements);
   };
 
   ////////////////////////
@@ -152,13 +250,15 @@ public:
 
 public:
   PackageRepository();
+  ~PackageRepository();
 
   void registerDependency(IDependency& depends);
   void setData(const QList<PackageListData>*const listOfPackages, const QSet<QString>& unrequiredPackages,
                const QSet<QString>& explicitlyInstalledPackages);
   void setAURData(const QList<PackageListData>*const listOfForeignPackages, const QSet<QString>& unrequiredPackages);
-  void setPackageDependencies(const QList<std::pair<PackageData*, QStringList> >& dependencies);
-  bool setPackageRequirements(bool forceSuccessful);
+  void setDependencyGraph(DependencyGraph* graph);
+  bool hasDependencyGraph() const;
+  const DependencyGraph* getDependencyGraph() const;
   void checkAndSetGroups(const QStringList& listOfGroups);
   void checkAndSetMembersOfGroup(const QString& group, const QStringList& members);
 
@@ -166,23 +266,46 @@ public:
   const TListOfPackages& getPackageList(const QString& group) const;
   PackageData*           getFirstPackageByName(const QString name) const;
 
+  /**
+   * @brief returns the installed package called %dependency or providing it, empty if there is none
+   *
+   * %dependency may be versioned ("java-runtime>=8"), which only versioned provides satisfy.
+   * Until the dependency graph is set only packages with the literal name are found.
+   */
+  QString getInstalledProvider(const QString& dependency) const;
+  inline bool isSatisfiedByInstalled(const QString& dependency) const {
+    return getInstalledProvider(dependency).isEmpty() == false;
+  }
+
+private:
+  struct TProvision {
+    QString provider;
+    QString version; // empty for unversioned provides
+  };
+
 private:
   std::vector<IDependency*> m_dependingModels;
   TListOfPackages           m_listOfPackages;       // sorted qlist of all packages
   TListOfPackages           m_listOfYaourtPackages; // sorted qlist of all yaourt packages
+  TListOfPackages           m_listOfOrphanPackages; // sorted qlist of installed packages no explicit one depends on
+  TListOfPackages           m_listOfUnusedOrphanPackages; // orphans which are not even an optional dependency
   QList<Group*>             m_listOfGroups;         // sorted list of all pacman package groups
+  PackageTable              m_pacmanPackages;       // storage of all pacman (non yaourt) packages
+  PackageTable              m_yaourtPackages;       // storage of the yaourt search results
+  std::auto_ptr<DependencyGraph> m_dependencyGraph; // built in the background, belongs to the current package list
+  QHash<QString, QVector<TProvision> > m_installedProvisions; // package or virtual name -> installed providers
   bool memberListOfGroupsEquals(const QStringList& listOfGroups);
+  void setInstalledProvisions(const DependencyGraph& graph);
+  void setOrphans(TListOfPackages& list, const QList<int>& nodes, const std::vector<PackageData*>& nodeToPackage);
+  void deletePackages();
 };
 
 
 void PackageRepository::PackageGuard::setDependencies(PackageData& pkg, const PackageData::TDependencyVec*const dependencies) {
   pkg.setDependsOn(dependencies);
 }
-void PackageRepository::PackageGuard::resetRequirements(PackageData& pkg) {
-  pkg.resetRequiredBy();
-}
-void PackageRepository::PackageGuard::addRequirement(PackageData& pkg, PackageData& dependsOnPkg) {
-  pkg.addRequiredBy(dependsOnPkg);
+void PackageRepository::PackageGuard::setRequirements(PackageData& pkg, const PackageData::TDependencyVec*const requirements) {
+  pkg.setRequiredBy(requirements);
 }
 
 #endif // OCTOPI_PACKAGEREPOSITORY_H
@@ -0,0 +1,233 @@
+/*
+* This file is part of Octopi, an open-source GUI for pacman.
+* Copyright (C) 2014 Thomas Binkau
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*
+*/
+
+#include "packagesnapshot.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <memory>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+
+#include "pacmandatabasewatcher.h"
+#include "QtSolutions/qtlocalpeer.h"
+
+
+namespace {
+
+const quint32 ctn_MAGIC = 0x4f435053; // "OCPS"
+
+/**
+ * @brief creates %path with mode 0700, false if it exists but isn't a directory of ours nobody else can enter
+ *
+ * Below /tmp anybody may have created the directory (or a symlink to another one) before us.
+ */
+bool makePrivateDirectory(const QString& path)
+{
+  const QByteArray name = QFile::encodeName(path);
+  if (mkdir(name.constData(), 0700) != 0 && errno != EEXIST) return false;
+
+  struct stat info;
+  return lstat(name.constData(), &info) == 0 && S_ISDIR(info.st_mode) &&
+         info.st_uid == getuid() && (info.st_mode & 0077) == 0;
+}
+
+void writePackages(QDataStream& out, const QList<PackageListData>& packages)
+{
+  out << qint32(packages.size());
+  for (QList<PackageListData>::const_iterator it = packages.begin(); it != packages.end(); ++it) {
+    out << it->name << it->repository << it->version << it->description << it->outatedVersion
+        << qint32(it->status);
+  }
+}
+
+void readPackages(QDataStream& in, QList<PackageListData>& packages)
+{
+  qint32 count;
+  in >> count;
+  if (in.status() != QDataStream::Ok || count < 0) return;
+
+  packages.reserve(count);
+  for (qint32 x = 0; x < count && in.status() == QDataStream::Ok; ++x) {
+    PackageListData pld;
+    qint32 status;
+    in >> pld.name >> pld.repository >> pld.version >> pld.description >> pld.outatedVersion >> status;
+    pld.status = static_cast<PackageStatus>(status);
+    packages.append(pld);
+  }
+}
+
+/**
+ * @brief reads magic, format version and database stamp, false if the file is of another format
+ */
+bool readHeader(QDataStream& in, QByteArray& databaseStamp)
+{
+  quint32 magic;
+  quint32 version;
+  in >> magic >> version;
+  if (in.status() != QDataStream::Ok || magic != ctn_MAGIC || version != PackageSnapshot::ctn_FORMAT_VERSION) {
+    return false;
+  }
+
+  in.setVersion(QDataStream::Qt_4_6);
+  in >> databaseStamp;
+  return in.status() == QDataStream::Ok;
+}
+
+} // namespace
+
+
+PackageSnapshot::PackageSnapshot()
+{
+}
+
+PackageSnapshot* PackageSnapshot::create()
+{
+  if (PacmanDatabaseWatcher::isLocked()) return NULL;
+
+  // the stamp is taken first: if pacman changes something meanwhile, the snapshot is already outdated
+  const QByteArray databaseStamp = PacmanDatabaseWatcher::getDatabaseStamp();
+  const std::auto_ptr<const QList<PackageListData> > packages(Package::getPackageList());
+  const std::auto_ptr<const QList<PackageListData> > foreignPackages(Package::getForeignPackageList());
+  const std::auto_ptr<const QSet<QString> > unrequiredPackages(Package::getUnrequiredPackageList());
+  const std::auto_ptr<const QSet<QString> > explicitPackages(Package::getExplicitPackageList());
+
+  PackageSnapshot* result = new PackageSnapshot();
+  result->setData(databaseStamp, *packages, *foreignPackages, *unrequiredPackages, *explicitPackages);
+  return result;
+}
+
+void PackageSnapshot::setData(const QByteArray& databaseStamp, const QList<PackageListData>& packages,
+                              const QList<PackageListData>& foreignPackages,
+                              const QSet<QString>& unrequiredPackages, const QSet<QString>& explicitPackages)
+{
+  m_databaseStamp      = databaseStamp;
+  m_packages           = packages;
+  m_foreignPackages    = foreignPackages;
+  m_unrequiredPackages = unrequiredPackages;
+  m_explicitPackages   = explicitPackages;
+}
+
+bool PackageSnapshot::isCurrent() const
+{
+  return !m_databaseStamp.isEmpty() && m_databaseStamp == PacmanDatabaseWatcher::getDatabaseStamp();
+}
+
+/**
+ * The file is mapped and parsed straight from the mapping, so it is read in one go without
+ * an intermediate copy.
+ */
+bool PackageSnapshot::read()
+{
+  QFile file(getFileName());
+  if (!file.open(QIODevice::ReadOnly) || file.size() == 0) return false;
+
+  uchar*const data = file.map(0, file.size());
+  if (data == NULL) return false;
+
+  const QByteArray mapped = QByteArray::fromRawData(reinterpret_cast<const char*>(data), static_cast<int>(file.size()));
+  QDataStream in(mapped);
+
+  PackageSnapshot snapshot;
+  bool ok = readHeader(in, snapshot.m_databaseStamp) && snapshot.isCurrent();
+  if (ok) {
+    readPackages(in, snapshot.m_packages);
+    readPackages(in, snapshot.m_foreignPackages);
+    in >> snapshot.m_unrequiredPackages >> snapshot.m_explicitPackages;
+    ok = in.status() == QDataStream::Ok;
+  }
+  file.unmap(data);
+
+  if (ok) *this = snapshot;
+  return ok;
+}
+
+/**
+ * Writes a temporary file next to the snapshot and renames it over the old one, so a reader
+ * never sees a half written snapshot.
+ */
+bool PackageSnapshot::write() const
+{
+  const QString fileName = getFileName();
+  if (fileName.isEmpty() || !makePrivateDirectory(QFileInfo(fileName).absolutePath())) return false;
+
+  // a leftover of a crashed writer is removed, a file put there by someone else is never written through
+  const QString tempFileName = fileName + ".tmp";
+  const QByteArray encodedTempFileName = QFile::encodeName(tempFileName);
+  int fd = ::open(encodedTempFileName.constData(), O_WRONLY | O_CREAT | O_EXCL | O_NOFOLLOW, 0600);
+  if (fd == -1 && errno == EEXIST && ::unlink(encodedTempFileName.constData()) == 0) {
+    fd = ::open(encodedTempFileName.constData(), O_WRONLY | O_CREAT | O_EXCL | O_NOFOLLOW, 0600);
+  }
+  if (fd == -1) return false;
+
+  QFile file;
+  if (!file.open(fd, QIODevice::WriteOnly, QFile::AutoCloseHandle)) {
+    ::close(fd);
+    QFile::remove(tempFileName);
+    return false;
+  }
+
+  QDataStream out(&file);
+  out << ctn_MAGIC << ctn_FORMAT_VERSION;
+  out.setVersion(QDataStream::Qt_4_6);
+  out << m_databaseStamp;
+  writePackages(out, m_packages);
+  writePackages(out, m_foreignPackages);
+  out << m_unrequiredPackages << m_explicitPackages;
+  file.close();
+
+  if (out.status() != QDataStream::Ok || file.error() != QFile::NoError ||
+      std::rename(QFile::encodeName(tempFileName).constData(), QFile::encodeName(fileName).constData()) != 0) {
+    QFile::remove(tempFileName);
+    return false;
+  }
+  return true;
+}
+
+bool PackageSnapshot::isFileCurrent()
+{
+  QFile file(getFileName());
+  if (!file.open(QIODevice::ReadOnly)) return false;
+
+  QDataStream in(&file);
+  QByteArray databaseStamp;
+  return readHeader(in, databaseStamp) && databaseStamp == PacmanDatabaseWatcher::getDatabaseStamp();
+}
+
+QString PackageSnapshot::getFileName()
+{
+  QString directory = QString::fromLocal8Bit(qgetenv("XDG_RUNTIME_DIR"));
+  if (directory.isEmpty()) {
+    directory = QDir::tempPath() + "/octopi-" + QString::number(getuid());
+    if (!makePrivateDirectory(directory)) return QString();
+  }
+  return directory + "/octopi/packages.snapshot";
+}
+
+void PackageSnapshot::notify(const QString& peerId)
+{
+  QtLocalPeer peer(0, peerId);
+  peer.sendMessage("SNAPSHOT", 1000);
+}
@@ -0,0 +1,107 @@
+/*
+* This file is part of Octopi, an open-source GUI for pacman.
+* Copyright (C) 2014 Thomas Binkau
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*
+*/
+
+#ifndef OCTOPI_PACKAGESNAPSHOT_H
+#define OCTOPI_PACKAGESNAPSHOT_H
+
+#include <QByteArray>
+#include <QList>
+#include <QSet>
+#include <QString>
+
+#include "package.h"
+
+// QtLocalPeer id octopi-notifier listens on (Octopi's is its QtSingleApplication id)
+const QString ctn_NOTIFIER_PEER_ID = "octopi-notifier";
+
+
+/**
+ * @brief The package lists Octopi builds its package view from, shared through a file
+ *
+ * Whichever of octopi and octopi-notifier queries pacman first writes them to
+ * "$XDG_RUNTIME_DIR/octopi/packages.snapshot", the other one maps the file instead of querying
+ * pacman again. Without XDG_RUNTIME_DIR it goes below "/tmp/octopi-<uid>", which must be a 0700
+ * directory of the user. The file starts with a format version and the database stamp of
+ * PacmanDatabaseWatcher taken before the queries, so a snapshot is only used while pacman's
+ * databases are unchanged. It is replaced atomically; readers are told by a "SNAPSHOT"
+ * QtLocalPeer message.
+ */
+class PackageSnapshot
+{
+public:
+  static const quint32 ctn_FORMAT_VERSION = 1;
+
+public:
+  PackageSnapshot();
+
+  /**
+   * @brief queries pacman for a fresh snapshot, NULL while pacman holds its lock
+   */
+  static PackageSnapshot* create();
+
+  void setData(const QByteArray& databaseStamp, const QList<PackageListData>& packages,
+               const QList<PackageListData>& foreignPackages, const QSet<QString>& unrequiredPackages,
+               const QSet<QString>& explicitPackages);
+
+  inline const QByteArray& getDatabaseStamp() const {
+    return m_databaseStamp;
+  }
+  inline const QList<PackageListData>& getPackages() const {
+    return m_packages;
+  }
+  inline const QList<PackageListData>& getForeignPackages() const {
+    return m_foreignPackages;
+  }
+  inline const QSet<QString>& getUnrequiredPackages() const {
+    return m_unrequiredPackages;
+  }
+  inline const QSet<QString>& getExplicitPackages() const {
+    return m_explicitPackages;
+  }
+  // whether the databases are still the ones the snapshot was taken from
+  bool isCurrent() const;
+
+  /**
+   * @brief loads the snapshot file, false if it is missing, of another format or not current
+   */
+  bool read();
+  bool write() const;
+
+  // true if the snapshot file is current, reads its header only
+  static bool isFileCurrent();
+  // empty if there is no directory only the user can access for it
+  static QString getFileName();
+
+  /**
+   * @brief tells the process listening on %peerId that the snapshot file changed
+   *
+   * Only to be called while that process runs, otherwise the QtLocalPeer would claim its id for a moment.
+   */
+  static void notify(const QString& peerId);
+
+private:
+  QByteArray              m_databaseStamp;
+  QList<PackageListData>  m_packages;
+  QList<PackageListData>  m_foreignPackages;
+  QSet<QString>           m_unrequiredPackages;
+  QSet<QString>           m_explicitPackages;
+};
+
+#endif // OCTOPI_PACKAGESNAPSHOT_H
@@ -0,0 +1,136 @@
+/*
+* This file is part of Octopi, an open-source GUI for pacman.
+* Copyright (C) 2014 Thomas Binkau
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*
+*/
+
+#include "pacmandatabasewatcher.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+
+#include "package.h"
+
+
+namespace {
+
+QString syncDirectory()
+{
+  return ctn_PACMAN_DATABASE_DIR + "/sync";
+}
+
+QString localDirectory()
+{
+  return ctn_PACMAN_DATABASE_DIR + "/local";
+}
+
+} // namespace
+
+
+PacmanDatabaseWatcher::PacmanDatabaseWatcher(QObject* parent)
+  : QObject(parent), m_syncStamps(readSyncStamps()), m_localStamp(readLocalStamp()), m_localChanged(false)
+{
+  m_settleTimer.setSingleShot(true);
+  m_settleTimer.setInterval(ctn_SETTLE_INTERVAL);
+  connect(&m_settleTimer, SIGNAL(timeout()), this, SLOT(poll()));
+
+  m_watcher.addPaths(QStringList() << ctn_PACMAN_DATABASE_DIR << syncDirectory() << localDirectory());
+  connect(&m_watcher, SIGNAL(directoryChanged(QString)), this, SLOT(onDirectoryChanged(QString)));
+}
+
+bool PacmanDatabaseWatcher::isLocked()
+{
+  return QFile::exists(ctn_PACMAN_DATABASE_DIR + "/db.lck");
+}
+
+QByteArray PacmanDatabaseWatcher::getDatabaseStamp()
+{
+  const QHash<QString, TStamp> syncStamps = readSyncStamps();
+  QStringList repositories = syncStamps.keys();
+  repositories.sort();
+
+  QByteArray result;
+  for (QStringList::const_iterator it = repositories.begin(); it != repositories.end(); ++it) {
+    const TStamp& stamp = syncStamps[*it];
+    result += it->toUtf8() + ' ' + QByteArray::number(stamp.modified.toMSecsSinceEpoch()) + ' ' +
+              QByteArray::number(stamp.size) + '\n';
+  }
+  result += "local " + QByteArray::number(readLocalStamp().toMSecsSinceEpoch()) + '\n';
+  return result;
+}
+
+void PacmanDatabaseWatcher::onDirectoryChanged(const QString& path)
+{
+  if (path == localDirectory()) m_localChanged = true;
+  // the removal of db.lck changes the database directory, so a locked state is always followed by a restart
+  m_settleTimer.start();
+}
+
+bool PacmanDatabaseWatcher::poll()
+{
+  if (isLocked()) return false;
+  m_settleTimer.stop();
+
+  const QHash<QString, TStamp> syncStamps = readSyncStamps();
+  QStringList repositories;
+  for (QHash<QString, TStamp>::const_iterator it = syncStamps.begin(); it != syncStamps.end(); ++it) {
+    const QHash<QString, TStamp>::const_iterator old = m_syncStamps.find(it.key());
+    if (old == m_syncStamps.end() || old.value().modified != it.value().modified ||
+        old.value().size != it.value().size) {
+      repositories.append(it.key());
+    }
+  }
+  for (QHash<QString, TStamp>::const_iterator it = m_syncStamps.begin(); it != m_syncStamps.end(); ++it) {
+    if (!syncStamps.contains(it.key())) repositories.append(it.key());
+  }
+
+  const QDateTime localStamp = readLocalStamp();
+  const bool local = m_localChanged || localStamp != m_localStamp;
+
+  m_syncStamps   = syncStamps;
+  m_localStamp   = localStamp;
+  m_localChanged = false;
+
+  if (repositories.isEmpty() && !local) return false;
+
+  repositories.sort();
+  emit databaseChanged(repositories, local);
+  return true;
+}
+
+QHash<QString, PacmanDatabaseWatcher::TStamp> PacmanDatabaseWatcher::readSyncStamps()
+{
+  QHash<QString, TStamp> result;
+
+  const QFileInfoList files = QDir(syncDirectory()).entryInfoList(QStringList("*.db"), QDir::Files);
+  for (QFileInfoList::const_iterator it = files.begin(); it != files.end(); ++it) {
+    TStamp stamp;
+    stamp.modified = it->lastModified();
+    stamp.size     = it->size();
+    result.insert(it->completeBaseName(), stamp);
+  }
+  return result;
+}
+
+/**
+ * @brief the "local" directory gets a new entry for every package installed, upgraded or removed
+ */
+QDateTime PacmanDatabaseWatcher::readLocalStamp()
+{
+  return QFileInfo(localDirectory()).lastModified();
+}
@@ -0,0 +1,91 @@
+/*
+* This file is part of Octopi, an open-source GUI for pacman.
+* Copyright (C) 2014 Thomas Binkau
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*
+*/
+
+#ifndef OCTOPI_PACMANDATABASEWATCHER_H
+#define OCTOPI_PACMANDATABASEWATCHER_H
+
+#include <QByteArray>
+#include <QDateTime>
+#include <QFileSystemWatcher>
+#include <QHash>
+#include <QObject>
+#include <QStringList>
+#include <QTimer>
+
+
+/**
+ * @brief Reports which pacman databases changed once pacman is done with them
+ *
+ * Watches the database directory (where db.lck comes and goes), its "sync" directory and its
+ * "local" directory. A sync or an upgrade touches them many times, so every change only restarts
+ * a timer; after ctn_SETTLE_INTERVAL without changes, and only while db.lck doesn't exist, the
+ * size and modification time of every sync/<repository>.db is compared with the last report
+ * and one databaseChanged is emitted for the repositories whose file differs.
+ */
+class PacmanDatabaseWatcher : public QObject
+{
+  Q_OBJECT
+
+public:
+  static const int ctn_SETTLE_INTERVAL = 2000; // ms
+
+public:
+  explicit PacmanDatabaseWatcher(QObject* parent = 0);
+
+  static bool isLocked();
+
+  /**
+   * @brief size and modification time of every database, changes whenever pacman changes one
+   */
+  static QByteArray getDatabaseStamp();
+
+public slots:
+  /**
+   * @brief compares the databases right away (unless locked), true if databaseChanged was emitted
+   */
+  bool poll();
+
+signals:
+  /**
+   * @brief %repositories: those whose sync database changed, %local: whether installed packages changed
+   */
+  void databaseChanged(const QStringList& repositories, bool local);
+
+private slots:
+  void onDirectoryChanged(const QString& path);
+
+private:
+  struct TStamp {
+    QDateTime modified;
+    qint64    size;
+  };
+
+  static QHash<QString, TStamp> readSyncStamps();
+  static QDateTime readLocalStamp();
+
+private:
+  QFileSystemWatcher      m_watcher;
+  QTimer                  m_settleTimer;
+  QHash<QString, TStamp>  m_syncStamps; // repository -> its sync database as last reported
+  QDateTime               m_localStamp;
+  bool                    m_localChanged;
+};
+
+#endif // OCTOPI_PACMANDATABASEWATCHER_H
@@ -36,14 +36,28 @@ public:
     ~PacmanHelperClient();
 
 public Q_SLOTS: // METHODS
+    inline QDBusPendingReply<> cancelsyncdb()
+    {
+        QList<QVariant> argumentList;
+        return asyncCallWithArgumentList(QLatin1String("cancelsyncdb"), argumentList);
+    }
+
     inline QDBusPendingReply<> syncdb()
     {
         QList<QVariant> argumentList;
         return asyncCallWithArgumentList(QLatin1String("syncdb"), argumentList);
     }
 
+    inline QDBusPendingReply<bool> syncdbasync()
+    {
+        QList<QVariant> argumentList;
+        return asyncCallWithArgumentList(QLatin1String("syncdbasync"), argumentList);
+    }
+
 Q_SIGNALS: // SIGNALS
     void syncdbcompleted();
+    void syncdbprogress(const QString &repository, qlonglong received, qlonglong total);
+    void syncdbrepositorycompleted(const QString &repository, int result);
 };
 
 namespace org {
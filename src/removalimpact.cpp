@@ -0,0 +1,147 @@
+/*
+* This file is part of Octopi, an open-source GUI for pacman.
+* Copyright (C) 2014 Thomas Binkau
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*
+*/
+
+#include "removalimpact.h"
+
+#include "dependencygraph.h"
+
+
+/**
+ * @param targets = names of the packages the user wants to remove (unknown or not installed ones are ignored)
+ * @param removeCommand = pacman remove operation without dash, e.g. "R", "Rs" or "Rcs"
+ */
+RemovalImpact::RemovalImpact(const DependencyGraph& graph, const QStringList& targets, const QString& removeCommand)
+  : m_graph(graph), m_removed(graph.getNodeCount(), false), m_targetCount(0), m_freedSize(0)
+{
+  for (QStringList::const_iterator it = targets.begin(); it != targets.end(); ++it) {
+    const int node = m_graph.findNode(*it);
+    if (node != -1 && m_graph.isInstalled(node) && !m_removed[node]) addNode(node);
+  }
+  m_targetCount = m_removalSet.size();
+
+  const bool cascade   = removeCommand.contains('c');
+  const int  recursive = removeCommand.count('s');
+
+  if (cascade) addCascade();
+  if (recursive > 0) addUnneeded(recursive > 1);
+
+  // without cascade pacman refuses to break the dependencies of packages that stay
+  if (!cascade) {
+    std::vector<bool> reported(m_graph.getNodeCount(), false);
+    for (QList<int>::const_iterator it = m_removalSet.begin(); it != m_removalSet.end(); ++it) {
+      const DependencyGraph::TNodeRange reqs = m_graph.requiredBy(*it);
+      for (DependencyGraph::TNodeIterator itReq = reqs.first; itReq != reqs.second; ++itReq) {
+        if (m_graph.isInstalled(*itReq) && !m_removed[*itReq] && !reported[*itReq]) {
+          reported[*itReq] = true;
+          m_blockers.append(*itReq);
+        }
+      }
+    }
+  }
+}
+
+/**
+ * @brief sorted names of all packages which will be removed
+ */
+QStringList RemovalImpact::getPackageNames() const
+{
+  return namesOf(m_removalSet.begin(), m_removalSet.end());
+}
+
+/**
+ * @brief sorted names of the packages which will be removed on top of the targets
+ */
+QStringList RemovalImpact::getAdditionalPackageNames() const
+{
+  return namesOf(m_removalSet.begin() + m_targetCount, m_removalSet.end());
+}
+
+/**
+ * @brief sorted names of installed packages which would be left with a missing dependency
+ */
+QStringList RemovalImpact::getBlockingPackageNames() const
+{
+  return namesOf(m_blockers.begin(), m_blockers.end());
+}
+
+void RemovalImpact::addNode(int node)
+{
+  m_removed[node] = true;
+  m_removalSet.append(node);
+  m_freedSize += m_graph.getInstalledSize(node);
+}
+
+/**
+ * @brief BFS over the reverse edges, starting with everything removed so far
+ */
+void RemovalImpact::addCascade()
+{
+  for (int x = 0; x < m_removalSet.size(); ++x) {
+    const DependencyGraph::TNodeRange reqs = m_graph.requiredBy(m_removalSet.at(x));
+    for (DependencyGraph::TNodeIterator it = reqs.first; it != reqs.second; ++it) {
+      if (m_graph.isInstalled(*it) && !m_removed[*it]) addNode(*it);
+    }
+  }
+}
+
+/**
+ * @brief BFS over the forward edges, removing dependencies nobody else needs anymore
+ *
+ * A dependency rejected because another dependency still needs it is visited again as soon as
+ * that one gets removed, since the dependencies of every removed package are queued.
+ */
+void RemovalImpact::addUnneeded(bool includeExplicit)
+{
+  std::vector<int> queue;
+  for (QList<int>::const_iterator it = m_removalSet.begin(); it != m_removalSet.end(); ++it) {
+    const DependencyGraph::TNodeRange deps = m_graph.dependsOn(*it);
+    queue.insert(queue.end(), deps.first, deps.second);
+  }
+
+  for (std::size_t x = 0; x < queue.size(); ++x) {
+    const int node = queue[x];
+    if (m_removed[node] || !m_graph.isInstalled(node)) continue;
+    if (m_graph.isExplicitlyInstalled(node) && !includeExplicit) continue;
+    if (!isOnlyRequiredByRemoved(node)) continue;
+
+    addNode(node);
+    const DependencyGraph::TNodeRange deps = m_graph.dependsOn(node);
+    queue.insert(queue.end(), deps.first, deps.second);
+  }
+}
+
+bool RemovalImpact::isOnlyRequiredByRemoved(int node) const
+{
+  const DependencyGraph::TNodeRange reqs = m_graph.requiredBy(node);
+  for (DependencyGraph::TNodeIterator it = reqs.first; it != reqs.second; ++it) {
+    if (m_graph.isInstalled(*it) && !m_removed[*it]) return false;
+  }
+  return true;
+}
+
+QStringList RemovalImpact::namesOf(QList<int>::const_iterator begin, QList<int>::const_iterator end) const
+{
+  QStringList result;
+  for (QList<int>::const_iterator it = begin; it != end; ++it) {
+    result.append(m_graph.getName(*it));
+  }
+  result.sort();
+  return result;
+}
@@ -0,0 +1,74 @@
+/*
+* This file is part of Octopi, an open-source GUI for pacman.
+* Copyright (C) 2014 Thomas Binkau
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*
+*/
+
+#ifndef OCTOPI_REMOVALIMPACT_H
+#define OCTOPI_REMOVALIMPACT_H
+
+#include <vector>
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+class DependencyGraph;
+
+
+/**
+ * @brief Computes which packages "pacman -R<options>" would remove for a set of targets
+ *
+ * The analysis runs on the DependencyGraph instead of asking pacman for a dry run:
+ * - cascade ("c"): all installed packages which (transitively) depend on a target are removed too
+ * - recursive ("s"): dependencies which are no longer required by anything else are removed too,
+ *   unless they were explicitly installed ("ss" removes those as well)
+ * Both closures are breadth-first searches with one visited bit per graph node.
+ */
+class RemovalImpact
+{
+public:
+  RemovalImpact(const DependencyGraph& graph, const QStringList& targets, const QString& removeCommand);
+
+  inline int getPackageCount() const {
+    return m_removalSet.size();
+  }
+  // sum of the installed sizes of all removed packages in KiB
+  inline double getFreedSize() const {
+    return m_freedSize;
+  }
+
+  QStringList getPackageNames() const;
+  QStringList getAdditionalPackageNames() const;
+  QStringList getBlockingPackageNames() const;
+
+private:
+  void addNode(int node);
+  void addCascade();
+  void addUnneeded(bool includeExplicit);
+  bool isOnlyRequiredByRemoved(int node) const;
+  QStringList namesOf(QList<int>::const_iterator begin, QList<int>::const_iterator end) const;
+
+private:
+  const DependencyGraph& m_graph;
+  std::vector<bool>      m_removed;     // visited bits, one per graph node
+  QList<int>             m_removalSet;  // targets first, then the packages pulled in
+  int                    m_targetCount;
+  QList<int>             m_blockers;    // installed packages left behind which depend on a removed one
+  double                 m_freedSize;
+};
+
+#endif // OCTOPI_REMOVALIMPACT_H
@@ -130,6 +130,10 @@ bool SettingsManager::getUseSilentActionOutput(){
   return (instance()->getSYSsettings()->value( ctn_KEY_USE_SILENT_ACTION_OUTPUT, true).toInt() == 1);
 }
 
+bool SettingsManager::getKeepOctopiReady(){
+  return (instance()->getSYSsettings()->value( ctn_KEY_KEEP_OCTOPI_READY, false).toInt() == 1);
+}
+
 bool SettingsManager::getAutomaticCheckUpdates(){
   return (instance()->getSYSsettings()->value( ctn_KEY_AUTOMATIC_CHECK_UPDATES, true).toInt() == 1);
 }
@@ -262,6 +266,14 @@ void SettingsManager::setUseSilentActionOutput(bool newValue){
   instance()->getSYSsettings()->sync();
 }
 
+void SettingsManager::setKeepOctopiReady(bool newValue){
+  int value=0;
+  if (newValue) value=1;
+
+  instance()->getSYSsettings()->setValue( ctn_KEY_KEEP_OCTOPI_READY, value);
+  instance()->getSYSsettings()->sync();
+}
+
 void SettingsManager::setWindowCloseHidesApp(bool newValue){
   int value=0;
   if (newValue) value=1;
@@ -49,6 +49,7 @@ const QString ctn_KEY_HIGHLIGHTED_SEARCH_ITEMS("Limit_Hightlighted_Search_Items"
 const QString ctn_KEY_FONT_SIZE_FACTOR("Font_Size_Factor");
 const QString ctn_KEY_USE_PKGTOOLS("Use_PkgTools");
 const QString ctn_KEY_USE_SILENT_ACTION_OUTPUT("Use_Silent_Action_Output");
+const QString ctn_KEY_KEEP_OCTOPI_READY("Keep_Octopi_Ready");
 
 enum PanelOrganizing { ectn_NORMAL=30, ectn_MAXIMIZE_PACKAGES=40, ectn_MAXIMIZE_PROPERTIES=50, ectn_GROUPS=5 };
 
@@ -93,6 +94,7 @@ class SettingsManager {
     static bool getStartIconified();
     static bool getUsePkgTools();
     static bool getUseSilentActionOutput();
+    static bool getKeepOctopiReady();
     static bool getAutomaticCheckUpdates();
     static bool getWindowCloseHidesApp();
     static int getFontSizeFactor();
@@ -127,6 +129,7 @@ class SettingsManager {
     static void setHighlightedSearchItems(int newValue);
     static void setUsePkgTools(bool newValue);
     static void setUseSilentActionOutput(bool newValue);
+    static void setKeepOctopiReady(bool newValue);
     static void setFontSizeFactor(int newValue);
     static void setWindowSize(QByteArray newValue);
     static void setSplitterHorizontalState(QByteArray newValue);
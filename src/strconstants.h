@@ -43,7 +43,9 @@ public:
         "-version: " + QObject::tr("show application version.") + "\n" +
         "-style <Qt4-style>: " + QObject::tr("use a different Qt4 style (ex: -style gtk).") + "\n" +
         "-removecmd <Remove-command>: " + QObject::tr("use a different remove command (ex: -removecmd R).") + "\n" +
-        "-sysupgrade: " + QObject::tr("force a system upgrade at startup.") + "\n";
+        "-sysupgrade: " + QObject::tr("force a system upgrade at startup.") + "\n" +
+        "-install <pkg1,pkg2>: " + QObject::tr("install the given repository packages.") + "\n" +
+        "-hide: " + QObject::tr("start hidden, or hide/show the running instance.") + "\n";
 
     return str;
   }
@@ -118,6 +120,14 @@ public:
     return QObject::tr("Display all groups");
   }
 
+  static QString getOrphansGroup(){
+    return "<" + QObject::tr("Orphans") + ">";
+  }
+
+  static QString getUnusedOrphansGroup(){
+    return "<" + QObject::tr("Not even optionally required") + ">";
+  }
+
   static QString getYaourtGroup(){
     if( UnixCommand::getLinuxDistro() == ectn_CHAKRA )
       return QLatin1String( "<Ccr>" );
@@ -192,6 +202,14 @@ public:
     return QObject::tr("Optional Deps");
   }
 
+  static QString getOptDepInstalled(){
+    return QObject::tr(" [installed]");
+  }
+
+  static QString getOptDepProvidedBy(){
+    return QObject::tr(" [installed: %1]");
+  }
+
   static QString getConflictsWith(){
     return QObject::tr("Conflicts With");
   }
@@ -424,6 +442,10 @@ public:
     return QObject::tr("There are %1 updates available!");
   }
 
+  static QString getNotifierMemoryUsage(){
+    return QObject::tr("Memory: %1 MiB resident, %2 KiB package index");
+  }
+
   static QString getConfirmationQuestion(){
     return QObject::tr("Confirm?");
   }
@@ -515,6 +537,82 @@ public:
     return QObject::tr("To be removed");
   }
 
+  static QString getDependencyCycle(){
+    return QObject::tr("(cycle)");
+  }
+
+  static QString getRemovalImpact(){
+    return QObject::tr("%1 packages, %2 freed");
+  }
+
+  static QString getRemovalImpactAlsoRemoves(){
+    return QObject::tr("Also removes: %1");
+  }
+
+  static QString getRemovalImpactBreaks(){
+    return QObject::tr("Still required by: %1");
+  }
+
+  static QString getTransactionEstimate(){
+    return QObject::tr("%1 to download, %2 installed");
+  }
+
+  static QString getTransactionEstimateCached(){
+    return QObject::tr("Already in the package cache: %1");
+  }
+
+  static QString getTransactionFileCollisions(){
+    return QObject::tr("File conflicts:");
+  }
+
+  static QString getTransactionFileExists(){
+    return QObject::tr("%1: %2 exists in filesystem");
+  }
+
+  static QString getTransactionFileOwned(){
+    return QObject::tr("%1: %2 is owned by %3");
+  }
+
+  static QString getTransactionFileListsUnavailable(){
+    return QObject::tr("File conflicts were not checked, the file lists of the packages are not available.");
+  }
+
+  static QString getTransactionCheckFailed(){
+    return QObject::tr("This transaction is going to fail!");
+  }
+
+  static QString getTransactionUnresolved(){
+    return QObject::tr("Some targets or dependencies can't be found, so pacman would refuse this transaction.");
+  }
+
+  static QString getTimeLeft(){
+    return QObject::tr("%1 left");
+  }
+
+  static QString getTransactionPhaseTimes(){
+    return QObject::tr("Download: %1 s\nChecks: %2 s\nInstall: %3 s\nHooks: %4 s");
+  }
+
+  static QString getTransactionTimelineSaved(){
+    return QObject::tr("Transaction timeline saved to %1");
+  }
+
+  static QString getTransactionTargetNotFound(){
+    return QObject::tr("target not found: %1");
+  }
+
+  static QString getTransactionUnresolvedDependency(){
+    return QObject::tr("unable to satisfy dependency '%1' required by %2");
+  }
+
+  static QString getTransactionConflict(){
+    return QObject::tr("%1 and %2 are in conflict");
+  }
+
+  static QString getTransactionReplacement(){
+    return QObject::tr("%1 replaces %2");
+  }
+
   static QString getRemove(){
     return QObject::tr("remove");
   }
@@ -0,0 +1,225 @@
+/*
+* This file is part of Octopi, an open-source GUI for pacman.
+* Copyright (C) 2014 Thomas Binkau
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*
+*/
+
+#include "textsearchindex.h"
+
+#include <algorithm>
+#include <QColor>
+#include <QScrollBar>
+#include <QTextBrowser>
+#include <QTextCursor>
+#include <QTextDocument>
+
+
+TextSearchIndex* TextSearchIndex::forBrowser(QTextBrowser* browser)
+{
+  TextSearchIndex* index = browser->findChild<TextSearchIndex*>();
+  if (index == NULL) index = new TextSearchIndex(browser);
+  return index;
+}
+
+TextSearchIndex::TextSearchIndex(QTextBrowser* browser)
+  : QObject(browser), m_browser(browser), m_matcher(QString(), Qt::CaseInsensitive),
+    m_highlightLimit(0), m_highlighted(false)
+{
+  m_highlightTimer.setSingleShot(true);
+  m_highlightTimer.setInterval(0);
+  connect(&m_highlightTimer, SIGNAL(timeout()), this, SLOT(updateHighlight()));
+
+  connect(m_browser->document(), SIGNAL(contentsChange(int,int,int)),
+          this, SLOT(onContentsChange(int,int,int)));
+  connect(m_browser->verticalScrollBar(), SIGNAL(valueChanged(int)), &m_highlightTimer, SLOT(start()));
+  connect(m_browser->horizontalScrollBar(), SIGNAL(valueChanged(int)), &m_highlightTimer, SLOT(start()));
+
+  rebuild();
+}
+
+void TextSearchIndex::setPattern(const QString& pattern)
+{
+  m_pattern = pattern;
+  m_matcher = QStringMatcher(pattern, Qt::CaseInsensitive);
+  m_matches.clear();
+  if (!m_pattern.isEmpty()) scan(0, m_text.size(), m_matches);
+
+  updateHighlight();
+}
+
+void TextSearchIndex::setHighlightLimit(int limit)
+{
+  m_highlightLimit = limit;
+}
+
+int TextSearchIndex::findNext(int position) const
+{
+  if (m_matches.isEmpty()) return -1;
+
+  QVector<int>::const_iterator it = std::lower_bound(m_matches.constBegin(), m_matches.constEnd(), position);
+  if (it == m_matches.constEnd()) it = m_matches.constBegin();
+  return *it;
+}
+
+int TextSearchIndex::findPrevious(int position) const
+{
+  if (m_matches.isEmpty()) return -1;
+
+  QVector<int>::const_iterator it = std::lower_bound(m_matches.constBegin(), m_matches.constEnd(), position);
+  if (it == m_matches.constBegin()) it = m_matches.constEnd();
+  return *(--it);
+}
+
+void TextSearchIndex::select(int offset)
+{
+  if (offset < 0) return;
+
+  QTextCursor cursor(m_browser->document());
+  cursor.setPosition(offset);
+  cursor.setPosition(offset + m_pattern.size(), QTextCursor::KeepAnchor);
+  m_browser->setTextCursor(cursor);
+  m_browser->ensureCursorVisible();
+}
+
+/**
+ * @brief mirrors one document change and re-matches the text around it
+ *
+ * Matches ending before the change stay, matches overlapping it are dropped and matches after
+ * it are moved by the size difference. Only the changed text plus the pattern length on both
+ * sides is searched again, so appending output costs what was appended.
+ */
+void TextSearchIndex::onContentsChange(int position, int charsRemoved, int charsAdded)
+{
+  QTextDocument*const document = m_browser->document();
+  const int length = document->characterCount() - 1;
+
+  // setHtml/clear report counts including the final paragraph separator, which isn't in the mirror
+  if (position < 0 || position + charsRemoved > m_text.size() || position + charsAdded > length ||
+      m_text.size() - charsRemoved + charsAdded != length) {
+    rebuild();
+    m_highlightTimer.start();
+    return;
+  }
+
+  QTextCursor cursor(document);
+  cursor.setPosition(position);
+  cursor.setPosition(position + charsAdded, QTextCursor::KeepAnchor);
+  QString added = cursor.selectedText();
+  if (added.size() != charsAdded) {
+    rebuild();
+    m_highlightTimer.start();
+    return;
+  }
+  normalize(added);
+  m_text.replace(position, charsRemoved, added);
+
+  if (!m_pattern.isEmpty()) {
+    const int patternLength = m_pattern.size();
+    const int delta = charsAdded - charsRemoved;
+
+    QVector<int>::iterator first = std::lower_bound(m_matches.begin(), m_matches.end(), position - patternLength + 1);
+    QVector<int>::iterator last  = std::lower_bound(first, m_matches.end(), position + charsRemoved);
+    const int index = static_cast<int>(first - m_matches.begin());
+    m_matches.erase(first, last);
+    for (int x = index; x < m_matches.size(); ++x) m_matches[x] += delta;
+
+    QVector<int> found;
+    scan(qMax(0, position - patternLength + 1), qMin(m_text.size(), position + charsAdded + patternLength - 1), found);
+    if (!found.isEmpty()) {
+      m_matches.insert(index, found.size(), 0);
+      std::copy(found.constBegin(), found.constEnd(), m_matches.begin() + index);
+    }
+  }
+
+  m_highlightTimer.start();
+}
+
+/**
+ * @brief gives the matches between the top left and the bottom right corner of the viewport an ExtraSelection
+ */
+void TextSearchIndex::updateHighlight()
+{
+  QList<QTextEdit::ExtraSelection> extraSelections;
+
+  if (!m_matches.isEmpty()) {
+    const QWidget*const viewport = m_browser->viewport();
+    const int first = m_browser->cursorForPosition(QPoint(0, 0)).position();
+    const int last  = m_browser->cursorForPosition(QPoint(viewport->width(), viewport->height())).position();
+    const QColor color = QColor(Qt::yellow).lighter(130);
+
+    QVector<int>::const_iterator it =
+        std::lower_bound(m_matches.constBegin(), m_matches.constEnd(), first - m_pattern.size() + 1);
+    for (; it != m_matches.constEnd() && *it <= last; ++it) {
+      QTextEdit::ExtraSelection extra;
+      extra.format.setBackground(color);
+      extra.cursor = QTextCursor(m_browser->document());
+      extra.cursor.setPosition(*it);
+      extra.cursor.setPosition(*it + m_pattern.size(), QTextCursor::KeepAnchor);
+      extraSelections.append(extra);
+
+      if (m_highlightLimit > 0 && extraSelections.count() == m_highlightLimit) break;
+    }
+  }
+
+  // leaves the extra selections of browsers which never had a match alone
+  if (extraSelections.isEmpty() && !m_highlighted) return;
+  m_browser->setExtraSelections(extraSelections);
+  m_highlighted = !extraSelections.isEmpty();
+}
+
+void TextSearchIndex::rebuild()
+{
+  m_text = m_browser->document()->toPlainText();
+  normalize(m_text);
+
+  m_matches.clear();
+  if (!m_pattern.isEmpty()) scan(0, m_text.size(), m_matches);
+}
+
+/**
+ * @brief appends the offsets of the non-overlapping matches lying completely inside [%from, %to)
+ */
+void TextSearchIndex::scan(int from, int to, QVector<int>& result) const
+{
+  const int patternLength = m_pattern.size();
+  if (patternLength == 0 || to - from < patternLength) return;
+
+  int position = from;
+  while ((position = m_matcher.indexIn(m_text.constData(), to, position)) != -1) {
+    result.append(position);
+    position += patternLength;
+  }
+}
+
+/**
+ * @brief maps separators the way QTextDocument::toPlainText does, one QChar for one QChar
+ */
+void TextSearchIndex::normalize(QString& text)
+{
+  QChar* it = text.data();
+  QChar*const end = it + text.size();
+  for (; it != end; ++it) {
+    const ushort unicode = it->unicode();
+    if (unicode == QChar::ParagraphSeparator || unicode == QChar::LineSeparator ||
+        unicode == 0xfdd0 || unicode == 0xfdd1) {
+      *it = QLatin1Char('\n');
+    }
+    else if (unicode == QChar::Nbsp) {
+      *it = QLatin1Char(' ');
+    }
+  }
+}
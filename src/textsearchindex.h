@@ -0,0 +1,90 @@
+/*
+* This file is part of Octopi, an open-source GUI for pacman.
+* Copyright (C) 2014 Thomas Binkau
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*
+*/
+
+#ifndef OCTOPI_TEXTSEARCHINDEX_H
+#define OCTOPI_TEXTSEARCHINDEX_H
+
+#include <QObject>
+#include <QString>
+#include <QStringMatcher>
+#include <QTimer>
+#include <QVector>
+
+class QTextBrowser;
+
+
+/**
+ * @brief Search backend of the search bars above text browsers
+ *
+ * Keeps a plain-text mirror of the browser's document which follows QTextDocument::contentsChange,
+ * so appending output only copies the appended text. The offsets of the search pattern are kept
+ * sorted and are updated around each change the same way, jumping to the next or previous match
+ * is a binary search. Only the matches inside the viewport get an ExtraSelection.
+ */
+class TextSearchIndex : public QObject
+{
+  Q_OBJECT
+
+public:
+  /**
+   * @brief the index of %browser, created on first use
+   */
+  static TextSearchIndex* forBrowser(QTextBrowser* browser);
+
+  /**
+   * @brief sets the (case insensitive) pattern, an empty one removes the highlights
+   */
+  void setPattern(const QString& pattern);
+  // maximum number of highlighted matches, 0 for no limit
+  void setHighlightLimit(int limit);
+
+  inline int getMatchCount() const {
+    return m_matches.size();
+  }
+  // offset of the first match at or after %position, wrapping around; -1 if there is none
+  int findNext(int position) const;
+  // offset of the last match before %position, wrapping around; -1 if there is none
+  int findPrevious(int position) const;
+  // selects the match at %offset and scrolls it into view
+  void select(int offset);
+
+private slots:
+  void onContentsChange(int position, int charsRemoved, int charsAdded);
+  void updateHighlight();
+
+private:
+  explicit TextSearchIndex(QTextBrowser* browser);
+
+  void rebuild();
+  void scan(int from, int to, QVector<int>& result) const;
+  static void normalize(QString& text);
+
+private:
+  QTextBrowser*  m_browser;
+  QString        m_text;     // plain text, one QChar per document position
+  QString        m_pattern;
+  QStringMatcher m_matcher;
+  QVector<int>   m_matches;  // sorted offsets of m_pattern in m_text
+  int            m_highlightLimit;
+  bool           m_highlighted;
+  QTimer         m_highlightTimer;
+};
+
+#endif // OCTOPI_TEXTSEARCHINDEX_H
@@ -0,0 +1,245 @@
+/*
+* This file is part of Octopi, an open-source GUI for pacman.
+* Copyright (C) 2014 Thomas Binkau
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*
+*/
+
+#include "transactionchecker.h"
+
+#include <QFileInfo>
+#include <QFuture>
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSet>
+
+#if QT_VERSION > 0x050000
+  #include <QtConcurrent/QtConcurrentMap>
+  #include <QtConcurrent/QtConcurrentRun>
+#else
+  #include <QtConcurrentMap>
+  #include <QtConcurrentRun>
+#endif
+
+#include "unixcommand.h"
+
+
+namespace {
+
+struct TPackageCheck {
+  QString                                  name;
+  QStringList                              files;    // directories left out, they are shared
+  const QHash<QString, QString>*           owners;   // file -> installed owner, only files a target ships
+  const QHash<QString, QString>*           incoming; // file -> first target shipping it
+  const QSet<QString>*                     leaving;  // installed packages upgraded, replaced or removed
+  QList<TransactionChecker::FileCollision> collisions;
+};
+
+void findCollisions(TPackageCheck& check)
+{
+  for (QStringList::const_iterator it = check.files.begin(); it != check.files.end(); ++it) {
+    TransactionChecker::FileCollision collision;
+    collision.package = check.name;
+    collision.file    = *it;
+
+    // a file shipped by two targets is reported once, by the second one
+    const QString shipper = check.incoming->value(*it);
+    if (shipper != check.name) {
+      collision.owner = shipper;
+      check.collisions.append(collision);
+      continue;
+    }
+
+    collision.owner = check.owners->value(*it);
+    if (collision.owner.isEmpty()) {
+      const QFileInfo fileInfo(*it);
+      if (fileInfo.exists() || fileInfo.isSymLink()) check.collisions.append(collision);
+    }
+    else if (collision.owner != check.name && !check.leaving->contains(collision.owner)) {
+      check.collisions.append(collision);
+    }
+  }
+}
+
+// "pacman -Ql" of an earlier check, valid until the local db changes
+QMutex     g_installedFilesMutex;
+QByteArray g_installedFiles;
+bool       g_installedFilesValid = false;
+int        g_installedFilesGeneration = 0; // counts the invalidations
+
+QByteArray cachedInstalledFileList(bool* ok)
+{
+  int generation;
+  {
+    QMutexLocker locker(&g_installedFilesMutex);
+    if (g_installedFilesValid) {
+      *ok = true;
+      return g_installedFiles;
+    }
+    generation = g_installedFilesGeneration;
+  }
+
+  const QByteArray result = UnixCommand::getInstalledFileList(ok);
+
+  // an invalidation while pacman was running may mean the output is already outdated
+  QMutexLocker locker(&g_installedFilesMutex);
+  if (*ok && generation == g_installedFilesGeneration) {
+    g_installedFiles      = result;
+    g_installedFilesValid = true;
+  }
+  return result;
+}
+
+bool lessByPackageAndFile(const TransactionChecker::FileCollision& a, const TransactionChecker::FileCollision& b)
+{
+  if (a.package != b.package) return a.package < b.package;
+  return a.file < b.file;
+}
+
+} // namespace
+
+
+TransactionChecker::TransactionChecker(const TransactionResolver& resolution)
+  : m_hasFileLists(false)
+{
+  const QList<TransactionResolver::Target>& targets = resolution.getTargets();
+  if (targets.isEmpty()) {
+    check(resolution, QByteArray(), QByteArray());
+    return;
+  }
+
+  // the file ownership of the installed packages is read while the file lists are fetched
+  bool installedFilesOk = false;
+  QFuture<QByteArray> installedFiles = QtConcurrent::run(cachedInstalledFileList, &installedFilesOk);
+
+  QStringList names;
+  for (QList<TransactionResolver::Target>::const_iterator it = targets.begin(); it != targets.end(); ++it) {
+    names.append(it->name);
+  }
+
+  bool syncFilesOk = false;
+  const QByteArray syncFiles = UnixCommand::getSyncFileList(names, &syncFilesOk);
+
+  // a truncated "pacman -Ql" would turn owned files into false collisions
+  installedFiles.waitForFinished();
+  check(resolution, syncFilesOk ? syncFiles : QByteArray(),
+        installedFilesOk ? installedFiles.result() : QByteArray());
+}
+
+TransactionChecker::TransactionChecker(const TransactionResolver& resolution, const QByteArray& syncFileList,
+                                       const QByteArray& installedFileList)
+  : m_hasFileLists(false)
+{
+  check(resolution, syncFileList, installedFileList);
+}
+
+void TransactionChecker::check(const TransactionResolver& resolution, const QByteArray& syncFileList,
+                               const QByteArray& installedFileList)
+{
+  QSet<QString> leaving = QSet<QString>::fromList(resolution.getRemovedPackages());
+  foreach (const TransactionResolver::Replacement& replacement, resolution.getReplacements()) {
+    leaving.insert(replacement.replaced);
+  }
+
+  // a conflict with a package which is removed or replaced first doesn't stop pacman
+  foreach (const TransactionResolver::Conflict& conflict, resolution.getConflicts()) {
+    if (!leaving.contains(conflict.package) && !leaving.contains(conflict.conflictsWith)) m_conflicts.append(conflict);
+  }
+
+  const QList<TransactionResolver::Target>& targets = resolution.getTargets();
+  if (targets.isEmpty()) return;
+
+  QHash<QString, QString> owners;
+  QHash<QString, QString> incoming;
+
+  QList<TPackageCheck> checks;
+  for (QList<TransactionResolver::Target>::const_iterator it = targets.begin(); it != targets.end(); ++it) {
+    TPackageCheck check;
+    check.name     = it->name;
+    check.owners   = &owners;
+    check.incoming = &incoming;
+    check.leaving  = &leaving;
+    checks.append(check);
+
+    // an upgraded package's old files may be taken over by other targets
+    if (!it->oldVersion.isEmpty()) leaving.insert(it->name);
+  }
+
+  QHash<QString, int> checkIndex;
+  for (int i = 0; i < checks.size(); ++i) checkIndex.insert(checks.at(i).name, i);
+
+  // "pacman -Fl" lines read "name path" with paths relative to /
+  int syncStart = 0;
+  while (syncStart < syncFileList.size()) {
+    int lineEnd = syncFileList.indexOf('\n', syncStart);
+    if (lineEnd == -1) lineEnd = syncFileList.size();
+
+    const int separator = syncFileList.indexOf(' ', syncStart);
+    if (separator != -1 && separator < lineEnd && syncFileList.at(lineEnd - 1) != '/') {
+      const QHash<QString, int>::const_iterator itCheck =
+          checkIndex.constFind(QString::fromUtf8(syncFileList.constData() + syncStart, separator - syncStart));
+      if (itCheck != checkIndex.constEnd()) {
+        checks[itCheck.value()].files.append(
+            '/' + QString::fromUtf8(syncFileList.constData() + separator + 1, lineEnd - separator - 1));
+      }
+    }
+    syncStart = lineEnd + 1;
+  }
+
+  for (QList<TPackageCheck>::const_iterator it = checks.begin(); it != checks.end(); ++it) {
+    if (!it->files.isEmpty()) m_hasFileLists = true;
+    for (QStringList::const_iterator itFile = it->files.begin(); itFile != it->files.end(); ++itFile) {
+      if (!incoming.contains(*itFile)) incoming.insert(*itFile, it->name);
+    }
+  }
+
+  if (!m_hasFileLists || installedFileList.isEmpty()) {
+    m_hasFileLists = false;
+    return;
+  }
+
+  // "pacman -Ql" lines read "name /path", only paths some target ships are kept
+  int lineStart = 0;
+  while (lineStart < installedFileList.size()) {
+    int lineEnd = installedFileList.indexOf('\n', lineStart);
+    if (lineEnd == -1) lineEnd = installedFileList.size();
+
+    const int separator = installedFileList.indexOf(' ', lineStart);
+    if (separator != -1 && separator < lineEnd) {
+      const QString file = QString::fromUtf8(installedFileList.constData() + separator + 1, lineEnd - separator - 1);
+      if (incoming.contains(file)) {
+        owners.insert(file, QString::fromUtf8(installedFileList.constData() + lineStart, separator - lineStart));
+      }
+    }
+    lineStart = lineEnd + 1;
+  }
+
+  QtConcurrent::blockingMap(checks, findCollisions);
+
+  for (QList<TPackageCheck>::const_iterator it = checks.begin(); it != checks.end(); ++it) {
+    m_fileCollisions.append(it->collisions);
+  }
+  qSort(m_fileCollisions.begin(), m_fileCollisions.end(), lessByPackageAndFile);
+}
+
+void TransactionChecker::invalidateInstalledFiles()
+{
+  QMutexLocker locker(&g_installedFilesMutex);
+  g_installedFiles.clear();
+  g_installedFilesValid = false;
+  ++g_installedFilesGeneration;
+}
@@ -0,0 +1,100 @@
+/*
+* This file is part of Octopi, an open-source GUI for pacman.
+* Copyright (C) 2014 Thomas Binkau
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*
+*/
+
+#ifndef OCTOPI_TRANSACTIONCHECKER_H
+#define OCTOPI_TRANSACTIONCHECKER_H
+
+#include <QByteArray>
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+#include "transactionresolver.h"
+
+
+/**
+ * @brief Pre-flight check of a resolved transaction, run before pacman is started
+ *
+ * Catches what would make pacman abort after all packages were downloaded:
+ * - declared conflicts (taken over from TransactionResolver, except those with packages the
+ *   transaction removes or replaces anyway)
+ * - file collisions: every file a target ships (file lists of the sync .files dbs, read once by
+ *   "pacman -Fl") is looked up in the file ownership of the installed packages ("pacman -Ql"). A file is fine
+ *   if it belongs to the target itself or to a package which is upgraded, replaced or removed
+ *   by the same transaction. Files no package owns collide if they exist on disk, as do files
+ *   shipped by two targets.
+ * Both lists are read in parallel and the files are checked per package in parallel. The whole check
+ * blocks for a while, so it is meant to be run by a worker thread (see checkTransaction in globals.h).
+ * The output of "pacman -Ql" is kept for the next checks until invalidateInstalledFiles() is called.
+ */
+class TransactionChecker
+{
+public:
+  struct FileCollision {
+    QString package;
+    QString file;
+    QString owner; // installed package or other target owning %file, empty for unowned files on disk
+  };
+
+public:
+  /**
+   * @param resolution = also tells which packages the same transaction removes before installing
+   */
+  explicit TransactionChecker(const TransactionResolver& resolution);
+
+  /**
+   * @brief checks against the given file lists instead of running pacman
+   * @param syncFileList = "pacman -Fl <targets>" output
+   * @param installedFileList = "pacman -Ql" output, empty if it could not be read
+   */
+  TransactionChecker(const TransactionResolver& resolution, const QByteArray& syncFileList,
+                     const QByteArray& installedFileList);
+
+  /**
+   * @brief drops the cached file ownership of the installed packages, to be called when the local db changed
+   */
+  static void invalidateInstalledFiles();
+
+  inline const QList<TransactionResolver::Conflict>& getConflicts() const {
+    return m_conflicts;
+  }
+  // sorted by package and file
+  inline const QList<FileCollision>& getFileCollisions() const {
+    return m_fileCollisions;
+  }
+  // false if no file list of any target was found (.files dbs not synced) or "pacman -Ql" failed
+  inline bool hasFileLists() const {
+    return m_hasFileLists;
+  }
+  inline bool hasProblems() const {
+    return !m_conflicts.isEmpty() || !m_fileCollisions.isEmpty();
+  }
+
+private:
+  void check(const TransactionResolver& resolution, const QByteArray& syncFileList,
+             const QByteArray& installedFileList);
+
+private:
+  QList<TransactionResolver::Conflict> m_conflicts;
+  QList<FileCollision>                 m_fileCollisions;
+  bool                                 m_hasFileLists;
+};
+
+#endif // OCTOPI_TRANSACTIONCHECKER_H
@@ -0,0 +1,130 @@
+/*
+* This file is part of Octopi, an open-source GUI for pacman.
+* Copyright (C) 2014 Thomas Binkau
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*
+*/
+
+#include "transactionestimator.h"
+
+#include <QDir>
+
+#include "dependencygraph.h"
+#include "package.h"
+
+
+TransactionEstimator::TransactionEstimator()
+  : m_graph(NULL), m_downloadSize(0), m_installedSizeDelta(0)
+{
+}
+
+void TransactionEstimator::setDependencyGraph(const DependencyGraph* graph)
+{
+  m_graph = graph;
+  scanPackageCache();
+
+  m_downloadSize       = 0;
+  m_installedSizeDelta = 0;
+  for (QHash<QString, TEstimate>::iterator it = m_install.begin(); it != m_install.end(); ++it) {
+    it.value() = estimate(ectn_INSTALL_QUEUE, it.key());
+    apply(it.value(), 1);
+  }
+  for (QHash<QString, TEstimate>::iterator it = m_remove.begin(); it != m_remove.end(); ++it) {
+    it.value() = estimate(ectn_REMOVE_QUEUE, it.key());
+    apply(it.value(), 1);
+  }
+}
+
+void TransactionEstimator::add(EQueue queue, const QString& pkgName)
+{
+  QHash<QString, TEstimate>& entries = queue == ectn_INSTALL_QUEUE ? m_install : m_remove;
+  if (entries.contains(pkgName)) return;
+
+  const TEstimate entry = estimate(queue, pkgName);
+  entries.insert(pkgName, entry);
+  apply(entry, 1);
+}
+
+void TransactionEstimator::remove(EQueue queue, const QString& pkgName)
+{
+  QHash<QString, TEstimate>& entries = queue == ectn_INSTALL_QUEUE ? m_install : m_remove;
+  const QHash<QString, TEstimate>::iterator it = entries.find(pkgName);
+  if (it == entries.end()) return;
+
+  apply(it.value(), -1);
+  entries.erase(it);
+}
+
+/**
+ * @brief sorted names of the queued install targets which are already in the package cache
+ */
+QStringList TransactionEstimator::getCachedPackages() const
+{
+  QStringList result;
+  for (QHash<QString, TEstimate>::const_iterator it = m_install.begin(); it != m_install.end(); ++it) {
+    if (it.value().cached) result.append(it.key());
+  }
+  result.sort();
+  return result;
+}
+
+TransactionEstimator::TEstimate TransactionEstimator::estimate(EQueue queue, const QString& pkgName) const
+{
+  TEstimate result;
+  result.downloadSize       = 0;
+  result.installedSizeDelta = 0;
+  result.cached             = false;
+
+  // install queue items read "repo/name"
+  const QString name = pkgName.mid(pkgName.indexOf('/') + 1);
+  const int node = m_graph != NULL ? m_graph->findNode(name) : -1;
+  if (node == -1) return result;
+
+  if (queue == ectn_REMOVE_QUEUE) {
+    result.installedSizeDelta = -m_graph->getInstalledSize(node);
+  }
+  else {
+    result.installedSizeDelta = m_graph->getSyncInstalledSize(node) - m_graph->getInstalledSize(node);
+    result.cached = m_packageCache.contains(name + "-" + m_graph->getSyncVersion(node));
+    if (!result.cached) result.downloadSize = m_graph->getDownloadSize(node);
+  }
+  return result;
+}
+
+/**
+ * @brief collects "name-version" of the package files in ctn_PACMAN_CACHE_DIR
+ *
+ * Files are named "name-version-arch.pkg.tar.<compression>", signatures and partial downloads are skipped.
+ */
+void TransactionEstimator::scanPackageCache()
+{
+  m_packageCache.clear();
+
+  const QStringList files = QDir(ctn_PACMAN_CACHE_DIR).entryList(QStringList() << "*.pkg.tar*", QDir::Files);
+  for (QStringList::const_iterator it = files.begin(); it != files.end(); ++it) {
+    if (it->endsWith(".sig") || it->endsWith(".part")) continue;
+
+    const QString base = it->left(it->lastIndexOf(".pkg.tar"));
+    const int arch = base.lastIndexOf('-');
+    if (arch > 0) m_packageCache.insert(base.left(arch));
+  }
+}
+
+void TransactionEstimator::apply(const TEstimate& estimate, int sign)
+{
+  m_downloadSize       += sign * estimate.downloadSize;
+  m_installedSizeDelta += sign * estimate.installedSizeDelta;
+}
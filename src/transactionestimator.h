@@ -0,0 +1,92 @@
+/*
+* This file is part of Octopi, an open-source GUI for pacman.
+* Copyright (C) 2014 Thomas Binkau
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*
+*/
+
+#ifndef OCTOPI_TRANSACTIONESTIMATOR_H
+#define OCTOPI_TRANSACTIONESTIMATOR_H
+
+#include <QHash>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+
+class DependencyGraph;
+
+
+/**
+ * @brief Running totals of the transaction queue: download size and net installed size change
+ *
+ * Every queued package contributes a fixed amount which is remembered, so adding or removing
+ * packages only touches those packages. Sync packages whose file is already in the pacman
+ * package cache need no download. Only the queued packages themselves are counted, the
+ * dependencies they pull in are left to TransactionResolver when the transaction is confirmed.
+ */
+class TransactionEstimator
+{
+public:
+  enum EQueue {
+    ectn_INSTALL_QUEUE,
+    ectn_REMOVE_QUEUE
+  };
+
+public:
+  TransactionEstimator();
+
+  /**
+   * @brief switches to a new graph (may be NULL), re-reads the package cache and re-estimates every queued package
+   */
+  void setDependencyGraph(const DependencyGraph* graph);
+
+  void add(EQueue queue, const QString& pkgName);
+  void remove(EQueue queue, const QString& pkgName);
+
+  inline int getPackageCount(EQueue queue) const {
+    return queue == ectn_INSTALL_QUEUE ? m_install.size() : m_remove.size();
+  }
+  // in KiB, packages already in the package cache excluded
+  inline double getDownloadSize() const {
+    return m_downloadSize;
+  }
+  // in KiB, of both queues
+  inline double getInstalledSizeDelta() const {
+    return m_installedSizeDelta;
+  }
+  QStringList getCachedPackages() const;
+
+private:
+  struct TEstimate {
+    double downloadSize;       // KiB
+    double installedSizeDelta; // KiB
+    bool   cached;
+  };
+
+  TEstimate estimate(EQueue queue, const QString& pkgName) const;
+  void scanPackageCache();
+  void apply(const TEstimate& estimate, int sign);
+
+private:
+  const DependencyGraph*      m_graph;
+  QHash<QString, TEstimate>   m_install;
+  QHash<QString, TEstimate>   m_remove;
+  QSet<QString>               m_packageCache; // "name-version" of every package file in the cache
+  double                      m_downloadSize;
+  double                      m_installedSizeDelta;
+};
+
+#endif // OCTOPI_TRANSACTIONESTIMATOR_H
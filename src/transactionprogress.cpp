@@ -0,0 +1,294 @@
+/*
+* This file is part of Octopi, an open-source GUI for pacman.
+* Copyright (C) 2014 Thomas Binkau
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*
+*/
+
+#include "transactionprogress.h"
+
+#include <QStringList>
+
+
+namespace {
+
+QString jsonString(const QString& value)
+{
+  QString result = "\"";
+  for (int x = 0; x < value.size(); ++x) {
+    const QChar c = value.at(x);
+    if (c == '"' || c == '\\') {
+      result += '\\';
+      result += c;
+    }
+    else if (c.unicode() < 0x20) {
+      result += QString("\\u%1").arg(c.unicode(), 4, 16, QChar('0'));
+    }
+    else {
+      result += c;
+    }
+  }
+  return result + "\"";
+}
+
+bool isInstallVerb(const QString& verb)
+{
+  return verb == "installing" || verb == "upgrading" || verb == "reinstalling" ||
+      verb == "downgrading" || verb == "removing";
+}
+
+} // namespace
+
+
+TransactionProgress::TransactionProgress()
+  : m_running(false), m_success(false), m_inHooks(false), m_expectedTargets(0),
+    m_expectedDownloadBytes(0), m_installTotal(0)
+{
+}
+
+void TransactionProgress::start(int expectedTargets, double expectedDownloadKiB)
+{
+  m_startTime = QDateTime::currentDateTime();
+  m_timer.start();
+  m_steps.clear();
+  m_running               = true;
+  m_success               = false;
+  m_inHooks               = false;
+  m_expectedTargets       = expectedTargets;
+  m_expectedDownloadBytes = expectedDownloadKiB * 1024;
+  m_installTotal          = 0;
+}
+
+void TransactionProgress::addEvent(const OutputParser::Event& event)
+{
+  if (!m_running) return;
+
+  switch (event.type) {
+  case OutputParser::ectn_DOWNLOAD:
+    beginStep(ectn_DOWNLOAD, event.target, event);
+    if (m_steps.last().bytes == 0) m_steps.last().bytes = parseSize(event.text);
+    break;
+
+  case OutputParser::ectn_PROGRESS:
+    m_inHooks = false;
+    if (isInstallVerb(event.verb)) {
+      beginStep(ectn_INSTALL, event.target, event);
+      if (event.total > 0) m_installTotal = event.total;
+    }
+    else {
+      beginStep(ectn_CHECK, event.text, event);
+    }
+    break;
+
+  case OutputParser::ectn_STAGE:
+    if (event.text.startsWith(":: Running") && event.text.contains("hooks")) {
+      endStep();
+      m_inHooks = true;
+    }
+    else if (m_inHooks && event.total > 0) {
+      beginStep(ectn_HOOK, event.text, event);
+    }
+    return;
+
+  default:
+    return;
+  }
+
+  // a step at 100% is done, unless it's one of the shared checks with more packages to come
+  if (event.percent == 100 && (event.total == 0 || event.current == event.total ||
+                               m_steps.last().phase != ectn_CHECK)) {
+    endStep();
+  }
+}
+
+void TransactionProgress::finish(bool success)
+{
+  if (!m_running) return;
+  endStep();
+  m_running = false;
+  m_success = success;
+}
+
+QString TransactionProgress::getCurrentStepText() const
+{
+  if (m_steps.isEmpty() || m_steps.last().endMs != -1) return QString();
+
+  const Step& step = m_steps.last();
+  if (step.total > 0) return QString("%1 (%2/%3)").arg(step.name).arg(step.current).arg(step.total);
+  return step.name;
+}
+
+qint64 TransactionProgress::getPhaseDuration(EPhase phase) const
+{
+  const qint64 now = m_running ? m_timer.elapsed() : 0;
+  qint64 result = 0;
+  for (QList<Step>::const_iterator it = m_steps.begin(); it != m_steps.end(); ++it) {
+    if (it->phase == phase) result += (it->endMs != -1 ? it->endMs : now) - it->startMs;
+  }
+  return result;
+}
+
+/**
+ * @brief remaining downloads at the rate seen so far plus remaining packages at the mean install time
+ */
+int TransactionProgress::getEstimatedSecondsLeft() const
+{
+  double downloadedBytes = 0;
+  qint64 downloadMs      = 0;
+  qint64 installMs       = 0;
+  int    installed       = 0;
+  for (QList<Step>::const_iterator it = m_steps.begin(); it != m_steps.end(); ++it) {
+    if (it->endMs == -1) {
+      // a long download would freeze the estimate until it's done, so its finished part counts, too
+      if (it->phase == ectn_DOWNLOAD && it->percent > 0) {
+        downloadedBytes += it->bytes * it->percent / 100;
+        downloadMs      += m_timer.elapsed() - it->startMs;
+      }
+      continue;
+    }
+    if (it->phase == ectn_DOWNLOAD) {
+      downloadedBytes += it->bytes;
+      downloadMs      += it->endMs - it->startMs;
+    }
+    else if (it->phase == ectn_INSTALL) {
+      installMs += it->endMs - it->startMs;
+      ++installed;
+    }
+  }
+
+  double secondsLeft = 0;
+  bool   known       = false;
+
+  if (downloadMs > 0 && downloadedBytes > 0 && m_expectedDownloadBytes > downloadedBytes) {
+    secondsLeft += (m_expectedDownloadBytes - downloadedBytes) / (downloadedBytes * 1000 / downloadMs);
+    known = true;
+  }
+
+  const int installTotal = m_installTotal > 0 ? m_installTotal : m_expectedTargets;
+  if (installed > 0 && installTotal > installed) {
+    secondsLeft += (installTotal - installed) * (installMs / 1000.0 / installed);
+    known = true;
+  }
+
+  return known ? static_cast<int>(secondsLeft + 0.5) : -1;
+}
+
+/**
+ * @brief the timeline as a JSON object: start, duration, per phase totals and every step
+ */
+QString TransactionProgress::toJson() const
+{
+  const qint64 duration = m_steps.isEmpty() ? 0 : (m_steps.last().endMs != -1 ? m_steps.last().endMs : m_timer.elapsed());
+
+  QString json = "{\n";
+  json += "  \"started\": " + jsonString(m_startTime.toString(Qt::ISODate)) + ",\n";
+  json += "  \"duration_ms\": " + QString::number(duration) + ",\n";
+  json += QString("  \"success\": ") + (m_success ? "true" : "false") + ",\n";
+
+  json += "  \"phases\": {";
+  for (int phase = 0; phase < ectn_PHASE_COUNT; ++phase) {
+    json += (phase == 0 ? " " : ", ") + jsonString(getPhaseName(static_cast<EPhase>(phase))) + ": " +
+        QString::number(getPhaseDuration(static_cast<EPhase>(phase)));
+  }
+  json += " },\n";
+
+  json += "  \"steps\": [";
+  for (int x = 0; x < m_steps.size(); ++x) {
+    const Step& step = m_steps.at(x);
+    const qint64 stepMs = (step.endMs != -1 ? step.endMs : duration) - step.startMs;
+
+    json += (x == 0 ? "\n" : ",\n");
+    json += "    { \"phase\": " + jsonString(getPhaseName(step.phase)) +
+        ", \"name\": " + jsonString(step.name) +
+        ", \"start_ms\": " + QString::number(step.startMs) +
+        ", \"duration_ms\": " + QString::number(stepMs);
+    if (step.phase == ectn_DOWNLOAD) {
+      json += ", \"bytes\": " + QString::number(step.bytes, 'f', 0) +
+          ", \"bytes_per_second\": " + QString::number(stepMs > 0 ? step.bytes * 1000 / stepMs : 0, 'f', 0);
+    }
+    json += " }";
+  }
+  json += m_steps.isEmpty() ? "]\n" : "\n  ]\n";
+  json += "}\n";
+  return json;
+}
+
+QString TransactionProgress::getPhaseName(EPhase phase)
+{
+  switch (phase) {
+  case ectn_DOWNLOAD: return "download";
+  case ectn_CHECK:    return "check";
+  case ectn_INSTALL:  return "install";
+  case ectn_HOOK:     return "hook";
+  default:            return QString();
+  }
+}
+
+/**
+ * @brief continues the running step if it's the same, otherwise ends it and starts a new one
+ */
+void TransactionProgress::beginStep(EPhase phase, const QString& name, const OutputParser::Event& event)
+{
+  if (!m_steps.isEmpty()) {
+    Step& last = m_steps.last();
+    if (last.endMs == -1 && last.phase == phase && last.name == name) {
+      last.current = event.current;
+      last.total   = event.total;
+      if (event.percent != -1) last.percent = event.percent;
+      return;
+    }
+    // pacman redraws a finished bar now and then
+    if (last.endMs != -1 && last.phase == phase && last.name == name && phase != ectn_CHECK) return;
+  }
+
+  endStep();
+
+  Step step;
+  step.phase   = phase;
+  step.name    = name;
+  step.startMs = m_timer.elapsed();
+  step.endMs   = -1;
+  step.bytes   = 0;
+  step.current = event.current;
+  step.total   = event.total;
+  step.percent = event.percent;
+  m_steps.append(step);
+}
+
+void TransactionProgress::endStep()
+{
+  if (!m_steps.isEmpty() && m_steps.last().endMs == -1) m_steps.last().endMs = m_timer.elapsed();
+}
+
+/**
+ * @brief "foo-1.0-1-x86_64   1024.0 KiB   512K/s 00:02" -> 1048576, 0 if there's no size
+ */
+double TransactionProgress::parseSize(const QString& downloadLine)
+{
+  const QStringList words = downloadLine.split(' ', QString::SkipEmptyParts);
+  for (int x = 1; x + 1 < words.size(); ++x) {
+    bool isNumber = false;
+    const double value = words.at(x).toDouble(&isNumber);
+    if (!isNumber) continue;
+
+    const QString& unit = words.at(x + 1);
+    if (unit == "B")   return value;
+    if (unit == "KiB") return value * 1024;
+    if (unit == "MiB") return value * 1024 * 1024;
+    if (unit == "GiB") return value * 1024 * 1024 * 1024;
+  }
+  return 0;
+}
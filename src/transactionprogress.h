@@ -0,0 +1,106 @@
+/*
+* This file is part of Octopi, an open-source GUI for pacman.
+* Copyright (C) 2014 Thomas Binkau
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*
+*/
+
+#ifndef OCTOPI_TRANSACTIONPROGRESS_H
+#define OCTOPI_TRANSACTIONPROGRESS_H
+
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QString>
+
+#include "outputparser.h"
+
+
+/**
+ * @brief Timeline of a running pacman transaction, built from the OutputParser events
+ *
+ * pacman works through one thing at a time, so every event either updates the running step or
+ * ends it and starts the next one: a download (file or db), a check ("checking package integrity"),
+ * the install/upgrade/removal of a package or a hook. Each step gets its start and end time,
+ * downloads also their size. The finished steps and the part of a running download which is
+ * done give the rates the remaining time is estimated from, and the whole timeline can be
+ * exported as JSON.
+ */
+class TransactionProgress
+{
+public:
+  enum EPhase {
+    ectn_DOWNLOAD,
+    ectn_CHECK,
+    ectn_INSTALL,
+    ectn_HOOK,
+    ectn_PHASE_COUNT
+  };
+
+  struct Step {
+    EPhase  phase;
+    QString name;     // package, file or db, check or hook
+    qint64  startMs;  // since the start of the transaction
+    qint64  endMs;    // -1 while running
+    double  bytes;    // downloads only, 0 if unknown
+    int     current;  // "(current/total)" of the step's line, 0 without one
+    int     total;
+    int     percent;  // of the last progress bar drawn, -1 without one
+  };
+
+public:
+  TransactionProgress();
+
+  /**
+   * @param expectedTargets, expectedDownloadKiB = what the resolver predicted, 0 if unknown
+   */
+  void start(int expectedTargets, double expectedDownloadKiB);
+  void addEvent(const OutputParser::Event& event);
+  void finish(bool success);
+
+  inline bool isRunning() const {
+    return m_running;
+  }
+  inline const QList<Step>& getSteps() const {
+    return m_steps;
+  }
+  QString getCurrentStepText() const;
+  qint64 getPhaseDuration(EPhase phase) const; // ms
+  int getEstimatedSecondsLeft() const; // -1 if there's nothing to estimate from yet
+
+  QString toJson() const;
+
+  static QString getPhaseName(EPhase phase);
+
+private:
+  void beginStep(EPhase phase, const QString& name, const OutputParser::Event& event);
+  void endStep();
+  static double parseSize(const QString& downloadLine);
+
+private:
+  QDateTime     m_startTime;
+  QElapsedTimer m_timer;
+  QList<Step>   m_steps;
+  bool          m_running;
+  bool          m_success;
+  bool          m_inHooks;
+  int           m_expectedTargets;
+  double        m_expectedDownloadBytes;
+  int           m_installTotal; // from the "(n/total)" of the install lines
+};
+
+#endif // OCTOPI_TRANSACTIONPROGRESS_H
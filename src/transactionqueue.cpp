@@ -0,0 +1,153 @@
+/*
+* This file is part of Octopi, an open-source GUI for pacman.
+* Copyright (C) 2014 Thomas Binkau
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*
+*/
+
+#include "transactionqueue.h"
+
+#include <algorithm>
+#include <functional>
+#include <vector>
+#include <QSet>
+#include <QStandardItemModel>
+
+#include "uihelper.h"
+
+
+TransactionQueue::TransactionQueue(QStandardItemModel* model)
+  : QObject(model), m_model(model)
+{
+  connect(m_model, SIGNAL(rowsInserted(QModelIndex,int,int)),
+          this, SLOT(onRowsInserted(QModelIndex,int,int)));
+  connect(m_model, SIGNAL(rowsAboutToBeRemoved(QModelIndex,int,int)),
+          this, SLOT(onRowsAboutToBeRemoved(QModelIndex,int,int)));
+}
+
+bool TransactionQueue::contains(EQueue queue, const QString& pkgName) const
+{
+  return m_index[queue].contains(keyOf(pkgName));
+}
+
+int TransactionQueue::count(EQueue queue) const
+{
+  return getParentItem(queue)->rowCount();
+}
+
+QStringList TransactionQueue::getPackages(EQueue queue) const
+{
+  QStandardItem*const parent = getParentItem(queue);
+  QStringList result;
+  for (int row = 0; row < parent->rowCount(); ++row) result.append(parent->child(row)->text());
+  return result;
+}
+
+QStandardItem* TransactionQueue::getParentItem(EQueue queue) const
+{
+  return m_model->item(queue, 0);
+}
+
+void TransactionQueue::insert(EQueue queue, const QStringList& pkgNames)
+{
+  const EQueue other = queue == ectn_INSTALL_QUEUE ? ectn_REMOVE_QUEUE : ectn_INSTALL_QUEUE;
+  const QIcon icon = queue == ectn_INSTALL_QUEUE ? IconHelper::getIconInstallItem() : IconHelper::getIconRemoveItem();
+
+  QList<QStandardItem*> items;
+  QStringList           moved;
+  QSet<QString>         batch;
+  for (QStringList::const_iterator it = pkgNames.begin(); it != pkgNames.end(); ++it) {
+    const QString key = keyOf(*it);
+    if (m_index[queue].contains(key) || batch.contains(key)) continue;
+    batch.insert(key);
+
+    if (m_index[other].contains(key)) moved.append(key);
+    // the remove queue doesn't show repositories
+    items.append(new QStandardItem(icon, queue == ectn_INSTALL_QUEUE ? *it : key));
+  }
+
+  if (!moved.isEmpty()) take(other, moved);
+  if (!items.isEmpty()) getParentItem(queue)->appendRows(items);
+}
+
+void TransactionQueue::clear(EQueue queue)
+{
+  QStandardItem*const parent = getParentItem(queue);
+  parent->removeRows(0, parent->rowCount());
+}
+
+void TransactionQueue::onRowsInserted(const QModelIndex& parent, int first, int last)
+{
+  const int queue = queueOf(parent);
+  if (queue == -1) return;
+
+  QStandardItem*const parentItem = getParentItem(static_cast<EQueue>(queue));
+  for (int row = first; row <= last; ++row) {
+    QStandardItem*const item = parentItem->child(row);
+    m_index[queue].insert(keyOf(item->text()), item);
+  }
+}
+
+void TransactionQueue::onRowsAboutToBeRemoved(const QModelIndex& parent, int first, int last)
+{
+  const int queue = queueOf(parent);
+  if (queue == -1) return;
+
+  QStandardItem*const parentItem = getParentItem(static_cast<EQueue>(queue));
+  for (int row = first; row <= last; ++row) {
+    m_index[queue].remove(keyOf(parentItem->child(row)->text()));
+  }
+}
+
+/**
+ * @brief "repo/name" -> "name"
+ */
+QString TransactionQueue::keyOf(const QString& itemText)
+{
+  return itemText.mid(itemText.indexOf('/') + 1);
+}
+
+/**
+ * @brief the queue whose parent item is %parent, -1 for anything else
+ */
+int TransactionQueue::queueOf(const QModelIndex& parent) const
+{
+  if (!parent.isValid() || parent.parent().isValid() || parent.column() != 0) return -1;
+  if (parent.row() == ectn_REMOVE_QUEUE || parent.row() == ectn_INSTALL_QUEUE) return parent.row();
+  return -1;
+}
+
+/**
+ * @brief removes the rows of the given keys, bottom up so the remaining row numbers stay valid
+ */
+void TransactionQueue::take(EQueue queue, const QStringList& keys)
+{
+  std::vector<int> rows;
+  rows.reserve(keys.size());
+  for (QStringList::const_iterator it = keys.begin(); it != keys.end(); ++it) {
+    rows.push_back(m_index[queue].value(*it)->row());
+  }
+  std::sort(rows.begin(), rows.end(), std::greater<int>());
+
+  // adjacent rows go in one call
+  QStandardItem*const parent = getParentItem(queue);
+  for (std::size_t x = 0; x < rows.size(); ) {
+    std::size_t y = x;
+    while (y + 1 < rows.size() && rows[y + 1] == rows[y] - 1) ++y;
+    parent->removeRows(rows[y], static_cast<int>(y - x + 1));
+    x = y + 1;
+  }
+}
@@ -0,0 +1,83 @@
+/*
+* This file is part of Octopi, an open-source GUI for pacman.
+* Copyright (C) 2014 Thomas Binkau
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*
+*/
+
+#ifndef OCTOPI_TRANSACTIONQUEUE_H
+#define OCTOPI_TRANSACTIONQUEUE_H
+
+#include <QHash>
+#include <QModelIndex>
+#include <QObject>
+#include <QStringList>
+
+class QStandardItem;
+class QStandardItemModel;
+
+
+/**
+ * @brief The remove and install queues shown in tvTransaction
+ *
+ * The QStandardItemModel stays the view model: one parent item per queue, one child item per
+ * package ("repo/name" for installs, "name" for removals, or a group name). Next to it every
+ * queue keeps a hash from package name to child item, so membership tests don't have to
+ * search the model. The hashes follow the model's signals, which keeps them right when
+ * the view removes rows on its own (DEL key).
+ */
+class TransactionQueue : public QObject
+{
+  Q_OBJECT
+
+public:
+  enum EQueue {
+    ectn_REMOVE_QUEUE = 0,
+    ectn_INSTALL_QUEUE = 1
+  };
+
+public:
+  /**
+   * @brief %model must already hold the remove parent in row 0 and the install parent in row 1
+   */
+  explicit TransactionQueue(QStandardItemModel* model);
+
+  bool contains(EQueue queue, const QString& pkgName) const;
+  int count(EQueue queue) const;
+  QStringList getPackages(EQueue queue) const; // item texts in queue order
+  QStandardItem* getParentItem(EQueue queue) const;
+
+  /**
+   * @brief appends the packages not queued yet (taking them out of the other queue) with one row insertion
+   */
+  void insert(EQueue queue, const QStringList& pkgNames);
+  void clear(EQueue queue);
+
+private slots:
+  void onRowsInserted(const QModelIndex& parent, int first, int last);
+  void onRowsAboutToBeRemoved(const QModelIndex& parent, int first, int last);
+
+private:
+  static QString keyOf(const QString& itemText);
+  int queueOf(const QModelIndex& parent) const;
+  void take(EQueue queue, const QStringList& keys);
+
+private:
+  QStandardItemModel*             m_model;
+  QHash<QString, QStandardItem*>  m_index[2]; // package name -> child item, per queue
+};
+
+#endif // OCTOPI_TRANSACTIONQUEUE_H
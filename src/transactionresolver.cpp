@@ -0,0 +1,338 @@
+/*
+* This file is part of Octopi, an open-source GUI for pacman.
+* Copyright (C) 2014 Thomas Binkau
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*
+*/
+
+#include "transactionresolver.h"
+
+#include "package.h"
+
+
+namespace {
+
+bool lessByName(const TransactionResolver::Target& a, const TransactionResolver::Target& b)
+{
+  return a.name < b.name;
+}
+
+/*
+ * True if one of %provides satisfies %constraint; versioned dependencies need a versioned provision
+ */
+bool providesConstraint(const QStringList& provides, const DependencyGraph::Constraint& constraint)
+{
+  for (QStringList::const_iterator it = provides.begin(); it != provides.end(); ++it) {
+    const DependencyGraph::Constraint provision = DependencyGraph::parseConstraint(*it);
+    if (provision.name != constraint.name) continue;
+    if (constraint.op == DependencyGraph::ectn_ANY) return true;
+    if (provision.op == DependencyGraph::ectn_EQUAL && constraint.isSatisfiedBy(provision.version)) return true;
+  }
+  return false;
+}
+
+} // namespace
+
+
+TransactionResolver::TransactionResolver(const DependencyGraph& graph, const QStringList& targets,
+                                         const QStringList& ignoredPackages, const QStringList& removedPackages)
+  : m_graph(graph), m_queued(graph.getNodeCount(), false), m_replaced(graph.getNodeCount(), false),
+    m_removed(graph.getNodeCount(), false), m_systemUpgrade(targets.isEmpty()), m_downloadSize(0),
+    m_installedSizeDelta(0)
+{
+  addRemovals(removedPackages);
+
+  if (m_systemUpgrade) {
+    addReplacements(ignoredPackages);
+    addUpgrades(ignoredPackages);
+  }
+  else {
+    for (QStringList::const_iterator it = targets.begin(); it != targets.end(); ++it) addTarget(*it);
+  }
+
+  addDependencies();
+  findConflicts();
+
+  qSort(m_targets.begin(), m_targets.end(), lessByName);
+}
+
+/**
+ * @brief marks the installed packages of %removedPackages ("name", "repo/name" or a group) as leaving
+ */
+void TransactionResolver::addRemovals(const QStringList& removedPackages)
+{
+  for (QStringList::const_iterator it = removedPackages.begin(); it != removedPackages.end(); ++it) {
+    const QString name = it->mid(it->indexOf('/') + 1);
+    const int node = m_graph.findNode(name);
+    // like "pacman -R", a group only counts if there is no installed package with that name
+    const QList<int> nodes = (node != -1 && m_graph.isInstalled(node)) ?
+          QList<int>() << node : m_graph.findInstalledGroupMembers(name);
+
+    for (QList<int>::const_iterator itNode = nodes.begin(); itNode != nodes.end(); ++itNode) {
+      if (m_removed[*itNode]) continue;
+
+      m_removed[*itNode] = true;
+      m_removedPackages.append(m_graph.getName(*itNode));
+    }
+  }
+  m_removedPackages.sort();
+}
+
+/**
+ * @brief installed packages named in the "Replaces" of a sync package are replaced by it (pacman -Su does so first)
+ */
+void TransactionResolver::addReplacements(const QStringList& ignoredPackages)
+{
+  const int nodeCount = m_graph.getNodeCount();
+  for (int node = 0; node < nodeCount; ++node) {
+    if (m_graph.isInstalled(node) || Package::isIgnoredPackage(m_graph.getName(node), ignoredPackages)) continue;
+
+    const QStringList replaces = m_graph.getReplaces(node);
+    for (QStringList::const_iterator it = replaces.begin(); it != replaces.end(); ++it) {
+      const DependencyGraph::Constraint constraint = DependencyGraph::parseConstraint(*it);
+      const int replaced = m_graph.findNode(constraint.name);
+      if (replaced == -1 || !m_graph.isInstalled(replaced) || m_replaced[replaced] || m_removed[replaced]) continue;
+      if (!constraint.isSatisfiedBy(m_graph.getVersion(replaced))) continue;
+      if (Package::isIgnoredPackage(m_graph.getName(replaced), ignoredPackages)) continue;
+
+      m_replaced[replaced] = true;
+      m_installedSizeDelta -= m_graph.getInstalledSize(replaced);
+
+      Replacement replacement;
+      replacement.replaced   = m_graph.getName(replaced);
+      replacement.replacedBy = m_graph.getName(node);
+      m_replacements.append(replacement);
+
+      addNode(node, false);
+    }
+  }
+}
+
+void TransactionResolver::addUpgrades(const QStringList& ignoredPackages)
+{
+  const int nodeCount = m_graph.getNodeCount();
+  for (int node = 0; node < nodeCount; ++node) {
+    if (!m_graph.isInstalled(node) || m_replaced[node] || m_removed[node] ||
+        m_graph.getSyncVersion(node).isEmpty()) continue;
+    if (Package::vercmp(m_graph.getVersion(node), m_graph.getSyncVersion(node)) >= 0) continue;
+    if (Package::isIgnoredPackage(m_graph.getName(node), ignoredPackages)) continue;
+
+    addNode(node, false);
+  }
+}
+
+/**
+ * @brief resolves one install target: "name", "repo/name", something provided by a sync package or a group
+ */
+void TransactionResolver::addTarget(const QString& target)
+{
+  const int slash = target.indexOf('/');
+  const QString name = target.mid(slash + 1);
+
+  int node = m_graph.findNode(name);
+  if (node == -1 || m_graph.getSyncVersion(node).isEmpty()) {
+    node = findCandidate(DependencyGraph::parseConstraint(name));
+  }
+
+  if (node != -1) {
+    addNode(node, false);
+    return;
+  }
+
+  // pacman only looks for a group if no package is called (or provides) %name, then installs all members
+  const QString repository = slash != -1 ? target.left(slash) : QString();
+  bool found = false;
+  const QList<int> members = m_graph.findGroupMembers(name);
+  for (QList<int>::const_iterator it = members.begin(); it != members.end(); ++it) {
+    if (!repository.isEmpty() && m_graph.getRepository(*it) != repository) continue;
+
+    addNode(*it, false);
+    found = true;
+  }
+
+  if (!found) {
+    Unresolved unresolved;
+    unresolved.dependency = target;
+    m_unresolved.append(unresolved);
+  }
+}
+
+void TransactionResolver::addNode(int node, bool isDependency)
+{
+  if (m_queued[node]) return;
+  m_queued[node] = true;
+  m_queue.push_back(node);
+
+  // what the package brings in is what its sync version provides, not the installed one
+  m_incoming.insertMulti(m_graph.getName(node), node);
+  const QStringList provides = m_graph.getSyncProvides(node);
+  for (QStringList::const_iterator it = provides.begin(); it != provides.end(); ++it) {
+    m_incoming.insertMulti(DependencyGraph::parseConstraint(*it).name, node);
+  }
+
+  Target target;
+  target.name               = m_graph.getName(node);
+  target.version            = m_graph.getSyncVersion(node);
+  target.oldVersion         = m_graph.isInstalled(node) ? m_graph.getVersion(node) : QString();
+  target.repository         = m_graph.getRepository(node);
+  target.downloadSize       = m_graph.getDownloadSize(node);
+  target.installedSizeDelta = m_graph.getSyncInstalledSize(node) - m_graph.getInstalledSize(node);
+  target.isDependency       = isDependency;
+  m_targets.append(target);
+
+  m_downloadSize       += target.downloadSize;
+  m_installedSizeDelta += target.installedSizeDelta;
+}
+
+/**
+ * @brief BFS over the dependencies of the sync versions of everything in the transaction
+ */
+void TransactionResolver::addDependencies()
+{
+  for (std::size_t x = 0; x < m_queue.size(); ++x) {
+    const int node = m_queue[x];
+    const QStringList depends = m_graph.getSyncDepends(node);
+
+    for (QStringList::const_iterator it = depends.begin(); it != depends.end(); ++it) {
+      const DependencyGraph::Constraint constraint = DependencyGraph::parseConstraint(*it);
+      if (isSatisfied(constraint)) continue;
+
+      const int candidate = findCandidate(constraint);
+      if (candidate != -1) {
+        addNode(candidate, true);
+      }
+      else {
+        Unresolved unresolved;
+        unresolved.dependency = *it;
+        unresolved.requiredBy = m_graph.getName(node);
+        m_unresolved.append(unresolved);
+      }
+    }
+  }
+}
+
+/**
+ * @brief checks the conflicts of the targets and the conflicts of the installed packages against the targets
+ */
+void TransactionResolver::findConflicts()
+{
+  for (std::vector<int>::const_iterator it = m_queue.begin(); it != m_queue.end(); ++it) {
+    const QStringList conflicts = m_graph.getSyncConflicts(*it);
+    for (QStringList::const_iterator itConf = conflicts.begin(); itConf != conflicts.end(); ++itConf) {
+      const DependencyGraph::Constraint constraint = DependencyGraph::parseConstraint(*itConf);
+
+      const int byName = m_graph.findNode(constraint.name);
+      if (byName != -1 && byName != *it) {
+        if ((m_queued[byName] && constraint.isSatisfiedBy(m_graph.getSyncVersion(byName))) ||
+            (isStaying(byName) && constraint.isSatisfiedBy(m_graph.getVersion(byName)))) {
+          addConflict(*it, byName);
+        }
+      }
+
+      // versioned conflicts are only checked against real package versions
+      if (constraint.op != DependencyGraph::ectn_ANY) continue;
+      // the provider index holds the installed provisions, so targets are looked up in m_incoming
+      const QList<int> providers = m_graph.findProviders(constraint.name);
+      for (QList<int>::const_iterator itProv = providers.begin(); itProv != providers.end(); ++itProv) {
+        if (*itProv != *it && isStaying(*itProv)) addConflict(*it, *itProv);
+      }
+      const QList<int> targets = m_incoming.values(constraint.name);
+      for (QList<int>::const_iterator itTarget = targets.begin(); itTarget != targets.end(); ++itTarget) {
+        if (*itTarget != *it) addConflict(*it, *itTarget);
+      }
+    }
+  }
+
+  const int nodeCount = m_graph.getNodeCount();
+  for (int node = 0; node < nodeCount; ++node) {
+    if (!isStaying(node)) continue;
+
+    const QStringList conflicts = m_graph.getConflicts(node);
+    for (QStringList::const_iterator itConf = conflicts.begin(); itConf != conflicts.end(); ++itConf) {
+      const DependencyGraph::Constraint constraint = DependencyGraph::parseConstraint(*itConf);
+      const QList<int> targets = m_incoming.values(constraint.name);
+      for (QList<int>::const_iterator itTarget = targets.begin(); itTarget != targets.end(); ++itTarget) {
+        const bool byName = m_graph.getName(*itTarget) == constraint.name;
+        if (constraint.op == DependencyGraph::ectn_ANY ||
+            (byName && constraint.isSatisfiedBy(m_graph.getSyncVersion(*itTarget)))) {
+          addConflict(*itTarget, node);
+        }
+      }
+    }
+  }
+}
+
+void TransactionResolver::addConflict(int node, int other)
+{
+  // "a conflicts with b" and "b conflicts with a" are the same conflict; node ids map 1:1 to names
+  const QPair<int, int> key = node < other ? qMakePair(node, other) : qMakePair(other, node);
+  if (m_conflictKeys.contains(key)) return;
+  m_conflictKeys.insert(key);
+
+  Conflict conflict;
+  conflict.package       = m_graph.getName(node);
+  conflict.conflictsWith = m_graph.getName(other);
+  m_conflicts.append(conflict);
+}
+
+/**
+ * @brief true for installed packages which are neither upgraded, replaced nor removed
+ */
+bool TransactionResolver::isStaying(int node) const
+{
+  return m_graph.isInstalled(node) && !m_queued[node] && !m_replaced[node] && !m_removed[node];
+}
+
+/**
+ * @brief true if a package which stays installed or one in the transaction satisfies %constraint
+ */
+bool TransactionResolver::isSatisfied(const DependencyGraph::Constraint& constraint) const
+{
+  const int byName = m_graph.findNode(constraint.name);
+  if (byName != -1) {
+    if (m_queued[byName] && constraint.isSatisfiedBy(m_graph.getSyncVersion(byName))) return true;
+    if (isStaying(byName) && constraint.isSatisfiedBy(m_graph.getVersion(byName))) return true;
+  }
+
+  const QList<int> providers = m_graph.findProviders(constraint.name);
+  for (QList<int>::const_iterator it = providers.begin(); it != providers.end(); ++it) {
+    if (isStaying(*it) && providesConstraint(m_graph.getProvides(*it), constraint)) return true;
+  }
+
+  // packages in the transaction count with their sync provides, which may differ from the installed ones
+  const QList<int> targets = m_incoming.values(constraint.name);
+  for (QList<int>::const_iterator it = targets.begin(); it != targets.end(); ++it) {
+    if (providesConstraint(m_graph.getSyncProvides(*it), constraint)) return true;
+  }
+  return false;
+}
+
+/**
+ * @brief returns the sync package to pull in for %constraint or -1
+ *
+ * The package with the exact name is taken if its sync version fits, otherwise whatever
+ * DependencyGraph::resolve picks among the providers.
+ */
+int TransactionResolver::findCandidate(const DependencyGraph::Constraint& constraint) const
+{
+  const int byName = m_graph.findNode(constraint.name);
+  if (byName != -1 && !m_graph.getSyncVersion(byName).isEmpty() &&
+      constraint.isSatisfiedBy(m_graph.getSyncVersion(byName))) return byName;
+
+  const int provider = m_graph.resolve(constraint);
+  if (provider != -1 && !m_graph.getSyncVersion(provider).isEmpty()) return provider;
+  return -1;
+}
@@ -0,0 +1,148 @@
+/*
+* This file is part of Octopi, an open-source GUI for pacman.
+* Copyright (C) 2014 Thomas Binkau
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*
+*/
+
+#ifndef OCTOPI_TRANSACTIONRESOLVER_H
+#define OCTOPI_TRANSACTIONRESOLVER_H
+
+#include <vector>
+#include <QHash>
+#include <QList>
+#include <QPair>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+
+#include "dependencygraph.h"
+
+
+/**
+ * @brief Dry run of "pacman -S <targets>" or "pacman -Su" on the DependencyGraph
+ *
+ * Replaces parsing "pacman -Sp/-Spu --print-format" output:
+ * - system upgrade: replacements of installed packages first, then every installed package
+ *   with a newer sync version which is not in IgnorePkg
+ * - install: the given targets ("repo/name", provides and groups are accepted, too)
+ * Installed packages removed by the same transaction ("pacman -R ...; pacman -S ...") neither
+ * satisfy dependencies nor conflict with the targets.
+ * Then the dependencies of the sync versions are pulled in breadth first (a dependency is
+ * satisfied by installed packages which stay or by the sync versions of packages already in the transaction) and
+ * conflicts are checked in both directions, between the targets and against the installed packages.
+ * All results are copied out of the graph, so they stay valid when the graph is replaced.
+ */
+class TransactionResolver
+{
+public:
+  struct Target {
+    QString name;
+    QString version;
+    QString oldVersion;         // installed version, empty for new packages
+    QString repository;
+    double  downloadSize;       // KiB
+    double  installedSizeDelta; // KiB, negative if the package shrinks
+    bool    isDependency;       // pulled in by another target
+  };
+
+  struct Replacement {
+    QString replaced;   // installed package
+    QString replacedBy; // sync package declaring "Replaces"
+  };
+
+  struct Conflict {
+    QString package;
+    QString conflictsWith;
+  };
+
+  struct Unresolved {
+    QString dependency;
+    QString requiredBy; // empty for targets which aren't in any sync db
+  };
+
+public:
+  /**
+   * @param targets = package names to install, an empty list resolves a system upgrade
+   * @param ignoredPackages = IgnorePkg entries, only used for system upgrades
+   * @param removedPackages = packages removed before the targets get installed
+   */
+  TransactionResolver(const DependencyGraph& graph, const QStringList& targets, const QStringList& ignoredPackages,
+                      const QStringList& removedPackages = QStringList());
+
+  inline bool isSystemUpgrade() const {
+    return m_systemUpgrade;
+  }
+  // sorted by name
+  inline const QList<Target>& getTargets() const {
+    return m_targets;
+  }
+  inline const QList<Replacement>& getReplacements() const {
+    return m_replacements;
+  }
+  inline const QList<Conflict>& getConflicts() const {
+    return m_conflicts;
+  }
+  inline const QList<Unresolved>& getUnresolved() const {
+    return m_unresolved;
+  }
+  // the installed packages of removedPackages, sorted by name
+  inline const QStringList& getRemovedPackages() const {
+    return m_removedPackages;
+  }
+  // in KiB
+  inline double getDownloadSize() const {
+    return m_downloadSize;
+  }
+  // in KiB, including the removal of replaced packages
+  inline double getInstalledSizeDelta() const {
+    return m_installedSizeDelta;
+  }
+
+private:
+  void addRemovals(const QStringList& removedPackages);
+  void addReplacements(const QStringList& ignoredPackages);
+  void addUpgrades(const QStringList& ignoredPackages);
+  void addTarget(const QString& target);
+  void addNode(int node, bool isDependency);
+  void addDependencies();
+  void findConflicts();
+  void addConflict(int node, int other);
+
+  bool isStaying(int node) const;
+  bool isSatisfied(const DependencyGraph::Constraint& constraint) const;
+  int  findCandidate(const DependencyGraph::Constraint& constraint) const;
+
+private:
+  const DependencyGraph& m_graph;     // only used while resolving
+  std::vector<bool>      m_queued;    // one bit per graph node
+  std::vector<bool>      m_replaced;  // one bit per graph node
+  std::vector<bool>      m_removed;   // one bit per graph node
+  std::vector<int>       m_queue;     // nodes in the transaction, in the order they were added
+  QHash<QString, int>    m_incoming;  // names and sync provisions of the queued nodes
+  bool                   m_systemUpgrade;
+
+  QList<Target>          m_targets;
+  QList<Replacement>     m_replacements;
+  QList<Conflict>        m_conflicts;
+  QSet<QPair<int, int> > m_conflictKeys; // (smaller node, bigger node) of m_conflicts
+  QList<Unresolved>      m_unresolved;
+  QStringList            m_removedPackages;
+  double                 m_downloadSize;
+  double                 m_installedSizeDelta;
+};
+
+#endif // OCTOPI_TRANSACTIONRESOLVER_H
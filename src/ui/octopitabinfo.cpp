@@ -20,9 +20,42 @@
 
 #include "octopitabinfo.h"
 
+#include "src/dependencygraph.h"
 #include "src/strconstants.h"
 
 
+namespace {
+
+/**
+ * @brief marks every optional dependency of the "Optional Deps" field an installed package satisfies
+ *
+ * Lines read "dependency: description", pacman's own "[installed]" marks are replaced,
+ * as pacman doesn't know about provides there.
+ */
+QString markInstalledOptDepends(const QString& optDepends, const PackageRepository& repository)
+{
+  QStringList lines = optDepends.split("<br>");
+  for (QStringList::iterator it = lines.begin(); it != lines.end(); ++it) {
+    it->remove(" [installed]");
+
+    const int separator = it->indexOf(": ");
+    const QString dependency = (separator == -1 ? *it : it->left(separator)).trimmed();
+    if (dependency.isEmpty()) continue;
+
+    const QString provider = repository.getInstalledProvider(dependency);
+    if (provider.isEmpty()) continue;
+
+    if (provider == DependencyGraph::parseConstraint(dependency).name)
+      it->append(StrConstants::getOptDepInstalled());
+    else
+      it->append(StrConstants::getOptDepProvidedBy().arg(provider));
+  }
+  return lines.join("<br>");
+}
+
+} // namespace
+
+
 /**
  * @brief OctopiTabInfo::anchorBegin for navigation
  */
@@ -37,17 +70,18 @@ OctopiTabInfo::OctopiTabInfo()
  * This function has been extracted from src/mainwindow_refresh.cpp void MainWindow::refreshTabInfo(QString pkgName)
  */
 QString OctopiTabInfo::formatTabInfo(const PackageRepository::PackageData& package,
-                                     const QHash<QString, QString>& outdatedYaourtPackagesNameVersion)
+                                     const QHash<QString, QString>& outdatedYaourtPackagesNameVersion,
+                                     const PackageRepository& repository)
 {
   PackageInfoData pid;
 
-  if (package.repository != StrConstants::getForeignRepositoryName() &&
+  if (package.getRepository() != StrConstants::getForeignRepositoryName() &&
       package.installed() == false) {
-    pid = Package::getInformation(package.name);
+    pid = Package::getInformation(package.getName());
   }
   else
   {
-    pid = Package::getInformation(package.name, true); //This is a foreign package!!!
+    pid = Package::getInformation(package.getName(), true); //This is a foreign package!!!
   }
 
   //Let's put package description in UTF-8 format
@@ -81,7 +115,7 @@ QString OctopiTabInfo::formatTabInfo(const PackageRepository::PackageData& packa
   html += "<meta http-equiv=\"Content-Type\" content=\"text/html; charset=utf-8\">";
   html += "<a id=\"" + anchorBegin + "\"></a>";
 
-  html += "<h2>" + package.name + "</h2>";
+  html += "<h2>" + package.getName() + "</h2>";
   html += "<a style=\"font-size:16px;\">" + pkgDescription + "</a>";
 
   html += "<table border=\"0\">";
@@ -91,43 +125,43 @@ QString OctopiTabInfo::formatTabInfo(const PackageRepository::PackageData& packa
 
   if (package.outdated())
   {
-    if (package.status != ectn_NEWER)
+    if (package.getStatus() != ectn_NEWER)
     {
-      if (package.repository != StrConstants::getForeignRepositoryName())
+      if (package.getRepository() != StrConstants::getForeignRepositoryName())
       {
-        QString outdatedVersion = package.outdatedVersion;
-        html += "<tr><td>" + version + "</td><td>" + package.version + " <b><font color=\"#E55451\">"
+        QString outdatedVersion = package.getOutdatedVersion();
+        html += "<tr><td>" + version + "</td><td>" + package.getVersion() + " <b><font color=\"#E55451\">"
             + StrConstants::getOutdatedInstalledVersion().arg(outdatedVersion) +
             "</b></font></td></tr>";
       }
     }
     else
     {
-      QString newerVersion = package.outdatedVersion;
-      html += "<tr><td>" + version + "</td><td>" + package.version + " <b><font color=\"#FF8040\">"
+      QString newerVersion = package.getOutdatedVersion();
+      html += "<tr><td>" + version + "</td><td>" + package.getVersion() + " <b><font color=\"#FF8040\">"
           + StrConstants::getNewerInstalledVersion().arg(newerVersion) +
           "</b></font></td></tr>";
     }
   }
   else
   {
-    if (package.repository != StrConstants::getForeignRepositoryName())
+    if (package.getRepository() != StrConstants::getForeignRepositoryName())
     {
-      html += "<tr><td>" + version + "</td><td>" + package.version + "</td></tr>";
+      html += "<tr><td>" + version + "</td><td>" + package.getVersion() + "</td></tr>";
     }
     else
     {
-      if (package.status == ectn_FOREIGN_OUTDATED &&
+      if (package.getStatus() == ectn_FOREIGN_OUTDATED &&
           outdatedYaourtPackagesNameVersion.count() > 0)
       {
-        QString availableVersion = outdatedYaourtPackagesNameVersion.value(package.name);
+        QString availableVersion = outdatedYaourtPackagesNameVersion.value(package.getName());
         html += "<tr><td>" + version + "</td><td>" + availableVersion + " <b><font color=\"#E55451\">"
-            + StrConstants::getOutdatedInstalledVersion().arg(package.version) +
+            + StrConstants::getOutdatedInstalledVersion().arg(package.getVersion()) +
             "</b></font></td></tr>";
       }
       else
       {
-        html += "<tr><td>" + version + "</td><td>" + package.version + "</td></tr>";
+        html += "<tr><td>" + version + "</td><td>" + package.getVersion() + "</td></tr>";
       }
     }
   }
@@ -153,7 +187,7 @@ QString OctopiTabInfo::formatTabInfo(const PackageRepository::PackageData& packa
   if(! pid.dependsOn.contains("None"))
     html += "<tr><td>" + dependsOn + "</td><td>" + pid.dependsOn + "</td></tr>";
   if(! pid.optDepends.contains("None"))
-    html += "<tr><td>" + optionalDeps + "</td><td>" + pid.optDepends + "</td></tr>";
+    html += "<tr><td>" + optionalDeps + "</td><td>" + markInstalledOptDepends(pid.optDepends, repository) + "</td></tr>";
   if(!pid.requiredBy.isEmpty() && !pid.requiredBy.contains("None"))
     html += "<tr><td>" + requiredBy + "</td><td>" + pid.requiredBy + "</td></tr>";
   if(!pid.optionalFor.isEmpty() && !pid.optionalFor.contains("None"))
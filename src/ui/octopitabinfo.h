@@ -53,11 +53,14 @@ public:
    * @brief formats TabInfo as HTML
    * @param package (the package to show details for)
    * @param outdatedYaourtPackagesNameVersion
+   * @param repository (marks the optional deps its installed packages satisfy)
    * @return html
    *
    * This function has been extracted from src/mainwindow_refresh.cpp void MainWindow::refreshTabInfo(QString pkgName)
    */
-  static QString formatTabInfo(const PackageRepository::PackageData& package, const QHash<QString, QString>& outdatedYaourtPackagesNameVersion);
+  static QString formatTabInfo(const PackageRepository::PackageData& package,
+                               const QHash<QString, QString>& outdatedYaourtPackagesNameVersion,
+                               const PackageRepository& repository);
 
   static const QString anchorBegin;
 };
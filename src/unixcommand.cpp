@@ -176,6 +176,34 @@ QByteArray UnixCommand::performQuery(const QString &args)
   return result;
 }
 
+/*
+ * Performs a pacman query which may run for a long time (no 30 secs timeout)
+ * exitCode is set to pacman's exit code, or to -1 if it could not be started or crashed,
+ * so callers can tell a complete output from a truncated one
+ */
+QByteArray UnixCommand::performLongQuery(const QStringList &args, int *exitCode)
+{
+  QByteArray result("");
+  QProcess pacman;
+
+  QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
+  env.insert("LANG", "C");
+  env.insert("LC_MESSAGES", "C");
+  env.insert("LC_ALL", "C");
+  pacman.setProcessEnvironment(env);
+
+  pacman.start("pacman", args);
+  if (pacman.waitForFinished(-1) && pacman.exitStatus() == QProcess::NormalExit)
+    *exitCode = pacman.exitCode();
+  else
+    *exitCode = -1;
+
+  result = pacman.readAllStandardOutput();
+  pacman.close();
+
+  return result;
+}
+
 /*
  * Performs a yourt command
  */
@@ -236,11 +264,28 @@ QByteArray UnixCommand::getExplicitlyInstalledPackageList()
 }
 
 /*
- * Returns a string containing all packages that are outdated since last DB sync
+ * Returns a string containing name, version and installed state of all sync packages
+ * (ex: "core acl 2.2.52-2 [installed: 2.2.51-1]")
+ */
+QByteArray UnixCommand::getSyncPackageVersionList()
+{
+  return performQuery(QStringList("-Sl"));
+}
+
+/*
+ * Same as above, for the packages of one repository only
  */
-QByteArray UnixCommand::getOutdatedPackageList()
+QByteArray UnixCommand::getSyncPackageVersionList(const QString &repository)
 {
-  return performQuery(QStringList("-Qu"));
+  return performQuery(QStringList() << "-Sl" << repository);
+}
+
+/*
+ * Returns a string containing name and version of all installed packages (ex: "acl 2.2.52-2")
+ */
+QByteArray UnixCommand::getInstalledPackageVersionList()
+{
+  return performQuery(QStringList("-Q"));
 }
 
 /*
@@ -292,6 +337,19 @@ QByteArray UnixCommand::getPackageInformation(const QString &pkgName, bool forei
   return result;
 }
 
+/*
+ * Returns the information fields of all installed (foreignPackage) or all sync packages
+ * "pacman -Si" may easily run longer than performQuery() waits, so there is no timeout here
+ * ok is false if pacman did not finish successfully, as the output is incomplete then
+ */
+QByteArray UnixCommand::getAllPackageInformation(bool foreignPackage, bool *ok)
+{
+  int exitCode;
+  QByteArray res = performLongQuery(QStringList(foreignPackage ? "-Qi" : "-Si"), &exitCode);
+  *ok = (exitCode == 0);
+  return res;
+}
+
 /*
  * Given an Yaourt package name, returns a string containing all of its information fields
  * (ex: name, description, version, dependsOn...)
@@ -315,6 +373,32 @@ QByteArray UnixCommand::getPackageContentsUsingPacman(const QString& pkgName)
   return res;
 }
 
+/*
+ * Returns a string with the files of all installed packages ("name /path" per line)
+ * ok is false if pacman did not finish successfully, as the list is incomplete then
+ */
+QByteArray UnixCommand::getInstalledFileList(bool *ok)
+{
+  int exitCode;
+  QByteArray res = performLongQuery(QStringList("-Ql"), &exitCode);
+  *ok = (exitCode == 0);
+  return res;
+}
+
+/*
+ * Returns a string with the files of the given sync packages ("name path" per line, paths
+ * without the leading slash), read from the sync .files dbs by one "pacman -Fl" run
+ * ok is false if pacman did not finish. Packages missing from the .files dbs only make pacman
+ * exit with 1 while the other ones are still listed, so that exit code is accepted.
+ */
+QByteArray UnixCommand::getSyncFileList(const QStringList &pkgNames, bool *ok)
+{
+  int exitCode;
+  QByteArray res = performLongQuery(QStringList("-Fl") << pkgNames, &exitCode);
+  *ok = (exitCode == 0 || exitCode == 1);
+  return res;
+}
+
 /*
  * Check if pkgfile is installed on the system
  */
@@ -992,6 +1076,32 @@ QStringList UnixCommand::getIgnorePkg()
   return res;
 }
 
+/*
+ * Reads the repository sections of "/etc/pacman.conf" (everything in brackets but "[options]")
+ */
+QStringList UnixCommand::getRepositoryList()
+{
+  QStringList res;
+  QFile file("/etc/pacman.conf");
+
+  if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+    return res;
+
+  QStringList lines = QString(file.readAll()).split("\n", QString::SkipEmptyParts);
+  foreach(QString line, lines)
+  {
+    line = line.trimmed();
+    if (line.startsWith('[') && line.endsWith(']'))
+    {
+      QString repository = line.mid(1, line.size()-2).trimmed();
+      if (repository != "options" && !res.contains(repository)) res.append(repository);
+    }
+  }
+
+  file.close();
+  return res;
+}
+
 /*
  * Retrieves the LinuxDistro where Octopi is running on!
  * Reads file "/etc/os-release" and searchs for compatible Octopi distros
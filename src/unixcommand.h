@@ -64,6 +64,9 @@ public:
   //Returns the list of ignored packages in "/etc/pacman.conf"
   static QStringList getIgnorePkg();
 
+  //Returns the repositories of "/etc/pacman.conf", in their order
+  static QStringList getRepositoryList();
+
   //Returns the Linux Distro where Octopi is running on
   static LinuxDistro getLinuxDistro();
 
@@ -76,18 +79,24 @@ public:
 
   static QByteArray performQuery(const QStringList args);
   static QByteArray performQuery(const QString &args);
+  static QByteArray performLongQuery(const QStringList &args, int *exitCode);
 
   static QByteArray performYaourtCommand(const QString &args);
   static QByteArray getYaourtPackageList(const QString &searchString);
   static QByteArray getUnrequiredPackageList();
   static QByteArray getExplicitlyInstalledPackageList();
-  static QByteArray getOutdatedPackageList();
+  static QByteArray getSyncPackageVersionList();
+  static QByteArray getSyncPackageVersionList(const QString &repository);
+  static QByteArray getInstalledPackageVersionList();
   static QByteArray getOutdatedYaourtPackageList();
   static QByteArray getForeignPackageList();
   static QByteArray getPackageList();
   static QByteArray getPackageInformation(const QString &pkgName, bool foreignPackage);
+  static QByteArray getAllPackageInformation(bool foreignPackage, bool *ok);
   static QByteArray getYaourtPackageVersionInformation();
   static QByteArray getPackageContentsUsingPacman(const QString &pkgName);
+  static QByteArray getInstalledFileList(bool *ok);
+  static QByteArray getSyncFileList(const QStringList &pkgNames, bool *ok);
   static bool isPkgfileInstalled();
   static QByteArray getPackageContentsUsingPkgfile(const QString &pkgName);
 
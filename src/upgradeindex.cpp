@@ -0,0 +1,206 @@
+/*
+* This file is part of Octopi, an open-source GUI for pacman.
+* Copyright (C) 2014 Thomas Binkau
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*
+*/
+
+#include "upgradeindex.h"
+
+#include <cstring>
+#include <unistd.h>
+#include <QFile>
+
+#include "package.h"
+
+
+struct UpgradeIndex::LessByName
+{
+  explicit LessByName(const char* pool) : m_pool(pool) {}
+
+  bool operator()(const TEntry& a, const TEntry& b) const {
+    return qstrcmp(m_pool + a.name, m_pool + b.name) < 0;
+  }
+
+  const char* m_pool;
+};
+
+
+UpgradeIndex::UpgradeIndex()
+  : m_hasInstalledPackages(false)
+{
+}
+
+void UpgradeIndex::setInstalledPackages(const QByteArray& list)
+{
+  // acl 2.2.52-2
+  parse(list, 0, m_installed);
+  m_hasInstalledPackages = true;
+}
+
+void UpgradeIndex::clearInstalledPackages()
+{
+  m_installed = TTable();
+  m_hasInstalledPackages = false;
+}
+
+void UpgradeIndex::setSyncPackages(const QString& repository, const QByteArray& list)
+{
+  // core acl 2.2.52-2 [installed: 2.2.51-1]
+  parse(list, 1, m_sync[repository]);
+}
+
+void UpgradeIndex::removeSyncPackages(const QString& repository)
+{
+  m_sync.remove(repository);
+}
+
+void UpgradeIndex::clearSyncPackages()
+{
+  m_sync.clear();
+}
+
+QStringList UpgradeIndex::getRepositories() const
+{
+  return m_sync.keys();
+}
+
+/**
+ * Like pacman, only the first repository holding a package counts; the installed table is
+ * walked against every repository table in name order and remembers which packages are decided.
+ */
+QStringList UpgradeIndex::getOutdatedPackages(const QStringList& repositories, const QStringList& ignorePkgList) const
+{
+  QStringList result;
+  const char*const localPool = m_installed.pool.constData();
+  const int localCount = m_installed.entries.size();
+  QVector<bool> decided(localCount, false);
+
+  for (QStringList::const_iterator itRepo = repositories.begin(); itRepo != repositories.end(); ++itRepo) {
+    const QHash<QString, TTable>::const_iterator itSync = m_sync.find(*itRepo);
+    if (itSync == m_sync.end()) continue;
+
+    const char*const syncPool = itSync.value().pool.constData();
+    const QVector<TEntry>& syncEntries = itSync.value().entries;
+
+    int x = 0;
+    int y = 0;
+    while (x < localCount && y < syncEntries.size()) {
+      const TEntry& local = m_installed.entries.at(x);
+      const TEntry& sync  = syncEntries.at(y);
+      const int cmp = qstrcmp(localPool + local.name, syncPool + sync.name);
+      if (cmp < 0) {
+        ++x;
+        continue;
+      }
+      if (cmp > 0) {
+        ++y;
+        continue;
+      }
+
+      if (!decided.at(x)) {
+        decided[x] = true;
+        if (qstrcmp(localPool + local.version, syncPool + sync.version) != 0 &&
+            Package::vercmp(QString::fromLatin1(localPool + local.version),
+                            QString::fromLatin1(syncPool + sync.version)) < 0) {
+          const QString name = QString::fromLatin1(localPool + local.name);
+          if (!Package::isIgnoredPackage(name, ignorePkgList)) result.append(name);
+        }
+      }
+      ++x;
+      ++y;
+    }
+  }
+
+  result.sort();
+  return result;
+}
+
+qint64 UpgradeIndex::getMemoryUsage() const
+{
+  qint64 result = sizeof(*this) + getMemoryUsage(m_installed);
+  for (QHash<QString, TTable>::const_iterator it = m_sync.begin(); it != m_sync.end(); ++it) {
+    result += sizeof(TTable) + it.key().capacity() * sizeof(QChar) + getMemoryUsage(it.value());
+  }
+  return result;
+}
+
+qint64 UpgradeIndex::getResidentSetSize()
+{
+  // statm: size resident shared text lib data dt, in pages
+  QFile statm("/proc/self/statm");
+  if (!statm.open(QIODevice::ReadOnly)) return -1;
+
+  const QList<QByteArray> fields = statm.readAll().split(' ');
+  if (fields.size() < 2) return -1;
+
+  bool ok;
+  const qint64 pages = fields.at(1).toLongLong(&ok);
+  return ok ? pages * sysconf(_SC_PAGESIZE) : -1;
+}
+
+/**
+ * @brief reads the two columns starting at %nameColumn (name and version) of every line of %list
+ */
+void UpgradeIndex::parse(const QByteArray& list, int nameColumn, TTable& table)
+{
+  table.pool.clear();
+  table.entries.clear();
+  // names and versions are a part of the list
+  table.pool.reserve(list.size());
+
+  const char* it = list.constData();
+  const char*const end = it + list.size();
+  while (it < end) {
+    const char* lineEnd = static_cast<const char*>(std::memchr(it, '\n', end - it));
+    if (lineEnd == NULL) lineEnd = end;
+
+    const char* words[2];
+    int lengths[2];
+    int found = 0;
+    for (int column = 0; it < lineEnd && found < 2; ++column) {
+      while (it < lineEnd && *it == ' ') ++it;
+      const char*const word = it;
+      while (it < lineEnd && *it != ' ') ++it;
+      if (word == it) break;
+
+      if (column >= nameColumn) {
+        words[found]   = word;
+        lengths[found] = static_cast<int>(it - word);
+        ++found;
+      }
+    }
+
+    if (found == 2) {
+      TEntry entry;
+      entry.name = table.pool.size();
+      table.pool.append(words[0], lengths[0]).append('\0');
+      entry.version = table.pool.size();
+      table.pool.append(words[1], lengths[1]).append('\0');
+      table.entries.append(entry);
+    }
+    it = lineEnd + 1;
+  }
+
+  table.pool.squeeze();
+  table.entries.squeeze();
+  qSort(table.entries.begin(), table.entries.end(), LessByName(table.pool.constData()));
+}
+
+qint64 UpgradeIndex::getMemoryUsage(const TTable& table)
+{
+  return table.pool.capacity() + table.entries.capacity() * static_cast<qint64>(sizeof(TEntry));
+}
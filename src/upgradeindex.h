@@ -0,0 +1,100 @@
+/*
+* This file is part of Octopi, an open-source GUI for pacman.
+* Copyright (C) 2014 Thomas Binkau
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*
+*/
+
+#ifndef OCTOPI_UPGRADEINDEX_H
+#define OCTOPI_UPGRADEINDEX_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+
+/**
+ * @brief The package versions octopi-notifier needs to find outdated packages, and nothing else
+ *
+ * Every table (the installed packages and one per sync repository) is a sorted flat array of
+ * (name, version) offsets into a single string pool, filled straight from pacman's output without
+ * building a QString per package. A lookup is a binary search and the outdated check walks
+ * the installed table against each repository table in one merged pass. Versions which differ
+ * are compared with Package::vercmp, like "pacman -Qu" does.
+ */
+class UpgradeIndex
+{
+public:
+  static const int ctn_MEMORY_BUDGET = 4 * 1024 * 1024; // bytes the notifier keeps resident for the index
+
+public:
+  UpgradeIndex();
+
+  /**
+   * @brief %list: output of "pacman -Q"
+   */
+  void setInstalledPackages(const QByteArray& list);
+  void clearInstalledPackages();
+  inline bool hasInstalledPackages() const {
+    return m_hasInstalledPackages;
+  }
+
+  /**
+   * @brief %list: output of "pacman -Sl %repository"
+   */
+  void setSyncPackages(const QString& repository, const QByteArray& list);
+  void removeSyncPackages(const QString& repository);
+  void clearSyncPackages();
+  inline bool hasSyncPackages(const QString& repository) const {
+    return m_sync.contains(repository);
+  }
+  QStringList getRepositories() const;
+
+  /**
+   * @brief installed packages older than in the first of %repositories holding them, sorted by name
+   */
+  QStringList getOutdatedPackages(const QStringList& repositories, const QStringList& ignorePkgList) const;
+
+  qint64 getMemoryUsage() const; // bytes
+
+  // resident set size of this process in bytes (from /proc/self/statm), -1 if unknown
+  static qint64 getResidentSetSize();
+
+private:
+  struct TEntry {
+    int name;    // offsets of '\0' terminated strings in TTable::pool
+    int version;
+  };
+
+  struct TTable {
+    QByteArray      pool;
+    QVector<TEntry> entries; // sorted by name
+  };
+
+  struct LessByName;
+
+  static void parse(const QByteArray& list, int nameColumn, TTable& table);
+  static qint64 getMemoryUsage(const TTable& table);
+
+private:
+  TTable                  m_installed;
+  bool                    m_hasInstalledPackages;
+  QHash<QString, TTable>  m_sync;
+};
+
+#endif // OCTOPI_UPGRADEINDEX_H
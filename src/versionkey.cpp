@@ -0,0 +1,164 @@
+/*
+* This file is part of Octopi, an open-source GUI for pacman.
+* Copyright (C) 2014 Thomas Binkau
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*
+*/
+
+#include "versionkey.h"
+
+#include <cstring>
+
+
+// rpmvercmp relies on isdigit/isalpha; versions are plain ASCII so we stick to that range
+static inline bool isDigit(const char c) {
+  return c >= '0' && c <= '9';
+}
+static inline bool isAlpha(const char c) {
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+
+VersionKey::VersionKey(const QString& version)
+{
+  append(m_key, version);
+}
+
+int VersionKey::compare(const VersionKey& other) const
+{
+  return compare(m_key.constData(), m_key.size(), other.m_key.constData(), other.m_key.size());
+}
+
+/**
+ * @brief tokenizes %version the same way Package::rpmvercmp walks through it
+ */
+void VersionKey::append(QByteArray& pool, const QString& version)
+{
+  const QByteArray latin1 = version.toLatin1();
+  const char* it  = latin1.constData();
+  const char* end = it + latin1.size();
+
+  pool.reserve(pool.size() + latin1.size() + 8);
+
+  while (it != end) {
+    const char* segBegin = it;
+    while (segBegin != end && !isDigit(*segBegin) && !isAlpha(*segBegin)) ++segBegin;
+    if (segBegin == end) {
+      pool.append(char(1)); // only separators left
+      return;
+    }
+
+    const bool numeric = isDigit(*segBegin);
+    const char* segEnd = segBegin;
+    if (numeric) {
+      while (segEnd != end && isDigit(*segEnd)) ++segEnd;
+    }
+    else {
+      while (segEnd != end && isAlpha(*segEnd)) ++segEnd;
+    }
+
+    appendVarInt(pool, static_cast<unsigned int>(segBegin - it));
+    pool.append(char(numeric ? NUMERIC : ALPHA));
+
+    const char* value = segBegin;
+    if (numeric) {
+      while (value != segEnd && *value == '0') ++value;
+    }
+    appendVarInt(pool, static_cast<unsigned int>(segEnd - value));
+    pool.append(value, static_cast<int>(segEnd - value));
+
+    it = segEnd;
+  }
+  pool.append(char(0));
+}
+
+/**
+ * Mirrors the control flow of Package::rpmvercmp:
+ * differing separator runs decide first, then numeric beats alpha, then the segment values.
+ * When one side runs out of segments, the next segment (and separator) of the other side decides.
+ * The last byte of a key is the trailer, everything in front of it are segment records.
+ */
+int VersionKey::compare(const char* key1, int size1, const char* key2, int size2)
+{
+  const bool trailing1 = key1[size1 - 1] != 0;
+  const bool trailing2 = key2[size2 - 1] != 0;
+  int pos1 = 0;
+  int pos2 = 0;
+
+  for (;;) {
+    const bool end1 = pos1 >= size1 - 1;
+    const bool end2 = pos2 >= size2 - 1;
+
+    if (end1 && end2) {
+      if (trailing1 == trailing2) return 0;
+      return trailing1 ? 1 : -1;
+    }
+    if (end1) {
+      const Segment seg2 = readSegment(key2, pos2);
+      if (trailing1) return seg2.type == NUMERIC ? -1 : 1;
+      return (seg2.separators > 0 || seg2.type == NUMERIC) ? -1 : 1;
+    }
+    if (end2) {
+      const Segment seg1 = readSegment(key1, pos1);
+      if (trailing2) return seg1.type == NUMERIC ? 1 : -1;
+      return (seg1.separators > 0 || seg1.type == NUMERIC) ? 1 : -1;
+    }
+
+    const Segment seg1 = readSegment(key1, pos1);
+    const Segment seg2 = readSegment(key2, pos2);
+
+    if (seg1.separators != seg2.separators) return seg1.separators < seg2.separators ? -1 : 1;
+    if (seg1.type != seg2.type) return seg1.type == NUMERIC ? 1 : -1;
+
+    // whichever number has more digits wins
+    if (seg1.type == NUMERIC && seg1.length != seg2.length) return seg1.length < seg2.length ? -1 : 1;
+
+    const int cmp = std::memcmp(seg1.data, seg2.data, seg1.length < seg2.length ? seg1.length : seg2.length);
+    if (cmp != 0) return cmp < 0 ? -1 : 1;
+    if (seg1.length != seg2.length) return seg1.length < seg2.length ? -1 : 1;
+  }
+}
+
+VersionKey::Segment VersionKey::readSegment(const char* key, int& pos)
+{
+  Segment seg;
+  seg.separators = readVarInt(key, pos);
+  seg.type       = key[pos++];
+  seg.length     = readVarInt(key, pos);
+  seg.data       = key + pos;
+  pos += seg.length;
+  return seg;
+}
+
+void VersionKey::appendVarInt(QByteArray& key, unsigned int value)
+{
+  while (value >= 0x80) {
+    key.append(char((value & 0x7F) | 0x80));
+    value >>= 7;
+  }
+  key.append(char(value));
+}
+
+unsigned int VersionKey::readVarInt(const char* key, int& pos)
+{
+  unsigned int value = 0;
+  int shift = 0;
+  for (;;) {
+    const unsigned char byte = static_cast<unsigned char>(key[pos++]);
+    value |= static_cast<unsigned int>(byte & 0x7F) << shift;
+    if ((byte & 0x80) == 0) return value;
+    shift += 7;
+  }
+}
@@ -0,0 +1,86 @@
+/*
+* This file is part of Octopi, an open-source GUI for pacman.
+* Copyright (C) 2014 Thomas Binkau
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*
+*/
+
+#ifndef OCTOPI_VERSIONKEY_H
+#define OCTOPI_VERSIONKEY_H
+
+#include <QByteArray>
+#include <QString>
+
+
+/**
+ * @brief Pre-tokenized package version for fast comparisons
+ *
+ * The version string is split once into its numeric and alpha segments (epoch, version and
+ * release are just segments here, exactly as Package::rpmvercmp sees them). Each segment is
+ * stored together with the length of the separator run in front of it; numeric segments are
+ * stored without leading zeros. Comparing two keys neither allocates nor re-tokenizes and
+ * boils down to a few length checks and memcmp calls per segment.
+ *
+ * compare() returns the very same result as Package::rpmvercmp on the Latin-1 strings.
+ *
+ * Besides standalone keys, the static functions write keys into and compare them inside a shared
+ * pool, so a package table needs no heap block per version (see PackageRepository::PackageTable).
+ */
+class VersionKey
+{
+public:
+  explicit VersionKey(const QString& version);
+
+  /**
+   * @brief compares like Package::rpmvercmp
+   * @return 1 if this is newer than %other, 0 if both are the same version, -1 if %other is newer
+   */
+  int compare(const VersionKey& other) const;
+
+  /**
+   * @brief appends the key of %version to %pool
+   */
+  static void append(QByteArray& pool, const QString& version);
+  /**
+   * @brief compares two keys written by append, %size1 and %size2 are their lengths in bytes
+   */
+  static int compare(const char* key1, int size1, const char* key2, int size2);
+
+private:
+  // Layout of m_key: one record per segment followed by a single trailer byte
+  //   record  = varint(separator length), segment type, varint(segment length), segment bytes
+  //   trailer = 1 if the version ends with separators, 0 otherwise
+  enum ESegmentType {
+    ALPHA   = 0,
+    NUMERIC = 1
+  };
+
+  struct Segment {
+    unsigned int separators;
+    char         type;
+    unsigned int length;
+    const char*  data;
+  };
+
+  static Segment readSegment(const char* key, int& pos);
+  static void appendVarInt(QByteArray& key, unsigned int value);
+  static unsigned int readVarInt(const char* key, int& pos);
+
+private:
+  QByteArray m_key;
+};
+
+#endif // OCTOPI_VERSIONKEY_H
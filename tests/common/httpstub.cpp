@@ -0,0 +1,168 @@
+/*
+* This file is part of Octopi, an open-source GUI for pacman.
+* Copyright (C) 2014 Thomas Binkau
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*
+*/
+
+#include "httpstub.h"
+
+#include <QHostAddress>
+#include <QLocale>
+#include <QStringList>
+#include <QTcpSocket>
+
+
+namespace {
+
+QByteArray toHttpDate(const QDateTime& time)
+{
+  return QLocale::c().toString(time.toUTC(), "ddd, dd MMM yyyy hh:mm:ss").toLatin1() + " GMT";
+}
+
+QDateTime fromHttpDate(const QByteArray& date)
+{
+  QDateTime time = QLocale::c().toDateTime(QString::fromLatin1(date.trimmed()), "ddd, dd MMM yyyy hh:mm:ss 'GMT'");
+  time.setTimeSpec(Qt::UTC);
+  return time;
+}
+
+QByteArray reasonPhrase(const int status)
+{
+  switch (status) {
+    case 200: return "OK";
+    case 304: return "Not Modified";
+    case 404: return "Not Found";
+    default:  return "Error";
+  }
+}
+
+} // namespace
+
+
+HttpStub::HttpStub(QObject* parent)
+  : QObject(parent)
+{
+  connect(&m_server, SIGNAL(newConnection()), this, SLOT(onNewConnection()));
+  m_server.listen(QHostAddress::LocalHost, 0);
+}
+
+QString HttpStub::url(const QString& path) const
+{
+  return QString("http://127.0.0.1:%1%2").arg(m_server.serverPort()).arg(path);
+}
+
+void HttpStub::setResource(const QString& path, const QByteArray& body, const QDateTime& lastModified,
+                           const QByteArray& eTag)
+{
+  TResource resource;
+  resource.status       = 200;
+  resource.body         = body;
+  resource.lastModified = lastModified;
+  resource.eTag         = eTag;
+  m_resources.insert(path, resource);
+}
+
+void HttpStub::setStatus(const QString& path, int status)
+{
+  TResource resource;
+  resource.status = status;
+  m_resources.insert(path, resource);
+}
+
+void HttpStub::removeResource(const QString& path)
+{
+  m_resources.remove(path);
+}
+
+int HttpStub::requestCount(const QString& path) const
+{
+  return m_requestCounts.value(path);
+}
+
+QByteArray HttpStub::lastRequestHeader(const QString& path, const QByteArray& name) const
+{
+  return m_lastHeaders.value(path).value(name.toLower());
+}
+
+void HttpStub::onNewConnection()
+{
+  while (m_server.hasPendingConnections()) {
+    QTcpSocket*const socket = m_server.nextPendingConnection();
+    connect(socket, SIGNAL(readyRead()), this, SLOT(onReadyRead()));
+    connect(socket, SIGNAL(disconnected()), socket, SLOT(deleteLater()));
+  }
+}
+
+void HttpStub::onReadyRead()
+{
+  QTcpSocket*const socket = qobject_cast<QTcpSocket*>(sender());
+  if (socket == NULL) return;
+
+  // GET requests have no body, so the request is complete with the empty line
+  QByteArray request = socket->property("request").toByteArray() + socket->readAll();
+  if (!request.contains("\r\n\r\n")) {
+    socket->setProperty("request", request);
+    return;
+  }
+  socket->setProperty("request", QByteArray());
+  respond(socket, request);
+}
+
+void HttpStub::respond(QTcpSocket* socket, const QByteArray& request)
+{
+  const QList<QByteArray> lines = request.left(request.indexOf("\r\n\r\n")).split('\n');
+  const QString path = QString::fromLatin1(lines.first().split(' ').value(1));
+
+  QHash<QByteArray, QByteArray> headers;
+  for (int i = 1; i < lines.size(); ++i) {
+    const int colon = lines.at(i).indexOf(':');
+    if (colon != -1) headers.insert(lines.at(i).left(colon).trimmed().toLower(), lines.at(i).mid(colon + 1).trimmed());
+  }
+  m_lastHeaders.insert(path, headers);
+  ++m_requestCounts[path];
+
+  int status = 404;
+  QByteArray extraHeaders;
+  QByteArray body;
+  const QHash<QString, TResource>::const_iterator it = m_resources.constFind(path);
+  if (it != m_resources.constEnd()) {
+    status = it->status;
+    if (status == 200) {
+      body = it->body;
+      if (!it->eTag.isEmpty()) extraHeaders += "ETag: " + it->eTag + "\r\n";
+      if (it->lastModified.isValid()) extraHeaders += "Last-Modified: " + toHttpDate(it->lastModified) + "\r\n";
+
+      const QByteArray ifNoneMatch     = headers.value("if-none-match");
+      const QByteArray ifModifiedSince = headers.value("if-modified-since");
+      if ((!ifNoneMatch.isEmpty() && ifNoneMatch == it->eTag) ||
+          (ifNoneMatch.isEmpty() && !ifModifiedSince.isEmpty() && it->lastModified.isValid() &&
+           it->lastModified.toTime_t() <= fromHttpDate(ifModifiedSince).toTime_t())) {
+        status = 304;
+        body.clear();
+      }
+    }
+  }
+
+  QByteArray response = "HTTP/1.1 " + QByteArray::number(status) + " " + reasonPhrase(status) + "\r\n";
+  response += extraHeaders;
+  response += "Content-Length: " + QByteArray::number(body.size()) + "\r\n";
+  response += "Connection: close\r\n\r\n";
+  response += body;
+
+  socket->write(response);
+  socket->disconnectFromHost();
+}
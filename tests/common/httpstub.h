@@ -0,0 +1,81 @@
+/*
+* This file is part of Octopi, an open-source GUI for pacman.
+* Copyright (C) 2014 Thomas Binkau
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*
+*/
+
+#ifndef OCTOPI_HTTPSTUB_H
+#define OCTOPI_HTTPSTUB_H
+
+#include <QByteArray>
+#include <QDateTime>
+#include <QHash>
+#include <QObject>
+#include <QString>
+#include <QTcpServer>
+
+class QTcpSocket;
+
+
+/**
+ * @brief Minimal HTTP/1.1 server on 127.0.0.1 standing in for mirrors and feeds in the tests
+ *
+ * Serves GET requests for the resources set, answers conditional requests (If-None-Match,
+ * If-Modified-Since) with 304 and everything unknown with 404. Every response closes the
+ * connection. Requests are counted and the headers of the last request per path are kept.
+ */
+class HttpStub : public QObject
+{
+  Q_OBJECT
+
+public:
+  explicit HttpStub(QObject* parent = 0);
+
+  // "http://127.0.0.1:<port><path>"
+  QString url(const QString& path) const;
+
+  void setResource(const QString& path, const QByteArray& body,
+                   const QDateTime& lastModified = QDateTime(), const QByteArray& eTag = QByteArray());
+  // answers %path with %status and an empty body, e.g. to simulate a broken mirror
+  void setStatus(const QString& path, int status);
+  void removeResource(const QString& path);
+
+  int requestCount(const QString& path) const;
+  QByteArray lastRequestHeader(const QString& path, const QByteArray& name) const;
+
+private slots:
+  void onNewConnection();
+  void onReadyRead();
+
+private:
+  struct TResource {
+    int        status;
+    QByteArray body;
+    QDateTime  lastModified;
+    QByteArray eTag;
+  };
+
+  void respond(QTcpSocket* socket, const QByteArray& request);
+
+private:
+  QTcpServer                                  m_server;
+  QHash<QString, TResource>                   m_resources;
+  QHash<QString, int>                         m_requestCounts;
+  QHash<QString, QHash<QByteArray, QByteArray> > m_lastHeaders; // path -> lower case name -> value
+};
+
+#endif // OCTOPI_HTTPSTUB_H
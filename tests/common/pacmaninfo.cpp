@@ -0,0 +1,42 @@
+/*
+* This file is part of Octopi, an open-source GUI for pacman.
+* Copyright (C) 2014 Thomas Binkau
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*
+*/
+
+#include "pacmaninfo.h"
+
+
+PacmanInfo& PacmanInfo::package(const QString& name, const QString& version, const QString& repository)
+{
+  // records are separated by an empty line
+  if (!m_text.isEmpty()) m_text += "\n";
+  if (!repository.isEmpty()) field("Repository", repository);
+  field("Name", name);
+  return field("Version", version);
+}
+
+PacmanInfo& PacmanInfo::field(const QString& key, const QString& value)
+{
+  m_text += key.leftJustified(16) + ": " + value + "\n";
+  return *this;
+}
+
+QByteArray PacmanInfo::toByteArray() const
+{
+  return m_text.toUtf8() + "\n";
+}
@@ -0,0 +1,47 @@
+/*
+* This file is part of Octopi, an open-source GUI for pacman.
+* Copyright (C) 2014 Thomas Binkau
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*
+*/
+
+#ifndef OCTOPI_PACMANINFO_H
+#define OCTOPI_PACMANINFO_H
+
+#include <QByteArray>
+#include <QString>
+
+
+/**
+ * @brief Writes "pacman -Qi" / "pacman -Si" output (LANG=C) for the tests of the dependency graph
+ *
+ * Every package() starts a new record, field() adds a line to it:
+ *   PacmanInfo().package("bash", "4.3-1", "core").field("Provides", "sh").toByteArray()
+ */
+class PacmanInfo
+{
+public:
+  // %repository is left out for "pacman -Qi" records
+  PacmanInfo& package(const QString& name, const QString& version, const QString& repository = QString());
+  PacmanInfo& field(const QString& key, const QString& value);
+
+  QByteArray toByteArray() const;
+
+private:
+  QString m_text;
+};
+
+#endif // OCTOPI_PACMANINFO_H
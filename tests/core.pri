@@ -0,0 +1,17 @@
+# The sources Package and UnixCommand need, the same set octopi-notifier links
+
+SOURCES += ../../src/unixcommand.cpp \
+    ../../src/package.cpp \
+    ../../src/versionkey.cpp \
+    ../../src/wmhelper.cpp \
+    ../../src/settingsmanager.cpp \
+    ../../src/utils/processwrapper.cpp
+
+HEADERS += ../../src/uihelper.h \
+    ../../src/unixcommand.h \
+    ../../src/wmhelper.h \
+    ../../src/strconstants.h \
+    ../../src/package.h \
+    ../../src/versionkey.h \
+    ../../src/settingsmanager.h \
+    ../../src/utils/processwrapper.h
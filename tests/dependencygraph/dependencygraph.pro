@@ -0,0 +1,11 @@
+include(../tests.pri)
+include(../core.pri)
+
+TARGET = tst_dependencygraph
+
+HEADERS += ../../src/dependencygraph.h \
+    ../common/pacmaninfo.h
+
+SOURCES += tst_dependencygraph.cpp \
+    ../../src/dependencygraph.cpp \
+    ../common/pacmaninfo.cpp
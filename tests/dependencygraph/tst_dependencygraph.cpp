@@ -0,0 +1,255 @@
+/*
+* This file is part of Octopi, an open-source GUI for pacman.
+* Copyright (C) 2014 Thomas Binkau
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*
+*/
+
+#include <QtTest/QtTest>
+#include <memory>
+
+#include "dependencygraph.h"
+#include "pacmaninfo.h"
+
+
+namespace {
+
+// "pacman -Qi": two explicitly installed packages, their dependencies and a few orphans
+QByteArray localInfo()
+{
+  return PacmanInfo()
+      .package("bash", "4.3-1")
+      .field("Groups", "base")
+      .field("Provides", "sh")
+      .field("Depends On", "glibc  readline>=6.3  glibc")
+      .field("Optional Deps", "optional: for the tests [installed]")
+      .field("Install Reason", "Explicitly installed")
+      .package("glibc", "2.20-1")
+      .field("Groups", "base")
+      .field("Install Reason", "Installed as a dependency for another package")
+      .package("readline", "6.3-1")
+      .field("Groups", "base")
+      .field("Depends On", "glibc  ncurses")
+      .package("leftover", "1.0-1")
+      .field("Depends On", "leftover-lib")
+      .package("leftover-lib", "1.0-1")
+      .package("optional", "1.0-1")
+      .package("foreign", "1.0-1")
+      .field("Depends On", "java-runtime")
+      .field("Install Reason", "Explicitly installed")
+      .package("jre-b", "8-1")
+      .field("Provides", "java-runtime=8")
+      .toByteArray();
+}
+
+// "pacman -Si": an upgrade of bash, packages which aren't installed and a package in two dbs
+QByteArray syncInfo()
+{
+  return PacmanInfo()
+      .package("bash", "4.3-2", "core")
+      .field("Groups", "base")
+      .field("Provides", "sh")
+      .field("Depends On", "glibc  readline>=6.3")
+      .field("Download Size", "1.00 MiB")
+      .field("Installed Size", "5.00 MiB")
+      .package("glibc", "2.20-1", "core")
+      .field("Groups", "base")
+      .package("readline", "6.3-1", "core")
+      .package("jre-a", "9-1", "extra")
+      .field("Provides", "java-runtime=9")
+      .package("jre-b", "8-1", "extra")
+      .field("Provides", "java-runtime=8")
+      .package("libfoo", "1.0-1", "extra")
+      .field("Provides", "libfoo.so")
+      .package("libfoo2", "2.0-1", "extra")
+      .field("Provides", "libfoo.so=2")
+      .package("app", "1.0-1", "extra")
+      .field("Groups", "apps")
+      .field("Depends On", "libfoo.so>=2  sh  sh  app")
+      .package("app", "0.9-1", "community")
+      .toByteArray();
+}
+
+QStringList names(const DependencyGraph& graph, const QList<int>& nodes)
+{
+  QStringList result;
+  for (QList<int>::const_iterator it = nodes.begin(); it != nodes.end(); ++it) result.append(graph.getName(*it));
+  result.sort();
+  return result;
+}
+
+QStringList names(const DependencyGraph& graph, const DependencyGraph::TNodeRange& range)
+{
+  QStringList result;
+  for (DependencyGraph::TNodeIterator it = range.first; it != range.second; ++it) result.append(graph.getName(*it));
+  result.sort();
+  return result;
+}
+
+} // namespace
+
+
+Q_DECLARE_METATYPE(DependencyGraph::EConstraintOperator)
+
+class TestDependencyGraph : public QObject
+{
+  Q_OBJECT
+
+private slots:
+  void initTestCase();
+  void parseConstraint_data();
+  void parseConstraint();
+  void isSatisfiedBy();
+  void nodes();
+  void edges();
+  void resolve();
+  void findOrphans();
+  void groups();
+
+private:
+  std::auto_ptr<DependencyGraph> m_graph;
+};
+
+void TestDependencyGraph::initTestCase()
+{
+  m_graph.reset(DependencyGraph::build(localInfo(), syncInfo()));
+  QVERIFY(m_graph.get() != NULL);
+}
+
+void TestDependencyGraph::parseConstraint_data()
+{
+  QTest::addColumn<QString>("spec");
+  QTest::addColumn<QString>("name");
+  QTest::addColumn<DependencyGraph::EConstraintOperator>("op");
+  QTest::addColumn<QString>("version");
+
+  QTest::newRow("any") << "sh" << "sh" << DependencyGraph::ectn_ANY << "";
+  QTest::newRow("equal") << "foo=1.0-2" << "foo" << DependencyGraph::ectn_EQUAL << "1.0-2";
+  QTest::newRow("greater equal") << "glibc>=2.19" << "glibc" << DependencyGraph::ectn_GREATER_EQUAL << "2.19";
+  QTest::newRow("less equal") << "foo<=2" << "foo" << DependencyGraph::ectn_LESS_EQUAL << "2";
+  QTest::newRow("greater") << "foo>1:1.0" << "foo" << DependencyGraph::ectn_GREATER << "1:1.0";
+  QTest::newRow("less") << "foo<2" << "foo" << DependencyGraph::ectn_LESS << "2";
+  QTest::newRow("optional dependency") << "python2: for the scripts" << "python2" << DependencyGraph::ectn_ANY << "";
+}
+
+void TestDependencyGraph::parseConstraint()
+{
+  QFETCH(QString, spec);
+  QFETCH(QString, name);
+  QFETCH(DependencyGraph::EConstraintOperator, op);
+  QFETCH(QString, version);
+
+  const DependencyGraph::Constraint constraint = DependencyGraph::parseConstraint(spec);
+  QCOMPARE(constraint.name, name);
+  QCOMPARE(constraint.op, op);
+  QCOMPARE(constraint.version, version);
+}
+
+void TestDependencyGraph::isSatisfiedBy()
+{
+  QVERIFY(DependencyGraph::parseConstraint("glibc>=2.19").isSatisfiedBy("2.20-1"));
+  QVERIFY(!DependencyGraph::parseConstraint("glibc>=2.19").isSatisfiedBy("2.18-1"));
+  // like pacman, a constraint without release matches every release
+  QVERIFY(DependencyGraph::parseConstraint("foo=1.0").isSatisfiedBy("1.0-3"));
+  QVERIFY(!DependencyGraph::parseConstraint("foo<1.0").isSatisfiedBy("1:0.5-1"));
+  QVERIFY(DependencyGraph::parseConstraint("foo").isSatisfiedBy(""));
+}
+
+void TestDependencyGraph::nodes()
+{
+  const DependencyGraph& graph = *m_graph;
+  // every name once: 8 installed packages and 4 which are only in the sync dbs
+  QCOMPARE(graph.getNodeCount(), 12);
+  QCOMPARE(graph.findNode("ncurses"), -1);
+
+  const int bash = graph.findNode("bash");
+  QVERIFY(bash != -1);
+  QVERIFY(graph.isInstalled(bash));
+  QVERIFY(graph.isExplicitlyInstalled(bash));
+  QCOMPARE(graph.getVersion(bash), QString("4.3-1"));
+  QCOMPARE(graph.getSyncVersion(bash), QString("4.3-2"));
+  QCOMPARE(graph.getRepository(bash), QString("core"));
+  QCOMPARE(graph.getDownloadSize(bash), 1024.0);
+  QCOMPARE(graph.getSyncInstalledSize(bash), 5120.0);
+  QCOMPARE(graph.getOptionalDepends(bash), QStringList() << "optional");
+
+  const int foreign = graph.findNode("foreign");
+  QVERIFY(graph.isInstalled(foreign));
+  QVERIFY(graph.getRepository(foreign).isEmpty());
+  QVERIFY(graph.getSyncVersion(foreign).isEmpty());
+
+  // the first sync db holding a package wins
+  const int app = graph.findNode("app");
+  QVERIFY(!graph.isInstalled(app));
+  QCOMPARE(graph.getRepository(app), QString("extra"));
+  QCOMPARE(graph.getVersion(app), QString("1.0-1"));
+  QCOMPARE(graph.getSyncVersion(app), QString("1.0-1"));
+}
+
+void TestDependencyGraph::edges()
+{
+  const DependencyGraph& graph = *m_graph;
+
+  // duplicates are merged, unknown dependencies (ncurses) dropped
+  QCOMPARE(names(graph, graph.dependsOn(graph.findNode("bash"))), QStringList() << "glibc" << "readline");
+  QCOMPARE(names(graph, graph.dependsOn(graph.findNode("readline"))), QStringList() << "glibc");
+  // provides count, versioned dependencies need versioned provides, self dependencies are dropped
+  QCOMPARE(names(graph, graph.dependsOn(graph.findNode("app"))), QStringList() << "bash" << "libfoo2");
+  QCOMPARE(names(graph, graph.dependsOn(graph.findNode("foreign"))), QStringList() << "jre-b");
+
+  QCOMPARE(names(graph, graph.requiredBy(graph.findNode("glibc"))), QStringList() << "bash" << "readline");
+  QCOMPARE(names(graph, graph.requiredBy(graph.findNode("bash"))), QStringList() << "app");
+  QVERIFY(names(graph, graph.requiredBy(graph.findNode("app"))).isEmpty());
+}
+
+void TestDependencyGraph::resolve()
+{
+  const DependencyGraph& graph = *m_graph;
+
+  QCOMPARE(names(graph, graph.findProviders("sh")), QStringList() << "bash");
+  QCOMPARE(names(graph, graph.findProviders("java-runtime")), QStringList() << "jre-a" << "jre-b");
+
+  // installed providers first, then the first one found
+  QCOMPARE(graph.getName(graph.resolve(DependencyGraph::parseConstraint("java-runtime"))), QString("jre-b"));
+  QCOMPARE(graph.getName(graph.resolve(DependencyGraph::parseConstraint("java-runtime>=9"))), QString("jre-a"));
+  QCOMPARE(graph.getName(graph.resolve(DependencyGraph::parseConstraint("libfoo.so"))), QString("libfoo"));
+  QCOMPARE(graph.getName(graph.resolve(DependencyGraph::parseConstraint("libfoo.so>=2"))), QString("libfoo2"));
+  QCOMPARE(graph.resolve(DependencyGraph::parseConstraint("libfoo.so>2")), -1);
+  QCOMPARE(graph.resolve(DependencyGraph::parseConstraint("glibc<2")), -1);
+}
+
+void TestDependencyGraph::findOrphans()
+{
+  const DependencyGraph& graph = *m_graph;
+
+  QCOMPARE(names(graph, graph.findOrphans(false)), QStringList() << "leftover" << "leftover-lib" << "optional");
+  QCOMPARE(names(graph, graph.findOrphans(true)), QStringList() << "leftover" << "leftover-lib");
+}
+
+void TestDependencyGraph::groups()
+{
+  const DependencyGraph& graph = *m_graph;
+
+  // readline left the group upstream, but the installed one is still in it
+  QCOMPARE(names(graph, graph.findGroupMembers("base")), QStringList() << "bash" << "glibc");
+  QCOMPARE(names(graph, graph.findInstalledGroupMembers("base")), QStringList() << "bash" << "glibc" << "readline");
+  QCOMPARE(names(graph, graph.findGroupMembers("apps")), QStringList() << "app");
+  QVERIFY(graph.findInstalledGroupMembers("apps").isEmpty());
+  QVERIFY(graph.findGroupMembers("unknown").isEmpty());
+}
+
+QTEST_APPLESS_MAIN(TestDependencyGraph)
+#include "tst_dependencygraph.moc"
@@ -0,0 +1,11 @@
+include(../tests.pri)
+include(../core.pri)
+
+TARGET = tst_newsfeed
+
+HEADERS += ../../src/newsfeed.h \
+    ../common/httpstub.h
+
+SOURCES += tst_newsfeed.cpp \
+    ../../src/newsfeed.cpp \
+    ../common/httpstub.cpp
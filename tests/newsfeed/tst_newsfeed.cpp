@@ -0,0 +1,212 @@
+/*
+* This file is part of Octopi, an open-source GUI for pacman.
+* Copyright (C) 2014 Thomas Binkau
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*
+*/
+
+#include <QtTest/QtTest>
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+
+#include "httpstub.h"
+#include "newsfeed.h"
+
+
+namespace {
+
+QByteArray readFile(const QString& fileName)
+{
+  QFile file(fileName);
+  if (!file.open(QIODevice::ReadOnly)) return QByteArray();
+  return file.readAll();
+}
+
+void removeDir(const QString& path)
+{
+  const QFileInfoList entries = QDir(path).entryInfoList(QDir::AllEntries | QDir::Hidden | QDir::NoDotAndDotDot);
+  for (QFileInfoList::const_iterator it = entries.begin(); it != entries.end(); ++it) {
+    if (it->isDir() && !it->isSymLink()) removeDir(it->filePath());
+    else QFile::remove(it->filePath());
+  }
+  QDir().rmdir(path);
+}
+
+QByteArray makeFeed(const QByteArray& lastBuildDate, int items)
+{
+  QByteArray feed = "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n<rss version=\"2.0\"><channel>"
+                    "<title>News</title><lastBuildDate>" + lastBuildDate + "</lastBuildDate>";
+  for (int i = 0; i < items; ++i) {
+    feed += "<item><title>News " + QByteArray::number(i) + "</title><link>http://example.org/" +
+            QByteArray::number(i) + "</link><description>Item " + QByteArray::number(i) +
+            "</description><pubDate>Mon, 06 Jan 2014 12:00:00 +0000</pubDate></item>";
+  }
+  return feed + "</channel></rss>\n";
+}
+
+} // namespace
+
+
+/*
+ * Fetches a feed from a stub server into a scratch directory
+ */
+class TestNewsFeed : public QObject
+{
+  Q_OBJECT
+
+private slots:
+  void init();
+  void cleanup();
+
+  void fetchesFeed();
+  void unchangedFeedByETag();
+  void changedFeed();
+  void unchangedFeedWithoutValidators();
+  void failedFetchWritesNothing();
+  void unsavedFeedKeepsValidators();
+  void htmlShowsLatestItems();
+
+private:
+  QString feedFile() const;
+  QString validatorsFile() const;
+
+private:
+  QString   m_dir;
+  HttpStub* m_stub;
+};
+
+void TestNewsFeed::init()
+{
+  m_dir  = QDir::tempPath() + QString("/octopi-tst-newsfeed-%1").arg(QCoreApplication::applicationPid());
+  m_stub = new HttpStub(this);
+  removeDir(m_dir);
+  QDir().mkpath(m_dir);
+}
+
+void TestNewsFeed::cleanup()
+{
+  delete m_stub;
+  removeDir(m_dir);
+}
+
+QString TestNewsFeed::feedFile() const
+{
+  return m_dir + "/news/feed.xml";
+}
+
+QString TestNewsFeed::validatorsFile() const
+{
+  return feedFile() + ".validators";
+}
+
+void TestNewsFeed::fetchesFeed()
+{
+  const QByteArray feed = makeFeed("Mon, 06 Jan 2014 12:00:00 +0000", 3);
+  m_stub->setResource("/feed", feed, QDateTime(QDate(2014, 1, 6), QTime(12, 0), Qt::UTC), "\"v1\"");
+
+  NewsFeed newsFeed(feedFile(), QUrl(m_stub->url("/feed")));
+  QCOMPARE(newsFeed.fetch(), NewsFeed::ectn_FEED_UPDATED);
+  QCOMPARE(readFile(feedFile()), feed);
+  QVERIFY(readFile(validatorsFile()).startsWith("\"v1\"\n"));
+  QVERIFY(!QFile::exists(feedFile() + ".tmp"));
+}
+
+void TestNewsFeed::unchangedFeedByETag()
+{
+  m_stub->setResource("/feed", makeFeed("Mon, 06 Jan 2014 12:00:00 +0000", 3), QDateTime(), "\"v1\"");
+
+  NewsFeed newsFeed(feedFile(), QUrl(m_stub->url("/feed")));
+  QCOMPARE(newsFeed.fetch(), NewsFeed::ectn_FEED_UPDATED);
+  QCOMPARE(newsFeed.fetch(), NewsFeed::ectn_FEED_UNCHANGED);
+  QCOMPARE(m_stub->requestCount("/feed"), 2);
+  QCOMPARE(m_stub->lastRequestHeader("/feed", "If-None-Match"), QByteArray("\"v1\""));
+}
+
+void TestNewsFeed::changedFeed()
+{
+  m_stub->setResource("/feed", makeFeed("Mon, 06 Jan 2014 12:00:00 +0000", 3), QDateTime(), "\"v1\"");
+  NewsFeed newsFeed(feedFile(), QUrl(m_stub->url("/feed")));
+  QCOMPARE(newsFeed.fetch(), NewsFeed::ectn_FEED_UPDATED);
+
+  const QByteArray feed = makeFeed("Tue, 07 Jan 2014 12:00:00 +0000", 4);
+  m_stub->setResource("/feed", feed, QDateTime(), "\"v2\"");
+  QCOMPARE(newsFeed.fetch(), NewsFeed::ectn_FEED_UPDATED);
+  QCOMPARE(readFile(feedFile()), feed);
+  QVERIFY(readFile(validatorsFile()).startsWith("\"v2\"\n"));
+}
+
+void TestNewsFeed::unchangedFeedWithoutValidators()
+{
+  m_stub->setResource("/feed", makeFeed("Mon, 06 Jan 2014 12:00:00 +0000", 3));
+
+  NewsFeed newsFeed(feedFile(), QUrl(m_stub->url("/feed")));
+  QCOMPARE(newsFeed.fetch(), NewsFeed::ectn_FEED_UPDATED);
+  QCOMPARE(newsFeed.fetch(), NewsFeed::ectn_FEED_UNCHANGED);
+  QCOMPARE(m_stub->requestCount("/feed"), 2);
+}
+
+void TestNewsFeed::failedFetchWritesNothing()
+{
+  m_stub->setStatus("/feed", 500);
+
+  NewsFeed newsFeed(feedFile(), QUrl(m_stub->url("/feed")));
+  QCOMPARE(newsFeed.fetch(), NewsFeed::ectn_FEED_FAILED);
+  QVERIFY(!QFile::exists(feedFile()));
+  QVERIFY(!QFile::exists(validatorsFile()));
+}
+
+void TestNewsFeed::unsavedFeedKeepsValidators()
+{
+  m_stub->setResource("/feed", makeFeed("Mon, 06 Jan 2014 12:00:00 +0000", 3), QDateTime(), "\"v1\"");
+  NewsFeed newsFeed(feedFile(), QUrl(m_stub->url("/feed")));
+  QCOMPARE(newsFeed.fetch(), NewsFeed::ectn_FEED_UPDATED);
+
+  // a directory in place of the feed makes saving the new one fail
+  QVERIFY(QFile::remove(feedFile()));
+  QVERIFY(QDir().mkpath(feedFile() + "/blocked"));
+  m_stub->setResource("/feed", makeFeed("Tue, 07 Jan 2014 12:00:00 +0000", 4), QDateTime(), "\"v2\"");
+
+  QCOMPARE(newsFeed.fetch(), NewsFeed::ectn_FEED_FAILED);
+  QVERIFY(readFile(validatorsFile()).startsWith("\"v1\"\n"));
+}
+
+void TestNewsFeed::htmlShowsLatestItems()
+{
+  m_stub->setResource("/feed", makeFeed("Mon, 06 Jan 2014 12:00:00 +0000", NewsFeed::ctn_NEWS_ITEMS + 2));
+  NewsFeed newsFeed(feedFile(), QUrl(m_stub->url("/feed")));
+  QCOMPARE(newsFeed.fetch(), NewsFeed::ectn_FEED_UPDATED);
+
+  const QString html = newsFeed.getHtml("<ul>");
+  QCOMPARE(html.count("<li>"), int(NewsFeed::ctn_NEWS_ITEMS));
+  QVERIFY(html.contains("<h3>News 0</h3>"));
+  QVERIFY(!html.contains("<h3>News " + QString::number(NewsFeed::ctn_NEWS_ITEMS) + "</h3>"));
+
+  // the second time it comes from the cache file
+  QVERIFY(QFile::exists(feedFile() + ".html"));
+  QCOMPARE(newsFeed.getHtml("<ul>"), html);
+}
+
+// NewsFeed::fetch() and HttpStub need an event loop
+int main(int argc, char* argv[])
+{
+  QCoreApplication app(argc, argv);
+  TestNewsFeed test;
+  return QTest::qExec(&test, argc, argv);
+}
+
+#include "tst_newsfeed.moc"
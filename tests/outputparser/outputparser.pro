@@ -0,0 +1,8 @@
+include(../tests.pri)
+
+TARGET = tst_outputparser
+
+HEADERS += ../../src/outputparser.h
+
+SOURCES += ../../src/outputparser.cpp \
+    tst_outputparser.cpp
@@ -0,0 +1,235 @@
+/*
+* This file is part of Octopi, an open-source GUI for pacman.
+* Copyright (C) 2014 Thomas Binkau
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*
+*/
+
+#include <QtTest/QtTest>
+
+#include "outputparser.h"
+
+
+namespace {
+
+// the events of %output as if the process had finished afterwards
+QList<OutputParser::Event> parseAll(const QString& output)
+{
+  OutputParser parser;
+  return parser.parse(output) + parser.flush();
+}
+
+} // namespace
+
+
+class TestOutputParser : public QObject
+{
+  Q_OBJECT
+
+private slots:
+  void counters();
+  void redrawsWithoutLineBreak();
+  void downloadBars();
+  void barTails();
+  void noiseMarkers();
+  void confirmationPrompts();
+  void errorsAndWarnings();
+  void stages();
+  void escapeSequences();
+  void linesSplitAcrossChunks();
+  void escapeSequencesSplitAcrossChunks();
+  void flushUnterminatedTail();
+};
+
+void TestOutputParser::counters()
+{
+  const QList<OutputParser::Event> events = parseAll("(1/3) installing foo   [#########-----] 50%\n");
+  QCOMPARE(events.size(), 1);
+  QCOMPARE(events.at(0).type, OutputParser::ectn_PROGRESS);
+  QCOMPARE(events.at(0).current, 1);
+  QCOMPARE(events.at(0).total, 3);
+  QCOMPARE(events.at(0).verb, QString("installing"));
+  QCOMPARE(events.at(0).target, QString("foo"));
+  QCOMPARE(events.at(0).percent, 50);
+
+  // pacman pads the counter when the total has more digits
+  const QList<OutputParser::Event> padded = parseAll("( 9/12) upgrading bar   [####] 100%\n");
+  QCOMPARE(padded.size(), 1);
+  QCOMPARE(padded.at(0).current, 9);
+  QCOMPARE(padded.at(0).total, 12);
+  QCOMPARE(padded.at(0).target, QString("bar"));
+}
+
+void TestOutputParser::redrawsWithoutLineBreak()
+{
+  const QList<OutputParser::Event> events =
+      parseAll("(1/2) installing a   [####] 100%(2/2) installing b   [##--] 50%\r(2/2) installing b   [####] 100%\n");
+  QCOMPARE(events.size(), 3);
+  QCOMPARE(events.at(0).target, QString("a"));
+  QCOMPARE(events.at(1).target, QString("b"));
+  QCOMPARE(events.at(1).percent, 50);
+  QCOMPARE(events.at(2).percent, 100);
+
+  // a counter inside a line doesn't need a bar in front of it
+  const QList<OutputParser::Event> stages = parseAll("(1/2) checking keyring...(2/2) checking integrity...\n");
+  QCOMPARE(stages.size(), 2);
+  QCOMPARE(stages.at(1).current, 2);
+}
+
+void TestOutputParser::downloadBars()
+{
+  const QList<OutputParser::Event> events =
+      parseAll(" foo-1.0-1-x86_64   1024.0 KiB   512K/s 00:02 [######----] 60%\n core   [######] 100%\n");
+  QCOMPARE(events.size(), 2);
+  QCOMPARE(events.at(0).type, OutputParser::ectn_DOWNLOAD);
+  QCOMPARE(events.at(0).target, QString("foo-1.0-1-x86_64"));
+  QCOMPARE(events.at(0).percent, 60);
+  QCOMPARE(events.at(1).type, OutputParser::ectn_DOWNLOAD);
+  QCOMPARE(events.at(1).target, QString("core"));
+}
+
+void TestOutputParser::barTails()
+{
+  // the end of a bar whose beginning was cut off by a redraw
+  const QList<OutputParser::Event> events = parseAll("####] 100%\n");
+  QCOMPARE(events.size(), 1);
+  QCOMPARE(events.at(0).type, OutputParser::ectn_NOISE);
+
+  // a percentage without a bar isn't a bar end
+  const QList<OutputParser::Event> text = parseAll("compressed by 50%\n");
+  QCOMPARE(text.size(), 1);
+  QCOMPARE(text.at(0).type, OutputParser::ectn_TEXT);
+  QCOMPARE(text.at(0).percent, -1);
+}
+
+void TestOutputParser::noiseMarkers()
+{
+  QList<OutputParser::Event> events = parseAll("Gkr-Message: secret service operation failed\n");
+  QCOMPARE(events.size(), 1);
+  QCOMPARE(events.at(0).type, OutputParser::ectn_NOISE);
+
+  // the text in front of a marker is kept
+  events = parseAll("resolving dependencies...kbuildsycoca4 running...\n");
+  QCOMPARE(events.size(), 1);
+  QCOMPARE(events.at(0).type, OutputParser::ectn_STAGE);
+  QCOMPARE(events.at(0).text, QString("resolving dependencies..."));
+
+  events = parseAll("\n   \n");
+  QVERIFY(events.isEmpty());
+}
+
+void TestOutputParser::confirmationPrompts()
+{
+  QList<OutputParser::Event> events = parseAll(":: Do you want to remove these packages? [Y/n]\n");
+  QCOMPARE(events.size(), 1);
+  QCOMPARE(events.at(0).type, OutputParser::ectn_NOISE);
+
+  events = parseAll(":: Proceed with installation? [Y/n]\n");
+  QCOMPARE(events.size(), 1);
+  QCOMPARE(events.at(0).type, OutputParser::ectn_NOISE);
+
+  events = parseAll("Enter a selection (default=all): \n");
+  QCOMPARE(events.size(), 1);
+  QCOMPARE(events.at(0).type, OutputParser::ectn_NOISE);
+}
+
+void TestOutputParser::errorsAndWarnings()
+{
+  const QList<OutputParser::Event> events =
+      parseAll("error: failed to commit transaction (conflicting files)\n"
+               "foo: /usr/bin/foo exists in filesystem\n"
+               "warning: bar-1.0-1 is up to date -- reinstalling\n");
+  QCOMPARE(events.size(), 3);
+  QCOMPARE(events.at(0).type, OutputParser::ectn_ERROR);
+  QCOMPARE(events.at(1).type, OutputParser::ectn_ERROR);
+  QCOMPARE(events.at(1).text, QString("foo: /usr/bin/foo exists in filesystem"));
+  QCOMPARE(events.at(2).type, OutputParser::ectn_WARNING);
+}
+
+void TestOutputParser::stages()
+{
+  const QList<OutputParser::Event> events =
+      parseAll(":: Retrieving packages ...\nresolving dependencies...\n(2/3) removing foo...\nfoo was removed\n");
+  QCOMPARE(events.size(), 4);
+  QCOMPARE(events.at(0).type, OutputParser::ectn_STAGE);
+  QCOMPARE(events.at(1).type, OutputParser::ectn_STAGE);
+  QCOMPARE(events.at(1).verb, QString("resolving"));
+  QCOMPARE(events.at(2).type, OutputParser::ectn_STAGE);
+  QCOMPARE(events.at(2).current, 2);
+  QCOMPARE(events.at(2).verb, QString("removing"));
+  QCOMPARE(events.at(2).target, QString("foo..."));
+  QCOMPARE(events.at(3).type, OutputParser::ectn_TEXT);
+}
+
+void TestOutputParser::escapeSequences()
+{
+  const QList<OutputParser::Event> events =
+      parseAll(QString(QChar(0x1b)) + "[1;33mwarning:" + QChar(0x1b) + "[0m foo\n[1;31merror:[0m bar\n");
+  QCOMPARE(events.size(), 2);
+  QCOMPARE(events.at(0).type, OutputParser::ectn_WARNING);
+  QCOMPARE(events.at(0).text, QString("warning: foo"));
+  QCOMPARE(events.at(1).type, OutputParser::ectn_ERROR);
+  QCOMPARE(events.at(1).text, QString("error: bar"));
+}
+
+void TestOutputParser::linesSplitAcrossChunks()
+{
+  OutputParser parser;
+  QVERIFY(parser.parse("(1/3) instal").isEmpty());
+  QVERIFY(parser.parse("ling foo   [####] 5").isEmpty());
+
+  QList<OutputParser::Event> events = parser.parse("0%(2/3) installing bar...\n(3/");
+  QCOMPARE(events.size(), 2);
+  QCOMPARE(events.at(0).type, OutputParser::ectn_PROGRESS);
+  QCOMPARE(events.at(0).target, QString("foo"));
+  QCOMPARE(events.at(0).percent, 50);
+  QCOMPARE(events.at(1).current, 2);
+
+  events = parser.parse("3) installing baz...\n");
+  QCOMPARE(events.size(), 1);
+  QCOMPARE(events.at(0).current, 3);
+  QCOMPARE(events.at(0).total, 3);
+  QVERIFY(parser.flush().isEmpty());
+}
+
+void TestOutputParser::escapeSequencesSplitAcrossChunks()
+{
+  OutputParser parser;
+  QVERIFY(parser.parse(QString(QChar(0x1b)) + "[1;3").isEmpty());
+
+  const QList<OutputParser::Event> events = parser.parse("3mwarning: foo\n");
+  QCOMPARE(events.size(), 1);
+  QCOMPARE(events.at(0).type, OutputParser::ectn_WARNING);
+  QCOMPARE(events.at(0).text, QString("warning: foo"));
+}
+
+void TestOutputParser::flushUnterminatedTail()
+{
+  OutputParser parser;
+  QVERIFY(parser.parse("error: no line break at the end").isEmpty());
+
+  const QList<OutputParser::Event> events = parser.flush();
+  QCOMPARE(events.size(), 1);
+  QCOMPARE(events.at(0).type, OutputParser::ectn_ERROR);
+
+  // reset() forgets the tail of the previous transaction
+  QVERIFY(parser.parse("foo").isEmpty());
+  parser.reset();
+  QVERIFY(parser.flush().isEmpty());
+}
+
+QTEST_APPLESS_MAIN(TestOutputParser)
+#include "tst_outputparser.moc"
@@ -0,0 +1,6 @@
+include(../tests.pri)
+include(../core.pri)
+
+TARGET = tst_package
+
+SOURCES += tst_package.cpp
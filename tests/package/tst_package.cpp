@@ -0,0 +1,93 @@
+/*
+* This file is part of Octopi, an open-source GUI for pacman.
+* Copyright (C) 2014 Thomas Binkau
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*
+*/
+
+#include <QtTest/QtTest>
+#include <memory>
+
+#include "package.h"
+
+
+class TestPackage : public QObject
+{
+  Q_OBJECT
+
+private slots:
+  void vercmp_data();
+  void vercmp();
+  void getOutdatedPackages();
+};
+
+void TestPackage::vercmp_data()
+{
+  QTest::addColumn<QString>("a");
+  QTest::addColumn<QString>("b");
+  QTest::addColumn<int>("expected");
+
+  // the release is compared on its own, never against a version segment
+  QTest::newRow("pkgver gains a component, pkgrel drops") << "1.0-2" << "1.0.1-1" << -1;
+  QTest::newRow("pkgver loses a component, pkgrel grows") << "1.0.1-1" << "1.0-2" << 1;
+  QTest::newRow("release only") << "1.0-10" << "1.0-9" << 1;
+  QTest::newRow("release ignored if one is missing") << "2.0" << "2.0-1" << 0;
+  QTest::newRow("same version") << "1.0-1" << "1.0-1" << 0;
+
+  // the epoch decides before anything else
+  QTest::newRow("epoch beats a higher version") << "1:1.0-1" << "2.0-1" << 1;
+  QTest::newRow("no epoch loses against an epoch") << "1.0-1" << "1:0.5-1" << -1;
+  QTest::newRow("higher epoch") << "1:9.0-1" << "2:0.1-1" << -1;
+  QTest::newRow("epoch 0 is no epoch") << "0:1.0-1" << "1.0-1" << 0;
+}
+
+void TestPackage::vercmp()
+{
+  QFETCH(QString, a);
+  QFETCH(QString, b);
+  QFETCH(int, expected);
+
+  QCOMPARE(Package::vercmp(a, b), expected);
+  QCOMPARE(Package::vercmp(b, a), -expected);
+}
+
+void TestPackage::getOutdatedPackages()
+{
+  QList<PackageListData> syncPackages;
+  syncPackages << PackageListData("octopi-test-a", "extra", "1.0.1-1", ectn_OUTDATED, "1.0-2")
+               << PackageListData("octopi-test-b", "extra", "1:0.5-1", ectn_OUTDATED, "1.0-1")
+               << PackageListData("octopi-test-c", "extra", "2.0-1", ectn_OUTDATED, "1:1.0-1")
+               << PackageListData("octopi-test-d", "extra", "1.0-2", ectn_OUTDATED, "1.0.1-1")
+               << PackageListData("octopi-test-e", "extra", "1.0-1", ectn_INSTALLED, "")
+               << PackageListData("octopi-test-f", "extra", "2.0-1", ectn_OUTDATED, "1.0-1")
+               << PackageListData("octopi-test-g", "extra", "2.0-1", ectn_OUTDATED, "1.0-1")
+               // only the first repository holding a package counts
+               << PackageListData("octopi-test-a", "community", "0.1-1", ectn_OUTDATED, "1.0-2");
+
+  // neither the host's IgnorePkg nor its frozen list may leak into the result
+  const QStringList ignorePkgList = QStringList() << "octopi-test-f" << "octopi-test-g*";
+  const std::auto_ptr<OutdatedPackages> result(Package::getOutdatedPackages(syncPackages, ignorePkgList));
+
+  QCOMPARE(result->outdated, QStringList() << "octopi-test-a" << "octopi-test-b");
+  QCOMPARE(result->newer, QStringList() << "octopi-test-c" << "octopi-test-d");
+
+  const std::auto_ptr<OutdatedPackages> unfiltered(Package::getOutdatedPackages(syncPackages, QStringList()));
+  QCOMPARE(unfiltered->outdated,
+           QStringList() << "octopi-test-a" << "octopi-test-b" << "octopi-test-f" << "octopi-test-g");
+}
+
+QTEST_APPLESS_MAIN(TestPackage)
+#include "tst_package.moc"
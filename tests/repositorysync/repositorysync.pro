@@ -0,0 +1,12 @@
+include(../tests.pri)
+
+TARGET = tst_repositorysync
+
+INCLUDEPATH += ../../notifier/pacmanhelper
+
+HEADERS += ../../notifier/pacmanhelper/repositorysync.h \
+    ../common/httpstub.h
+
+SOURCES += tst_repositorysync.cpp \
+    ../../notifier/pacmanhelper/repositorysync.cpp \
+    ../common/httpstub.cpp
@@ -0,0 +1,222 @@
+/*
+* This file is part of Octopi, an open-source GUI for pacman.
+* Copyright (C) 2014 Thomas Binkau
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*
+*/
+
+#include <QtTest/QtTest>
+#include <QCoreApplication>
+#include <QDir>
+#include <QEventLoop>
+#include <QFile>
+#include <QFileInfo>
+#include <QTimer>
+
+#include "httpstub.h"
+#include "repositorysync.h"
+
+
+namespace {
+
+QByteArray readFile(const QString& fileName)
+{
+  QFile file(fileName);
+  if (!file.open(QIODevice::ReadOnly)) return QByteArray();
+  return file.readAll();
+}
+
+void writeFile(const QString& fileName, const QByteArray& data)
+{
+  QFile file(fileName);
+  if (file.open(QIODevice::WriteOnly | QIODevice::Truncate)) file.write(data);
+}
+
+void removeDir(const QString& path)
+{
+  const QFileInfoList entries = QDir(path).entryInfoList(QDir::AllEntries | QDir::Hidden | QDir::NoDotAndDotDot);
+  for (QFileInfoList::const_iterator it = entries.begin(); it != entries.end(); ++it) {
+    if (it->isDir() && !it->isSymLink()) removeDir(it->filePath());
+    else QFile::remove(it->filePath());
+  }
+  QDir().rmdir(path);
+}
+
+} // namespace
+
+
+/*
+ * Syncs the repository "core" of a scratch pacman.conf against two stub mirrors
+ */
+class TestRepositorySync : public QObject
+{
+  Q_OBJECT
+
+private slots:
+  void init();
+  void cleanup();
+
+  void downloadsDatabaseAndSignature();
+  void unchangedDatabase();
+  void missingSignatureRemovesOldOne();
+  void brokenSignatureKeepsOldFiles();
+  void failingServerMovesOn();
+  void lockedDatabase();
+
+private:
+  void serve(const QString& mirror, const QByteArray& db, const QByteArray& sig, const QDateTime& lastModified);
+  int  sync();
+  QString syncFile(const QString& name) const;
+
+private:
+  QString   m_dir;
+  HttpStub* m_stub;
+};
+
+void TestRepositorySync::init()
+{
+  m_dir  = QDir::tempPath() + QString("/octopi-tst-repositorysync-%1").arg(QCoreApplication::applicationPid());
+  m_stub = new HttpStub(this);
+  removeDir(m_dir);
+  QDir().mkpath(m_dir);
+
+  writeFile(m_dir + "/pacman.conf",
+            "[options]\nArchitecture = x86_64\n\n"
+            "[core]\n"
+            "Server = " + m_stub->url("/mirror1/$repo/os/$arch").toLatin1() + "\n"
+            "Server = " + m_stub->url("/mirror2/$repo/os/$arch").toLatin1() + "\n");
+}
+
+void TestRepositorySync::cleanup()
+{
+  delete m_stub;
+  removeDir(m_dir);
+}
+
+void TestRepositorySync::serve(const QString& mirror, const QByteArray& db, const QByteArray& sig,
+                               const QDateTime& lastModified)
+{
+  const QString path = "/" + mirror + "/core/os/x86_64/core.db";
+  m_stub->setResource(path, db, lastModified);
+  if (sig.isNull()) m_stub->removeResource(path + ".sig");
+  else m_stub->setResource(path + ".sig", sig, lastModified);
+}
+
+/*
+ * Runs a whole sync and returns the result of "core", -1 if it didn't finish
+ */
+int TestRepositorySync::sync()
+{
+  RepositorySync repositorySync(0, m_dir + "/pacman.conf", m_dir);
+  QSignalSpy results(&repositorySync, SIGNAL(repositoryFinished(QString,int)));
+
+  QEventLoop loop;
+  connect(&repositorySync, SIGNAL(finished()), &loop, SLOT(quit()));
+  QTimer::singleShot(10000, &loop, SLOT(quit()));
+  if (!repositorySync.start()) return -1;
+  if (repositorySync.isRunning()) loop.exec();
+
+  if (results.count() != 1 || repositorySync.isRunning()) return -1;
+  return results.at(0).at(1).toInt();
+}
+
+QString TestRepositorySync::syncFile(const QString& name) const
+{
+  return m_dir + "/sync/" + name;
+}
+
+void TestRepositorySync::downloadsDatabaseAndSignature()
+{
+  const QDateTime lastModified(QDate(2014, 1, 1), QTime(12, 0), Qt::UTC);
+  serve("mirror1", "db1", "sig1", lastModified);
+
+  QCOMPARE(sync(), int(RepositorySync::ectn_REPOSITORY_UPDATED));
+  QCOMPARE(readFile(syncFile("core.db")), QByteArray("db1"));
+  QCOMPARE(readFile(syncFile("core.db.sig")), QByteArray("sig1"));
+  QCOMPARE(QFileInfo(syncFile("core.db")).lastModified().toUTC(), lastModified);
+  QVERIFY(!QFile::exists(syncFile("core.db.part")));
+  QVERIFY(!QFile::exists(syncFile("core.db.sig.part")));
+  QVERIFY(!QFile::exists(m_dir + "/db.lck"));
+}
+
+void TestRepositorySync::unchangedDatabase()
+{
+  serve("mirror1", "db1", "sig1", QDateTime(QDate(2014, 1, 1), QTime(12, 0), Qt::UTC));
+  QCOMPARE(sync(), int(RepositorySync::ectn_REPOSITORY_UPDATED));
+
+  QCOMPARE(sync(), int(RepositorySync::ectn_REPOSITORY_UNCHANGED));
+  QVERIFY(!m_stub->lastRequestHeader("/mirror1/core/os/x86_64/core.db", "If-Modified-Since").isEmpty());
+  QCOMPARE(m_stub->requestCount("/mirror1/core/os/x86_64/core.db.sig"), 1);
+  QCOMPARE(readFile(syncFile("core.db.sig")), QByteArray("sig1"));
+}
+
+void TestRepositorySync::missingSignatureRemovesOldOne()
+{
+  serve("mirror1", "db1", "sig1", QDateTime(QDate(2014, 1, 1), QTime(12, 0), Qt::UTC));
+  QCOMPARE(sync(), int(RepositorySync::ectn_REPOSITORY_UPDATED));
+
+  serve("mirror1", "db2", QByteArray(), QDateTime(QDate(2014, 2, 1), QTime(12, 0), Qt::UTC));
+  QCOMPARE(sync(), int(RepositorySync::ectn_REPOSITORY_UPDATED));
+  QCOMPARE(readFile(syncFile("core.db")), QByteArray("db2"));
+  QVERIFY(!QFile::exists(syncFile("core.db.sig")));
+}
+
+void TestRepositorySync::brokenSignatureKeepsOldFiles()
+{
+  serve("mirror1", "db1", "sig1", QDateTime(QDate(2014, 1, 1), QTime(12, 0), Qt::UTC));
+  QCOMPARE(sync(), int(RepositorySync::ectn_REPOSITORY_UPDATED));
+
+  // the new database arrives, but its signature doesn't, and mirror2 has nothing at all
+  serve("mirror1", "db2", "sig2", QDateTime(QDate(2014, 2, 1), QTime(12, 0), Qt::UTC));
+  m_stub->setStatus("/mirror1/core/os/x86_64/core.db.sig", 500);
+
+  QCOMPARE(sync(), int(RepositorySync::ectn_REPOSITORY_FAILED));
+  QCOMPARE(readFile(syncFile("core.db")), QByteArray("db1"));
+  QCOMPARE(readFile(syncFile("core.db.sig")), QByteArray("sig1"));
+  QVERIFY(!QFile::exists(syncFile("core.db.part")));
+  QVERIFY(!QFile::exists(syncFile("core.db.sig.part")));
+}
+
+void TestRepositorySync::failingServerMovesOn()
+{
+  m_stub->setStatus("/mirror1/core/os/x86_64/core.db", 500);
+  serve("mirror2", "db2", "sig2", QDateTime(QDate(2014, 2, 1), QTime(12, 0), Qt::UTC));
+
+  QCOMPARE(sync(), int(RepositorySync::ectn_REPOSITORY_UPDATED));
+  QCOMPARE(readFile(syncFile("core.db")), QByteArray("db2"));
+  QCOMPARE(readFile(syncFile("core.db.sig")), QByteArray("sig2"));
+}
+
+void TestRepositorySync::lockedDatabase()
+{
+  serve("mirror1", "db1", "sig1", QDateTime(QDate(2014, 1, 1), QTime(12, 0), Qt::UTC));
+  writeFile(m_dir + "/db.lck", QByteArray());
+
+  RepositorySync repositorySync(0, m_dir + "/pacman.conf", m_dir);
+  QVERIFY(!repositorySync.start());
+  QVERIFY(QFile::exists(m_dir + "/db.lck"));
+  QCOMPARE(m_stub->requestCount("/mirror1/core/os/x86_64/core.db"), 0);
+}
+
+// QNetworkAccessManager needs an event loop
+int main(int argc, char* argv[])
+{
+  QCoreApplication app(argc, argv);
+  TestRepositorySync test;
+  return QTest::qExec(&test, argc, argv);
+}
+
+#include "tst_repositorysync.moc"
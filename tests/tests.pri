@@ -0,0 +1,15 @@
+# Settings shared by every test project
+
+QT += core gui network dbus testlib
+
+greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
+
+CONFIG += qt console warn_on debug testcase
+CONFIG -= app_bundle
+
+TEMPLATE = app
+
+INCLUDEPATH += ../../src ../common
+
+OBJECTS_DIR += build
+MOC_DIR += build
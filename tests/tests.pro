@@ -0,0 +1,16 @@
+#-------------------------------------------------
+#
+# Unit tests: qmake tests.pro && make && make check
+#
+#-------------------------------------------------
+
+TEMPLATE = subdirs
+
+SUBDIRS += package \
+           versionkey \
+           repositorysync \
+           newsfeed \
+           outputparser \
+           dependencygraph \
+           transactionresolver \
+           transactionchecker
@@ -0,0 +1,17 @@
+include(../tests.pri)
+include(../core.pri)
+
+greaterThan(QT_MAJOR_VERSION, 4): QT += concurrent
+
+TARGET = tst_transactionchecker
+
+HEADERS += ../../src/dependencygraph.h \
+    ../../src/transactionresolver.h \
+    ../../src/transactionchecker.h \
+    ../common/pacmaninfo.h
+
+SOURCES += tst_transactionchecker.cpp \
+    ../../src/dependencygraph.cpp \
+    ../../src/transactionresolver.cpp \
+    ../../src/transactionchecker.cpp \
+    ../common/pacmaninfo.cpp
@@ -0,0 +1,184 @@
+/*
+* This file is part of Octopi, an open-source GUI for pacman.
+* Copyright (C) 2014 Thomas Binkau
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*
+*/
+
+#include <QtTest/QtTest>
+#include <QFileInfo>
+#include <QTemporaryFile>
+#include <memory>
+
+#include "dependencygraph.h"
+#include "transactionresolver.h"
+#include "transactionchecker.h"
+#include "pacmaninfo.h"
+
+
+namespace {
+
+QByteArray localInfo()
+{
+  return PacmanInfo()
+      .package("editor", "1.0-1")
+      .package("lib", "1.0-1")
+      .package("owner", "1.0-1")
+      .package("legacy", "1.0-1")
+      .toByteArray();
+}
+
+QByteArray syncInfo()
+{
+  return PacmanInfo()
+      .package("editor", "1.0-1", "extra")
+      .package("lib", "2.0-1", "core")
+      .package("owner", "1.0-1", "extra")
+      .package("legacy-ng", "1.0-1", "extra")
+      .field("Replaces", "legacy")
+      .field("Conflicts With", "legacy")
+      .package("vim", "1.0-1", "extra")
+      .field("Conflicts With", "editor")
+      .package("a", "1.0-1", "extra")
+      .package("b", "1.0-1", "extra")
+      .toByteArray();
+}
+
+// "pacman -Ql" of the installed packages above
+QByteArray installedFiles()
+{
+  return QByteArray(
+        "lib /usr/\n"
+        "lib /usr/lib/\n"
+        "lib /usr/lib/libfoo.so\n"
+        "lib /usr/lib/libold.so\n"
+        "owner /usr/\n"
+        "owner /usr/share/owner/file\n"
+        "legacy /usr/bin/legacy\n");
+}
+
+QStringList collisions(const TransactionChecker& checker)
+{
+  QStringList result;
+  foreach (const TransactionChecker::FileCollision& collision, checker.getFileCollisions()) {
+    result.append(collision.package + ':' + collision.file + ':' + collision.owner);
+  }
+  return result;
+}
+
+} // namespace
+
+
+class TestTransactionChecker : public QObject
+{
+  Q_OBJECT
+
+private slots:
+  void initTestCase();
+  void conflicts();
+  void fileCollisions();
+  void replacement();
+  void noFileLists();
+
+private:
+  std::auto_ptr<DependencyGraph> m_graph;
+};
+
+void TestTransactionChecker::initTestCase()
+{
+  m_graph.reset(DependencyGraph::build(localInfo(), syncInfo()));
+  QVERIFY(m_graph.get() != NULL);
+}
+
+void TestTransactionChecker::conflicts()
+{
+  const TransactionResolver install(*m_graph, QStringList() << "vim", QStringList());
+  const TransactionChecker checker(install, QByteArray(), QByteArray());
+  QCOMPARE(checker.getConflicts().size(), 1);
+  QCOMPARE(checker.getConflicts().at(0).package, QString("vim"));
+  QCOMPARE(checker.getConflicts().at(0).conflictsWith, QString("editor"));
+  QVERIFY(checker.hasProblems());
+
+  // removed first, so pacman goes through
+  const TransactionResolver removeAndInstall(*m_graph, QStringList() << "vim", QStringList(),
+                                             QStringList() << "editor");
+  const TransactionChecker noConflicts(removeAndInstall, QByteArray(), QByteArray());
+  QVERIFY(noConflicts.getConflicts().isEmpty());
+  QVERIFY(!noConflicts.hasProblems());
+}
+
+void TestTransactionChecker::fileCollisions()
+{
+  QTemporaryFile unowned;
+  QVERIFY(unowned.open());
+  const QString existing = QFileInfo(unowned).absoluteFilePath();
+
+  const QByteArray syncFiles =
+      "a usr/\n"
+      "a usr/bin/\n"
+      "a usr/bin/shared\n"
+      "a usr/lib/libold.so\n"
+      "a usr/share/owner/file\n"
+      "a " + existing.mid(1).toUtf8() + "\n"
+      "a " + existing.mid(1).toUtf8() + ".missing\n"
+      "b usr/bin/shared\n"
+      "b usr/bin/b\n"
+      "lib usr/lib/libfoo.so\n"
+      "not-a-target usr/share/owner/file";
+
+  const TransactionResolver install(*m_graph, QStringList() << "a" << "b" << "lib", QStringList());
+  const TransactionChecker checker(install, syncFiles, installedFiles());
+  QVERIFY(checker.hasFileLists());
+  QVERIFY(checker.hasProblems());
+
+  // the old files of the upgraded lib and the files it ships itself are fine
+  QStringList expected;
+  expected << "a:" + existing + ':'
+           << "a:/usr/share/owner/file:owner"
+           << "b:/usr/bin/shared:a";
+  expected.sort();
+  QCOMPARE(collisions(checker), expected);
+}
+
+void TestTransactionChecker::replacement()
+{
+  const TransactionResolver upgrade(*m_graph, QStringList(), QStringList());
+  QCOMPARE(upgrade.getReplacements().size(), 1);
+
+  const TransactionChecker checker(upgrade, "legacy-ng usr/bin/legacy\nlib usr/lib/libfoo.so\n", installedFiles());
+  QVERIFY(checker.hasFileLists());
+  QVERIFY(checker.getConflicts().isEmpty());
+  QVERIFY(checker.getFileCollisions().isEmpty());
+  QVERIFY(!checker.hasProblems());
+}
+
+void TestTransactionChecker::noFileLists()
+{
+  const TransactionResolver install(*m_graph, QStringList() << "a", QStringList());
+
+  // .files dbs not synced
+  const TransactionChecker noSyncFiles(install, "b usr/bin/b\n", installedFiles());
+  QVERIFY(!noSyncFiles.hasFileLists());
+  QVERIFY(!noSyncFiles.hasProblems());
+
+  // "pacman -Ql" failed
+  const TransactionChecker noInstalledFiles(install, "a usr/share/owner/file\n", QByteArray());
+  QVERIFY(!noInstalledFiles.hasFileLists());
+  QVERIFY(noInstalledFiles.getFileCollisions().isEmpty());
+}
+
+QTEST_APPLESS_MAIN(TestTransactionChecker)
+#include "tst_transactionchecker.moc"
@@ -0,0 +1,13 @@
+include(../tests.pri)
+include(../core.pri)
+
+TARGET = tst_transactionresolver
+
+HEADERS += ../../src/dependencygraph.h \
+    ../../src/transactionresolver.h \
+    ../common/pacmaninfo.h
+
+SOURCES += tst_transactionresolver.cpp \
+    ../../src/dependencygraph.cpp \
+    ../../src/transactionresolver.cpp \
+    ../common/pacmaninfo.cpp
@@ -0,0 +1,221 @@
+/*
+* This file is part of Octopi, an open-source GUI for pacman.
+* Copyright (C) 2014 Thomas Binkau
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*
+*/
+
+#include <QtTest/QtTest>
+#include <memory>
+
+#include "dependencygraph.h"
+#include "transactionresolver.h"
+#include "pacmaninfo.h"
+
+
+namespace {
+
+QByteArray localInfo()
+{
+  return PacmanInfo()
+      .package("old-name", "1.0-1")
+      .package("editor", "1.0-1")
+      .field("Provides", "editor-bin")
+      .package("ignored", "1.0-1")
+      .package("lib", "1.0-1")
+      .package("tool", "1.0-1")
+      .field("Depends On", "lib")
+      .field("Conflicts With", "tool-ng")
+      .package("kde-a", "1.0-1")
+      .field("Groups", "kde")
+      .package("kde-b", "1.0-1")
+      .field("Groups", "kde")
+      .toByteArray();
+}
+
+QByteArray syncInfo()
+{
+  return PacmanInfo()
+      .package("old-name", "1.0-1", "extra")
+      .package("new-name", "2.0-1", "extra")
+      .field("Replaces", "old-name")
+      .field("Provides", "old-name")
+      .package("editor", "1.0-1", "extra")
+      .field("Provides", "editor-bin")
+      .package("ignored", "2.0-1", "extra")
+      .package("lib", "2.0-1", "core")
+      .field("Depends On", "libdep")
+      .package("libdep", "1.0-1", "core")
+      .package("tool", "1.0-1", "extra")
+      .field("Depends On", "lib")
+      .field("Conflicts With", "tool-ng")
+      .package("tool-ng", "1.0-1", "extra")
+      .field("Conflicts With", "tool")
+      .package("vim", "1.0-1", "extra")
+      .field("Provides", "editor-bin")
+      .field("Conflicts With", "editor")
+      .field("Download Size", "100.00 KiB")
+      .field("Installed Size", "300.00 KiB")
+      .package("kde-a", "2.0-1", "extra")
+      .field("Groups", "kde")
+      .package("kde-b", "1.0-1", "extra")
+      .field("Groups", "kde")
+      .package("kde-c", "1.0-1", "community")
+      .field("Groups", "kde")
+      .package("needs-missing", "1.0-1", "extra")
+      .field("Depends On", "nonexistent>=1")
+      .toByteArray();
+}
+
+QStringList targetNames(const TransactionResolver& resolution)
+{
+  QStringList result;
+  foreach (const TransactionResolver::Target& target, resolution.getTargets()) result.append(target.name);
+  return result;
+}
+
+} // namespace
+
+
+class TestTransactionResolver : public QObject
+{
+  Q_OBJECT
+
+private slots:
+  void initTestCase();
+  void systemUpgrade();
+  void install();
+  void dependencies();
+  void conflicts();
+  void removeAndInstall();
+  void groups();
+  void unresolved();
+
+private:
+  std::auto_ptr<DependencyGraph> m_graph;
+};
+
+void TestTransactionResolver::initTestCase()
+{
+  m_graph.reset(DependencyGraph::build(localInfo(), syncInfo()));
+  QVERIFY(m_graph.get() != NULL);
+}
+
+void TestTransactionResolver::systemUpgrade()
+{
+  const TransactionResolver resolution(*m_graph, QStringList(), QStringList() << "ignore*");
+  QVERIFY(resolution.isSystemUpgrade());
+
+  // the replacement comes first, the new dependency of lib is pulled in, IgnorePkg is honored
+  QCOMPARE(resolution.getReplacements().size(), 1);
+  QCOMPARE(resolution.getReplacements().at(0).replaced, QString("old-name"));
+  QCOMPARE(resolution.getReplacements().at(0).replacedBy, QString("new-name"));
+  QCOMPARE(targetNames(resolution), QStringList() << "kde-a" << "lib" << "libdep" << "new-name");
+
+  const TransactionResolver::Target& lib = resolution.getTargets().at(1);
+  QCOMPARE(lib.oldVersion, QString("1.0-1"));
+  QCOMPARE(lib.version, QString("2.0-1"));
+  QVERIFY(!lib.isDependency);
+  QVERIFY(resolution.getTargets().at(2).isDependency);
+  QVERIFY(resolution.getTargets().at(3).oldVersion.isEmpty());
+
+  QVERIFY(resolution.getConflicts().isEmpty());
+  QVERIFY(resolution.getUnresolved().isEmpty());
+
+  const TransactionResolver unfiltered(*m_graph, QStringList(), QStringList());
+  QVERIFY(targetNames(unfiltered).contains("ignored"));
+}
+
+void TestTransactionResolver::install()
+{
+  // "repo/name" and provides are accepted as targets
+  const TransactionResolver resolution(*m_graph, QStringList() << "extra/vim" << "editor-bin", QStringList());
+  QVERIFY(!resolution.isSystemUpgrade());
+  QCOMPARE(targetNames(resolution), QStringList() << "editor" << "vim");
+
+  const TransactionResolver::Target& vim = resolution.getTargets().at(1);
+  QVERIFY(vim.oldVersion.isEmpty());
+  QCOMPARE(vim.repository, QString("extra"));
+  QCOMPARE(vim.downloadSize, 100.0);
+  QCOMPARE(vim.installedSizeDelta, 300.0);
+  QCOMPARE(resolution.getDownloadSize(), 100.0);
+}
+
+void TestTransactionResolver::dependencies()
+{
+  // installed packages which stay satisfy the dependencies
+  const TransactionResolver reinstall(*m_graph, QStringList() << "tool", QStringList());
+  QCOMPARE(targetNames(reinstall), QStringList() << "tool");
+
+  // removed ones don't, so lib comes back in its sync version, together with its new dependency
+  const TransactionResolver resolution(*m_graph, QStringList() << "tool", QStringList(), QStringList() << "lib");
+  QCOMPARE(targetNames(resolution), QStringList() << "lib" << "libdep" << "tool");
+  QVERIFY(resolution.getTargets().at(0).isDependency);
+}
+
+void TestTransactionResolver::conflicts()
+{
+  const TransactionResolver vim(*m_graph, QStringList() << "vim", QStringList());
+  QCOMPARE(vim.getConflicts().size(), 1);
+  QCOMPARE(vim.getConflicts().at(0).package, QString("vim"));
+  QCOMPARE(vim.getConflicts().at(0).conflictsWith, QString("editor"));
+
+  // declared on both sides, reported once
+  const TransactionResolver toolNg(*m_graph, QStringList() << "tool-ng", QStringList());
+  QCOMPARE(toolNg.getConflicts().size(), 1);
+  QCOMPARE(toolNg.getConflicts().at(0).package, QString("tool-ng"));
+  QCOMPARE(toolNg.getConflicts().at(0).conflictsWith, QString("tool"));
+}
+
+void TestTransactionResolver::removeAndInstall()
+{
+  // "pacman -R editor tool; pacman -S vim tool-ng" doesn't conflict
+  const TransactionResolver resolution(*m_graph, QStringList() << "vim" << "tool-ng", QStringList(),
+                                       QStringList() << "tool" << "extra/editor" << "not-installed");
+  QCOMPARE(resolution.getRemovedPackages(), QStringList() << "editor" << "tool");
+  QCOMPARE(targetNames(resolution), QStringList() << "tool-ng" << "vim");
+  QVERIFY(resolution.getConflicts().isEmpty());
+}
+
+void TestTransactionResolver::groups()
+{
+  // every member is installed, like "pacman -S kde" does by default
+  const TransactionResolver install(*m_graph, QStringList() << "kde", QStringList());
+  QCOMPARE(targetNames(install), QStringList() << "kde-a" << "kde-b" << "kde-c");
+  QVERIFY(install.getUnresolved().isEmpty());
+
+  const TransactionResolver fromRepository(*m_graph, QStringList() << "extra/kde", QStringList());
+  QCOMPARE(targetNames(fromRepository), QStringList() << "kde-a" << "kde-b");
+
+  // only the installed members are removed
+  const TransactionResolver remove(*m_graph, QStringList() << "vim", QStringList(), QStringList() << "kde");
+  QCOMPARE(remove.getRemovedPackages(), QStringList() << "kde-a" << "kde-b");
+}
+
+void TestTransactionResolver::unresolved()
+{
+  const TransactionResolver resolution(*m_graph, QStringList() << "missing-target" << "needs-missing", QStringList());
+  QCOMPARE(targetNames(resolution), QStringList() << "needs-missing");
+
+  QCOMPARE(resolution.getUnresolved().size(), 2);
+  QCOMPARE(resolution.getUnresolved().at(0).dependency, QString("missing-target"));
+  QVERIFY(resolution.getUnresolved().at(0).requiredBy.isEmpty());
+  QCOMPARE(resolution.getUnresolved().at(1).dependency, QString("nonexistent>=1"));
+  QCOMPARE(resolution.getUnresolved().at(1).requiredBy, QString("needs-missing"));
+}
+
+QTEST_APPLESS_MAIN(TestTransactionResolver)
+#include "tst_transactionresolver.moc"
@@ -0,0 +1,216 @@
+/*
+* This file is part of Octopi, an open-source GUI for pacman.
+* Copyright (C) 2014 Thomas Binkau
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*
+*/
+
+#include <QtTest/QtTest>
+#include <algorithm>
+#include <vector>
+
+#include "package.h"
+#include "versionkey.h"
+
+
+namespace {
+
+// versions rpmvercmp is known to be picky about
+const char* const ctn_EDGE_CASES[] = {
+  "", "0", "00", "1", "01", "001.0", "1.", "1..", "1..a", "1.0", "1.0.0", "1.01", "1.001", "1.0.1",
+  "1a", "1.a", "a1", "1a1", "1.0a", "1.0.a", "1.0rc1", "1.0.rc1", "1.0~rc1", "1_2", "1+2", "a", "alpha",
+  "..", "1.0-9", "1.0-10", "1:1.0-1", "2:0.1", "20140101", "2014.01.01",
+  "123456789012345678901234567890", "123456789012345678901234567891", "0000123456789012345678901234567890"
+};
+
+int sign(const int value)
+{
+  return value < 0 ? -1 : (value > 0 ? 1 : 0);
+}
+
+int rpmvercmp(const QString& a, const QString& b)
+{
+  return sign(Package::rpmvercmp(a.toLatin1().constData(), b.toLatin1().constData()));
+}
+
+// digits, letters and separators, with short runs of each being likely
+QString randomVersion()
+{
+  static const char alphabet[] = "00123789aAzZ.._-+:~ ";
+  const int length = qrand() % 10;
+  QString version;
+  for (int i = 0; i < length; ++i) version.append(QChar(alphabet[qrand() % (sizeof(alphabet) - 1)]));
+  return version;
+}
+
+// what the sync dbs are made of: mostly dotted numbers and a release, sometimes an epoch or a tag
+QStringList realisticVersions(const int count)
+{
+  QStringList versions;
+  versions.reserve(count);
+  for (int i = 0; i < count; ++i) {
+    QString version = QString("%1.%2.%3").arg(qrand() % 20).arg(qrand() % 100).arg(qrand() % 1000);
+    if (qrand() % 10 == 0) version.prepend(QString("%1:").arg(qrand() % 3));
+    if (qrand() % 8 == 0) version.append(QString("rc%1").arg(qrand() % 5));
+    if (qrand() % 20 == 0) version = QString("r%1.%2").arg(qrand() % 3000).arg(qrand(), 0, 16);
+    versions.append(version + QString("-%1").arg(qrand() % 5 + 1));
+  }
+  return versions;
+}
+
+bool lessByRpmvercmp(const QString& a, const QString& b)
+{
+  return Package::rpmvercmp(a.toLatin1().constData(), b.toLatin1().constData()) < 0;
+}
+
+struct TLessByKey {
+  explicit TLessByKey(const std::vector<VersionKey>& keys) : m_keys(keys) {}
+  bool operator()(const int a, const int b) const {
+    return m_keys[a].compare(m_keys[b]) < 0;
+  }
+  const std::vector<VersionKey>& m_keys;
+};
+
+struct TLessByPooledKey {
+  TLessByPooledKey(const QByteArray& pool, const std::vector<int>& offsets) : m_pool(pool), m_offsets(offsets) {}
+  bool operator()(const int a, const int b) const {
+    return VersionKey::compare(m_pool.constData() + m_offsets[a], m_offsets[a + 1] - m_offsets[a],
+                               m_pool.constData() + m_offsets[b], m_offsets[b + 1] - m_offsets[b]) < 0;
+  }
+  const QByteArray&       m_pool;
+  const std::vector<int>& m_offsets;
+};
+
+const int ctn_SORT_SIZE = 60000;
+
+} // namespace
+
+
+/*
+ * VersionKey must order exactly like Package::rpmvercmp, as the package list sorts with it
+ */
+class TestVersionKey : public QObject
+{
+  Q_OBJECT
+
+private slots:
+  void initTestCase();
+  void edgeCases();
+  void randomVersions();
+  void pooledKeys();
+
+  void sortWithRpmvercmp();
+  void sortWithVersionKey();
+  void sortWithPooledKeys();
+
+private:
+  QStringList m_sortInput;
+};
+
+void TestVersionKey::initTestCase()
+{
+  qsrand(20140101);
+  m_sortInput = realisticVersions(ctn_SORT_SIZE);
+}
+
+void TestVersionKey::edgeCases()
+{
+  const int count = sizeof(ctn_EDGE_CASES) / sizeof(ctn_EDGE_CASES[0]);
+  for (int i = 0; i < count; ++i) {
+    for (int j = 0; j < count; ++j) {
+      const QString a = ctn_EDGE_CASES[i];
+      const QString b = ctn_EDGE_CASES[j];
+      const int expected = rpmvercmp(a, b);
+      const int actual   = VersionKey(a).compare(VersionKey(b));
+      QVERIFY2(actual == expected,
+               qPrintable(QString("\"%1\" vs \"%2\": rpmvercmp %3, VersionKey %4").arg(a, b).arg(expected).arg(actual)));
+    }
+  }
+}
+
+void TestVersionKey::randomVersions()
+{
+  for (int i = 0; i < 200000; ++i) {
+    const QString a = randomVersion();
+    const QString b = qrand() % 4 == 0 ? a + randomVersion() : randomVersion();
+    const int expected = rpmvercmp(a, b);
+    const int actual   = VersionKey(a).compare(VersionKey(b));
+    QVERIFY2(actual == expected,
+             qPrintable(QString("\"%1\" vs \"%2\": rpmvercmp %3, VersionKey %4").arg(a, b).arg(expected).arg(actual)));
+  }
+}
+
+void TestVersionKey::pooledKeys()
+{
+  QByteArray pool;
+  std::vector<int> offsets(1, 0);
+  for (int i = 0; i < 1000; ++i) {
+    VersionKey::append(pool, m_sortInput.at(i));
+    offsets.push_back(pool.size());
+  }
+
+  for (int i = 0; i < 1000; ++i) {
+    const int j = qrand() % 1000;
+    const int pooled = VersionKey::compare(pool.constData() + offsets[i], offsets[i + 1] - offsets[i],
+                                           pool.constData() + offsets[j], offsets[j + 1] - offsets[j]);
+    QCOMPARE(pooled, VersionKey(m_sortInput.at(i)).compare(VersionKey(m_sortInput.at(j))));
+    QCOMPARE(pooled, rpmvercmp(m_sortInput.at(i), m_sortInput.at(j)));
+  }
+}
+
+/*
+ * The three ways to sort the version column, building the keys is part of the measurement
+ */
+void TestVersionKey::sortWithRpmvercmp()
+{
+  QBENCHMARK {
+    QStringList versions = m_sortInput;
+    qStableSort(versions.begin(), versions.end(), lessByRpmvercmp);
+  }
+}
+
+void TestVersionKey::sortWithVersionKey()
+{
+  QBENCHMARK {
+    std::vector<VersionKey> keys;
+    keys.reserve(m_sortInput.size());
+    for (int i = 0; i < m_sortInput.size(); ++i) keys.push_back(VersionKey(m_sortInput.at(i)));
+
+    std::vector<int> order(m_sortInput.size());
+    for (int i = 0; i < m_sortInput.size(); ++i) order[i] = i;
+    std::stable_sort(order.begin(), order.end(), TLessByKey(keys));
+  }
+}
+
+void TestVersionKey::sortWithPooledKeys()
+{
+  QBENCHMARK {
+    QByteArray pool;
+    std::vector<int> offsets(1, 0);
+    offsets.reserve(m_sortInput.size() + 1);
+    for (int i = 0; i < m_sortInput.size(); ++i) {
+      VersionKey::append(pool, m_sortInput.at(i));
+      offsets.push_back(pool.size());
+    }
+
+    std::vector<int> order(m_sortInput.size());
+    for (int i = 0; i < m_sortInput.size(); ++i) order[i] = i;
+    std::stable_sort(order.begin(), order.end(), TLessByPooledKey(pool, offsets));
+  }
+}
+
+QTEST_APPLESS_MAIN(TestVersionKey)
+#include "tst_versionkey.moc"
@@ -0,0 +1,6 @@
+include(../tests.pri)
+include(../core.pri)
+
+TARGET = tst_versionkey
+
+SOURCES += tst_versionkey.cpp